@@ -0,0 +1,610 @@
+/*!
+ * @file arena.c
+ * @brief Pooled allocator with size classes that implements the codec allocator interface
+ *
+ * Requests are rounded up to one of four size classes per power of two
+ * and blocks released by the caller are kept on a free list for the size
+ * class instead of being returned to the system, so the wavelet bands,
+ * frame buffers, and scratch buffers that the codec allocates and frees
+ * on every format change and many frames are recycled.  Each thread keeps
+ * a small cache of blocks in the smaller size classes that is used without
+ * taking the arena lock.  Every block starts on a cache line boundary.
+ *
+ * (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+ *
+ * Licensed under either:
+ * - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+ * - MIT license, http://opensource.org/licenses/MIT
+ * at your option.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stdafx.h"
+#include "config.h"
+#include "thread.h"
+#include "arena.h"
+
+#if __linux__
+#include <sys/mman.h>
+#endif
+
+#define ARENA_HEADER_SIZE		64			// Size of the block header (preserves the alignment)
+#define ARENA_ALIGNMENT			64			// Minimum alignment of every block
+#define ARENA_MIN_CLASS_SIZE	64			// Smallest size class
+#define ARENA_MAX_CLASS_SIZE	(256 << 20)	// Larger blocks are not kept on a free list
+#define ARENA_CLASS_COUNT		89			// Size classes from 64 bytes to 256 MB
+#define ARENA_CACHE_CLASS_COUNT	37			// Size classes up to 32 KB are cached per thread
+#define ARENA_CACHE_DEPTH		32			// Maximum number of blocks per class in a thread cache
+#define ARENA_DIRECT_CLASS		0xFFFFFFFF	// Block was allocated for a single request
+#define ARENA_BLOCK_MAGIC		0x41524E41	// Identifies blocks that belong to an arena
+#define ARENA_HUGE_PAGE_SIZE	(2 << 20)	// Size of a transparent huge page
+
+typedef struct arena_block
+{
+    struct arena_block *next;		// Next block in the free list
+    void *base;						// Memory obtained from the system
+    size_t size;					// Usable bytes in the block
+    size_t reserved;				// Bytes obtained from the system for the block
+    uint32_t size_class;			// Index of the size class or ARENA_DIRECT_CLASS
+    uint32_t magic;					// Set to ARENA_BLOCK_MAGIC
+    uint32_t mapped;				// Memory was mapped for huge pages
+
+} ARENA_BLOCK;
+
+typedef struct arena_cache
+{
+    struct arena_cache *next;		// Next thread cache owned by the arena
+    struct arena *arena;			// Arena that owns the cached blocks
+    ARENA_BLOCK *head[ARENA_CACHE_CLASS_COUNT];
+    int count[ARENA_CACHE_CLASS_COUNT];
+
+} ARENA_CACHE;
+
+typedef struct arena
+{
+    ALLOCATOR allocator;			// Must be the first member (the arena is passed as the allocator)
+    uint32_t flags;					// Flags passed to CreateArena
+    LOCK lock;						// Exclusive access to the free lists and the list of caches
+    ARENA_BLOCK *free_list[ARENA_CLASS_COUNT];
+    ARENA_CACHE *caches;			// Thread caches that have been created for this arena
+#ifdef _WIN32
+    DWORD cache_key;				// Fiber local storage index for the thread cache
+#else
+    pthread_key_t cache_key;		// Thread specific data key for the thread cache
+#endif
+    ARENA_STATS stats;				// Updated with atomic operations
+
+} ARENA;
+
+
+#ifdef _WIN32
+
+static inline void ArenaCounterAdd(uint64_t *counter, uint64_t value)
+{
+    InterlockedExchangeAdd64((volatile LONG64 *)counter, (LONG64)value);
+}
+
+static inline uint64_t ArenaCounterRead(uint64_t *counter)
+{
+    return (uint64_t)InterlockedCompareExchange64((volatile LONG64 *)counter, 0, 0);
+}
+
+static inline void ArenaCounterMax(uint64_t *counter, uint64_t value)
+{
+    LONG64 current = InterlockedCompareExchange64((volatile LONG64 *)counter, 0, 0);
+    while ((uint64_t)current < value)
+    {
+        LONG64 previous = InterlockedCompareExchange64((volatile LONG64 *)counter, (LONG64)value, current);
+        if (previous == current) break;
+        current = previous;
+    }
+}
+
+static inline int ArenaLog2(size_t n)
+{
+    unsigned long index;
+#ifdef _WIN64
+    _BitScanReverse64(&index, n);
+#else
+    _BitScanReverse(&index, (unsigned long)n);
+#endif
+    return (int)index;
+}
+
+#else
+
+static inline void ArenaCounterAdd(uint64_t *counter, uint64_t value)
+{
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t ArenaCounterRead(uint64_t *counter)
+{
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+static inline void ArenaCounterMax(uint64_t *counter, uint64_t value)
+{
+    uint64_t current = __atomic_load_n(counter, __ATOMIC_RELAXED);
+    while (current < value &&
+            !__atomic_compare_exchange_n(counter, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static inline int ArenaLog2(size_t n)
+{
+    return (int)(8 * sizeof(unsigned long long) - 1) - __builtin_clzll((unsigned long long)n);
+}
+
+#endif
+
+// Return the index of the smallest size class that can hold the request
+static inline uint32_t ArenaSizeClass(size_t size)
+{
+    size_t n;
+    int p;
+
+    if (size <= ARENA_MIN_CLASS_SIZE) return 0;
+
+    // Four classes between consecutive powers of two
+    n = size - 1;
+    p = ArenaLog2(n);
+    return (uint32_t)((p - 6) * 4 + ((n >> (p - 2)) & 3) + 1);
+}
+
+// Return the number of usable bytes in blocks of the size class
+static inline size_t ArenaClassSize(uint32_t size_class)
+{
+    int p;
+
+    if (size_class == 0) return ARENA_MIN_CLASS_SIZE;
+
+    p = 6 + (size_class - 1) / 4;
+    return ((size_t)1 << p) + ((size_class - 1) % 4 + 1) * ((size_t)1 << (p - 2));
+}
+
+static inline ARENA_BLOCK *ArenaBlockHeader(void *ptr)
+{
+    return (ARENA_BLOCK *)((uint8_t *)ptr - ARENA_HEADER_SIZE);
+}
+
+static ARENA_BLOCK *ArenaSystemAlloc(ARENA *arena, size_t size, size_t alignment, uint32_t size_class)
+{
+    ARENA_BLOCK *block;
+    uint8_t *memory = NULL;
+    uintptr_t address;
+    size_t reserved;
+    uint32_t mapped = 0;
+
+    // Room for the header in front of the aligned block
+    if (size > SIZE_MAX - ARENA_HEADER_SIZE - alignment) {
+        return NULL;
+    }
+
+#if __linux__
+    if ((arena->flags & ARENA_FLAGS_HUGE_PAGES) &&
+            alignment <= ARENA_HUGE_PAGE_SIZE &&
+            size >= ARENA_HUGE_PAGE_SIZE - alignment &&
+            size <= SIZE_MAX - 2 * ARENA_HUGE_PAGE_SIZE - alignment)
+    {
+        // Map extra memory so that the block can start on a huge page boundary
+        size_t length = (alignment + size + ARENA_HUGE_PAGE_SIZE - 1) & ~(size_t)(ARENA_HUGE_PAGE_SIZE - 1);
+        uint8_t *region = (uint8_t *)mmap(NULL, length + ARENA_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (region != (uint8_t *)MAP_FAILED)
+        {
+            uint8_t *start = (uint8_t *)(((uintptr_t)region + ARENA_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(ARENA_HUGE_PAGE_SIZE - 1));
+            size_t head = start - region;
+            size_t tail = ARENA_HUGE_PAGE_SIZE - head;
+
+            if (head > 0) munmap(region, head);
+            if (tail > 0) munmap(start + length, tail);
+#ifdef MADV_HUGEPAGE
+            madvise(start, length, MADV_HUGEPAGE);
+#endif
+            memory = start;
+            reserved = length;
+            mapped = 1;
+        }
+    }
+#endif
+
+    if (memory == NULL)
+    {
+        reserved = ARENA_HEADER_SIZE + size + alignment - 1;
+        memory = (uint8_t *)MEMORY_ALLOC(reserved);
+        if (memory == NULL) {
+            return NULL;
+        }
+    }
+
+    // The header immediately precedes the aligned block
+    address = ((uintptr_t)memory + ARENA_HEADER_SIZE + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    block = (ARENA_BLOCK *)(address - ARENA_HEADER_SIZE);
+    block->next = NULL;
+    block->base = memory;
+    block->size = size;
+    block->reserved = reserved;
+    block->size_class = size_class;
+    block->magic = ARENA_BLOCK_MAGIC;
+    block->mapped = mapped;
+
+    ArenaCounterAdd(&arena->stats.bytes_reserved, reserved);
+    ArenaCounterAdd(&arena->stats.system_alloc_count, 1);
+
+    return block;
+}
+
+static void ArenaSystemFree(ARENA *arena, ARENA_BLOCK *block)
+{
+    size_t reserved = block->reserved;
+
+    ArenaCounterAdd(&arena->stats.bytes_reserved, (uint64_t)0 - reserved);
+    ArenaCounterAdd(&arena->stats.system_free_count, 1);
+
+    block->magic = 0;
+
+#if __linux__
+    if (block->mapped)
+    {
+        munmap(block->base, reserved);
+        return;
+    }
+#endif
+
+    MEMORY_FREE(block->base);
+}
+
+// Move the blocks in the thread cache to the free lists (the arena must be locked)
+static void ArenaFlushCache(ARENA *arena, ARENA_CACHE *cache)
+{
+    uint32_t size_class;
+
+    for (size_class = 0; size_class < ARENA_CACHE_CLASS_COUNT; size_class++)
+    {
+        ARENA_BLOCK *block = cache->head[size_class];
+        while (block != NULL)
+        {
+            ARENA_BLOCK *next = block->next;
+            block->next = arena->free_list[size_class];
+            arena->free_list[size_class] = block;
+            block = next;
+        }
+        cache->head[size_class] = NULL;
+        cache->count[size_class] = 0;
+    }
+}
+
+// Return the cached blocks to the arena when the thread exits
+static void ArenaReleaseCache(ARENA_CACHE *cache)
+{
+    ARENA *arena = cache->arena;
+    ARENA_CACHE **link;
+
+    Lock(&arena->lock);
+    ArenaFlushCache(arena, cache);
+    for (link = &arena->caches; *link != NULL; link = &(*link)->next)
+    {
+        if (*link == cache)
+        {
+            *link = cache->next;
+            break;
+        }
+    }
+    Unlock(&arena->lock);
+
+    MEMORY_FREE(cache);
+}
+
+#ifdef _WIN32
+static VOID WINAPI ArenaCacheDestructor(PVOID value)
+{
+    if (value != NULL) {
+        ArenaReleaseCache((ARENA_CACHE *)value);
+    }
+}
+
+static inline ARENA_CACHE *ArenaGetCache(ARENA *arena)
+{
+    return (ARENA_CACHE *)FlsGetValue(arena->cache_key);
+}
+
+static inline void ArenaSetCache(ARENA *arena, ARENA_CACHE *cache)
+{
+    FlsSetValue(arena->cache_key, cache);
+}
+#else
+static void ArenaCacheDestructor(void *value)
+{
+    ArenaReleaseCache((ARENA_CACHE *)value);
+}
+
+static inline ARENA_CACHE *ArenaGetCache(ARENA *arena)
+{
+    return (ARENA_CACHE *)pthread_getspecific(arena->cache_key);
+}
+
+static inline void ArenaSetCache(ARENA *arena, ARENA_CACHE *cache)
+{
+    pthread_setspecific(arena->cache_key, cache);
+}
+#endif
+
+// Return the cache for the calling thread (created on first use)
+static ARENA_CACHE *ArenaThreadCache(ARENA *arena)
+{
+    ARENA_CACHE *cache = ArenaGetCache(arena);
+
+    if (cache == NULL)
+    {
+        cache = (ARENA_CACHE *)MEMORY_ALLOC(sizeof(ARENA_CACHE));
+        if (cache == NULL) {
+            return NULL;
+        }
+        memset(cache, 0, sizeof(ARENA_CACHE));
+        cache->arena = arena;
+
+        Lock(&arena->lock);
+        cache->next = arena->caches;
+        arena->caches = cache;
+        Unlock(&arena->lock);
+
+        ArenaSetCache(arena, cache);
+    }
+
+    return cache;
+}
+
+static void *ArenaAlloc(ARENA *arena, size_t size, size_t alignment)
+{
+    ARENA_BLOCK *block = NULL;
+    uint64_t bytes_in_use;
+
+    if (alignment < ARENA_ALIGNMENT) {
+        alignment = ARENA_ALIGNMENT;
+    }
+
+    if (alignment > ARENA_ALIGNMENT || size > ARENA_MAX_CLASS_SIZE)
+    {
+        // Blocks with unusual alignment or size are not recycled
+        block = ArenaSystemAlloc(arena, size, alignment, ARENA_DIRECT_CLASS);
+    }
+    else
+    {
+        uint32_t size_class = ArenaSizeClass(size);
+
+        if (size_class < ARENA_CACHE_CLASS_COUNT && !(arena->flags & ARENA_FLAGS_NO_THREAD_CACHE))
+        {
+            ARENA_CACHE *cache = ArenaThreadCache(arena);
+            if (cache != NULL && cache->head[size_class] != NULL)
+            {
+                block = cache->head[size_class];
+                cache->head[size_class] = block->next;
+                cache->count[size_class]--;
+            }
+        }
+
+        if (block == NULL)
+        {
+            Lock(&arena->lock);
+            block = arena->free_list[size_class];
+            if (block != NULL) {
+                arena->free_list[size_class] = block->next;
+            }
+            Unlock(&arena->lock);
+        }
+
+        if (block != NULL) {
+            ArenaCounterAdd(&arena->stats.reuse_count, 1);
+        }
+        else {
+            block = ArenaSystemAlloc(arena, ArenaClassSize(size_class), ARENA_ALIGNMENT, size_class);
+        }
+    }
+
+    if (block == NULL) {
+        return NULL;
+    }
+
+    ArenaCounterAdd(&arena->stats.alloc_count, 1);
+    ArenaCounterAdd(&arena->stats.bytes_in_use, block->size);
+    bytes_in_use = ArenaCounterRead(&arena->stats.bytes_in_use);
+    ArenaCounterMax(&arena->stats.peak_bytes_in_use, bytes_in_use);
+
+    block->next = NULL;
+    return (uint8_t *)block + ARENA_HEADER_SIZE;
+}
+
+static void ArenaFree(ARENA *arena, void *ptr)
+{
+    ARENA_BLOCK *block;
+    uint32_t size_class;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    block = ArenaBlockHeader(ptr);
+    assert(block->magic == ARENA_BLOCK_MAGIC);
+    if (block->magic != ARENA_BLOCK_MAGIC) {
+        // Do not release memory that was not allocated by the arena
+        return;
+    }
+
+    ArenaCounterAdd(&arena->stats.free_count, 1);
+    ArenaCounterAdd(&arena->stats.bytes_in_use, (uint64_t)0 - block->size);
+
+    size_class = block->size_class;
+    if (size_class == ARENA_DIRECT_CLASS)
+    {
+        ArenaSystemFree(arena, block);
+        return;
+    }
+
+    if (size_class < ARENA_CACHE_CLASS_COUNT && !(arena->flags & ARENA_FLAGS_NO_THREAD_CACHE))
+    {
+        ARENA_CACHE *cache = ArenaThreadCache(arena);
+        if (cache != NULL && cache->count[size_class] < ARENA_CACHE_DEPTH)
+        {
+            block->next = cache->head[size_class];
+            cache->head[size_class] = block;
+            cache->count[size_class]++;
+            return;
+        }
+    }
+
+    Lock(&arena->lock);
+    block->next = arena->free_list[size_class];
+    arena->free_list[size_class] = block;
+    Unlock(&arena->lock);
+}
+
+static void *ArenaUnalignedAlloc(void *allocator, size_t size)
+{
+    return ArenaAlloc((ARENA *)allocator, size, ARENA_ALIGNMENT);
+}
+
+static void ArenaUnalignedFree(void *allocator, void *block)
+{
+    ArenaFree((ARENA *)allocator, block);
+}
+
+static void *ArenaAlignedAlloc(void *allocator, size_t size, size_t alignment)
+{
+    return ArenaAlloc((ARENA *)allocator, size, alignment);
+}
+
+static void ArenaAlignedFree(void *allocator, void *block)
+{
+    ArenaFree((ARENA *)allocator, block);
+}
+
+static struct cfhd_allocator_vtable arena_vtable =
+{
+    ArenaUnalignedAlloc,
+    ArenaUnalignedFree,
+    ArenaAlignedAlloc,
+    ArenaAlignedFree,
+};
+
+ALLOCATOR *CreateArena(uint32_t flags)
+{
+    ARENA *arena = (ARENA *)MEMORY_ALLOC(sizeof(ARENA));
+    if (arena == NULL) {
+        return NULL;
+    }
+
+    memset(arena, 0, sizeof(ARENA));
+    arena->allocator.vtable = &arena_vtable;
+    arena->flags = flags;
+    CreateLock(&arena->lock);
+
+    if (!(flags & ARENA_FLAGS_NO_THREAD_CACHE))
+    {
+        // Use the shared free lists if thread local storage is not available
+#ifdef _WIN32
+        arena->cache_key = FlsAlloc(ArenaCacheDestructor);
+        if (arena->cache_key == FLS_OUT_OF_INDEXES) {
+            arena->flags |= ARENA_FLAGS_NO_THREAD_CACHE;
+        }
+#else
+        if (pthread_key_create(&arena->cache_key, ArenaCacheDestructor) != 0) {
+            arena->flags |= ARENA_FLAGS_NO_THREAD_CACHE;
+        }
+#endif
+    }
+
+    return &arena->allocator;
+}
+
+int IsArena(ALLOCATOR *allocator)
+{
+    return (allocator != NULL && allocator->vtable == &arena_vtable);
+}
+
+void TrimArena(ALLOCATOR *allocator)
+{
+    ARENA *arena = (ARENA *)allocator;
+    ARENA_CACHE *cache = NULL;
+    uint32_t size_class;
+
+    // Only the cache for the calling thread can be flushed safely
+    if (!(arena->flags & ARENA_FLAGS_NO_THREAD_CACHE)) {
+        cache = ArenaGetCache(arena);
+    }
+
+    Lock(&arena->lock);
+
+    if (cache != NULL) {
+        ArenaFlushCache(arena, cache);
+    }
+
+    for (size_class = 0; size_class < ARENA_CLASS_COUNT; size_class++)
+    {
+        ARENA_BLOCK *block = arena->free_list[size_class];
+        while (block != NULL)
+        {
+            ARENA_BLOCK *next = block->next;
+            ArenaSystemFree(arena, block);
+            block = next;
+        }
+        arena->free_list[size_class] = NULL;
+    }
+
+    Unlock(&arena->lock);
+}
+
+void GetArenaStats(ALLOCATOR *allocator, ARENA_STATS *stats)
+{
+    ARENA *arena = (ARENA *)allocator;
+
+    stats->bytes_in_use = ArenaCounterRead(&arena->stats.bytes_in_use);
+    stats->peak_bytes_in_use = ArenaCounterRead(&arena->stats.peak_bytes_in_use);
+    stats->bytes_reserved = ArenaCounterRead(&arena->stats.bytes_reserved);
+    stats->alloc_count = ArenaCounterRead(&arena->stats.alloc_count);
+    stats->free_count = ArenaCounterRead(&arena->stats.free_count);
+    stats->reuse_count = ArenaCounterRead(&arena->stats.reuse_count);
+    stats->system_alloc_count = ArenaCounterRead(&arena->stats.system_alloc_count);
+    stats->system_free_count = ArenaCounterRead(&arena->stats.system_free_count);
+}
+
+void ReleaseArena(ALLOCATOR *allocator)
+{
+    ARENA *arena = (ARENA *)allocator;
+    ARENA_CACHE *cache;
+
+    if (!(arena->flags & ARENA_FLAGS_NO_THREAD_CACHE))
+    {
+        // Freeing the fiber local storage index returns the caches of running threads to the
+        // arena on Windows, deleting the thread specific data key does not call the destructors
+#ifdef _WIN32
+        FlsFree(arena->cache_key);
+#else
+        pthread_key_delete(arena->cache_key);
+#endif
+    }
+
+    // Move the blocks in the remaining thread caches to the free lists
+    Lock(&arena->lock);
+    cache = arena->caches;
+    while (cache != NULL)
+    {
+        ARENA_CACHE *next = cache->next;
+        ArenaFlushCache(arena, cache);
+        MEMORY_FREE(cache);
+        cache = next;
+    }
+    arena->caches = NULL;
+    Unlock(&arena->lock);
+
+    // Blocks that are still allocated by the caller are not reclaimed
+    arena->flags |= ARENA_FLAGS_NO_THREAD_CACHE;
+    TrimArena(allocator);
+
+    DeleteLock(&arena->lock);
+    MEMORY_FREE(arena);
+}
@@ -0,0 +1,68 @@
+/*!
+ * @file arena.h
+ * @brief Pooled allocator with size classes that implements the codec allocator interface
+ *
+ * (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+ *
+ * Licensed under either:
+ * - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+ * - MIT license, http://opensource.org/licenses/MIT
+ * at your option.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "../Common/CFHDAllocator.h"
+
+// Flags that control the arena (same values as the public CFHD_ArenaFlags)
+#define ARENA_FLAGS_NONE			0
+#define ARENA_FLAGS_NO_THREAD_CACHE	(1 << 0)	// Every allocation goes through the shared free lists
+#define ARENA_FLAGS_HUGE_PAGES		(1 << 1)	// Request transparent huge pages for large blocks
+
+typedef struct arena_stats
+{
+    uint64_t bytes_in_use;			// Usable bytes in blocks held by the caller
+    uint64_t peak_bytes_in_use;		// Largest value of bytes_in_use since the arena was created
+    uint64_t bytes_reserved;		// Bytes obtained from the system (includes free blocks)
+    uint64_t alloc_count;			// Number of allocations
+    uint64_t free_count;			// Number of blocks released by the caller
+    uint64_t reuse_count;			// Allocations satisfied by a block from a free list
+    uint64_t system_alloc_count;	// Allocations that required memory from the system
+    uint64_t system_free_count;		// Blocks returned to the system
+
+} ARENA_STATS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Create an arena and return the allocator interface (NULL if out of memory)
+ALLOCATOR *CreateArena(uint32_t flags);
+
+// Return the free blocks in the arena to the system
+void TrimArena(ALLOCATOR *allocator);
+
+// Return the allocation statistics for the arena
+void GetArenaStats(ALLOCATOR *allocator, ARENA_STATS *stats);
+
+// Return true if the allocator was created by CreateArena
+int IsArena(ALLOCATOR *allocator);
+
+// Release the arena and all of its free blocks
+void ReleaseArena(ALLOCATOR *allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3035,10 +3035,10 @@ void ConvertLinesToOutput(DECODER *decoder, int width, int height, int linenum,
 
                         if (x < width)
                         {
-                            unsigned long *yu64 = (unsigned long *)ptrYUYV;
-                            unsigned long *yr16Y = (unsigned long *)ptrY;
-                            unsigned long *yr16U = (unsigned long *)ptrU;
-                            unsigned long *yr16V = (unsigned long *)ptrV;
+                            uint32_t *yu64 = (uint32_t *)ptrYUYV;
+                            uint32_t *yr16Y = (uint32_t *)ptrY;
+                            uint32_t *yr16U = (uint32_t *)ptrU;
+                            uint32_t *yr16V = (uint32_t *)ptrV;
 
 
                             for (; x < width; x += 4)
@@ -3143,6 +3143,13 @@ void ConvertLinesToOutput(DECODER *decoder, int width, int height, int linenum,
                             vvvvvvvv = _mm_loadu_si128((__m128i *)&sptr[width * 2]);
                             sptr += 8;
                         }
+                        else if (flags & ACTIVEMETADATA_SRC_8PIXEL_PLANAR)
+                        {
+                            yyyyyyyy = _mm_loadu_si128((__m128i *)&sptr[0]);
+                            uuuuuuuu = _mm_loadu_si128((__m128i *)&sptr[8]);
+                            vvvvvvvv = _mm_loadu_si128((__m128i *)&sptr[16]);
+                            sptr += 24;
+                        }
                         else
                         {
                             yyyyyyyy = _mm_insert_epi16(yyyyyyyy, sptr[0], 0);
@@ -3173,6 +3180,13 @@ void ConvertLinesToOutput(DECODER *decoder, int width, int height, int linenum,
                             sptr += 24;
                         }
 
+                        if (dnshiftto13bit > 0)
+                        {
+                            yyyyyyyy = _mm_srli_epi16(yyyyyyyy, dnshiftto13bit);		//13-bit
+                            uuuuuuuu = _mm_srli_epi16(uuuuuuuu, dnshiftto13bit);
+                            vvvvvvvv = _mm_srli_epi16(vvvvvvvv, dnshiftto13bit);
+                        }
+
                         yyyyyyyy = _mm_srai_epi16(yyyyyyyy, 1);
                         uuuuuuuu = _mm_srai_epi16(uuuuuuuu, 1);
                         vvvvvvvv = _mm_srai_epi16(vvvvvvvv, 1);
@@ -3611,6 +3625,7 @@ void ConvertLinesToOutput(DECODER *decoder, int width, int height, int linenum,
                 __m128i ditheryy =  _mm_set1_epi16(0);
                 __m128i ditheruu =  _mm_set1_epi16(0);
                 __m128i dithervv =  _mm_set1_epi16(0);
+                __m128i partial_epi8[4];
 
 
                 for (lines = linenum; lines < linenum + height; lines++)
@@ -3633,6 +3648,14 @@ void ConvertLinesToOutput(DECODER *decoder, int width, int height, int linenum,
 
                     for (x = 0; x < width; x += 16)
                     {
+                        __m128i *row_epi8 = out_epi8;
+
+                        // The last pixels in a row that is not a multiple of sixteen pixels are stored through a buffer
+                        if (x + 16 > width)
+                        {
+                            out_epi8 = partial_epi8;
+                        }
+
                         if (flags & ACTIVEMETADATA_SRC_8PIXEL_PLANAR)
                         {
                             yyyyyyyy1 = _mm_loadu_si128((__m128i *)&sptr[0]);
@@ -3776,6 +3799,11 @@ void ConvertLinesToOutput(DECODER *decoder, int width, int height, int linenum,
                             AYUV = _mm_unpackhi_epi16(AY, UV);
                             _mm_storeu_si128(out_epi8++, AYUV);
                         }
+
+                        if (row_epi8 != out_epi8 - 4)
+                        {
+                            memcpy(row_epi8, partial_epi8, (width - x) * 4);
+                        }
                     }
                     if (flags & ACTIVEMETADATA_PLANAR)
                     {
@@ -4266,6 +4294,11 @@ void ConvertLinesToOutput(DECODER *decoder, int width, int height, int linenum,
             break;
 
         case COLOR_FORMAT_NV12:
+        case COLOR_FORMAT_YV12:
+        case COLOR_FORMAT_P010:
+        case COLOR_FORMAT_P016:
+        case COLOR_FORMAT_P210:
+        case COLOR_FORMAT_P216:
             if (flags & ACTIVEMETADATA_SRC_8PIXEL_PLANAR)
             {
                 // only RGB output should use ACTIVEMETADATA_SRC_8PIXEL_PLANAR
@@ -4299,46 +4332,45 @@ void ConvertLinesToOutput(DECODER *decoder, int width, int height, int linenum,
                 }
             }
 
-            ConvertYUV16ToNV12(decoder, width, height, linenum, src,
-                               output, pitch, format, whitepoint, flags);
-            break;
-
-        case COLOR_FORMAT_YV12:
-            if (flags & ACTIVEMETADATA_SRC_8PIXEL_PLANAR)
+            if (format == COLOR_FORMAT_NV12)
             {
-                // only RGB output should use ACTIVEMETADATA_SRC_8PIXEL_PLANAR
-                assert(0);
+                ConvertYUV16ToNV12(decoder, width, height, linenum, src,
+                                   output, pitch, format, whitepoint, flags);
+            }
+            else if (format == COLOR_FORMAT_YV12)
+            {
+                ConvertYUV16ToYV12(decoder, width, height, linenum, src,
+                                   output, pitch, format, whitepoint, flags);
             }
+            else
+            {
+                ConvertYUV16ToSemiPlanar16(decoder, width, height, linenum, src,
+                                           output, pitch, format, whitepoint, flags);
+            }
+            break;
 
+        case COLOR_FORMAT_GBRP16:
+        case COLOR_FORMAT_GBRAP16:
             // Need to convert more than one row?
             for (row = 0; row < height; row++)
             {
                 unsigned short *src2 = &src[row * width * 3];
 
-                if (upshiftto16bit)
+                if (whitepoint != 16 && whitepoint != 0)
                 {
                     UpShift16(src2, width * 3, upshiftto16bit, 1);
                 }
-
-                if (!(flags & ACTIVEMETADATA_COLORFORMATDONE))
-                {
-                    // Perform inplace conversion to YUV
-
-                    if (flags & ACTIVEMETADATA_PLANAR)
-                    {
-                        // Input is unpacked pixels
-                        PlanarRGB16toPlanarYUV16(src2, src2, width, colorspace);
-                    }
-                    else
-                    {
-                        // Input is packed pixels
-                        ChunkyRGB16toChunkyYUV16(src2, src2, width, colorspace);
-                    }
-                }
             }
 
-            ConvertYUV16ToYV12(decoder, width, height, linenum, src,
-                               output, pitch, format, whitepoint, flags);
+            ConvertRGB16ToPlanar16(decoder, width, height, linenum, src,
+                                   output, pitch, format, whitepoint, flags);
+            break;
+
+        case COLOR_FORMAT_RGBA_HALF:
+        case COLOR_FORMAT_RGBA_FLOAT:
+        case COLOR_FORMAT_GBRAP_FLOAT:
+            ConvertRGB16ToFloat(decoder, width, height, linenum, src,
+                                output, pitch, format, whitepoint, flags, 3);
             break;
 
         default:
@@ -6197,6 +6229,15 @@ void ComputeCube(DECODER *decoder)
             decoder->frame.output_format == COLOR_FORMAT_DPX0 ||
             decoder->frame.output_format == COLOR_FORMAT_V210 ||
             decoder->frame.output_format == COLOR_FORMAT_YU64 ||
+            decoder->frame.output_format == COLOR_FORMAT_P010 ||
+            decoder->frame.output_format == COLOR_FORMAT_P016 ||
+            decoder->frame.output_format == COLOR_FORMAT_P210 ||
+            decoder->frame.output_format == COLOR_FORMAT_P216 ||
+            decoder->frame.output_format == COLOR_FORMAT_GBRP16 ||
+            decoder->frame.output_format == COLOR_FORMAT_GBRAP16 ||
+            decoder->frame.output_format == COLOR_FORMAT_RGBA_HALF ||
+            decoder->frame.output_format == COLOR_FORMAT_RGBA_FLOAT ||
+            decoder->frame.output_format == COLOR_FORMAT_GBRAP_FLOAT ||
             decoder->frame.output_format == COLOR_FORMAT_YR16 ||
             decoder->frame.output_format == COLOR_FORMAT_RG48 ||
             decoder->frame.output_format == COLOR_FORMAT_B64A ||
@@ -9600,6 +9641,15 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
             info->format == COLOR_FORMAT_DPX0 ||
             info->format == COLOR_FORMAT_YR16 ||
             info->format == COLOR_FORMAT_YU64 ||
+            info->format == COLOR_FORMAT_P010 ||
+            info->format == COLOR_FORMAT_P016 ||
+            info->format == COLOR_FORMAT_P210 ||
+            info->format == COLOR_FORMAT_P216 ||
+            info->format == COLOR_FORMAT_GBRP16 ||
+            info->format == COLOR_FORMAT_GBRAP16 ||
+            info->format == COLOR_FORMAT_RGBA_HALF ||
+            info->format == COLOR_FORMAT_RGBA_FLOAT ||
+            info->format == COLOR_FORMAT_GBRAP_FLOAT ||
             info->format == COLOR_FORMAT_V210 ||
             info->format == COLOR_FORMAT_R4FL)
     {
@@ -9670,6 +9720,11 @@ void DemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *
             highquality = 0;
             deripple = 1;
             break;
+        case 10: // Edge directed
+            sharpening = -1;
+            highquality = DEBAYER_EDGE_DIRECTED;
+            deripple = 1;
+            break;
     }
 
     if (decoder->sample_uncompressed)
@@ -10528,6 +10583,15 @@ void VerticalOnlyDemosaicRAW(DECODER *decoder, FRAME_INFO *info, int thread_inde
             info->format == COLOR_FORMAT_DPX0 ||
             info->format == COLOR_FORMAT_YR16 ||
             info->format == COLOR_FORMAT_YU64 ||
+            info->format == COLOR_FORMAT_P010 ||
+            info->format == COLOR_FORMAT_P016 ||
+            info->format == COLOR_FORMAT_P210 ||
+            info->format == COLOR_FORMAT_P216 ||
+            info->format == COLOR_FORMAT_GBRP16 ||
+            info->format == COLOR_FORMAT_GBRAP16 ||
+            info->format == COLOR_FORMAT_RGBA_HALF ||
+            info->format == COLOR_FORMAT_RGBA_FLOAT ||
+            info->format == COLOR_FORMAT_GBRAP_FLOAT ||
             info->format == COLOR_FORMAT_V210 ||
             info->format == COLOR_FORMAT_R4FL)
     {
@@ -11510,10 +11574,38 @@ void QuarterRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *o
     int maxbound = 4095; //10-bit source
     int midpoint = 32768 >> 3;
     int shift = 4;
+    int descale = 0;
+    int replicate = 0;
 
-    for (channel = 0; channel < 3; channel++)
+    if (info->resolution == DECODED_RESOLUTION_LOWPASS_ONLY)
     {
-        lowpass_images[channel] = transform_array[channel]->wavelet[decoder->gop_frame_num];//0/*frame*/];
+        // Only the lowpass bands at the top of the wavelet tree were decoded
+        for (channel = 0; channel < 3; channel++)
+        {
+            lowpass_images[channel] = transform_array[channel]->wavelet[5];
+            if (lowpass_images[channel] == NULL) // therefore IntraFrame compressed.
+            {
+                lowpass_images[channel] = transform_array[channel]->wavelet[2];
+            }
+            else
+            {
+                // The temporal lowpass band is the sum of the two frames in the group
+                descale = 1;
+            }
+        }
+
+        // Replicate the lowpass pixels if the output is twice the size of the lowpass bands
+        if (info->width >= 2 * lowpass_images[0]->width)
+        {
+            replicate = 1;
+        }
+    }
+    else
+    {
+        for (channel = 0; channel < 3; channel++)
+        {
+            lowpass_images[channel] = transform_array[channel]->wavelet[decoder->gop_frame_num];//0/*frame*/];
+        }
     }
     g_image = lowpass_images[0];
     rg_image = lowpass_images[1];
@@ -11571,9 +11663,9 @@ void QuarterRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *o
 
                 newline += pitch * y;
 
-                newG += y * (g_image->pitch / sizeof(PIXEL));
-                newRG += y * (rg_image->pitch / sizeof(PIXEL));
-                newBG += y * (bg_image->pitch / sizeof(PIXEL));
+                newG += (y >> replicate) * (g_image->pitch / sizeof(PIXEL));
+                newRG += (y >> replicate) * (rg_image->pitch / sizeof(PIXEL));
+                newBG += (y >> replicate) * (bg_image->pitch / sizeof(PIXEL));
 
                 gptr = newG;
                 rgptr = newRG;
@@ -11583,10 +11675,10 @@ void QuarterRAW(DECODER *decoder, FRAME_INFO *info, int thread_index, uint8_t *o
 
                 for (x = 0; x < info->width; x++)
                 {
-                    g = (*gptr++);
+                    g = gptr[x >> replicate] >> descale;
                     if (g > maxbound) g = maxbound;
-                    rg = (*rgptr++);
-                    bg = (*bgptr++);
+                    rg = rgptr[x >> replicate] >> descale;
+                    bg = bgptr[x >> replicate] >> descale;
 
                     r = (rg << 1) - midpoint + g;
                     b = (bg << 1) - midpoint + g;
@@ -12024,6 +12116,24 @@ void Row16uUncompressed2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thr
 
 
 
+// Copy the columns in the region of interest from each plane in a row of 16-bit pixels
+static unsigned short *CropPlanarRow16u(DECODER *decoder, unsigned short *src, int src_width, int num_planes,
+                                        unsigned short *region_row)
+{
+    int width = decoder->region.width;
+    int plane;
+
+    if (!decoder->region_decoded || width == src_width)
+        return src;
+
+    for (plane = 0; plane < num_planes; plane++)
+    {
+        memcpy(region_row + plane * width, src + plane * src_width + decoder->region.left, width * sizeof(unsigned short));
+    }
+
+    return region_row;
+}
+
 void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_index,
                              uint8_t *output, int pitch, uint8_t *scratch, int scratch_size,
                              int threading)
@@ -12046,6 +12156,21 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
     int color_space = decoder->frame.colorspace;
     int need4444 = (decoder->codec.encoded_format == ENCODED_FORMAT_RGBA_4444 && ALPHAOUTPUT(info->format));
 
+    // Region of the decoded frame that is output
+    int width = info->width;
+    int left = 0;
+    int top = 0;
+    int bottom = info->height;
+    uint16_t *region_row;
+
+    if (decoder->region_decoded)
+    {
+        left = decoder->region.left;
+        top = decoder->region.top;
+        bottom = top + decoder->region.height;
+        width = decoder->region.width;
+    }
+
     scanline = (uint16_t *)buffer;
 
     scanline2 = scanline;
@@ -12054,6 +12179,9 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
     else
         scanline2 += info->width * 6;
 
+    // Columns of each plane in the region of interest
+    region_row = scanline2 + info->width * 8;
+
     for (;;)
     {
         if (threading)
@@ -12072,7 +12200,14 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
             uint8_t *newline = line;
             int flags = 0;
 
-            newline += pitch * y;
+            if (y < top || bottom <= y)
+            {
+                // The row is outside the region of interest
+                y++;
+                continue;
+            }
+
+            newline += pitch * (y - top);
 
             //memcpy(scanline, newline, info->width*4);
 
@@ -12093,18 +12228,19 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
 
                                 src = decoder->RGBFilterBuffer16;
                                 src += info->width * 4 * y;
+                                src = CropPlanarRow16u(decoder, src, info->width, 4, region_row);
 
                                 if (decoder->frame.generate_look)
                                 {
-                                    DrawBlankLUT(src, info->width, y, 1);
+                                    DrawBlankLUT(src, width, y, 1);
                                     flags = ACTIVEMETADATA_PRESATURATED;
                                 }
 
-                                sptr = ApplyActiveMetaData4444(decoder, info->width, 1, y,
+                                sptr = ApplyActiveMetaData4444(decoder, width, 1, y,
                                                                (uint32_t *)src, (uint32_t *)scanline,
                                                                info->format, &whitebitdepth, &flags);
 
-                                Convert4444LinesToOutput(decoder, info->width, 1, y, sptr,
+                                Convert4444LinesToOutput(decoder, width, 1, y, sptr,
                                                          newline, pitch, info->format, whitebitdepth, flags);
                             }
                         }
@@ -12117,27 +12253,30 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
 
                                 src = decoder->RGBFilterBuffer16;
                                 src += info->width * 4 * y;
+                                src = CropPlanarRow16u(decoder, src, info->width, 4, region_row);
 
                                 if (decoder->frame.generate_look)
                                 {
-                                    DrawBlankLUT(scanline, info->width, y, 1);
+                                    DrawBlankLUT(scanline, width, y, 1);
                                     flags = ACTIVEMETADATA_PRESATURATED;
                                 }
                                 else
                                 {
                                     if (decoder->RGBFilterBufferPhase == 1) //GRB
-                                        ConvertPlanarGRBAToPlanarRGBA((PIXEL *)scanline, (PIXEL *)src, info->width);
+                                        ConvertPlanarGRBAToPlanarRGBA((PIXEL *)scanline, (PIXEL *)src, width);
                                     else
-                                        memcpy(scanline, src, info->width * 4 * 2);
+                                        memcpy(scanline, src, width * 4 * 2);
                                 }
 
-                                Convert4444LinesToOutput(decoder, info->width, 1, y, scanline,
+                                Convert4444LinesToOutput(decoder, width, 1, y, scanline,
                                                          newline, pitch, info->format, whitebitdepth, flags);
                             }
                         }
+                        break;
                     }
                 }
-                break;
+
+                // The alpha channel was not decoded so output the rows as RGB 4:4:4
 
                 case ENCODED_FORMAT_RGB_444:		// Three planes of RGB 4:4:4
                 {
@@ -12152,18 +12291,19 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
 
                             src = decoder->RGBFilterBuffer16;
                             src += info->width * 3 * y;
+                            src = CropPlanarRow16u(decoder, src, info->width, 3, region_row);
 
                             if (decoder->frame.generate_look)
                             {
-                                DrawBlankLUT(src, info->width, y, 1);
+                                DrawBlankLUT(src, width, y, 1);
                                 flags = ACTIVEMETADATA_PRESATURATED;
                             }
 
-                            sptr = ApplyActiveMetaData(decoder, info->width, 1, y,
+                            sptr = ApplyActiveMetaData(decoder, width, 1, y,
                                                        (uint32_t *)src, (uint32_t *)scanline,
                                                        info->format, &whitebitdepth, &flags);
 
-                            ConvertLinesToOutput(decoder, info->width, 1, y, sptr,
+                            ConvertLinesToOutput(decoder, width, 1, y, sptr,
                                                  newline, pitch, info->format, whitebitdepth, flags);
                         }
                     }
@@ -12176,21 +12316,22 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
 
                             src = decoder->RGBFilterBuffer16;
                             src += info->width * 3 * y;
+                            src = CropPlanarRow16u(decoder, src, info->width, 3, region_row);
 
                             if (decoder->frame.generate_look)
                             {
-                                DrawBlankLUT(scanline, info->width, y, 1);
+                                DrawBlankLUT(scanline, width, y, 1);
                                 flags = ACTIVEMETADATA_PRESATURATED;
                             }
                             else
                             {
                                 if (decoder->RGBFilterBufferPhase == 1) //GRB
-                                    ConvertPlanarGRBToPlanarRGB((PIXEL *)scanline, (PIXEL *)src, info->width);
+                                    ConvertPlanarGRBToPlanarRGB((PIXEL *)scanline, (PIXEL *)src, width);
                                 else
-                                    memcpy(scanline, src, info->width * 3 * 2);
+                                    memcpy(scanline, src, width * 3 * 2);
                             }
 
-                            ConvertLinesToOutput(decoder, info->width, 1, y, scanline,
+                            ConvertLinesToOutput(decoder, width, 1, y, scanline,
                                                  newline, pitch, info->format, whitebitdepth, flags);
                         }
                     }
@@ -12203,7 +12344,7 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
                     int planar_pitch[3];
                     int whitebitdepth = 16;
                     ROI roi;
-                    roi.width = info->width;
+                    roi.width = width;
                     roi.height = 1;
 
                     if (decoder->RGBFilterBufferPhase == 2) // YUV in a buffer
@@ -12212,9 +12353,9 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
                         planar_output[1] = planar_output[0] + info->width * 2;
                         planar_output[2] = planar_output[0] + info->width * 3;
 
-                        planar_output[0] += info->width * 4 * y;
-                        planar_output[1] += info->width * 4 * y;
-                        planar_output[2] += info->width * 4 * y;
+                        planar_output[0] += info->width * 4 * y + left * 2;
+                        planar_output[1] += info->width * 4 * y + left;
+                        planar_output[2] += info->width * 4 * y + left;
 
                         planar_pitch[0] = 0;
                         planar_pitch[1] = 0;
@@ -12235,28 +12376,32 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
                         if (info->format == COLOR_FORMAT_V210 || info->format == COLOR_FORMAT_YU64)
                         {
                             ROI newroi;
-                            newroi.width = info->width;
+                            newroi.width = width;
                             newroi.height = 1;
 
-                            memcpy(scanline, newline, info->width * 2 * 2);
-                            planar_output[0] = (uint8_t *)scanline;
-                            planar_output[1] = planar_output[0] + info->width * 2;
-                            planar_output[2] = planar_output[0] + info->width * 3;
+                            // Rows that are not in a buffer are converted in place
+                            if (decoder->RGBFilterBufferPhase != 2)
+                            {
+                                memcpy(scanline, newline, width * 2 * 2);
+                                planar_output[0] = (uint8_t *)scanline;
+                                planar_output[1] = planar_output[0] + width * 2;
+                                planar_output[2] = planar_output[0] + width * 3;
+                            }
 
                             ConvertYUVStripPlanarToV210((PIXEL **)planar_output, planar_pitch, newroi,
-                                                        newline, pitch, info->width, info->format, info->colorspace, 16);
+                                                        newline, pitch, width, info->format, info->colorspace, 16);
                         }
                         else
                         {
                             if (decoder->frame.generate_look)
                             {
-                                DrawBlankLUT(scanline, info->width, y, 1);
+                                DrawBlankLUT(scanline, width, y, 1);
                                 flags = ACTIVEMETADATA_PRESATURATED;
                             }
                             else
                             {
                                 ConvertYUVRow16uToYUV444(planar_output, planar_pitch, roi,
-                                                         (uint8_t *)scanline, info->width, pitch, COLOR_FORMAT_RGB_8PIXEL_PLANAR);
+                                                         (uint8_t *)scanline, width, pitch, COLOR_FORMAT_RGB_8PIXEL_PLANAR);
 
                                 flags = (ACTIVEMETADATA_PRESATURATED |
                                          ACTIVEMETADATA_SRC_8PIXEL_PLANAR |
@@ -12264,7 +12409,7 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
                             }
                             sptr = scanline;
 
-                            ConvertLinesToOutput(decoder, info->width, 1, y, sptr,
+                            ConvertLinesToOutput(decoder, width, 1, y, sptr,
                                                  newline, pitch, info->format, whitebitdepth, flags);
                         }
                     }
@@ -12272,7 +12417,7 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
                     {
                         if (decoder->frame.generate_look)
                         {
-                            DrawBlankLUT(scanline, info->width, y, 1);
+                            DrawBlankLUT(scanline, width, y, 1);
                             flags = ACTIVEMETADATA_PRESATURATED;
                         }
                         else
@@ -12281,10 +12426,10 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
                             {
                                 int colorspace = color_space & (8 | 3); // VSRGB is done in cube
                                 ConvertYUVRow16uToBGRA64(planar_output, planar_pitch, roi,
-                                                         (unsigned char *)scanline, info->width, pitch,
+                                                         (unsigned char *)scanline, width, pitch,
                                                          COLOR_FORMAT_RGB_8PIXEL_PLANAR, colorspace, &whitebitdepth, &flags);
 
-                                sptr = ApplyActiveMetaData(decoder, info->width, 1, y,
+                                sptr = ApplyActiveMetaData(decoder, width, 1, y,
                                                            (uint32_t *)scanline, (uint32_t *)scanline2,
                                                            info->format, &whitebitdepth, &flags);
 
@@ -12295,15 +12440,15 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
                             }
                             else
                             {
-                                ChannelYUYV16toPlanarYUV16((unsigned short **)planar_output, scanline, info->width, color_space);
-                                PlanarYUV16toPlanarRGB16(scanline, scanline2, info->width, color_space | COLOR_SPACE_8_PIXEL_PLANAR);
+                                ChannelYUYV16toPlanarYUV16((unsigned short **)planar_output, scanline, width, color_space);
+                                PlanarYUV16toPlanarRGB16(scanline, scanline2, width, color_space | COLOR_SPACE_8_PIXEL_PLANAR);
                                 sptr = scanline2;
                                 flags = COLOR_FORMAT_RGB_8PIXEL_PLANAR;
                                 whitebitdepth = 16;
                             }
                         }
 
-                        ConvertLinesToOutput(decoder, info->width, 1, y, sptr,
+                        ConvertLinesToOutput(decoder, width, 1, y, sptr,
                                              newline, pitch, info->format, whitebitdepth, flags);
                     }
                 }
@@ -12314,6 +12459,8 @@ void Row16uFull2OutputFormat(DECODER *decoder, FRAME_INFO *info, int thread_inde
                     break;
             }
 
+            DecodedRowsWritten(decoder, line, y - top, 1);
+
             y++;
         }
         else
@@ -13947,9 +14094,8 @@ THREAD_PROC(WorkerThreadProc, lpParam)
                             Row16uHalf2OutputFormat(decoder, &info, thread_index, output, pitch, frame, scratch, (int)scratchsize, true);
                         else if (info.resolution == DECODED_RESOLUTION_QUARTER)
                             Row16uQuarter2OutputFormat(decoder, &info, thread_index, output, pitch, frame, scratch, (int)scratchsize, true, channeldata, channelpitch);
-                        else //lowpass?
-                        {
-                        }
+                        else if (info.resolution == DECODED_RESOLUTION_LOWPASS_ONLY)
+                            Row16uFull2OutputFormat(decoder, &info, thread_index, output, pitch, scratch, (int)scratchsize, true);
                         decoder->frame.alpha_Companded = 1;
                         break;
 
@@ -13985,7 +14131,8 @@ THREAD_PROC(WorkerThreadProc, lpParam)
                             //TODO half res bayer decodes
                             NoDemosaicRAW(decoder, &info, thread_index, output, pitch, scratch, (int)scratchsize);
                         }
-                        else if (info.resolution == DECODED_RESOLUTION_HALF) // quarter res,
+                        else if (info.resolution == DECODED_RESOLUTION_HALF || // quarter res,
+                                 info.resolution == DECODED_RESOLUTION_LOWPASS_ONLY) // eighth and sixteenth res,
                         {
                             QuarterRAW(decoder, &info, thread_index, output, pitch, scratch, (int)scratchsize);
                         }
@@ -17878,6 +18025,13 @@ void Convert4444LinesToOutput(DECODER *decoder, int width, int height, int linen
         }
         break;
 
+        case COLOR_FORMAT_RGBA_HALF:
+        case COLOR_FORMAT_RGBA_FLOAT:
+        case COLOR_FORMAT_GBRAP_FLOAT:
+            ConvertRGB16ToFloat(decoder, width, height, linenum, src,
+                                output, pitch, format, whitepoint, flags, 4);
+            break;
+
         default:
             assert(0);
             break;
@@ -1214,6 +1214,34 @@ enum BlendTypes
     BLEND_ANAGLYPH_DUBOIS
 };
 
+// Rectangle in the decoded frame (zero width or height for the entire frame)
+typedef struct decoded_region
+{
+    int left;
+    int top;
+    int width;
+    int height;
+
+} DECODED_REGION;
+
+// Callback that receives bands of output rows in order as the rows are written
+typedef void (* DECODED_ROWS_PROC)(void *param, int first_row, int row_count);
+
+// Progress of the output rows written into the output buffer for the current frame
+typedef struct decoded_rows
+{
+    DECODED_ROWS_PROC proc;		// Callback for bands of rows (NULL if rows are not reported)
+    void *param;				// Argument passed to the callback
+    uint8_t *output;			// Output buffer written by the final stage of decoding
+    int num_rows;				// Number of rows in the output buffer
+    int band_rows;				// Minimum number of rows reported in each band before the last band
+    int finished_rows;			// All rows before this row have been written
+    int reported_rows;			// All rows before this row have been reported
+    uint8_t *row_written;		// Flag for each row that has been written
+    int row_written_size;		// Number of row flags that have been allocated
+
+} DECODED_ROWS;
+
 /*!
 	@brief Data structure for storing the decoder state information
 
@@ -1530,6 +1558,17 @@ typedef struct decoder		// Decoder state (derived from codec)
     unsigned int dmo_png_height[64];
     char dmo_png_path[64][260];
 
+    // Metadata in the last sample, used to skip processing metadata that has not changed
+    int metadata_hash_valid;			// set if the fields below describe the last sample
+    uint64_t metadata_hash;				// hash of the metadata chunks in the last sample
+    size_t metadata_size;				// total size of the metadata chunks
+    int metadata_chunk_count;			// number of metadata chunks
+    uint32_t metadata_framenumber;		// unique frame number after the metadata was applied
+    int metadata_drawobjects;			// number of DSPm objects in the metadata
+    unsigned char dmo_chunk[64];		// metadata chunk that contains each DSPm object
+    unsigned int dmo_offset[64];		// offset of each DSPm object within its metadata chunk
+    CFHDDATA metadata_cfhddata;			// cfhddata after the metadata in the last sample was applied
+
     unsigned int LUTcacheCRC; // last LUT CRC currently loaded
     float *LUTcache; // last LUT currently loaded
     int LUTcacheSize; // last LUT currently loaded
@@ -1571,6 +1610,13 @@ typedef struct decoder		// Decoder state (derived from codec)
 
     int useAlphaMixDown[2]; // check colors
 
+    DECODED_REGION region;		// Region of interest in the decoded frame
+    int region_decoded;			// Only the region of interest was output for the current frame
+
+    DECODED_ROWS decoded_rows;	// Rows of the output frame that have been written and reported
+
+    struct sample_layout *sample_layout;	// Layout of the previous sample header (allocated when first used)
+
 } DECODER;
 
 #define FLAG3D_SWAPPED				1
@@ -80,6 +80,18 @@ typedef enum color_format
     COLOR_FORMAT_NV12 = 16,		// 4:2:0 pixel formats
     COLOR_FORMAT_YV12 = 17,		//
 
+    COLOR_FORMAT_P010 = 18,		// 16-bit luma plane and interleaved chroma plane (10 significant bits)
+    COLOR_FORMAT_P016 = 19,		// 4:2:0 with 16 bits per component
+    COLOR_FORMAT_P210 = 20,		// 4:2:2 with 10 significant bits per component
+    COLOR_FORMAT_P216 = 21,		// 4:2:2 with 16 bits per component
+
+    COLOR_FORMAT_GBRP16 = 22,	// Planes of 16-bit G, B, and R 4:4:4
+    COLOR_FORMAT_GBRAP16 = 23,	// Planes of 16-bit G, B, R, and A 4:4:4:4
+
+    COLOR_FORMAT_RGBA_HALF = 24,	// RGBA 4:4:4:4 with 16-bit floating-point components
+    COLOR_FORMAT_RGBA_FLOAT = 25,	// RGBA 4:4:4:4 with 32-bit floating-point components
+    COLOR_FORMAT_GBRAP_FLOAT = 26,	// Planes of 32-bit floating-point G, B, R, and A 4:4:4:4
+
     // New color formats added for QuickTime (fourcc listed as comment)
     COLOR_FORMAT_BGRA64 = 30,	// b64a
     COLOR_FORMAT_YUVA_FLOAT,	// r4fl
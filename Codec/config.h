@@ -94,6 +94,28 @@
 
 #endif
 
+// Enable code that uses newer instruction sets selected at runtime by GetProcessorFeatures
+#ifndef _AVX2OPT
+#if _XMMOPT && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define _AVX2OPT	1
+#else
+#define _AVX2OPT	0
+#endif
+#endif
+
+// Compile a function for an instruction set that is not enabled for the rest of the file
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2		__attribute__((target("avx2")))
+#define TARGET_F16C		__attribute__((target("avx,f16c")))
+#define TARGET_SSE42	__attribute__((target("sse4.2")))
+#define TARGET_PCLMUL	__attribute__((target("sse4.2,pclmul")))
+#else
+#define TARGET_AVX2
+#define TARGET_F16C
+#define TARGET_SSE42
+#define TARGET_PCLMUL
+#endif
+
 //TODO: Enable use of the new memory allocator functions be default
 
 // Enable or disable use of the new memory allocator functions
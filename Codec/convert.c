@@ -40,6 +40,11 @@
 
 #include "swap.h"
 
+#if _AVX2OPT
+#include <immintrin.h>		// AVX2 intrinsics
+#include "cpuid.h"
+#endif
+
 // Performance measurements
 #if _TIMING
 extern TIMER tk_convert;
@@ -2100,6 +2105,63 @@ void ConvertYUV16sRowToYU64(PIXEL *input, uint8_t *output, int length)
 //#endif
 
 
+#if _AVX2OPT
+// Unpack groups of 48 pixels of v210 using 256-bit registers (returns the number of pixels converted)
+TARGET_AVX2 static int ConvertV210RowToPlanar16sAVX2(uint8_t *input, int length, PIXEL *y_output, PIXEL *cb_output, PIXEL *cr_output)
+{
+    // Each lane holds six pixels unpacked into the first (a), second (b), and third (c) value of each word:
+    //   a = Cb0 Y1 Cr2 Y4, b = Y0 Cb2 Y3 Cr4, c = Cr0 Y2 Cb4 Y5
+    // After packing a and b into ab and c into cc the luma and chroma are gathered with byte shuffles
+    const __m256i luma_ab = _mm256_setr_epi8(8, 9, 2, 3, -1, -1, 12, 13, 6, 7, -1, -1, -1, -1, -1, -1,
+                            8, 9, 2, 3, -1, -1, 12, 13, 6, 7, -1, -1, -1, -1, -1, -1);
+    const __m256i luma_cc = _mm256_setr_epi8(-1, -1, -1, -1, 2, 3, -1, -1, -1, -1, 6, 7, -1, -1, -1, -1,
+                            -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, 6, 7, -1, -1, -1, -1);
+    const __m256i chroma_ab = _mm256_setr_epi8(0, 1, 10, 11, -1, -1, -1, -1, -1, -1, 4, 5, 14, 15, -1, -1,
+                              0, 1, 10, 11, -1, -1, -1, -1, -1, -1, 4, 5, 14, 15, -1, -1);
+    const __m256i chroma_cc = _mm256_setr_epi8(-1, -1, -1, -1, 4, 5, -1, -1, 0, 1, -1, -1, -1, -1, -1, -1,
+                              -1, -1, -1, -1, 4, 5, -1, -1, 0, 1, -1, -1, -1, -1, -1, -1);
+
+    // Move the six luma values in each lane next to each other
+    const __m256i luma_order = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+    const __m256i mask_epi32 = _mm256_set1_epi32(V210_VALUE_MASK);
+
+    int column = 0;
+
+    // The chroma stores write one value past the end of each group of six pixels
+    for (; column + 48 + 2 <= length; column += 48)
+    {
+        int group;
+
+        for (group = 0; group < 4; group++)
+        {
+            __m256i input_si256 = _mm256_loadu_si256((__m256i *)(input + (column + group * 12) / 6 * 16));
+            __m256i a_epi32 = _mm256_and_si256(input_si256, mask_epi32);
+            __m256i b_epi32 = _mm256_and_si256(_mm256_srli_epi32(input_si256, V210_VALUE2_SHIFT), mask_epi32);
+            __m256i c_epi32 = _mm256_and_si256(_mm256_srli_epi32(input_si256, V210_VALUE3_SHIFT), mask_epi32);
+            __m256i ab_epi16 = _mm256_packus_epi32(a_epi32, b_epi32);
+            __m256i cc_epi16 = _mm256_packus_epi32(c_epi32, c_epi32);
+            __m256i y_epi16 = _mm256_or_si256(_mm256_shuffle_epi8(ab_epi16, luma_ab), _mm256_shuffle_epi8(cc_epi16, luma_cc));
+            __m256i uv_epi16 = _mm256_or_si256(_mm256_shuffle_epi8(ab_epi16, chroma_ab), _mm256_shuffle_epi8(cc_epi16, chroma_cc));
+            __m128i uv1_si128 = _mm256_castsi256_si128(uv_epi16);
+            __m128i uv2_si128 = _mm256_extracti128_si256(uv_epi16, 1);
+            int y_index = column + group * 12;
+            int uv_index = y_index / 2;
+
+            y_epi16 = _mm256_permutevar8x32_epi32(y_epi16, luma_order);
+            _mm_storeu_si128((__m128i *)&y_output[y_index], _mm256_castsi256_si128(y_epi16));
+            _mm_storel_epi64((__m128i *)&y_output[y_index + 8], _mm256_extracti128_si256(y_epi16, 1));
+
+            _mm_storel_epi64((__m128i *)&cb_output[uv_index], uv1_si128);
+            _mm_storel_epi64((__m128i *)&cb_output[uv_index + 3], uv2_si128);
+            _mm_storel_epi64((__m128i *)&cr_output[uv_index], _mm_unpackhi_epi64(uv1_si128, uv1_si128));
+            _mm_storel_epi64((__m128i *)&cr_output[uv_index + 3], _mm_unpackhi_epi64(uv2_si128, uv2_si128));
+        }
+    }
+
+    return column;
+}
+#endif
+
 //#if BUILD_PROSPECT
 // Convert one row of 10-bit YUV padded to three channels of 16-bit YUV
 void ConvertV210RowToPlanar16s(uint8_t *input, int length, PIXEL *y_output, PIXEL *u_output, PIXEL *v_output)
@@ -2130,6 +2192,18 @@ void ConvertV210RowToPlanar16s(uint8_t *input, int length, PIXEL *y_output, PIXE
     // Must have an even number of pixels
     assert((length % 2) == 0);
 
+#if _AVX2OPT
+    if (GetProcessorFeatures() & _CPU_FEATURE_AVX2)
+    {
+        // Convert most of the row with AVX2 and let the SSE2 loop finish the groups of 48 pixels
+        column = ConvertV210RowToPlanar16sAVX2(input, length, y_output, v_output, u_output);
+        input_ptr += column / 6;
+        y_output_ptr += column / 8;
+        u_output_ptr += column / 16;
+        v_output_ptr += column / 16;
+    }
+#endif
+
     for (; column < post_column; column += column_step)
     {
         const __m128i mask_epi32 = _mm_set1_epi32(V210_VALUE_MASK);
@@ -8939,6 +9013,15 @@ void ConvertYUVRow16uToBGRA64(uint8_t *planar_output[], int planar_pitch[], ROI
                         break;
 
                     case COLOR_FORMAT_RGB_8PIXEL_PLANAR:
+                    {
+                        // Blocks of eight red, eight green, and eight blue values (13-bit signed)
+                        short *block = (short *)outptr + 3 * (column & ~7);
+                        block[(column & 7) + 0] = (R >> 3);
+                        block[(column & 7) + 8] = (G >> 3);
+                        block[(column & 7) + 16] = (B >> 3);
+                    }
+                    break;
+
                     case COLOR_FORMAT_R210:
                     case COLOR_FORMAT_DPX0: //DPX0
                     case COLOR_FORMAT_RG30: //RG30
@@ -8985,6 +9068,14 @@ void ConvertYUVRow16uToBGRA64(uint8_t *planar_output[], int planar_pitch[], ROI
                         break;
 
                     case COLOR_FORMAT_RGB_8PIXEL_PLANAR:
+                    {
+                        short *block = (short *)outptr + 3 * (column & ~7);
+                        block[(column & 7) + 1] = (R >> 3);
+                        block[(column & 7) + 9] = (G >> 3);
+                        block[(column & 7) + 17] = (B >> 3);
+                    }
+                    break;
+
                     case COLOR_FORMAT_R210:
                     case COLOR_FORMAT_DPX0: //DPX0
                     case COLOR_FORMAT_RG30: //RG30
@@ -9064,10 +9155,10 @@ void ConvertYUVRow16uToYUV444(uint8_t *planar_output[], int planar_pitch[], ROI
             {
                 __m128i y1, y2, u, v, u1, u2, v1, v2;
 
-                y1 = _mm_load_si128(yptr++);
-                y2 = _mm_load_si128(yptr++);
-                u = _mm_load_si128(uptr++);
-                v = _mm_load_si128(vptr++);
+                y1 = _mm_loadu_si128(yptr++);
+                y2 = _mm_loadu_si128(yptr++);
+                u = _mm_loadu_si128(uptr++);
+                v = _mm_loadu_si128(vptr++);
 
 
                 // Duplicate the second two chroma values
@@ -9129,8 +9220,22 @@ void ConvertYUVRow16uToYUV444(uint8_t *planar_output[], int planar_pitch[], ROI
             assert(column == post_column);
 
 #endif
-            // Should have exited the loop just after the last column
-            assert(column == width);
+            // Process the remaining columns in blocks of eight pixels
+            for (; column < width; column += 8)
+            {
+                PIXEL16U *output_ptr = (PIXEL16U *)output_row_ptr + 3 * column;
+                int i;
+
+                for (i = 0; i < 8 && column + i < width; i++)
+                {
+                    int x = column + i;
+                    int last = (x > 0) ? (x - 1) / 2 : 0;
+
+                    output_ptr[i] = y_row_ptr[x];
+                    output_ptr[i + 8] = (u_row_ptr[last] >> 1) + (u_row_ptr[x / 2] >> 1);
+                    output_ptr[i + 16] = (v_row_ptr[last] >> 1) + (v_row_ptr[x / 2] >> 1);
+                }
+            }
 
             // Advance to the next rows in the input and output arrays
             y_row_ptr += y_pitch;
@@ -14942,14 +15047,70 @@ void ConvertCbYCrY_16bitToRow16u(DECODER *decoder,
 }
 
 /*!
-	@brief Convert 16-bit YUV 4:2:2 to luma and chroma planes in NV12 format
+	@brief Convert one row of 16-bit YUV 4:4:4 to 8-bit luma and 4:2:0 chroma
+
+	Each chroma sample is the average of two adjacent columns.  The chroma for
+	a pair of rows is taken from the even row and the odd row only stores luma,
+	since the rows in each pair may be converted by different threads.
+
+	The chroma output pointers may address interleaved (NV12) or separate (YV12)
+	chroma planes and are advanced by the chroma step after each sample.
+*/
+static void ConvertYUV16RowTo420(uint16_t *input,
+                                 int width,
+                                 int planar,
+                                 bool store_chroma,
+                                 uint8_t *luma_row_ptr,
+                                 uint8_t *cb_row_ptr,
+                                 uint8_t *cr_row_ptr,
+                                 int chroma_step)
+{
+    uint16_t *y_input = input;
+    uint16_t *cb_input = planar ? &input[width] : &input[1];
+    uint16_t *cr_input = planar ? &input[width * 2] : &input[2];
+    int step = planar ? 1 : 3;
+    int column;
+
+    // Output width must be a multiple of two
+    assert((width % 2) == 0);
+
+    for (column = 0; column < width; column += 2)
+    {
+        int index = column * step;
+        uint32_t Y1 = y_input[index];
+        uint32_t Y2 = y_input[index + step];
+        uint32_t Cb = cb_input[index] + cb_input[index + step];
+        uint32_t Cr = cr_input[index] + cr_input[index + step];
+
+        // Reduce the input components to eight bits
+        luma_row_ptr[column + 0] = (uint8_t)(Y1 >> 8);
+        luma_row_ptr[column + 1] = (uint8_t)(Y2 >> 8);
+
+        if (store_chroma)
+        {
+            Cb = (Cb + 256) >> 9;
+            Cr = (Cr + 256) >> 9;
+
+            *cb_row_ptr = (uint8_t)((Cb > 255) ? 255 : Cb);
+            *cr_row_ptr = (uint8_t)((Cr > 255) ? 255 : Cr);
+        }
+
+        cb_row_ptr += chroma_step;
+        cr_row_ptr += chroma_step;
+    }
+}
+
+/*!
+	@brief Convert 16-bit YUV 4:4:4 to luma and chroma planes in NV12 format
 
 	The output is an upper plane of 8-bit luma and a lower plane of interleaved
 	8-bit chroma with 4:2:0 sampling.  The chroma plane is half the height of the
-	luma plane.
+	luma plane and follows the last row of the luma plane.
 
-	This routine has not been optimized for performance and does not average the
-	chroma rows when downsampling to 4:2:0.
+	The output pointer is the address of the luma row in the output frame.  The
+	row number is computed from the base address of the frame, so the rows can be
+	converted directly into the output buffer by the threads that compute the strips
+	of the inverse transform.
 */
 void ConvertYUV16ToNV12(DECODER *decoder,
                         int width,
@@ -14963,271 +15124,485 @@ void ConvertYUV16ToNV12(DECODER *decoder,
                         int flags)
 {
     int planar = (flags & ACTIVEMETADATA_PLANAR);
-    uint16_t *input_row_ptr = input;
-    uint8_t *luma_row_ptr = output;
-    uint8_t *chroma_row_ptr = NULL;
-    int input_row_pitch = width * 3;
-    int output_row_pitch = width;
-    int row, column;
+    uint8_t *chroma_plane = decoder->local_output + pitch * DecodedOutputHeight(decoder);
+    int line = (int)((output - decoder->local_output) / pitch);
+    int row;
 
-    size_t diffline = ((size_t)luma_row_ptr - (size_t)decoder->local_output) / width;
+    (void) linenum;
 
-    chroma_row_ptr = decoder->local_output + width * decoder->frame.height + width * (diffline / 2);
+    for (row = 0; row < height; row++, line++)
+    {
+        uint8_t *chroma_row_ptr = chroma_plane + (line / 2) * pitch;
 
-    // The routine processes a single row or an even number of rows
-    assert(height == 1 || ((height % 2) == 0));
+        ConvertYUV16RowTo420(input, width, planar, (line % 2) == 0,
+                             output, &chroma_row_ptr[0], &chroma_row_ptr[1], 2);
 
-    if (planar)
+        input += width * 3;
+        output += pitch;
+    }
+}
+
+/*!
+	@brief Convert 16-bit YUV 4:4:4 to luma and chroma planes in YV12 format
+
+	The output is an upper plane of 8-bit luma followed by the Cr and Cb planes
+	with 4:2:0 sampling.  Each chroma plane is half the height and half the width
+	of the luma plane and has half the pitch of the luma plane.
+
+	The rows are located in the output frame in the same way as the NV12 format.
+*/
+void ConvertYUV16ToYV12(DECODER *decoder,
+                        int width,
+                        int height,
+                        int linenum,
+                        uint16_t *input,
+                        uint8_t *output,
+                        int pitch,
+                        int format,
+                        int whitepoint,
+                        int flags)
+{
+    int planar = (flags & ACTIVEMETADATA_PLANAR);
+    int chroma_pitch = pitch / 2;
+    uint8_t *cr_plane = decoder->local_output + pitch * DecodedOutputHeight(decoder);
+    uint8_t *cb_plane = cr_plane + chroma_pitch * ((DecodedOutputHeight(decoder) + 1) / 2);
+    int line = (int)((output - decoder->local_output) / pitch);
+    int row;
+
+    (void) linenum;
+
+    for (row = 0; row < height; row++, line++)
     {
-        uint16_t *input_plane_array[3];
+        size_t chroma_offset = (line / 2) * chroma_pitch;
 
-        for (row = 0; row < height; row++)
-        {
-            input_plane_array[0] = (uint16_t *)&input_row_ptr[0];
-            input_plane_array[1] = (uint16_t *)&input_row_ptr[width];
-            input_plane_array[2] = (uint16_t *)&input_row_ptr[width * 2];
+        ConvertYUV16RowTo420(input, width, planar, (line % 2) == 0,
+                             output, cb_plane + chroma_offset, cr_plane + chroma_offset, 1);
 
-            // Output width must be a multiple of two
-            assert((width % 2) == 0);
+        input += width * 3;
+        output += pitch;
+    }
+}
 
-            // Two columns of input yield one byte of output in the luma plane
-            for (column = 0; column < width; column += 2)
-            {
-                uint32_t Y1_unsigned, Cr_unsigned, Y2_unsigned, Cb_unsigned;
 
-                // Get the luma and chroma components from the separate planes
-                Y1_unsigned = input_plane_array[0][column + 0];
-                Y2_unsigned = input_plane_array[0][column + 1];
-                Cr_unsigned = input_plane_array[1][column + 0] + input_plane_array[1][column + 1];
-                Cb_unsigned = input_plane_array[2][column + 0] + input_plane_array[2][column + 1];
+// Round a 16-bit component to the number of significant bits in the output format
+static inline uint16_t RoundComponent16(uint32_t value, int shift)
+{
+    value += (1 << shift) >> 1;
+    if (value > 65535) value = 65535;
+    return (uint16_t)(value & ~((1 << shift) - 1));
+}
 
-                // Reduce the input components to eight bits
-                Y1_unsigned >>= 8;
-                Y2_unsigned >>= 8;
-                Cr_unsigned >>= 9;
-                Cb_unsigned >>= 9;
+/*!
+	@brief Convert 16-bit YUV 4:4:4 to a luma plane and an interleaved chroma plane
+	with 16-bit components
 
-                // Output two luma components to the upper plane
-                luma_row_ptr[column + 0] = Y1_unsigned;
-                luma_row_ptr[column + 1] = Y2_unsigned;
+	The P010 and P016 formats have 4:2:0 chroma sampling and the P210 and P216
+	formats have 4:2:2 chroma sampling.  The 10-bit formats store the significant
+	bits in the upper bits of each component.  The chroma plane follows the last
+	row of the luma plane and has the same pitch.
 
-                //TODO: Average the chroma rows
-                if ((height == 1 && (linenum % 2) == 1) || (row % 2) == 1)
-                {
-                    // Output two interleaved chroma components to the lower plane
-                    chroma_row_ptr[column + 0] = Cr_unsigned;
-                    chroma_row_ptr[column + 1] = Cb_unsigned;
-                }
-            }
+	As with the NV12 format, the 4:2:0 chroma for a pair of rows is taken from
+	the even row.
+*/
+void ConvertYUV16ToSemiPlanar16(DECODER *decoder,
+                                int width,
+                                int height,
+                                int linenum,
+                                uint16_t *input,
+                                uint8_t *output,
+                                int pitch,
+                                int format,
+                                int whitepoint,
+                                int flags)
+{
+    int planar = (flags & ACTIVEMETADATA_PLANAR);
+    int step = planar ? 1 : 3;
+    bool subsample_rows = (format == COLOR_FORMAT_P010 || format == COLOR_FORMAT_P016);
+    int shift = (format == COLOR_FORMAT_P010 || format == COLOR_FORMAT_P210) ? 6 : 0;
+    uint8_t *chroma_plane = decoder->local_output + pitch * DecodedOutputHeight(decoder);
+    int line = (int)((output - decoder->local_output) / pitch);
+    int row;
 
-            input_row_ptr += input_row_pitch;
-            luma_row_ptr += output_row_pitch;
+    (void) linenum;
+    (void) whitepoint;
 
-            if ((height == 1 && (linenum % 2) == 1) || (row % 2) == 1)
-            {
-                chroma_row_ptr += output_row_pitch;
-            }
-        }
-    }
-    else
+    // Output width must be a multiple of two
+    assert((width % 2) == 0);
+
+    for (row = 0; row < height; row++, line++)
     {
-        //uint16_t *input_plane_array[3];
+        uint16_t *y_input = input;
+        uint16_t *cb_input = planar ? &input[width] : &input[1];
+        uint16_t *cr_input = planar ? &input[width * 2] : &input[2];
+        uint16_t *luma_row_ptr = (uint16_t *)output;
+        uint16_t *chroma_row_ptr;
+        bool store_chroma = !subsample_rows || (line % 2) == 0;
+        int column;
 
-        for (row = 0; row < height; row++)
+        chroma_row_ptr = (uint16_t *)(chroma_plane + (subsample_rows ? line / 2 : line) * pitch);
+
+        for (column = 0; column < width; column += 2)
         {
-            //input_plane_array[0] = (uint16_t *)&input_row_ptr[0];
-            //input_plane_array[1] = (uint16_t *)&input_row_ptr[width];
-            //input_plane_array[2] = (uint16_t *)&input_row_ptr[width*2];
+            int index = column * step;
 
-            // Output width must be a multiple of two
-            assert((width % 2) == 0);
+            luma_row_ptr[column + 0] = RoundComponent16(y_input[index], shift);
+            luma_row_ptr[column + 1] = RoundComponent16(y_input[index + step], shift);
 
-            // Two columns of input yield one byte of output in the luma plane
-            for (column = 0; column < width; column += 2)
+            if (store_chroma)
             {
-                uint32_t Y1_unsigned, Cr_unsigned, Y2_unsigned, Cb_unsigned;
+                uint32_t Cb = (cb_input[index] + cb_input[index + step] + 1) >> 1;
+                uint32_t Cr = (cr_input[index] + cr_input[index + step] + 1) >> 1;
 
-                // Get the luma and chroma components from the row
-                Y1_unsigned = input_row_ptr[column * 3];
-                Y2_unsigned = input_row_ptr[(column + 1) * 3];
-                Cr_unsigned = input_row_ptr[column * 3 + 1] + input_row_ptr[(column + 1) * 3 + 1];
-                Cb_unsigned = input_row_ptr[column * 3 + 2] + input_row_ptr[(column + 1) * 3 + 2];
+                chroma_row_ptr[column + 0] = RoundComponent16(Cb, shift);
+                chroma_row_ptr[column + 1] = RoundComponent16(Cr, shift);
+            }
+        }
 
-                // Reduce the input components to eight bits
-                Y1_unsigned >>= 8;
-                Y2_unsigned >>= 8;
-                Cr_unsigned >>= 9;
-                Cb_unsigned >>= 9;
+        input += width * 3;
+        output += pitch;
+    }
+}
 
-                // Output two luma components to the upper plane
-                luma_row_ptr[column + 0] = Y1_unsigned;
-                luma_row_ptr[column + 1] = Y2_unsigned;
+/*!
+	@brief Convert 16-bit RGB 4:4:4 to separate planes of 16-bit components
 
-                //TODO: Average the chroma rows
-                if ((height == 1 && (linenum % 2) == 1) || (row % 2) == 1)
-                {
-                    // Output two interleaved chroma components to the lower plane
-                    chroma_row_ptr[column + 0] = Cr_unsigned;
-                    chroma_row_ptr[column + 1] = Cb_unsigned;
-                }
+	The planes are stored in the order green, blue, red, and alpha as in the
+	planar RGB formats used by FFmpeg.  Each plane has the output pitch and
+	follows the last row of the previous plane.  The input rows do not carry
+	alpha, so the alpha plane is opaque as in the other RGBA output formats
+	computed from rows of RGB.
+*/
+void ConvertRGB16ToPlanar16(DECODER *decoder,
+                            int width,
+                            int height,
+                            int linenum,
+                            uint16_t *input,
+                            uint8_t *output,
+                            int pitch,
+                            int format,
+                            int whitepoint,
+                            int flags)
+{
+    size_t plane_size = (size_t)pitch * DecodedOutputHeight(decoder);
+    int row;
+
+    (void) linenum;
+    (void) whitepoint;
+
+    for (row = 0; row < height; row++)
+    {
+        uint16_t *g_output = (uint16_t *)output;
+        uint16_t *b_output = (uint16_t *)(output + plane_size);
+        uint16_t *r_output = (uint16_t *)(output + 2 * plane_size);
+        int column;
+
+        if (flags & ACTIVEMETADATA_SRC_8PIXEL_PLANAR)
+        {
+            // Each group of eight pixels is stored as eight red, green, and blue values
+            for (column = 0; column < width; column += 8)
+            {
+                uint16_t *group = &input[column * 3];
+
+                memcpy(&r_output[column], &group[0], 8 * sizeof(uint16_t));
+                memcpy(&g_output[column], &group[8], 8 * sizeof(uint16_t));
+                memcpy(&b_output[column], &group[16], 8 * sizeof(uint16_t));
             }
+        }
+        else if (flags & ACTIVEMETADATA_PLANAR)
+        {
+            memcpy(r_output, &input[0], width * sizeof(uint16_t));
+            memcpy(g_output, &input[width], width * sizeof(uint16_t));
+            memcpy(b_output, &input[width * 2], width * sizeof(uint16_t));
+        }
+        else
+        {
+            for (column = 0; column < width; column++)
+            {
+                r_output[column] = input[3 * column + 0];
+                g_output[column] = input[3 * column + 1];
+                b_output[column] = input[3 * column + 2];
+            }
+        }
 
-            input_row_ptr += input_row_pitch;
-            luma_row_ptr += output_row_pitch;
+        if (format == COLOR_FORMAT_GBRAP16)
+        {
+            uint16_t *a_output = (uint16_t *)(output + 3 * plane_size);
 
-            if ((height == 1 && (linenum % 2) == 1) || (row % 2) == 1)
+            for (column = 0; column < width; column++)
             {
-                chroma_row_ptr += output_row_pitch;
+                a_output[column] = 0xffff;
             }
         }
+
+        input += width * 3;
+        output += pitch;
     }
 }
 
-/*!
-	@brief Convert 16-bit YUV 4:2:2 to luma and chroma planes in YV12 format
+// Convert a single-precision value to half precision with rounding to the nearest even value
+static uint16_t FloatToHalf(float value)
+{
+    union
+    {
+        float f;
+        uint32_t u;
+    } bits;
+    uint32_t sign, exponent, mantissa, half, remainder, midpoint;
+    int shift;
+
+    bits.f = value;
+    sign = (bits.u >> 16) & 0x8000;
+    exponent = (bits.u >> 23) & 0xFF;
+    mantissa = bits.u & 0x7FFFFF;
+
+    // Infinity or not a number
+    if (exponent == 0xFF)
+        return (uint16_t)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+
+    // Too large for half precision
+    if (exponent > 142)
+        return (uint16_t)(sign | 0x7C00);
 
-	The output is an upper plane of 8-bit luma and two lower planes of 8-bit
-	chroma with 4:2:0 sampling.  Each chroma plane is half the height and half
-	the width of the luma plane.
+    // Too small to round to the smallest half-precision denormal
+    if (exponent < 102)
+        return (uint16_t)sign;
 
-	This routine has not been optimized for performance and does not average the
-	chroma rows when downsampling to 4:2:0.
+    if (exponent < 113)
+    {
+        // Denormal in half precision
+        mantissa |= 0x800000;
+        shift = 126 - exponent;
+        half = mantissa >> shift;
+    }
+    else
+    {
+        shift = 13;
+        half = ((exponent - 112) << 10) | (mantissa >> shift);
+    }
+
+    // A carry out of the mantissa correctly increments the exponent
+    remainder = mantissa & ((1 << shift) - 1);
+    midpoint = 1 << (shift - 1);
+    if (remainder > midpoint || (remainder == midpoint && (half & 1)))
+        half++;
+
+    return (uint16_t)(sign | half);
+}
+
+#if _AVX2OPT
+/*!
+	@brief Convert eight pixels per iteration from rows of 16-bit RGB(A) to
+	floating point
+
+	Only the planar row layouts are converted.  Returns the number of pixels
+	converted, which is a multiple of eight.
 */
-void ConvertYUV16ToYV12(DECODER *decoder,
-                        int width,
-                        int height,
-                        int linenum,
-                        uint16_t *input,
-                        uint8_t *output,
-                        int pitch,
-                        int format,
-                        int whitepoint,
-                        int flags)
+static int TARGET_F16C ConvertRGB16RowToFloatF16C(uint16_t *input, int width, int num_channels,
+        int flags, int is_signed, float scale, int format,
+        uint8_t *output, size_t plane_size)
 {
-    int planar = (flags & ACTIVEMETADATA_PLANAR);
-    uint16_t *input_row_ptr = input;
-    uint8_t *Y_row_ptr = output;
-    uint8_t *V_row_ptr = Y_row_ptr + width * height;
-    uint8_t *U_row_ptr = V_row_ptr + (width * height) / 4;
-    int input_row_pitch = width * 3;
-    int Y_row_pitch = width;
-    int V_row_pitch = width / 2;
-    int U_row_pitch = width / 2;
-    int row, column;
+    const __m256 scale_ps = _mm256_set1_ps(scale);
+    const __m256 zero_ps = _mm256_setzero_ps();
+    const __m256 one_ps = _mm256_set1_ps(1.0f);
+    int group_size = 8 * num_channels;
+    int column;
 
-    // The routine processes a single row or an even number of rows
-    assert(height == 1 || ((height % 2) == 0));
+    if (!(flags & (ACTIVEMETADATA_SRC_8PIXEL_PLANAR | ACTIVEMETADATA_PLANAR)))
+        return 0;
 
-    if (planar)
+    for (column = 0; column + 8 <= width; column += 8)
     {
-        uint16_t *input_plane_array[3];
+        __m128i component_epi16[4];
+        __m256 component_ps[4];
+        __m256 r_ps, g_ps, b_ps, a_ps;
+        int channel;
 
-        for (row = 0; row < height; row++)
+        for (channel = 0; channel < num_channels; channel++)
         {
-            input_plane_array[0] = (uint16_t *)&input_row_ptr[0];
-            input_plane_array[1] = (uint16_t *)&input_row_ptr[width];
-            input_plane_array[2] = (uint16_t *)&input_row_ptr[width * 2];
-
-            // Output width must be a multiple of two
-            assert((width % 2) == 0);
-
-            // Two columns of input yield one byte of output in the luma plane
-            for (column = 0; column < width; column += 2)
-            {
-                uint16_t Y1_unsigned, Cr_unsigned, Y2_unsigned, Cb_unsigned;
+            uint16_t *component;
 
-                // Get the luma and chroma components from the separate planes
-                Y1_unsigned = input_plane_array[0][column + 0];
-                Y2_unsigned = input_plane_array[0][column + 1];
-                Cr_unsigned = input_plane_array[1][column + 0];
-                Cb_unsigned = input_plane_array[2][column + 0];
+            if (flags & ACTIVEMETADATA_SRC_8PIXEL_PLANAR)
+                component = &input[(column / 8) * group_size + channel * 8];
+            else
+                component = &input[channel * width + column];
 
-                // Reduce the input components to eight bits
-                Y1_unsigned >>= 8;
-                Y2_unsigned >>= 8;
-                Cr_unsigned >>= 8;
-                Cb_unsigned >>= 8;
+            component_epi16[channel] = _mm_loadu_si128((__m128i *)component);
+        }
 
-                // Output two luma components to the upper plane
-                Y_row_ptr[column + 0] = (uint8_t)Y1_unsigned;
-                Y_row_ptr[column + 1] = (uint8_t)Y2_unsigned;
+        for (channel = 0; channel < num_channels; channel++)
+        {
+            __m128i extend_epi16 = is_signed ? _mm_srai_epi16(component_epi16[channel], 15) : _mm_setzero_si128();
+            __m128i lo_epi32 = _mm_unpacklo_epi16(component_epi16[channel], extend_epi16);
+            __m128i hi_epi32 = _mm_unpackhi_epi16(component_epi16[channel], extend_epi16);
+            __m256i value_epi32 = _mm256_insertf128_si256(_mm256_castsi128_si256(lo_epi32), hi_epi32, 1);
 
-                //TODO: Average the chroma rows
-                if ((height == 1 && (linenum % 2) == 1) || (row % 2) == 1)
-                {
-                    // Output two interleaved chroma components to the lower plane
-                    U_row_ptr[column / 2] = (uint8_t)Cb_unsigned;
-                    V_row_ptr[column / 2] = (uint8_t)Cr_unsigned;
-                }
-            }
+            component_ps[channel] = _mm256_mul_ps(_mm256_cvtepi32_ps(value_epi32), scale_ps);
+        }
 
-            input_row_ptr += input_row_pitch;
-            Y_row_ptr += Y_row_pitch;
+        r_ps = component_ps[0];
+        g_ps = component_ps[1];
+        b_ps = component_ps[2];
+        a_ps = (num_channels == 4) ? _mm256_min_ps(_mm256_max_ps(component_ps[3], zero_ps), one_ps) : one_ps;
 
-            if ((height == 1 && (linenum % 2) == 1) || (row % 2) == 1)
-            {
-                U_row_ptr += U_row_pitch;
-                V_row_ptr += V_row_pitch;
-            }
+        if (format == COLOR_FORMAT_GBRAP_FLOAT)
+        {
+            _mm256_storeu_ps((float *)output + column, g_ps);
+            _mm256_storeu_ps((float *)(output + plane_size) + column, b_ps);
+            _mm256_storeu_ps((float *)(output + 2 * plane_size) + column, r_ps);
+            _mm256_storeu_ps((float *)(output + 3 * plane_size) + column, a_ps);
+        }
+        else if (format == COLOR_FORMAT_RGBA_HALF)
+        {
+            __m128i r_epi16 = _mm256_cvtps_ph(r_ps, 0);
+            __m128i g_epi16 = _mm256_cvtps_ph(g_ps, 0);
+            __m128i b_epi16 = _mm256_cvtps_ph(b_ps, 0);
+            __m128i a_epi16 = _mm256_cvtps_ph(a_ps, 0);
+            __m128i rg_epi16 = _mm_unpacklo_epi16(r_epi16, g_epi16);
+            __m128i ba_epi16 = _mm_unpacklo_epi16(b_epi16, a_epi16);
+            __m128i *rgba_ptr = (__m128i *)(output + column * 8);
+
+            _mm_storeu_si128(rgba_ptr + 0, _mm_unpacklo_epi32(rg_epi16, ba_epi16));
+            _mm_storeu_si128(rgba_ptr + 1, _mm_unpackhi_epi32(rg_epi16, ba_epi16));
+
+            rg_epi16 = _mm_unpackhi_epi16(r_epi16, g_epi16);
+            ba_epi16 = _mm_unpackhi_epi16(b_epi16, a_epi16);
+
+            _mm_storeu_si128(rgba_ptr + 2, _mm_unpacklo_epi32(rg_epi16, ba_epi16));
+            _mm_storeu_si128(rgba_ptr + 3, _mm_unpackhi_epi32(rg_epi16, ba_epi16));
+        }
+        else
+        {
+            // Transpose the components into pixels (each lane holds pixels n and n + 4)
+            __m256 rg_lo_ps = _mm256_unpacklo_ps(r_ps, g_ps);
+            __m256 ba_lo_ps = _mm256_unpacklo_ps(b_ps, a_ps);
+            __m256 rg_hi_ps = _mm256_unpackhi_ps(r_ps, g_ps);
+            __m256 ba_hi_ps = _mm256_unpackhi_ps(b_ps, a_ps);
+            __m256 pixel0_ps = _mm256_shuffle_ps(rg_lo_ps, ba_lo_ps, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 pixel1_ps = _mm256_shuffle_ps(rg_lo_ps, ba_lo_ps, _MM_SHUFFLE(3, 2, 3, 2));
+            __m256 pixel2_ps = _mm256_shuffle_ps(rg_hi_ps, ba_hi_ps, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 pixel3_ps = _mm256_shuffle_ps(rg_hi_ps, ba_hi_ps, _MM_SHUFFLE(3, 2, 3, 2));
+            float *rgba_ptr = (float *)(output + column * 16);
+
+            _mm256_storeu_ps(rgba_ptr + 0, _mm256_permute2f128_ps(pixel0_ps, pixel1_ps, 0x20));
+            _mm256_storeu_ps(rgba_ptr + 8, _mm256_permute2f128_ps(pixel2_ps, pixel3_ps, 0x20));
+            _mm256_storeu_ps(rgba_ptr + 16, _mm256_permute2f128_ps(pixel0_ps, pixel1_ps, 0x31));
+            _mm256_storeu_ps(rgba_ptr + 24, _mm256_permute2f128_ps(pixel2_ps, pixel3_ps, 0x31));
         }
     }
-    else
+
+    return column;
+}
+#endif
+
+/*!
+	@brief Convert 16-bit RGB(A) 4:4:4(:4) to RGBA with floating-point components
+
+	The components are scaled so that the white point is one.  Rows decoded
+	with a white point less than 16 bits contain signed values, so values
+	outside the nominal range are preserved.  The alpha is clamped to the
+	range zero to one and is opaque if the input rows do not carry alpha.
+
+	The packed formats are RGBA with 16-bit or 32-bit floating-point components.
+	The planar format stores planes of 32-bit floating-point green, blue, red,
+	and alpha in the same order as the GBRAP16 format.
+*/
+void ConvertRGB16ToFloat(DECODER *decoder,
+                         int width,
+                         int height,
+                         int linenum,
+                         uint16_t *input,
+                         uint8_t *output,
+                         int pitch,
+                         int format,
+                         int whitepoint,
+                         int flags,
+                         int num_channels)
+{
+    size_t plane_size = (size_t)pitch * DecodedOutputHeight(decoder);
+    int is_signed = (whitepoint != 16 && whitepoint != 0);
+    float scale = 1.0f / (float)((1 << (is_signed ? whitepoint : 16)) - 1);
+    int group_size = 8 * num_channels;
+#if _AVX2OPT
+    int use_f16c = ((GetProcessorFeatures() & (_CPU_FEATURE_AVX | _CPU_FEATURE_F16C)) ==
+                    (_CPU_FEATURE_AVX | _CPU_FEATURE_F16C));
+#endif
+    int row;
+
+    (void) linenum;
+
+    assert(num_channels == 3 || num_channels == 4);
+
+    for (row = 0; row < height; row++)
     {
-        //uint16_t *input_plane_array[3];
+        int column = 0;
 
-        for (row = 0; row < height; row++)
+#if _AVX2OPT
+        if (use_f16c)
         {
-            //input_plane_array[0] = (uint16_t *)&input_row_ptr[0];
-            //input_plane_array[1] = (uint16_t *)&input_row_ptr[width];
-            //input_plane_array[2] = (uint16_t *)&input_row_ptr[width*2];
+            column = ConvertRGB16RowToFloatF16C(input, width, num_channels, flags, is_signed,
+                                                scale, format, output, plane_size);
+        }
+#endif
 
-            // Output width must be a multiple of two
-            assert((width % 2) == 0);
+        for (; column < width; column++)
+        {
+            float component[4];
+            int offset[4];
+            int channel;
 
-            // Two columns of input yield one byte of output in the luma plane
-            for (column = 0; column < width; column += 2)
+            for (channel = 0; channel < num_channels; channel++)
             {
-                uint16_t Y1_unsigned, Cr_unsigned, Y2_unsigned, Cb_unsigned;
+                if (flags & ACTIVEMETADATA_SRC_8PIXEL_PLANAR)
+                    offset[channel] = (column / 8) * group_size + channel * 8 + (column % 8);
+                else if (flags & ACTIVEMETADATA_PLANAR)
+                    offset[channel] = channel * width + column;
+                else
+                    offset[channel] = column * num_channels + channel;
 
-                // Get the luma and chroma components from the row
-                Y1_unsigned = input_row_ptr[column * 3];
-                Y2_unsigned = input_row_ptr[(column + 1) * 3];
-                Cr_unsigned = input_row_ptr[column * 3 + 1];
-                Cb_unsigned = input_row_ptr[column * 3 + 2];
+                if (is_signed)
+                    component[channel] = (float)((int16_t)input[offset[channel]]) * scale;
+                else
+                    component[channel] = (float)input[offset[channel]] * scale;
+            }
 
-                // Reduce the input components to eight bits
-                Y1_unsigned >>= 8;
-                Y2_unsigned >>= 8;
-                Cr_unsigned >>= 8;
-                Cb_unsigned >>= 8;
+            if (num_channels == 4)
+            {
+                if (component[3] < 0.0f) component[3] = 0.0f;
+                if (component[3] > 1.0f) component[3] = 1.0f;
+            }
+            else
+            {
+                component[3] = 1.0f;
+            }
 
-                // Output two luma components to the upper plane
-                Y_row_ptr[column + 0] = (uint8_t)Y1_unsigned;
-                Y_row_ptr[column + 1] = (uint8_t)Y2_unsigned;
+            if (format == COLOR_FORMAT_GBRAP_FLOAT)
+            {
+                ((float *)output)[column] = component[1];
+                ((float *)(output + plane_size))[column] = component[2];
+                ((float *)(output + 2 * plane_size))[column] = component[0];
+                ((float *)(output + 3 * plane_size))[column] = component[3];
+            }
+            else if (format == COLOR_FORMAT_RGBA_HALF)
+            {
+                uint16_t *rgba_ptr = (uint16_t *)output + column * 4;
 
-                //TODO: Average the chroma rows
-                if ((height == 1 && (linenum % 2) == 1) || (row % 2) == 1)
+                for (channel = 0; channel < 4; channel++)
                 {
-                    // Output two interleaved chroma components to the lower plane
-                    U_row_ptr[column / 2] = (uint8_t)Cb_unsigned;
-                    V_row_ptr[column / 2] = (uint8_t)Cr_unsigned;
+                    rgba_ptr[channel] = FloatToHalf(component[channel]);
                 }
             }
-
-            input_row_ptr += input_row_pitch;
-            Y_row_ptr += Y_row_pitch;
-
-            if ((height == 1 && (linenum % 2) == 1) || (row % 2) == 1)
+            else
             {
-                U_row_ptr += U_row_pitch;
-                V_row_ptr += V_row_pitch;
+                memcpy((float *)output + column * 4, component, sizeof(component));
             }
         }
+
+        input += width * num_channels;
+        output += pitch;
     }
 }
 
 
-
 bool ConvertPreformatted3D(DECODER *decoder, int use_local_buffer, int internal_format, int channel_mask, uint8_t *local_output, int local_pitch, int *channel_offset_ptr)
 {
     bool ret = true;
@@ -44,7 +44,13 @@
 			(colorformat & 0x7fffffff) == COLOR_FORMAT_CbYCrY_16bit || \
 			(colorformat & 0x7fffffff) == COLOR_FORMAT_CbYCrY_10bit_2_8 || \
 			(colorformat & 0x7fffffff) == COLOR_FORMAT_CbYCrY_16bit_2_14 || \
-			(colorformat & 0x7fffffff) == COLOR_FORMAT_CbYCrY_16bit_10_6)
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_CbYCrY_16bit_10_6 || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_NV12 || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_YV12 || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_P010 || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_P016 || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_P210 || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_P216)
 
 #define FORMATRGB(colorformat) \
 		   ((colorformat & 0x7fffffff) == COLOR_FORMAT_RGB24 || \
@@ -62,6 +68,11 @@
 			(colorformat & 0x7fffffff) == COLOR_FORMAT_AB10 || \
 			(colorformat & 0x7fffffff) == COLOR_FORMAT_WP13 || \
 			(colorformat & 0x7fffffff) == COLOR_FORMAT_W13A || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_GBRP16 || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_GBRAP16 || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_RGBA_HALF || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_RGBA_FLOAT || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_GBRAP_FLOAT || \
 			(colorformat & 0x7fffffff) == COLOR_FORMAT_RGB_8PIXEL_PLANAR)
 
 #define INVERTEDFORMAT(colorformat) \
@@ -78,6 +89,16 @@
 			colorformat == COLOR_FORMAT_V408 || \
 			colorformat == COLOR_FORMAT_V210 || \
 			colorformat == COLOR_FORMAT_NV12 || \
+			colorformat == COLOR_FORMAT_YV12 || \
+			colorformat == COLOR_FORMAT_P010 || \
+			colorformat == COLOR_FORMAT_P016 || \
+			colorformat == COLOR_FORMAT_P210 || \
+			colorformat == COLOR_FORMAT_P216 || \
+			colorformat == COLOR_FORMAT_GBRP16 || \
+			colorformat == COLOR_FORMAT_GBRAP16 || \
+			colorformat == COLOR_FORMAT_RGBA_HALF || \
+			colorformat == COLOR_FORMAT_RGBA_FLOAT || \
+			colorformat == COLOR_FORMAT_GBRAP_FLOAT || \
 			colorformat == COLOR_FORMAT_YU64 || \
 			colorformat == COLOR_FORMAT_YR16 || \
 			colorformat == COLOR_FORMAT_RG48 || \
@@ -115,6 +136,9 @@
 			(colorformat & 0x7fffffff) == COLOR_FORMAT_RG64 || \
 			(colorformat & 0x7fffffff) == COLOR_FORMAT_B64A || \
 			(colorformat & 0x7fffffff) == COLOR_FORMAT_W13A || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_RGBA_HALF || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_RGBA_FLOAT || \
+			(colorformat & 0x7fffffff) == COLOR_FORMAT_GBRAP_FLOAT || \
 			(colorformat & 0x7fffffff) == COLOR_FORMAT_R408 || \
 			(colorformat & 0x7fffffff) == COLOR_FORMAT_V408)
 
@@ -483,6 +507,40 @@ void ConvertYUV16ToYV12(DECODER *decoder,
                         int whitepoint,
                         int flags);
 
+void ConvertYUV16ToSemiPlanar16(DECODER *decoder,
+                                int width,
+                                int height,
+                                int linenum,
+                                uint16_t *input,
+                                uint8_t *output,
+                                int pitch,
+                                int format,
+                                int whitepoint,
+                                int flags);
+
+void ConvertRGB16ToPlanar16(DECODER *decoder,
+                            int width,
+                            int height,
+                            int linenum,
+                            uint16_t *input,
+                            uint8_t *output,
+                            int pitch,
+                            int format,
+                            int whitepoint,
+                            int flags);
+
+void ConvertRGB16ToFloat(DECODER *decoder,
+                         int width,
+                         int height,
+                         int linenum,
+                         uint16_t *input,
+                         uint8_t *output,
+                         int pitch,
+                         int format,
+                         int whitepoint,
+                         int flags,
+                         int num_channels);
+
 bool ConvertPreformatted3D(DECODER *decoder,
                            int use_local_buffer,
                            int internal_format,
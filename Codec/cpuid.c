@@ -40,6 +40,17 @@
 // This bit is set when cpuid is called with register set to 80000001h (only applicable to AMD)
 #define _3DNOW_FEATURE_BIT      0x80000000
 
+// These are the bit flags in register ecx after calling cpuid with register eax set to 1
+#define _PCLMUL_FEATURE_BIT     0x00000002
+#define _SSE41_FEATURE_BIT      0x00080000
+#define _SSE42_FEATURE_BIT      0x00100000
+#define _OSXSAVE_FEATURE_BIT    0x08000000
+#define _AVX_FEATURE_BIT        0x10000000
+#define _F16C_FEATURE_BIT       0x20000000
+
+// This bit is set in register ebx when cpuid is called with register eax set to 7
+#define _AVX2_FEATURE_BIT       0x00000020
+
 #ifdef _WIN32
 
 int GetProcessorCount()
@@ -96,3 +107,95 @@ int GetProcessorCount()
 }
 
 #endif
+
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static void ProcessorInfo(unsigned int info[4], unsigned int leaf, unsigned int subleaf)
+{
+#ifdef _MSC_VER
+    __cpuidex((int *)info, leaf, subleaf);
+#else
+    __asm__ __volatile__ ("cpuid"
+                          : "=a" (info[0]), "=b" (info[1]), "=c" (info[2]), "=d" (info[3])
+                          : "a" (leaf), "c" (subleaf));
+#endif
+}
+
+// Return the register state that the operating system saves on a context switch
+static unsigned int ProcessorExtendedState()
+{
+#ifdef _MSC_VER
+    return (unsigned int)_xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+    return eax;
+#endif
+}
+
+static int DetectProcessorFeatures()
+{
+    unsigned int info[4];
+    unsigned int max_leaf;
+    int features = 0;
+
+    ProcessorInfo(info, 0, 0);
+    max_leaf = info[0];
+    if (max_leaf < 1)
+    {
+        return 0;
+    }
+
+    ProcessorInfo(info, 1, 0);
+
+    if (info[3] & _MMX_FEATURE_BIT) features |= _CPU_FEATURE_MMX;
+    if (info[3] & _SSE_FEATURE_BIT) features |= _CPU_FEATURE_SSE;
+    if (info[3] & _SSE2_FEATURE_BIT) features |= _CPU_FEATURE_SSE2;
+    if (info[2] & _SSE41_FEATURE_BIT) features |= _CPU_FEATURE_SSE41;
+    if (info[2] & _SSE42_FEATURE_BIT) features |= _CPU_FEATURE_SSE42;
+    if (info[2] & _PCLMUL_FEATURE_BIT) features |= _CPU_FEATURE_PCLMUL;
+
+    // The AVX registers can only be used if the operating system saves them
+    if ((info[2] & _OSXSAVE_FEATURE_BIT) && (info[2] & _AVX_FEATURE_BIT) &&
+            (ProcessorExtendedState() & 0x06) == 0x06)
+    {
+        features |= _CPU_FEATURE_AVX;
+
+        if (info[2] & _F16C_FEATURE_BIT) features |= _CPU_FEATURE_F16C;
+
+        if (max_leaf >= 7)
+        {
+            ProcessorInfo(info, 7, 0);
+            if (info[1] & _AVX2_FEATURE_BIT) features |= _CPU_FEATURE_AVX2;
+        }
+    }
+
+    return features;
+}
+
+#else
+
+static int DetectProcessorFeatures()
+{
+    return 0;
+}
+
+#endif
+
+int GetProcessorFeatures()
+{
+    // The result is the same for every thread so a race on the first call is harmless
+    static volatile int processor_features = -1;
+
+    if (processor_features < 0)
+    {
+        processor_features = DetectProcessorFeatures();
+    }
+
+    return processor_features;
+}
@@ -27,6 +27,12 @@
 #define _CPU_FEATURE_SSE    0x0002
 #define _CPU_FEATURE_SSE2   0x0004
 #define _CPU_FEATURE_3DNOW  0x0008
+#define _CPU_FEATURE_SSE41  0x0010
+#define _CPU_FEATURE_SSE42  0x0020
+#define _CPU_FEATURE_AVX    0x0040
+#define _CPU_FEATURE_AVX2   0x0080
+#define _CPU_FEATURE_F16C   0x0100
+#define _CPU_FEATURE_PCLMUL 0x0200
 
 #define _MAX_VNAME_LEN  13
 #define _MAX_MNAME_LEN  30
@@ -37,6 +43,9 @@ extern "C" {
 
 int GetProcessorCount();
 
+// Return the _CPU_FEATURE_* flags for the instruction sets supported by the processor and operating system
+int GetProcessorFeatures();
+
 #ifdef __cplusplus
 }
 #endif
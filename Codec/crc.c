@@ -0,0 +1,331 @@
+/*!
+ * @file crc.c
+ * @brief Cyclic redundancy checks used for look files, metadata, and samples
+ *
+ * The CRC-32 identifies look files and metadata, so its values must not change.
+ * The CRC-32C is used for sample checksums because it is computed by a single
+ * instruction on processors with SSE4.2.  Both checks fall back to a table that
+ * processes eight bytes per iteration (slicing-by-8).  The CRC-32 is computed by
+ * folding the buffer with carry-less multiplication on processors with PCLMUL.
+ *
+ * (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+ *
+ * Licensed under either:
+ * - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+ * - MIT license, http://opensource.org/licenses/MIT
+ * at your option.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stdafx.h"
+#include "config.h"
+#include "thread.h"
+#include "cpuid.h"
+#include "crc.h"
+
+#if _AVX2OPT
+#include <nmmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+// Polynomials in the bit order used by the table (least significant bit first)
+#define CRC32_POLYNOMIAL	0xEDB88320
+#define CRC32C_POLYNOMIAL	0x82F63B78
+
+// Smallest buffer that is folded using carry-less multiplication
+#define CRC32_FOLD_MINIMUM	64
+
+typedef uint32_t (* CRC_UPDATE_PROC)(uint32_t crc, const uint8_t *buffer, size_t size);
+
+static struct crc_state
+{
+    uint32_t crc32_table[8][256];		// Tables for the CRC-32
+    uint32_t crc32c_table[8][256];		// Tables for the CRC-32C
+
+    CRC_UPDATE_PROC crc32_update;		// Fastest CRC-32 implementation for this processor
+    CRC_UPDATE_PROC crc32c_update;		// Fastest CRC-32C implementation for this processor
+
+} crc_state;
+
+static void MakeTable(uint32_t table[8][256], uint32_t polynomial)
+{
+    uint32_t c;
+    int n, k;
+
+    for (n = 0; n < 256; n++)
+    {
+        c = (uint32_t)n;
+        for (k = 0; k < 8; k++)
+        {
+            if (c & 1)
+                c = polynomial ^ (c >> 1);
+            else
+                c = c >> 1;
+        }
+        table[0][n] = c;
+    }
+
+    // Each table advances the CRC by one more byte of zeros
+    for (n = 0; n < 256; n++)
+    {
+        c = table[0][n];
+        for (k = 1; k < 8; k++)
+        {
+            c = table[0][c & 0xFF] ^ (c >> 8);
+            table[k][n] = c;
+        }
+    }
+}
+
+// Update the CRC register using the tables (the register is the complement of the CRC)
+static uint32_t UpdateSliced(uint32_t table[8][256], uint32_t crc, const uint8_t *buffer, size_t size)
+{
+    while (size >= 8)
+    {
+        uint32_t one = crc ^ (buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | ((uint32_t)buffer[3] << 24));
+        uint32_t two = buffer[4] | (buffer[5] << 8) | (buffer[6] << 16) | ((uint32_t)buffer[7] << 24);
+
+        crc = table[7][one & 0xFF] ^ table[6][(one >> 8) & 0xFF] ^
+              table[5][(one >> 16) & 0xFF] ^ table[4][one >> 24] ^
+              table[3][two & 0xFF] ^ table[2][(two >> 8) & 0xFF] ^
+              table[1][(two >> 16) & 0xFF] ^ table[0][two >> 24];
+
+        buffer += 8;
+        size -= 8;
+    }
+
+    while (size > 0)
+    {
+        crc = table[0][(crc ^ *(buffer++)) & 0xFF] ^ (crc >> 8);
+        size--;
+    }
+
+    return crc;
+}
+
+static uint32_t UpdateCRC32Sliced(uint32_t crc, const uint8_t *buffer, size_t size)
+{
+    return UpdateSliced(crc_state.crc32_table, crc, buffer, size);
+}
+
+static uint32_t UpdateCRC32CSliced(uint32_t crc, const uint8_t *buffer, size_t size)
+{
+    return UpdateSliced(crc_state.crc32c_table, crc, buffer, size);
+}
+
+#if _AVX2OPT
+
+/*!
+    @brief Fold the buffer into the CRC-32 register using carry-less multiplication
+
+    The size must be a multiple of 16 bytes and at least 64 bytes.  The constants
+    are the powers of x modulo the polynomial from the Intel white paper "Fast CRC
+    Computation for Generic Polynomials Using PCLMULQDQ Instruction".
+*/
+TARGET_PCLMUL static uint32_t FoldCRC32(uint32_t crc, const uint8_t *buffer, size_t size)
+{
+    const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596LL, 0x0154442BD4LL);
+    const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009ELL, 0x01751997D0LL);
+    const __m128i k5k0 = _mm_set_epi64x(0, 0x0163CD6124LL);
+    const __m128i poly = _mm_set_epi64x(0x01F7011641LL, 0x01DB710641LL);
+    const __m128i mask = _mm_setr_epi32(~0, 0, ~0, 0);
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+    x1 = _mm_loadu_si128((const __m128i *)(buffer + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *)(buffer + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *)(buffer + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *)(buffer + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    buffer += 64;
+    size -= 64;
+
+    // Fold four blocks of 16 bytes in parallel
+    x0 = k1k2;
+    while (size >= 64)
+    {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(buffer + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(buffer + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(buffer + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(buffer + 0x30)));
+
+        buffer += 64;
+        size -= 64;
+    }
+
+    // Fold the four blocks into one block
+    x0 = k3k4;
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    // Fold the remaining blocks of 16 bytes
+    while (size >= 16)
+    {
+        x2 = _mm_loadu_si128((const __m128i *)buffer);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        buffer += 16;
+        size -= 16;
+    }
+
+    // Reduce 128 bits to 64 bits
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+    x0 = k5k0;
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x0 = poly;
+    x2 = _mm_and_si128(x1, mask);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, mask);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+static uint32_t UpdateCRC32Folded(uint32_t crc, const uint8_t *buffer, size_t size)
+{
+    if (size >= CRC32_FOLD_MINIMUM)
+    {
+        size_t folded = size & ~(size_t)15;
+        crc = FoldCRC32(crc, buffer, folded);
+        buffer += folded;
+        size -= folded;
+    }
+
+    return UpdateSliced(crc_state.crc32_table, crc, buffer, size);
+}
+
+TARGET_SSE42 static uint32_t UpdateCRC32CHardware(uint32_t crc, const uint8_t *buffer, size_t size)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    uint64_t crc64 = crc;
+
+    for (; size >= 8; size -= 8, buffer += 8)
+    {
+        uint64_t word;
+        memcpy(&word, buffer, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+
+    crc = (uint32_t)crc64;
+#endif
+
+    for (; size >= 4; size -= 4, buffer += 4)
+    {
+        uint32_t word;
+        memcpy(&word, buffer, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+
+    for (; size > 0; size--, buffer++)
+    {
+        crc = _mm_crc32_u8(crc, *buffer);
+    }
+
+    return crc;
+}
+
+#endif
+
+static void InitializeState(void)
+{
+    MakeTable(crc_state.crc32_table, CRC32_POLYNOMIAL);
+    MakeTable(crc_state.crc32c_table, CRC32C_POLYNOMIAL);
+
+    crc_state.crc32_update = UpdateCRC32Sliced;
+    crc_state.crc32c_update = UpdateCRC32CSliced;
+
+#if _AVX2OPT
+    if ((GetProcessorFeatures() & (_CPU_FEATURE_SSE41 | _CPU_FEATURE_PCLMUL)) == (_CPU_FEATURE_SSE41 | _CPU_FEATURE_PCLMUL))
+    {
+        crc_state.crc32_update = UpdateCRC32Folded;
+    }
+
+    if (GetProcessorFeatures() & _CPU_FEATURE_SSE42)
+    {
+        crc_state.crc32c_update = UpdateCRC32CHardware;
+    }
+#endif
+}
+
+#ifdef _WIN32
+static INIT_ONCE crc_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK CRCInitialize(PINIT_ONCE once, PVOID param, PVOID *context)
+{
+    (void) once;
+    (void) param;
+    (void) context;
+
+    InitializeState();
+    return TRUE;
+}
+
+static void CRCInitializeOnce(void)
+{
+    InitOnceExecuteOnce(&crc_once, CRCInitialize, NULL, NULL);
+}
+#else
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static void CRCInitializeOnce(void)
+{
+    pthread_once(&crc_once, InitializeState);
+}
+#endif
+
+uint32_t UpdateCRC32(uint32_t crc, const void *buffer, size_t size)
+{
+    CRCInitializeOnce();
+    return ~crc_state.crc32_update(~crc, (const uint8_t *)buffer, size);
+}
+
+uint32_t CalculateCRC32(const void *buffer, size_t size)
+{
+    return UpdateCRC32(0, buffer, size);
+}
+
+uint32_t UpdateCRC32C(uint32_t crc, const void *buffer, size_t size)
+{
+    CRCInitializeOnce();
+    return ~crc_state.crc32c_update(~crc, (const uint8_t *)buffer, size);
+}
+
+uint32_t CalculateCRC32C(const void *buffer, size_t size)
+{
+    return UpdateCRC32C(0, buffer, size);
+}
@@ -0,0 +1,45 @@
+/*!
+ * @file crc.h
+ * @brief Cyclic redundancy checks used for look files, metadata, and samples
+ *
+ * (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+ *
+ * Licensed under either:
+ * - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+ * - MIT license, http://opensource.org/licenses/MIT
+ * at your option.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _CRC_H
+#define _CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Update the CRC-32 (polynomial 0x04C11DB7 as used by zlib) with the bytes in the buffer
+uint32_t UpdateCRC32(uint32_t crc, const void *buffer, size_t size);
+
+// Return the CRC-32 of the bytes in the buffer (the CRC stored with look files)
+uint32_t CalculateCRC32(const void *buffer, size_t size);
+
+// Update the CRC-32C (Castagnoli polynomial 0x1EDC6F41) with the bytes in the buffer
+uint32_t UpdateCRC32C(uint32_t crc, const void *buffer, size_t size);
+
+// Return the CRC-32C of the bytes in the buffer (the checksum used for samples)
+uint32_t CalculateCRC32C(const void *buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -66,6 +66,7 @@
 #include "swap.h"
 #include "RGB2YUV.h"
 #include "lutpath.h"
+#include "lutcache.h"
 
 extern void FastVignetteInplaceWP13(DECODER *decoder, int displayWidth, int width, int height, int y, float r1, float r2, float gain,
                                     int16_t *sptr, int resolution, int pixelsize);
@@ -249,6 +250,17 @@ static int PixelSize(int format)
     {
         pixel_size = 8;
     }
+    else if (COLOR_FORMAT_P010 <= format && format <= COLOR_FORMAT_GBRAP16)
+    {
+        // Size of the pixels in the first plane
+        pixel_size = 2;
+    }
+    else if (format == COLOR_FORMAT_RGBA_HALF)
+        pixel_size = 8;
+    else if (format == COLOR_FORMAT_RGBA_FLOAT)
+        pixel_size = 16;
+    else if (format == COLOR_FORMAT_GBRAP_FLOAT)
+        pixel_size = 4;
 
     return pixel_size;
 }
@@ -568,6 +580,16 @@ void ClearDecoder(DECODER *decoder)
         decoder->aligned_sample_buffer_size = 0;
     }
 
+    if (decoder->sample_layout)
+    {
+#if _ALLOCATOR
+        Free(decoder->allocator, decoder->sample_layout);
+#else
+        MEMORY_FREE(decoder->sample_layout);
+#endif
+        decoder->sample_layout = NULL;
+    }
+
     if (decoder->tools)
     {
 #if _ALLOCATOR
@@ -610,6 +632,17 @@ void ClearDecoder(DECODER *decoder)
     }
     decoder->threads_buffer_size = 0;
 
+    if (decoder->decoded_rows.row_written)
+    {
+#if _ALLOCATOR
+        Free(decoder->allocator, decoder->decoded_rows.row_written);
+#else
+        MEMORY_FREE(decoder->decoded_rows.row_written);
+#endif
+        decoder->decoded_rows.row_written = NULL;
+        decoder->decoded_rows.row_written_size = 0;
+    }
+
     // Do not attempt to free the codebooks since the
     // codebook pointers are references to static tables
 
@@ -769,10 +802,10 @@ void ClearDecoder(DECODER *decoder)
         decoder->GammaContrastBlu = NULL;
     }
 
-    //3d LUT
+    //3d LUT (shared with other decoders through the look table cache)
     {
         if (decoder->LUTcache)
-            Free(decoder->allocator, decoder->LUTcache);
+            LUTCacheRelease(decoder->LUTcache);
         decoder->LUTcache = NULL;
         decoder->LUTcacheCRC = 0;
     }
@@ -847,10 +880,10 @@ void ClearDecoder(DECODER *decoder)
         decoder->GammaContrastBlu = NULL;
     }
 
-    //3d LUT
+    //3d LUT (shared with other decoders through the look table cache)
     {
         if (decoder->LUTcache)
-            MEMORY_FREE(decoder->LUTcache);
+            LUTCacheRelease(decoder->LUTcache);
         decoder->LUTcache = NULL;
         decoder->LUTcacheCRC = 0;
     }
@@ -1291,6 +1324,12 @@ bool DecodeInit(DECODER *decoder, int width, int height, int format, int resolut
         width = width / 4;
         height = height / 4;
     }
+    else if (resolution == DECODED_RESOLUTION_LOWPASS_ONLY)
+    {
+        // Only the lowpass bands at the top of the wavelet tree are decoded
+        width = width / 8;
+        height = height / 8;
+    }
 
     // Initialize the codebooks
 #if _ALLOCATOR
@@ -1585,6 +1624,9 @@ CODEC_ERROR ReconstructSampleFrameBayerFullToBuffer(DECODER *decoder, FRAME_INFO
 CODEC_ERROR ReconstructSampleFrameBayerHalfToBuffer(DECODER *decoder, FRAME_INFO *info, int frame, uint8_t *output, int pitch);
 CODEC_ERROR ReconstructSampleFrameBayerQuarterToBuffer(DECODER *decoder, int frame, uint8_t *output, int pitch);
 
+// Output the lowpass bands at the top of the wavelet tree in any of the decoded formats
+CODEC_ERROR ReconstructSampleFrameLowpassToBuffer(DECODER *decoder, FRAME_INFO *info, int frame, uint8_t *output, int pitch);
+
 CODEC_ERROR UncompressedSampleFrameBayerToBuffer(DECODER *decoder, FRAME_INFO *info, int frame, uint8_t *output, int pitch);
 CODEC_ERROR UncompressedSampleFrameYUVToBuffer(DECODER *decoder, FRAME_INFO *info, int frame, uint8_t *output, int pitch);
 CODEC_ERROR UncompressedSampleFrameRGBToBuffer(DECODER *decoder, FRAME_INFO *info, int frame, uint8_t *output, int pitch);
@@ -1812,12 +1854,205 @@ ComputeFrameDimensionsFromFirstWavelet(int transform_type,
     return true;
 }
 
-// Decode the sample header to determine the type of sample and other parameters
-bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
+// Read the tag value pair at the specified offset in the sample
+static inline uint32_t GetSampleTuple(const uint8_t *sample, uint32_t offset)
+{
+    const uint8_t *tuple = sample + offset;
+    return ((uint32_t)tuple[0] << 24) | ((uint32_t)tuple[1] << 16) | ((uint32_t)tuple[2] << 8) | (uint32_t)tuple[3];
+}
+
+// Return the offset to the lowpass band that follows the lowpass subband tag (zero if not found)
+static int FindLowPassBandOffset(const uint8_t *sample, int subband_offset)
+{
+    const uint32_t *lptr = (const uint32_t *)(sample + subband_offset + 4);
+    int count = 8;
+
+    do
+    {
+        uint32_t longword = SwapInt32(lptr[count]);
+        unsigned short t, v;
+        t = (longword >> 16) & 0xffff;
+        v = (longword) & 0xffff;
+        if (t == CODEC_TAG_MARKER && IsLowPassBandMarker(v))
+        {
+            return subband_offset + 4 + count * 4 + 4;
+        }
+
+        count++;
+    } while (count < 32);
+
+    return 0;
+}
+
+// Record a tuple that must be the same in the next sample (returns false if the layout is full)
+static bool RecordLayoutTuple(SAMPLE_LAYOUT *layout, const uint8_t *sample, int offset, uint32_t mask)
+{
+    int index = layout->check_count;
+
+    if (index >= SAMPLE_LAYOUT_MAX_CHECKS)
+    {
+        return false;
+    }
+
+    layout->check_offset[index] = offset;
+    layout->check_mask[index] = mask;
+    layout->check_value[index] = GetSampleTuple(sample, offset) & mask;
+    layout->check_count++;
+
+    if (layout->min_size < (uint32_t)offset + 4)
+    {
+        layout->min_size = offset + 4;
+    }
+
+    return true;
+}
+
+// Record a chunk that must have the same type in the next sample (the size can be different)
+static bool RecordLayoutChunk(SAMPLE_LAYOUT *layout, int offset, int chunk_type)
+{
+    int index = layout->chunk_count;
+
+    if (index >= SAMPLE_LAYOUT_MAX_CHUNKS)
+    {
+        return false;
+    }
+
+    layout->chunk_offset[index] = offset;
+    layout->chunk_type[index] = chunk_type;
+    layout->chunk_count++;
+
+    if (layout->min_size < (uint32_t)offset + 4)
+    {
+        layout->min_size = offset + 4;
+    }
+
+    return true;
+}
+
+// Return the type of chunk (the tag without the high bits of the chunk size)
+static inline int GetChunkType(uint32_t tuple)
+{
+    int tag = (int16_t)(tuple >> 16);
+    if (tag < 0) tag = NEG(tag);
+    return tag & 0xff00;
+}
+
+// Return the size of a chunk in the sample header (in segments)
+static inline int GetChunkSize(uint32_t tuple)
+{
+    int tag = (int16_t)(tuple >> 16);
+    if (tag < 0) tag = NEG(tag);
+    return (int)(tuple & 0xffff) + ((tag & 0xff) << 16);
+}
+
+// Parse the sample header using the layout recorded from the previous sample
+static bool ApplySampleLayout(BITSTREAM *input, SAMPLE_HEADER *header, SAMPLE_LAYOUT *layout, int find_flags)
+{
+    const uint8_t *sample = input->lpCurrentWord;
+    uint32_t sample_size = input->nWordsUsed;
+    uint32_t frame_number = 0;
+    uint32_t channel_offset = 0;
+    int lowpass_offset[CODEC_MAX_CHANNELS];
+    int i;
+
+    if (!layout->valid || layout->find_flags != find_flags || sample_size < layout->min_size)
+    {
+        return false;
+    }
+
+    // The tuples that determine the sample header must be the same as in the previous sample
+    for (i = 0; i < layout->check_count; i++)
+    {
+        if ((GetSampleTuple(sample, layout->check_offset[i]) & layout->check_mask[i]) != layout->check_value[i])
+        {
+            return false;
+        }
+    }
+
+    for (i = 0; i < layout->chunk_count; i++)
+    {
+        if (GetChunkType(GetSampleTuple(sample, layout->chunk_offset[i])) != layout->chunk_type[i])
+        {
+            return false;
+        }
+    }
+
+    // The parser skips the sample size chunk if the chunk is larger than the sample
+    if (layout->sample_size_offset >= 0)
+    {
+        int chunk_size = GetChunkSize(GetSampleTuple(sample, layout->sample_size_offset));
+        int skip = ((find_flags & 4) || sample_size < (uint32_t)chunk_size * 4) ? 1 : 0;
+        if (skip != layout->sample_size_skip)
+        {
+            return false;
+        }
+    }
+
+    // The parser continues past the frame number tag if the frame number is zero
+    if (layout->frame_number_offset >= 0)
+    {
+        frame_number = GetSampleTuple(sample, layout->frame_number_offset) & 0xffff;
+        if ((frame_number == 0) != (layout->header.frame_number == 0))
+        {
+            return false;
+        }
+    }
+
+    // Compute the offsets to the lowpass subband in each channel from the channel sizes
+    for (i = 0; i < layout->lowpass_count; i++)
+    {
+        int offset = layout->lowpass_delta[i] + channel_offset;
+        uint32_t tuple;
+
+        if (i > 0)
+        {
+            if (layout->index_offset < 0 || i > layout->index_count)
+            {
+                return false;
+            }
+            channel_offset += GetSampleTuple(sample, layout->index_offset + (i - 1) * 4);
+            offset = layout->lowpass_delta[i] + channel_offset;
+        }
+
+        if (offset < 0 || (uint32_t)offset + 4 > sample_size)
+        {
+            return false;
+        }
+
+        tuple = GetSampleTuple(sample, offset);
+        if (abs((int16_t)(tuple >> 16)) != CODEC_TAG_LOWPASS_SUBBAND || (tuple & 0xffff) != 0)
+        {
+            return false;
+        }
+
+        lowpass_offset[i] = offset;
+    }
+
+    memcpy(header, &layout->header, sizeof(SAMPLE_HEADER));
+    header->frame_number = frame_number;
+
+    for (i = 0; i < layout->lowpass_count; i++)
+    {
+        header->thumbnail_channel_offsets[i] = FindLowPassBandOffset(sample, lowpass_offset[i]);
+    }
+
+    return true;
+}
+
+// Decode the sample header and record the layout of the header if a layout is provided
+static bool ParseSampleHeaderLayout(BITSTREAM *input, SAMPLE_HEADER *header, SAMPLE_LAYOUT *layout)
 {
     TAGVALUE segment;
     int sample_type;
     int sample_size = 0;
+    const uint8_t *sample = input->lpCurrentWord;
+    int tuple_offset = 0;
+
+    // Channel offsets to the lowpass subbands for recording the layout
+    int lowpass_offset[CODEC_MAX_CHANNELS];
+    bool recording = (layout != NULL);
+    bool layout_complete = true;
+    bool sample_size_skip = false;
 
     // Group index
     uint32_t channel_size[TRANSFORM_MAX_CHANNELS];
@@ -1917,6 +2152,39 @@ bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
             break;
     }
 
+    // The second frame in a group does not change the layout recorded from the previous group
+    if (sample_type == SAMPLE_TYPE_FRAME)
+    {
+        layout = NULL;
+        recording = false;
+    }
+
+    if (layout != NULL)
+    {
+        // The layout is only valid after the sample header has been parsed successfully
+        layout->valid = 0;
+        layout->find_flags = find_lowpass_bands | (find_uncompressed << 1) | (find_header_info_only << 2);
+        layout->check_count = 0;
+        layout->chunk_count = 0;
+        layout->min_size = 0;
+        layout->frame_number_offset = -1;
+        layout->sample_size_offset = -1;
+        layout->sample_size_skip = 0;
+        layout->index_offset = -1;
+        layout->index_count = 0;
+        layout->lowpass_count = 0;
+
+        // The layout of the second eye in a stereo sample is not recorded
+        if (currentVideoChannel > 1)
+        {
+            recording = false;
+        }
+        else
+        {
+            RecordLayoutTuple(layout, sample, 0, 0xffffffff);
+        }
+    }
+
     // Continue parsing the sample header until all of the information has been found
     while (	(find_lowpass_bands == 1 && current_channel < 3) || //parse all
             (find_uncompressed == 1 && current_channel < 1) ||
@@ -1928,6 +2196,11 @@ bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
             (header->interlaced_flags == 0 && header->hdr_progressive == 0))
     {
         int chunksize = 0;
+        bool record_tuple = recording;
+
+        // Offset to the next tag value pair in the sample
+        tuple_offset = sample_size - input->nWordsUsed;
+
         // Get the next tag value pair from the bitstream
         segment = GetSegment(input);
 
@@ -1982,6 +2255,15 @@ bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
 
                 skip = find_header_info_only;
 
+                if (record_tuple && layout->sample_size_offset < 0)
+                {
+                    // The size of the sample can change but the parser must take the same path
+                    layout->sample_size_offset = tuple_offset;
+                    layout->sample_size_skip = skip;
+                    sample_size_skip = (skip != 0);
+                    record_tuple = false;
+                }
+
                 if (currentVideoChannel <= 1 && header->videoChannels == 2 && !find_header_info_only)
                 {
                     BITSTREAM input2;
@@ -2029,10 +2311,25 @@ bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
                 header->hdr_uncompressed = 1;
                 skip = 1;
                 if (find_lowpass_bands != 1)
+                {
+                    if (record_tuple && !RecordLayoutChunk(layout, tuple_offset, 0x2300))
+                    {
+                        layout_complete = recording = false;
+                    }
                     break;
+                }
             }
             if ((segment.tuple.tag & 0xff00) == 0x2100) //level
             {
+                if (record_tuple)
+                {
+                    if (!RecordLayoutChunk(layout, tuple_offset, 0x2100))
+                    {
+                        layout_complete = recording = false;
+                    }
+                    record_tuple = false;
+                }
+
                 if (find_lowpass_bands == 1)
                 {
                     skip = 0;
@@ -2045,6 +2342,23 @@ bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
             }
 
 
+            if (record_tuple)
+            {
+                uint32_t mask = 0xffffffff;
+
+                if (segment.tuple.tag == CODEC_TAG_FRAME_NUMBER && chunksize == 0)
+                {
+                    // The frame number is read from each sample
+                    layout->frame_number_offset = tuple_offset;
+                    mask = 0xffff0000;
+                }
+
+                if (!RecordLayoutTuple(layout, sample, tuple_offset, mask))
+                {
+                    layout_complete = recording = false;
+                }
+            }
+
             if (chunksize)
             {
                 if (skip)
@@ -2066,6 +2380,11 @@ bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
                         // Get the number of channels in the index to skip
                         channel_count = segment.tuple.value;
                         DecodeGroupIndex(input, (uint32_t *)&channel_size[0], channel_count);
+                        if (recording && layout->index_offset < 0)
+                        {
+                            layout->index_offset = tuple_offset + 4;
+                            layout->index_count = channel_count;
+                        }
                         break;
 
                     case CODEC_TAG_FRAME_WIDTH:
@@ -2133,24 +2452,23 @@ bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
                     case CODEC_TAG_LOWPASS_SUBBAND:
                         if (segment.tuple.value == 0) // low pass band
                         {
-                            int count = 8;
-                            uint32_t *lptr = (uint32_t *)input->lpCurrentWord;
-                            do
+                            if (current_channel < 4)
                             {
-                                uint32_t longword = SwapInt32(lptr[count]);
-                                unsigned short t, v;
-                                t = (longword >> 16) & 0xffff;
-                                v = (longword) & 0xffff;
-                                if (t == CODEC_TAG_MARKER && IsLowPassBandMarker(v) && current_channel < 4)
-                                {
-                                    header->thumbnail_channel_offsets[current_channel] = (sample_size - input->nWordsUsed) + count * 4 + 4;
-                                    break;
-                                }
+                                header->thumbnail_channel_offsets[current_channel] = FindLowPassBandOffset(sample, tuple_offset);
+                            }
 
-                                count++;
-                            } while (count < 32);
+                            if (layout != NULL && current_channel < CODEC_MAX_CHANNELS)
+                            {
+                                lowpass_offset[current_channel] = tuple_offset;
+                            }
 
                             current_channel++;
+
+                            // The other channels are found using the channel sizes in the index
+                            if (find_lowpass_bands == 1)
+                            {
+                                recording = false;
+                            }
                         }
                         break;
 
@@ -2235,6 +2553,14 @@ bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
                 }
             }
         }
+        else if (record_tuple)
+        {
+            // Unknown tags are ignored but a known tag in the next sample would change the header
+            if (!RecordLayoutTuple(layout, sample, tuple_offset, 0xffff0000))
+            {
+                layout_complete = recording = false;
+            }
+        }
     }
 
     if (header->width == 0 || header->height == 0)
@@ -2266,13 +2592,83 @@ bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
     }
 
     // Return true if the header was parsed completely and correctly
-    return (header->width > 0 &&
+    if (!(header->width > 0 &&
             header->height > 0 &&
             ((sample_type == SAMPLE_TYPE_FRAME) ||
              (header->input_format != COLOR_FORMAT_UNKNOWN &&
-              header->encoded_format != ENCODED_FORMAT_UNKNOWN)));
+              header->encoded_format != ENCODED_FORMAT_UNKNOWN))))
+    {
+        return false;
+    }
 
     // It is not an error if the frame number was not found in the sample header
+
+    // Record the layout if the next sample can be parsed by comparing tuples with this sample
+    if (layout != NULL && layout_complete && layout->check_count > 0 && !sample_size_skip &&
+            header->videoChannels == 1 &&
+            input->error == BITSTREAM_ERROR_OKAY &&
+            current_channel <= CODEC_MAX_CHANNELS &&
+            (current_channel <= 1 || (layout->index_offset >= 0 && current_channel <= layout->index_count + 1)))
+    {
+        int channel;
+
+        // Recording stops early only after the lowpass subband in the first channel when searching all channels
+        if (!recording && !(find_lowpass_bands == 1 && current_channel > 0))
+        {
+            return true;
+        }
+
+        layout->lowpass_count = current_channel;
+
+        if (current_channel > 0)
+        {
+            uint32_t channel_offset = 0;
+
+            layout->lowpass_delta[0] = lowpass_offset[0];
+            for (channel = 1; channel < current_channel; channel++)
+            {
+                channel_offset += channel_size[channel - 1];
+                layout->lowpass_delta[channel] = lowpass_offset[channel] - (int)channel_offset;
+            }
+
+            if (layout->min_size < (uint32_t)lowpass_offset[0] + 4)
+            {
+                layout->min_size = lowpass_offset[0] + 4;
+            }
+        }
+
+        if (layout->index_offset >= 0 && layout->min_size < (uint32_t)(layout->index_offset + layout->index_count * 4))
+        {
+            layout->min_size = layout->index_offset + layout->index_count * 4;
+        }
+
+        memcpy(&layout->header, header, sizeof(SAMPLE_HEADER));
+        layout->valid = 1;
+    }
+
+    return true;
+}
+
+// Decode the sample header to determine the type of sample and other parameters
+bool ParseSampleHeader(BITSTREAM *input, SAMPLE_HEADER *header)
+{
+    return ParseSampleHeaderLayout(input, header, NULL);
+}
+
+// Decode the sample header using the layout of the previous sample in the same stream
+bool ParseSampleHeaderWithLayout(BITSTREAM *input, SAMPLE_HEADER *header, SAMPLE_LAYOUT *layout)
+{
+    if (layout != NULL && header != NULL && header->videoChannels <= 1)
+    {
+        int find_flags = header->find_lowpass_bands & 7;
+
+        if (ApplySampleLayout(input, header, layout, find_flags))
+        {
+            return true;
+        }
+    }
+
+    return ParseSampleHeaderLayout(input, header, layout);
 }
 
 bool DumpSampleHeader(BITSTREAM *input, FILE *logfile)
@@ -8564,6 +8960,9 @@ bool DecodeSample(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch
 
     decoder->local_output = local_output; // used for NV12 decodes.
 
+    // Set when the frame is reconstructed to the region of interest
+    decoder->region_decoded = 0;
+
     decoder->sample_uncompressed = 0; // set if a uncompressed sample is found.
     decoder->image_dev_only = 0;
 
@@ -8611,7 +9010,22 @@ bool DecodeSample(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch
         InitBitstreamBuffer(&input2, input->lpCurrentWord, input->nWordsUsed, BITSTREAM_ACCESS_READ);
         memset(&header, 0, sizeof(SAMPLE_HEADER));
         header.find_lowpass_bands = 2; // help finding the uncompressed flag
-        if (ParseSampleHeader(&input2, &header))
+
+        // Samples in the same stream usually have the same header layout
+        if (decoder->sample_layout == NULL)
+        {
+#if _ALLOCATOR
+            decoder->sample_layout = (SAMPLE_LAYOUT *)Alloc(decoder->allocator, sizeof(SAMPLE_LAYOUT));
+#else
+            decoder->sample_layout = (SAMPLE_LAYOUT *)MEMORY_ALLOC(sizeof(SAMPLE_LAYOUT));
+#endif
+            if (decoder->sample_layout)
+            {
+                memset(decoder->sample_layout, 0, sizeof(SAMPLE_LAYOUT));
+            }
+        }
+
+        if (ParseSampleHeaderWithLayout(&input2, &header, decoder->sample_layout))
         {
             decoder->codec.encoded_format = header.encoded_format;
             decoder->sample_uncompressed = header.hdr_uncompressed;
@@ -11748,6 +12162,62 @@ void ComputeOutputDimensions(DECODER *decoder, int frame,
 
 #define DEBUG_ROW16U	0
 
+// Return true if the final inverse transform and the output conversion can be limited to the region of interest
+static bool IsRegionDecodeSupported(DECODER *decoder, int resolution, int uncompressed)
+{
+    DECODED_REGION *region = &decoder->region;
+
+    if (region->width <= 0 || region->height <= 0) return false;
+
+    // Frames decoded through an intermediate buffer for stereo or framing corrections are output in full
+    if (decoder->use_local_buffer || decoder->channel_decodes > 1 || decoder->image_dev_only || uncompressed)
+        return false;
+
+    if (resolution != DECODED_RESOLUTION_FULL) return false;
+
+    // Frames that are not already output by the active metadata decoder are cropped by the caller
+    // so that the pixels in the region are the same as the pixels in the entire frame
+    if (!decoder->use_active_metadata_decoder || !decoder->apply_color_active_metadata) return false;
+
+    // The region must be inside the frame and aligned to pairs of rows and chroma samples
+    if (((region->left | region->top | region->width | region->height) & 1) != 0 ||
+            region->left < 0 || region->top < 0 ||
+            region->left + region->width > decoder->frame.width ||
+            region->top + region->height > decoder->frame.height)
+        return false;
+
+    // The color conversion of each row processes blocks of sixteen pixels
+    if ((region->width % 16) != 0) return false;
+
+    switch (decoder->codec.encoded_format)
+    {
+        case ENCODED_FORMAT_RGB_444:
+        case ENCODED_FORMAT_RGBA_4444:
+            // Interlaced RGB frames are not reconstructed to rows of 16-bit pixels
+            if (!decoder->codec.progressive) return false;
+            break;
+
+        case ENCODED_FORMAT_YUV_422:
+            break;
+
+        default:
+            return false;
+    }
+
+    // Formats that are not produced by the row output of the active metadata decoder
+    switch (decoder->frame.format)
+    {
+        case DECODED_FORMAT_YR16:
+        case DECODED_FORMAT_CbYCrY_10bit_2_8:
+            return false;
+
+        default:
+            break;
+    }
+
+    return true;
+}
+
 void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output, int pitch)
 {
     FRAME_INFO local_info;
@@ -11876,7 +12346,18 @@ void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output
             }
         }
 
-        if (	decoder->frame.format == COLOR_FORMAT_NV12)
+        // The planar and floating-point formats are only produced by the row output of the active metadata decoder
+        if (	decoder->frame.format == COLOR_FORMAT_NV12 ||
+                decoder->frame.format == COLOR_FORMAT_YV12 ||
+                decoder->frame.format == COLOR_FORMAT_P010 ||
+                decoder->frame.format == COLOR_FORMAT_P016 ||
+                decoder->frame.format == COLOR_FORMAT_P210 ||
+                decoder->frame.format == COLOR_FORMAT_P216 ||
+                decoder->frame.format == COLOR_FORMAT_GBRP16 ||
+                decoder->frame.format == COLOR_FORMAT_GBRAP16 ||
+                decoder->frame.format == COLOR_FORMAT_RGBA_HALF ||
+                decoder->frame.format == COLOR_FORMAT_RGBA_FLOAT ||
+                decoder->frame.format == COLOR_FORMAT_GBRAP_FLOAT)
         {
             decoder->use_active_metadata_decoder = true;
 
@@ -11888,6 +12369,12 @@ void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output
             decoder->use_active_metadata_decoder = true;
             decoder->apply_color_active_metadata = true;
         }
+
+        // The region of interest is cropped from the rows of 16-bit pixels by the active metadata decoder
+        if (IsRegionDecodeSupported(decoder, resolution, uncompressed))
+        {
+            decoder->region_decoded = 1;
+        }
     }
 
     // Get the decoding scale
@@ -12086,6 +12573,11 @@ void ReconstructSampleFrameToBuffer(DECODER *decoder, int frame, uint8_t *output
                 break;
         }
     }
+    else if (resolution == DECODED_RESOLUTION_LOWPASS_ONLY)
+    {
+        // Convert the lowpass bands to the output format without the inverse transforms
+        error = ReconstructSampleFrameLowpassToBuffer(decoder, info, frame, output, pitch);
+    }
     else
     {
         // Call the appropriate routine for the encoded format
@@ -15494,11 +15986,13 @@ void DecodeForceMetadataRefresh(DECODER *decoder)
     CFHDDATA *cfhddata = &decoder->cfhddata;
 
     cfhddata->force_metadata_refresh = true;
+    decoder->metadata_hash_valid = false;
 
     if (decoder->parallelDecoder)
     {
         cfhddata = &decoder->parallelDecoder->cfhddata;
         cfhddata->force_metadata_refresh = true;
+        decoder->parallelDecoder->metadata_hash_valid = false;
     }
 
 }
@@ -15520,6 +16014,144 @@ void SetDecoderFlags(DECODER *decoder, uint32_t flags)
 #endif
 }
 
+void SetDecoderRegion(DECODER *decoder, int left, int top, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+    {
+        // Output the entire frame
+        left = top = width = height = 0;
+    }
+
+    decoder->region.left = left;
+    decoder->region.top = top;
+    decoder->region.width = width;
+    decoder->region.height = height;
+}
+
+bool IsRegionDecoded(DECODER *decoder)
+{
+    return (decoder->region_decoded != 0);
+}
+
+int DecodedOutputHeight(DECODER *decoder)
+{
+    return (decoder->region_decoded ? decoder->region.height : decoder->frame.height);
+}
+
+// Return true if the pair of output rows computed from a row of the final wavelet is in the region of interest
+static bool IsRowPairInRegion(DECODER *decoder, int row)
+{
+    int top = decoder->region.top;
+    int bottom = top + decoder->region.height;
+
+    if (!decoder->region_decoded) return true;
+
+    return (top <= 2 * row + 1 && 2 * row < bottom);
+}
+
+bool StartDecodedRows(DECODER *decoder, DECODED_ROWS_PROC proc, void *param, int band_rows,
+                      uint8_t *output, int num_rows)
+{
+    DECODED_ROWS *rows = &decoder->decoded_rows;
+
+    rows->proc = NULL;
+
+    if (proc == NULL || output == NULL || num_rows <= 0)
+    {
+        return false;
+    }
+
+    // Allocate a flag for each row in the output buffer
+    if (rows->row_written == NULL || rows->row_written_size < num_rows)
+    {
+#if _ALLOCATOR
+        if (rows->row_written) Free(decoder->allocator, rows->row_written);
+        rows->row_written = (uint8_t *)Alloc(decoder->allocator, num_rows);
+#else
+        if (rows->row_written) MEMORY_FREE(rows->row_written);
+        rows->row_written = (uint8_t *)MEMORY_ALLOC(num_rows);
+#endif
+        rows->row_written_size = (rows->row_written != NULL) ? num_rows : 0;
+    }
+
+    if (rows->row_written == NULL)
+    {
+        return false;
+    }
+
+    memset(rows->row_written, 0, num_rows);
+
+    rows->param = param;
+    rows->output = output;
+    rows->num_rows = num_rows;
+    rows->band_rows = (band_rows > 0) ? band_rows : 1;
+    rows->finished_rows = 0;
+    rows->reported_rows = 0;
+    rows->proc = proc;
+
+    return true;
+}
+
+void FinishDecodedRows(DECODER *decoder, bool report)
+{
+    DECODED_ROWS *rows = &decoder->decoded_rows;
+
+    if (rows->proc == NULL) return;
+
+    // The worker threads have finished the frame so the rows can be reported without the lock
+    if (report && rows->reported_rows < rows->num_rows)
+    {
+        rows->proc(rows->param, rows->reported_rows, rows->num_rows - rows->reported_rows);
+        rows->reported_rows = rows->num_rows;
+    }
+
+    rows->proc = NULL;
+    rows->output = NULL;
+}
+
+void DecodedRowsWritten(DECODER *decoder, uint8_t *output, int first_row, int row_count)
+{
+    DECODED_ROWS *rows = &decoder->decoded_rows;
+    int last_row = first_row + row_count;
+    int row;
+#if _THREADED
+    bool locked = (decoder->worker_thread.pool.thread_count > 0);
+#endif
+
+    // Rows written into intermediate buffers or combined later with another channel are not reported
+    if (rows->proc == NULL || output != rows->output || decoder->channel_decodes > 1) return;
+
+    if (first_row < 0) first_row = 0;
+    if (last_row > rows->num_rows) last_row = rows->num_rows;
+    if (first_row >= last_row) return;
+
+#if _THREADED
+    if (locked) Lock(&decoder->worker_thread.lock);
+#endif
+
+    for (row = first_row; row < last_row; row++)
+    {
+        rows->row_written[row] = 1;
+    }
+
+    while (rows->finished_rows < rows->num_rows && rows->row_written[rows->finished_rows])
+    {
+        rows->finished_rows++;
+    }
+
+    // The band is reported while holding the lock so that the bands are reported in order
+    if (rows->finished_rows - rows->reported_rows >= rows->band_rows ||
+            (rows->finished_rows == rows->num_rows && rows->reported_rows < rows->num_rows))
+    {
+        rows->proc(rows->param, rows->reported_rows, rows->finished_rows - rows->reported_rows);
+        rows->reported_rows = rows->finished_rows;
+    }
+
+#if _THREADED
+    if (locked) Unlock(&decoder->worker_thread.lock);
+#endif
+}
+
 void SetDecoderFormat(DECODER *decoder, int width, int height, int format, int resolution)
 {
     // Need to modify the codec to use the decoding format
@@ -15656,6 +16288,25 @@ int DecodedResolution(int input_width, int input_height, int output_width, int o
         return DECODED_RESOLUTION_QUARTER;
     }
 
+    // Compute the dimensions of the lowpass bands at the top of the wavelet tree
+    decoded_width /= 2;
+    decoded_height /= 2;
+
+    // Do the output dimensions correspond to decoding only the lowpass bands?
+    if (output_width == decoded_width && output_height == decoded_height)
+    {
+        return DECODED_RESOLUTION_LOWPASS_ONLY;
+    }
+
+    // The lowpass bands can also be reduced by half in each dimension
+    decoded_width /= 2;
+    decoded_height /= 2;
+
+    if (output_width == decoded_width && output_height == decoded_height)
+    {
+        return DECODED_RESOLUTION_LOWPASS_ONLY;
+    }
+
     return DECODED_RESOLUTION_UNSUPPORTED;
 }
 
@@ -15693,7 +16344,8 @@ void ComputeDecodedDimensions(int encoded_width, int encoded_height, int decoded
 // Return true if the specified resolution is supported
 bool IsDecodedResolution(int resolution)
 {
-    if (resolution == DECODED_RESOLUTION_QUARTER)
+    if (resolution == DECODED_RESOLUTION_QUARTER ||
+            resolution == DECODED_RESOLUTION_LOWPASS_ONLY)
     {
         return true;
     }
@@ -17858,6 +18510,10 @@ void TransformInverseFrameToRow16u(DECODER *decoder, TRANSFORM *transform[], int
     int channel;
     int row;
 
+    // Range of rows in the horizontal bands that are reconstructed
+    int first_row = 0;
+    int last_row = half_height;
+
 #if (DEBUG_ROW16U)
     PIXEL16U *output_buffer;
 #endif
@@ -17932,8 +18588,27 @@ void TransformInverseFrameToRow16u(DECODER *decoder, TRANSFORM *transform[], int
         output_row_width[channel] = (channel == 0) ? luma_width : chroma_width;
     }
 
+    // Each row in the bands is reconstructed into two output rows
+    if (decoder->region_decoded)
+    {
+        first_row = decoder->region.top / 2;
+        last_row = (decoder->region.top + decoder->region.height + 1) / 2;
+
+        for (channel = 0; channel < num_channels; channel++)
+        {
+            int offset = first_row * horizontal_pitch[channel];
+
+            horizontal_lowlow[channel] += offset;
+            horizontal_lowhigh[channel] += offset;
+            horizontal_highlow[channel] += offset;
+            horizontal_highhigh[channel] += offset;
+        }
+
+        output += first_row * field_pitch / sizeof(PIXEL16U);
+    }
+
     // Process one row at a time from each channel
-    for (row = 0; row < half_height; row++)
+    for (row = first_row; row < last_row; row++)
     {
 #if (DEBUG_ROW16U)
         PIXEL16U *output_row_ptr = output_buffer;
@@ -18251,7 +18926,11 @@ void TransformInverseFrameSectionToRow16u(DECODER *decoder, int thread_index, in
             }
         }
 
-        if (return_value == WAIT_OBJECT_0 && 0 <= row && row < half_height)
+        if (return_value == WAIT_OBJECT_0 && 0 <= row && row < half_height && !IsRowPairInRegion(decoder, row))
+        {
+            // The output rows are outside the region of interest
+        }
+        else if (return_value == WAIT_OBJECT_0 && 0 <= row && row < half_height)
         {
             assert(0 <= row && row < half_height);
 
@@ -21673,6 +22352,334 @@ CODEC_ERROR ReconstructSampleFrameBayerQuarterToBuffer(DECODER *decoder, int fra
     return error;
 }
 
+// Output the lowpass bands at the top of the wavelet tree through rows of 16-bit pixels
+CODEC_ERROR ReconstructSampleFrameLowpassToBuffer(DECODER *decoder, FRAME_INFO *info, int frame, uint8_t *output, int pitch)
+{
+#if _THREADED
+    CODEC_STATE *codec = &decoder->codec;
+    int num_channels = codec->num_channels;
+    int encoded_format = codec->encoded_format;
+    TRANSFORM **transform_array = decoder->transform;
+    IMAGE *lowpass_images[TRANSFORM_MAX_CHANNELS];
+    WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
+    int lowpass_bits = 14;
+    int row_pitch;
+    int frame_size;
+    int scale;
+    int shift;
+    int limit;
+    int channel;
+    int row;
+
+#if _ALLOCATOR
+    ALLOCATOR *allocator = decoder->allocator;
+#endif
+
+    // Frame decoded without the temporal transform?
+    if (transform_array[0]->wavelet[5] == NULL)
+    {
+        for (channel = 0; channel < num_channels; channel++)
+        {
+            lowpass_images[channel] = transform_array[channel]->wavelet[2];
+        }
+    }
+    else
+    {
+        // The temporal lowpass band is the sum of the two frames in the group
+        for (channel = 0; channel < num_channels; channel++)
+        {
+            lowpass_images[channel] = transform_array[channel]->wavelet[5];
+        }
+        lowpass_bits++;
+    }
+
+    if (lowpass_images[0] == NULL)
+    {
+        return CODEC_ERROR_UNSUPPORTED_FORMAT;
+    }
+
+    if (encoded_format == ENCODED_FORMAT_BAYER)
+    {
+        // The Bayer lowpass bands are half the size of the RGB lowpass bands and are
+        // converted to RGB by the worker threads (pixels are replicated for eighth size)
+        if (decoder->frame.format == DECODED_FORMAT_BYR2 || decoder->frame.format == DECODED_FORMAT_BYR4)
+        {
+            return CODEC_ERROR_UNSUPPORTED_FORMAT;
+        }
+        if (info->width > 2 * lowpass_images[0]->width || info->height > 2 * lowpass_images[0]->height)
+        {
+            return CODEC_ERROR_FRAMESIZE;
+        }
+        row_pitch = 0;
+    }
+    else if (encoded_format == ENCODED_FORMAT_YUV_422)
+    {
+        // The luma and chroma lowpass bands have four more bits than the encoded precision
+        lowpass_bits += codec->precision - 10;
+
+        // Each row has the luma followed by the two chroma channels
+        row_pitch = info->width * 4;
+    }
+    else if (encoded_format == ENCODED_FORMAT_RGB_444 || encoded_format == ENCODED_FORMAT_RGBA_4444)
+    {
+        // Only output the alpha channel if it will be used
+        if (!(encoded_format == ENCODED_FORMAT_RGBA_4444 && ALPHAOUTPUT(info->format)))
+        {
+            num_channels = 3;
+        }
+
+        // Each row has a plane for each channel
+        row_pitch = info->width * num_channels * 2;
+    }
+    else
+    {
+        return CODEC_ERROR_UNSUPPORTED_FORMAT;
+    }
+
+    if (row_pitch > 0)
+    {
+        // Average pairs of rows and columns if the output is half the size of the lowpass bands
+        scale = (lowpass_images[0]->width >= 2 * info->width) ? 2 : 1;
+        if (!(lowpass_images[0]->width >= scale * info->width && lowpass_images[0]->height >= scale * info->height))
+        {
+            return CODEC_ERROR_FRAMESIZE;
+        }
+
+        frame_size = row_pitch * info->height;
+        shift = 16 - lowpass_bits;
+        limit = (1 << lowpass_bits) - 1;
+
+        if (decoder->RGBFilterBuffer16 == NULL || decoder->RGBFilterBufferSize < frame_size)
+        {
+#if _ALLOCATOR
+            if (decoder->RGBFilterBuffer16)
+            {
+                FreeAligned(decoder->allocator, decoder->RGBFilterBuffer16);
+                decoder->RGBFilterBuffer16 = NULL;
+            }
+            decoder->RGBFilterBuffer16 = (PIXEL16U *)AllocAligned(allocator, frame_size, 16);
+#else
+            if (decoder->RGBFilterBuffer16)
+            {
+                MEMORY_ALIGNED_FREE(decoder->RGBFilterBuffer16);
+                decoder->RGBFilterBuffer16 = NULL;
+            }
+            decoder->RGBFilterBuffer16 = (PIXEL16U *)MEMORY_ALIGNED_ALLOC(frame_size, 16);
+#endif
+            assert(decoder->RGBFilterBuffer16 != NULL);
+            if (! (decoder->RGBFilterBuffer16 != NULL))
+            {
+                return CODEC_ERROR_MEMORY_ALLOC;
+            }
+            decoder->RGBFilterBufferSize = frame_size;
+        }
+
+        // Convert the lowpass coefficients to rows of unsigned 16-bit pixels
+        for (row = 0; row < info->height; row++)
+        {
+            PIXEL16U *output_row = (PIXEL16U *)((uint8_t *)decoder->RGBFilterBuffer16 + row * row_pitch);
+
+            for (channel = 0; channel < num_channels; channel++)
+            {
+                IMAGE *image = lowpass_images[channel];
+                int lowpass_pitch = image->pitch / sizeof(PIXEL);
+                PIXEL *lowpass_row = image->band[0] + scale * row * lowpass_pitch;
+                int width = info->width;
+                int column;
+
+                // The chroma channels are sampled at half the width of the luma channel
+                if (encoded_format == ENCODED_FORMAT_YUV_422 && channel > 0)
+                {
+                    width /= 2;
+                }
+
+                for (column = 0; column < width; column++)
+                {
+                    int value;
+
+                    if (scale == 2)
+                    {
+                        PIXEL *lowpass_ptr = lowpass_row + 2 * column;
+                        value = (lowpass_ptr[0] + lowpass_ptr[1] +
+                                 lowpass_ptr[lowpass_pitch] + lowpass_ptr[lowpass_pitch + 1] + 2) >> 2;
+                    }
+                    else
+                    {
+                        value = lowpass_row[column];
+                    }
+
+                    if (value < 0) value = 0;
+                    if (value > limit) value = limit;
+
+                    output_row[column] = value << shift;
+                }
+
+                output_row += width;
+            }
+        }
+    }
+
+    // The worker threads invert the rows of Bayer data
+    if (encoded_format != ENCODED_FORMAT_BAYER &&
+            (info->format == DECODED_FORMAT_RGB24 || info->format == DECODED_FORMAT_RGB32))
+    {
+        output += (info->height - 1) * pitch;		// Start at the bottom row
+        pitch = NEG(pitch);							// Negate the pitch to go up
+    }
+
+#if _DELAY_THREAD_START
+    if (decoder->worker_thread.pool.thread_count == 0)
+    {
+        CreateLock(&decoder->worker_thread.lock);
+        // Initialize the pool of transform worker threads
+        ThreadPoolCreate(&decoder->worker_thread.pool,
+                         decoder->thread_cntrl.capabilities >> 16/*cpus*/,
+                         WorkerThreadProc,
+                         decoder);
+    }
+#endif
+    // Post a message to the mailbox
+    mailbox->output = output;
+    mailbox->pitch = pitch;
+    mailbox->framenum = frame;
+    memcpy(&mailbox->info, info, sizeof(FRAME_INFO));
+    mailbox->jobType = JOB_TYPE_OUTPUT;
+    if (encoded_format == ENCODED_FORMAT_YUV_422)
+    {
+        decoder->RGBFilterBufferPhase = 2; // yuv
+    }
+    else if (encoded_format != ENCODED_FORMAT_BAYER)
+    {
+        decoder->RGBFilterBufferPhase = 1; // grb
+    }
+
+    // Set the work count to the number of rows to process
+    ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+
+    // Start the transform worker threads
+    ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+
+    // Wait for all of the worker threads to finish
+    ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+
+    decoder->RGBFilterBufferPhase = 0;
+
+    return CODEC_ERROR_OKAY;
+#else
+    return CODEC_ERROR_UNSUPPORTED_FORMAT;
+#endif
+}
+
+// Reconstruct the region of interest in a YUV 4:2:2 frame through rows of 16-bit luma and chroma
+static CODEC_ERROR ReconstructRegionYUV422ToBuffer(DECODER *decoder, int frame, uint8_t *output, int pitch)
+{
+    FRAME_INFO *info = &decoder->frame;
+    CODEC_STATE *codec = &decoder->codec;
+    int num_channels = codec->num_channels;
+    int precision = codec->precision;
+    int chroma_offset = codec->chroma_offset;
+
+    // Each row has the luma followed by the two chroma channels
+    int row_pitch = info->width * 4;
+    int frame_size = row_pitch * info->height;
+
+#if _ALLOCATOR
+    ALLOCATOR *allocator = decoder->allocator;
+#endif
+
+    if (info->format == DECODED_FORMAT_RGB24 || info->format == DECODED_FORMAT_RGB32)
+    {
+        output += (DecodedOutputHeight(decoder) - 1) * pitch;		// Start at the bottom row
+        pitch = NEG(pitch);											// Negate the pitch to go up
+    }
+
+    if (decoder->RGBFilterBuffer16 == NULL || decoder->RGBFilterBufferSize < frame_size)
+    {
+#if _ALLOCATOR
+        if (decoder->RGBFilterBuffer16)
+        {
+            FreeAligned(decoder->allocator, decoder->RGBFilterBuffer16);
+            decoder->RGBFilterBuffer16 = NULL;
+        }
+        decoder->RGBFilterBuffer16 = (PIXEL16U *)AllocAligned(allocator, frame_size, 16);
+#else
+        if (decoder->RGBFilterBuffer16)
+        {
+            MEMORY_ALIGNED_FREE(decoder->RGBFilterBuffer16);
+            decoder->RGBFilterBuffer16 = NULL;
+        }
+        decoder->RGBFilterBuffer16 = (PIXEL16U *)MEMORY_ALIGNED_ALLOC(frame_size, 16);
+#endif
+        assert(decoder->RGBFilterBuffer16 != NULL);
+        if (! (decoder->RGBFilterBuffer16 != NULL))
+        {
+            return CODEC_ERROR_MEMORY_ALLOC;
+        }
+        decoder->RGBFilterBufferSize = frame_size;
+    }
+
+#if _THREADED
+    // Only the rows of the last transform that overlap the region are computed
+    if (codec->progressive)
+    {
+        TransformInverseSpatialUniversalThreadedToRow16u(decoder, frame, num_channels,
+                (uint8_t *)decoder->RGBFilterBuffer16, row_pitch,
+                info, chroma_offset, precision);
+    }
+    else
+    {
+#if _INTERLACED_WORKER_THREADS
+        StartInterlaceWorkerThreads(decoder);
+
+        TransformInverseFrameThreadedToRow16u(decoder, frame, num_channels,
+                                              (PIXEL16U *)decoder->RGBFilterBuffer16, row_pitch,
+                                              info, chroma_offset, precision);
+#else
+        TransformInverseFrameToRow16u(decoder, decoder->transform, frame, num_channels,
+                                      (PIXEL16U *)decoder->RGBFilterBuffer16, row_pitch, info,
+                                      &decoder->scratch, chroma_offset, precision);
+#endif
+    }
+
+    {
+        WORKER_THREAD_DATA *mailbox = &decoder->worker_thread.data;
+
+#if _DELAY_THREAD_START
+        if (decoder->worker_thread.pool.thread_count == 0)
+        {
+            CreateLock(&decoder->worker_thread.lock);
+            // Initialize the pool of transform worker threads
+            ThreadPoolCreate(&decoder->worker_thread.pool,
+                             decoder->thread_cntrl.capabilities >> 16/*cpus*/,
+                             WorkerThreadProc,
+                             decoder);
+        }
+#endif
+        // Post a message to the mailbox
+        mailbox->output = output;
+        mailbox->pitch = pitch;
+        memcpy(&mailbox->info, info, sizeof(FRAME_INFO));
+        mailbox->jobType = JOB_TYPE_OUTPUT;
+        decoder->RGBFilterBufferPhase = 2; // yuv
+
+        // Set the work count to the number of rows to process
+        ThreadPoolSetWorkCount(&decoder->worker_thread.pool, info->height);
+
+        // Start the transform worker threads
+        ThreadPoolSendMessage(&decoder->worker_thread.pool, THREAD_MESSAGE_START);
+
+        // Wait for all of the worker threads to finish
+        ThreadPoolWaitAllDone(&decoder->worker_thread.pool);
+
+        decoder->RGBFilterBufferPhase = 0;
+    }
+
+    return CODEC_ERROR_OKAY;
+#else
+    return CODEC_ERROR_UNSUPPORTED_FORMAT;
+#endif
+}
+
 // Reconstruct the original YUV 4:2:2 encoded format to the requested output format
 CODEC_ERROR ReconstructSampleFrameYUV422ToBuffer(DECODER *decoder, int frame, uint8_t *output, int pitch)
 {
@@ -21805,6 +22812,12 @@ CODEC_ERROR ReconstructSampleFrameYUV422ToBuffer(DECODER *decoder, int frame, ui
     }
 
 
+    // Reconstruct only the rows and columns in the region of interest
+    if (decoder->region_decoded)
+    {
+        return ReconstructRegionYUV422ToBuffer(decoder, frame, output, pitch);
+    }
+
     // Was the video source interlaced or progressive?
     if (progressive)
     {
@@ -22056,6 +23069,16 @@ CODEC_ERROR ReconstructSampleFrameYUV422ToBuffer(DECODER *decoder, int frame, ui
             switch (format & 0x7ffffff)
             {
                 case DECODED_FORMAT_NV12:
+                case DECODED_FORMAT_YV12:
+                case DECODED_FORMAT_P010:
+                case DECODED_FORMAT_P016:
+                case DECODED_FORMAT_P210:
+                case DECODED_FORMAT_P216:
+                case DECODED_FORMAT_GBRP16:
+                case DECODED_FORMAT_GBRAP16:
+                case DECODED_FORMAT_RGBA_HALF:
+                case DECODED_FORMAT_RGBA_FLOAT:
+                case DECODED_FORMAT_GBRAP_FLOAT:
                 case DECODED_FORMAT_RGB24: // Output buffer is too small to decode into for
                 case DECODED_FORMAT_YUYV:
                 case DECODED_FORMAT_UYVY:
@@ -22277,7 +23300,7 @@ CODEC_ERROR ReconstructSampleFrameRGB444ToBuffer(DECODER *decoder, int frame, ui
 
     if (info->format == DECODED_FORMAT_RGB24 || info->format == DECODED_FORMAT_RGB32)
     {
-        output += (info->height - 1) * pitch;
+        output += (DecodedOutputHeight(decoder) - 1) * pitch;
         pitch = -pitch;
     }
 
@@ -23021,6 +24044,9 @@ void TransformInverseSpatialSectionToOutput(DECODER *decoder, int thread_index,
     int row;
     int odd_display_lines = 0;
 
+    // Rows of 16-bit planes are converted to the output format by a later pass
+    bool report_rows = (horizontal_filter_proc != InvertHorizontalStrip16sToRow16uPlanar);
+
     THREAD_ERROR error;
 
     // Push the scratch space state to allocate a new section
@@ -23126,7 +24152,8 @@ void TransformInverseSpatialSectionToOutput(DECODER *decoder, int thread_index,
         last_line++;
 
 
-    if (thread_index == TRANSFORM_WORKER_TOP_THREAD)
+    // Rows that are outside the region of interest are not reconstructed
+    if (thread_index == TRANSFORM_WORKER_TOP_THREAD && IsRowPairInRegion(decoder, 0))
     {
         // Process the first row
         row = 0;
@@ -23150,11 +24177,13 @@ void TransformInverseSpatialSectionToOutput(DECODER *decoder, int thread_index,
                                        (PIXEL *)buffer, buffer_size,
                                        precision,
                                        horizontal_filter_proc);
+
+        if (report_rows) DecodedRowsWritten(decoder, output_buffer, 0, 2);
     }
 
     if (thread_index == TRANSFORM_WORKER_BOTTOM_THREAD || decoder->worker_thread.pool.thread_count == 1)
     {
-        if (last_row == last_display_row) //DAN20071218 -- Added as old 1080 RAW files would crash
+        if (last_row == last_display_row && IsRowPairInRegion(decoder, last_row - 1)) //DAN20071218 -- Added as old 1080 RAW files would crash
         {
             int pitch = output_pitch;
             // Process the last row
@@ -23188,6 +24217,8 @@ void TransformInverseSpatialSectionToOutput(DECODER *decoder, int thread_index,
                                               (PIXEL *)buffer, buffer_size,
                                               precision, odd_display_lines,
                                               horizontal_filter_proc);
+
+            if (report_rows) DecodedRowsWritten(decoder, output_buffer, 2 * row, 2);
         }
     }
 
@@ -23221,7 +24252,7 @@ void TransformInverseSpatialSectionToOutput(DECODER *decoder, int thread_index,
         }
 
         // Is the row inside the top and bottom border?
-        if (0 < row && row < last_line)
+        if (0 < row && row < last_line && IsRowPairInRegion(decoder, row))
         {
             int outputlines = 2;
 
@@ -23249,6 +24280,8 @@ void TransformInverseSpatialSectionToOutput(DECODER *decoder, int thread_index,
                                               precision,
                                               horizontal_filter_proc,
                                               outputlines);
+
+            if (report_rows) DecodedRowsWritten(decoder, output_buffer, 2 * row, outputlines);
         }
     }
 }
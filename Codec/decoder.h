@@ -85,6 +85,19 @@ typedef enum decoded_format
     DECODED_FORMAT_NV12 = COLOR_FORMAT_NV12,
     DECODED_FORMAT_YV12 = COLOR_FORMAT_YV12,
 
+    // Planar formats with more than eight bits per component
+    DECODED_FORMAT_P010 = COLOR_FORMAT_P010,
+    DECODED_FORMAT_P016 = COLOR_FORMAT_P016,
+    DECODED_FORMAT_P210 = COLOR_FORMAT_P210,
+    DECODED_FORMAT_P216 = COLOR_FORMAT_P216,
+    DECODED_FORMAT_GBRP16 = COLOR_FORMAT_GBRP16,
+    DECODED_FORMAT_GBRAP16 = COLOR_FORMAT_GBRAP16,
+
+    // Floating-point RGBA formats
+    DECODED_FORMAT_RGBA_HALF = COLOR_FORMAT_RGBA_HALF,
+    DECODED_FORMAT_RGBA_FLOAT = COLOR_FORMAT_RGBA_FLOAT,
+    DECODED_FORMAT_GBRAP_FLOAT = COLOR_FORMAT_GBRAP_FLOAT,
+
     // Bayer formats
     DECODED_FORMAT_BYR1 = COLOR_FORMAT_BYR1,
     DECODED_FORMAT_BYR2 = COLOR_FORMAT_BYR2,
@@ -202,6 +215,51 @@ typedef struct sample_header
 
 } SAMPLE_HEADER;
 
+// Maximum number of tuples compared with the previous sample before the layout is reused
+#define SAMPLE_LAYOUT_MAX_CHECKS	64
+
+// Maximum number of chunks in the sample header that are compared by the type of chunk
+#define SAMPLE_LAYOUT_MAX_CHUNKS	4
+
+/*
+	Layout of the tags in the header of the previous sample
+
+	Samples from the same stream usually have the header tags at the same offsets.
+	The layout records the offsets of the tuples that were read while parsing the
+	sample header so that the next sample can be parsed by comparing those tuples
+	with the previous sample instead of walking the header tag by tag.  The frame
+	number and the sizes of the chunks are allowed to change from sample to sample.
+*/
+typedef struct sample_layout
+{
+    int valid;					// The layout can be used for the next sample
+    int find_flags;				// Search flags used when the layout was recorded
+
+    SAMPLE_HEADER header;		// Sample header parsed from the previous sample
+
+    int check_count;			// Tuples that must be the same in the next sample
+    uint32_t check_offset[SAMPLE_LAYOUT_MAX_CHECKS];
+    uint32_t check_mask[SAMPLE_LAYOUT_MAX_CHECKS];
+    uint32_t check_value[SAMPLE_LAYOUT_MAX_CHECKS];
+
+    int chunk_count;			// Chunks that must have the same type in the next sample
+    uint32_t chunk_offset[SAMPLE_LAYOUT_MAX_CHUNKS];
+    int chunk_type[SAMPLE_LAYOUT_MAX_CHUNKS];
+
+    uint32_t min_size;			// Sample must contain all of the tuples that are compared
+
+    int frame_number_offset;	// Offset to the frame number tuple (negative if not present)
+    int sample_size_offset;		// Offset to the sample size chunk (negative if not present)
+    int sample_size_skip;		// The sample size chunk was skipped by the parser
+
+    int index_offset;			// Offset to the channel sizes after the index (negative if not present)
+    int index_count;			// Number of channel sizes in the index
+
+    int lowpass_count;			// Number of channels with a lowpass band offset
+    int lowpass_delta[CODEC_MAX_CHANNELS];	// Offset to the lowpass subband tag relative to the channel sizes
+
+} SAMPLE_LAYOUT;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -240,6 +298,9 @@ bool DecodeSampleFrame(DECODER *decoder, BITSTREAM *input, uint8_t *output, int
 bool DecodeSampleIntraFrame(DECODER *decoder, BITSTREAM *input, uint8_t *output, int pitch, ColorParam *colorparams);
 
 bool ParseSampleHeader(BITSTREAM *sample, SAMPLE_HEADER *header);
+
+// Parse the sample header using the layout of the previous sample and record the layout for the next sample
+bool ParseSampleHeaderWithLayout(BITSTREAM *sample, SAMPLE_HEADER *header, SAMPLE_LAYOUT *layout);
 bool DumpSampleHeader(BITSTREAM *input, FILE *logfile);
 
 // Return the pixel size of the decoded format (in bytes)
@@ -271,6 +332,25 @@ void SetDecoderCapabilities(DECODER *decoder);
 int GetDecoderCapabilities(DECODER *decoder);
 bool SetDecoderColorFlags(DECODER *decoder, uint32_t color_flags);
 void SetDecoderFlags(DECODER *decoder, uint32_t flags);
+
+// Set the region of the decoded frame that is output (zero width or height for the entire frame)
+void SetDecoderRegion(DECODER *decoder, int left, int top, int width, int height);
+
+// Return true if only the region of interest was output for the last decoded frame
+bool IsRegionDecoded(DECODER *decoder);
+
+// Return the number of rows in the output buffer for the frame being decoded
+int DecodedOutputHeight(DECODER *decoder);
+
+// Report bands of rows written into the output buffer in order while the next frame is decoded
+bool StartDecodedRows(DECODER *decoder, DECODED_ROWS_PROC proc, void *param, int band_rows,
+                      uint8_t *output, int num_rows);
+
+// Report the rows that have not been reported and stop reporting rows
+void FinishDecodedRows(DECODER *decoder, bool report);
+
+// Record rows written into the output buffer by the final stage of decoding
+void DecodedRowsWritten(DECODER *decoder, uint8_t *output, int first_row, int row_count);
 bool ResizeDecoderBuffer(DECODER *decoder, int width, int height, int format);
 
 // Optimized decoding routine
@@ -45,6 +45,12 @@
 #include "metadata.h"
 #include "convert.h"
 #include "lutpath.h"
+#include "lutcache.h"
+
+#if _AVX2OPT
+#include <immintrin.h>		// AVX2 intrinsics
+#include "cpuid.h"
+#endif
 
 #include "demosaicframes.h"
 
@@ -60,7 +66,6 @@ extern "C" {
 #endif
 
 // Forward references
-uint32_t gencrc(unsigned char *buf, int len);
 void GetCurrentID(DECODER *decoder, unsigned char *ptr, unsigned int len, char *id, unsigned int id_size);
 
 void UpdateCFHDDATA(DECODER *decoder, unsigned char *ptr, int len, int delta, int priority);
@@ -317,6 +322,242 @@ void BLUCELL(unsigned short *rgbptr, unsigned short *bayerptr, int width)
 }
 
 
+#if _AVX2OPT
+
+// Cell types passed to the vectorized debayer row kernel
+#define DEBAYER_CELL_RED		0
+#define DEBAYER_CELL_GRN_RED	1	// Green cell in a row of red cells
+#define DEBAYER_CELL_GRN_BLU	2	// Green cell in a row of blue cells
+#define DEBAYER_CELL_BLU		3
+
+// Pixels (eight cells of each type) computed by each iteration of the vectorized row kernel
+#define DEBAYER_SIMD_PIXELS		16
+
+/*
+	The vectorized kernel computes eight cells of the same type at a time in 32-bit lanes.
+	Cells of the same type are two pixels apart, so loading sixteen pixels and keeping the
+	low half of each 32-bit lane gathers every other pixel.  The arithmetic is the same as
+	REDCELL, GRNREDCELL, GRNBLUCELL and BLUCELL (or the bilinear interpolation) and the
+	integer divisions are computed in double precision which is exact for these operands,
+	so the results are identical to the scalar code.
+*/
+
+TARGET_AVX2 static __m256i DebayerLoadCells(const unsigned short *bayerptr)
+{
+    return _mm256_and_si256(_mm256_loadu_si256((const __m256i *)bayerptr), _mm256_set1_epi32(0xFFFF));
+}
+
+// Truncating integer division of the numerator by the denominator
+TARGET_AVX2 static __m256i DebayerDivideCells(__m256i numerator, __m256i denominator)
+{
+    __m256d nlo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(numerator));
+    __m256d nhi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(numerator, 1));
+    __m256d dlo = _mm256_cvtepi32_pd(_mm256_castsi256_si128(denominator));
+    __m256d dhi = _mm256_cvtepi32_pd(_mm256_extracti128_si256(denominator, 1));
+    __m128i qlo = _mm256_cvttpd_epi32(_mm256_div_pd(nlo, dlo));
+    __m128i qhi = _mm256_cvttpd_epi32(_mm256_div_pd(nhi, dhi));
+
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(qlo), qhi, 1);
+}
+
+// Edge strength used by the CF_ENHANCE weights
+TARGET_AVX2 static __m256i DebayerDiffCells(__m256i a, __m256i b)
+{
+    return _mm256_srli_epi32(_mm256_abs_epi32(_mm256_sub_epi32(a, b)), 10);
+}
+
+// Weight of the neighbors along an edge: base + scale * numer^2 / (2 + denom^2)
+TARGET_AVX2 static __m256i DebayerFactorCells(int base, int scale, __m256i numer, __m256i denom)
+{
+    __m256i n = _mm256_mullo_epi32(_mm256_set1_epi32(scale), _mm256_mullo_epi32(numer, numer));
+    __m256i d = _mm256_add_epi32(_mm256_set1_epi32(2), _mm256_mullo_epi32(denom, denom));
+
+    return _mm256_add_epi32(_mm256_set1_epi32(base), DebayerDivideCells(n, d));
+}
+
+TARGET_AVX2 static __m256i DebayerSaturateCells(__m256i x)
+{
+    return _mm256_min_epi32(_mm256_max_epi32(x, _mm256_setzero_si256()), _mm256_set1_epi32(65535));
+}
+
+// Compute the RGB values for eight cells of the same type two pixels apart
+TARGET_AVX2 static void DebayerCellsAVX2(__m256i rgb[3], unsigned short *bayerptr, int width, int cell, int highquality)
+{
+    __m256i p0 = DebayerLoadCells(bayerptr);
+    __m256i pl = DebayerLoadCells(bayerptr - 1);
+    __m256i pr = DebayerLoadCells(bayerptr + 1);
+    __m256i pu = DebayerLoadCells(bayerptr - width);
+    __m256i pd = DebayerLoadCells(bayerptr + width);
+    __m256i pul = DebayerLoadCells(bayerptr - width - 1);
+    __m256i pur = DebayerLoadCells(bayerptr - width + 1);
+    __m256i pdl = DebayerLoadCells(bayerptr + width - 1);
+    __m256i pdr = DebayerLoadCells(bayerptr + width + 1);
+    __m256i diag = _mm256_add_epi32(_mm256_add_epi32(pul, pur), _mm256_add_epi32(pdl, pdr));
+    __m256i horz = _mm256_add_epi32(pl, pr);
+    __m256i vert = _mm256_add_epi32(pu, pd);
+    __m256i est1, est2;
+
+    if (highquality)
+    {
+        __m256i pl2 = DebayerLoadCells(bayerptr - 2);
+        __m256i pr2 = DebayerLoadCells(bayerptr + 2);
+        __m256i pu2 = DebayerLoadCells(bayerptr - 2 * width);
+        __m256i pd2 = DebayerLoadCells(bayerptr + 2 * width);
+        __m256i horz2 = _mm256_add_epi32(pl2, pr2);
+        __m256i vert2 = _mm256_add_epi32(pu2, pd2);
+
+        if (cell == DEBAYER_CELL_RED || cell == DEBAYER_CELL_BLU)
+        {
+            __m256i diffS = DebayerDiffCells(pl2, pr2);
+            __m256i diffG = DebayerDiffCells(pl, pr);
+            __m256i diffD = DebayerDiffCells(pul, pdr);
+            __m256i factorC = DebayerFactorCells(2, 2, diffS, diffG);
+            __m256i factorD = DebayerFactorCells(4, 4, diffG, diffD);
+            __m256i cross2 = _mm256_add_epi32(horz2, vert2);
+            __m256i num;
+
+            // Green from the four adjacent cells
+            num = _mm256_mullo_epi32(factorC, _mm256_add_epi32(horz, vert));
+            num = _mm256_add_epi32(num, _mm256_slli_epi32(p0, 2));
+            num = _mm256_sub_epi32(num, cross2);
+            est1 = DebayerDivideCells(num, _mm256_slli_epi32(factorC, 2));
+
+            // Opposite color from the four diagonal cells
+            num = _mm256_mullo_epi32(factorD, diag);
+            num = _mm256_add_epi32(num, _mm256_mullo_epi32(p0, _mm256_set1_epi32(12)));
+            num = _mm256_sub_epi32(num, _mm256_mullo_epi32(cross2, _mm256_set1_epi32(3)));
+            est2 = DebayerDivideCells(num, _mm256_slli_epi32(factorD, 2));
+        }
+        else
+        {
+            __m256i diffG = (cell == DEBAYER_CELL_GRN_RED) ? DebayerDiffCells(pl2, pr2) : DebayerDiffCells(pu2, pd2);
+            __m256i factorH = DebayerFactorCells(8, 4, diffG, DebayerDiffCells(pl, pr));
+            __m256i factorV = DebayerFactorCells(8, 4, diffG, DebayerDiffCells(pu, pd));
+            __m256i base = _mm256_sub_epi32(_mm256_mullo_epi32(p0, _mm256_set1_epi32(10)), _mm256_slli_epi32(diag, 1));
+            __m256i num;
+
+            // Interpolation from the horizontal neighbors
+            num = _mm256_add_epi32(_mm256_mullo_epi32(factorH, horz), base);
+            num = _mm256_add_epi32(num, _mm256_sub_epi32(vert2, _mm256_slli_epi32(horz2, 1)));
+            est1 = DebayerDivideCells(num, _mm256_slli_epi32(factorH, 1));
+
+            // Interpolation from the vertical neighbors
+            num = _mm256_add_epi32(_mm256_mullo_epi32(factorV, vert), base);
+            num = _mm256_add_epi32(num, _mm256_sub_epi32(horz2, _mm256_slli_epi32(vert2, 1)));
+            est2 = DebayerDivideCells(num, _mm256_slli_epi32(factorV, 1));
+        }
+
+        est1 = DebayerSaturateCells(est1);
+        est2 = DebayerSaturateCells(est2);
+    }
+    else
+    {
+        if (cell == DEBAYER_CELL_RED || cell == DEBAYER_CELL_BLU)
+        {
+            est1 = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(horz, vert), _mm256_set1_epi32(2)), 2);
+            est2 = _mm256_srli_epi32(_mm256_add_epi32(diag, _mm256_set1_epi32(2)), 2);
+        }
+        else
+        {
+            est1 = _mm256_srli_epi32(_mm256_add_epi32(horz, _mm256_set1_epi32(1)), 1);
+            est2 = _mm256_srli_epi32(_mm256_add_epi32(vert, _mm256_set1_epi32(1)), 1);
+        }
+    }
+
+    switch (cell)
+    {
+        case DEBAYER_CELL_RED:
+            rgb[0] = p0, rgb[1] = est1, rgb[2] = est2;
+            break;
+
+        case DEBAYER_CELL_GRN_RED:
+            rgb[0] = est1, rgb[1] = p0, rgb[2] = est2;
+            break;
+
+        case DEBAYER_CELL_GRN_BLU:
+            rgb[0] = est2, rgb[1] = p0, rgb[2] = est1;
+            break;
+
+        case DEBAYER_CELL_BLU:
+            rgb[0] = est2, rgb[1] = est1, rgb[2] = p0;
+            break;
+    }
+}
+
+// Byte shuffles that interleave eight pixels from the red, green, and blue vectors into three vectors of RGB triplets
+static const uint8_t debayer_rgb_shuffle[3][3][16] =
+{
+    {{0x00, 0x01, 0x80, 0x80, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x04, 0x05, 0x80, 0x80},
+     {0x80, 0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x04, 0x05},
+     {0x80, 0x80, 0x80, 0x80, 0x00, 0x01, 0x80, 0x80, 0x80, 0x80, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80}},
+    {{0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x08, 0x09, 0x80, 0x80, 0x80, 0x80, 0x0A, 0x0B},
+     {0x80, 0x80, 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x08, 0x09, 0x80, 0x80, 0x80, 0x80},
+     {0x04, 0x05, 0x80, 0x80, 0x80, 0x80, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x08, 0x09, 0x80, 0x80}},
+    {{0x80, 0x80, 0x80, 0x80, 0x0C, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x0E, 0x0F, 0x80, 0x80, 0x80, 0x80},
+     {0x0A, 0x0B, 0x80, 0x80, 0x80, 0x80, 0x0C, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x0E, 0x0F, 0x80, 0x80},
+     {0x80, 0x80, 0x0A, 0x0B, 0x80, 0x80, 0x80, 0x80, 0x0C, 0x0D, 0x80, 0x80, 0x80, 0x80, 0x0E, 0x0F}},
+};
+
+/*
+	Debayer the interior of a row that alternates between two cell types and return the
+	number of pixels that were computed.  The pixels that remain are computed by the caller.
+	The count is the number of pixels before the end of the row that the caller would
+	compute with the scalar code, which keeps all loads inside the row.
+*/
+TARGET_AVX2 static int DebayerRowAVX2(unsigned short *rgbptr, unsigned short *bayerptr, int width, int count,
+                                      int first_cell, int second_cell, int highquality)
+{
+    __m256i shuffle[3][3];
+    int done = 0;
+    int i, j;
+
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            shuffle[i][j] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)debayer_rgb_shuffle[i][j]));
+        }
+    }
+
+    for (; done + DEBAYER_SIMD_PIXELS < count; done += DEBAYER_SIMD_PIXELS)
+    {
+        __m256i even[3], odd[3], packed[3];
+
+        DebayerCellsAVX2(even, bayerptr + done, width, first_cell, highquality);
+        DebayerCellsAVX2(odd, bayerptr + done + 1, width, second_cell, highquality);
+
+        // Combine the two cell types into sixteen consecutive pixels per color
+        for (j = 0; j < 3; j++)
+        {
+            packed[j] = _mm256_or_si256(even[j], _mm256_slli_epi32(odd[j], 16));
+        }
+
+        // Each 128-bit lane holds eight pixels that are interleaved into 24 values
+        for (i = 0; i < 3; i++)
+        {
+            __m256i rgb = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(packed[0], shuffle[i][0]),
+                                          _mm256_shuffle_epi8(packed[1], shuffle[i][1])),
+                                          _mm256_shuffle_epi8(packed[2], shuffle[i][2]));
+
+            _mm_storeu_si128((__m128i *)&rgbptr[8 * i], _mm256_castsi256_si128(rgb));
+            _mm_storeu_si128((__m128i *)&rgbptr[24 + 8 * i], _mm256_extracti128_si256(rgb, 1));
+        }
+
+        rgbptr += 3 * DEBAYER_SIMD_PIXELS;
+    }
+
+    return done;
+}
+
+// Use the vectorized debayer kernel if the processor supports it
+static int DebayerUseAVX2()
+{
+    return (GetProcessorFeatures() & _CPU_FEATURE_AVX2) != 0;
+}
+
+#endif
+
+
 void FastSharpeningBlurHinplace(int width, unsigned short *sptr, int sharpness)
 {
     int i = 0, shift = 2, B, C;
@@ -2981,7 +3222,16 @@ void DoDEBAYER_ORDER_RED_GRN(
                 blu[rgboffset] = (basebayer[offset - width] + basebayer[offset + width] + 1) >> 1;
                 offset++, rgboffset += pixelstride;
 
-                for (x = 2; x < width - 2; x += 2)
+                x = 2;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 4,
+                                              DEBAYER_CELL_RED, DEBAYER_CELL_GRN_RED, 1);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 2; x += 2)
                 {
                     /*red cell*/
                     REDCELL(&red[rgboffset], &basebayer[offset], width);
@@ -3018,7 +3268,16 @@ void DoDEBAYER_ORDER_RED_GRN(
                 blu[rgboffset] = (basebayer[offset - width + 1] + basebayer[offset + width + 1] + 1) >> 1;
                 offset++, rgboffset += pixelstride;
 
-                for (x = 1; x < width - 1; x += 2)
+                x = 1;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 2,
+                                              DEBAYER_CELL_GRN_RED, DEBAYER_CELL_RED, 0);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 1; x += 2)
                 {
                     /*grn cell*/
                     grn[rgboffset] = basebayer[offset];
@@ -3088,7 +3347,16 @@ void DoDEBAYER_ORDER_RED_GRN(
                 blu[rgboffset] = basebayer[offset];
                 offset++, rgboffset += pixelstride;
 
-                for (x = 2; x < width - 2; x += 2)
+                x = 2;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 4,
+                                              DEBAYER_CELL_GRN_BLU, DEBAYER_CELL_BLU, 1);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 2; x += 2)
                 {
                     /*grn*/
                     GRNBLUCELL(&red[rgboffset], &basebayer[offset], width);
@@ -3125,7 +3393,16 @@ void DoDEBAYER_ORDER_RED_GRN(
                 blu[rgboffset] = basebayer[offset + 1];
                 offset++, rgboffset += pixelstride;
 
-                for (x = 1; x < width - 1; x += 2)
+                x = 1;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 2,
+                                              DEBAYER_CELL_BLU, DEBAYER_CELL_GRN_BLU, 0);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 1; x += 2)
                 {
                     /* blu */
                     grn[rgboffset] = (basebayer[offset - 1] + basebayer[offset + 1] + basebayer[offset - width] + basebayer[offset + width] + 2) >> 2;
@@ -3245,7 +3522,16 @@ void DoDEBAYER_ORDER_GRN_BLU(
                 offset++, rgboffset += pixelstride;
 
 
-                for (x = 2; x < width - 2; x += 2)
+                x = 2;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 4,
+                                              DEBAYER_CELL_GRN_BLU, DEBAYER_CELL_BLU, 1);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 2; x += 2)
                 {
                     /*grn cell*/
                     GRNBLUCELL(&red[rgboffset], &basebayer[offset], width);
@@ -3285,7 +3571,16 @@ void DoDEBAYER_ORDER_GRN_BLU(
                 offset++, rgboffset += pixelstride;
 
 
-                for (x = 1; x < width - 1; x += 2)
+                x = 1;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 2,
+                                              DEBAYER_CELL_BLU, DEBAYER_CELL_GRN_BLU, 0);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 1; x += 2)
                 {
                     /* blu */
                     grn[rgboffset] = (basebayer[offset - 1] + basebayer[offset + 1] + basebayer[offset - width] + basebayer[offset + width] + 2) >> 2;
@@ -3354,7 +3649,16 @@ void DoDEBAYER_ORDER_GRN_BLU(
                 blu[rgboffset] = (basebayer[offset - width] + basebayer[offset + width] + 1) >> 1;
                 offset++, rgboffset += pixelstride;
 
-                for (x = 2; x < width - 2; x += 2)
+                x = 2;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 4,
+                                              DEBAYER_CELL_RED, DEBAYER_CELL_GRN_RED, 1);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 2; x += 2)
                 {
                     /*red cell*/
                     REDCELL(&red[rgboffset], &basebayer[offset], width);
@@ -3392,7 +3696,16 @@ void DoDEBAYER_ORDER_GRN_BLU(
                 blu[rgboffset] = (basebayer[offset - width + 1] + basebayer[offset + width + 1] + 1) >> 1;
                 offset++, rgboffset += pixelstride;
 
-                for (x = 1; x < width - 1; x += 2)
+                x = 1;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 2,
+                                              DEBAYER_CELL_GRN_RED, DEBAYER_CELL_RED, 0);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 1; x += 2)
                 {
                     /*grn*/
                     grn[rgboffset] = basebayer[offset];
@@ -3510,7 +3823,16 @@ void DoDEBAYER_ORDER_GRN_RED(
                 blu[rgboffset] = (basebayer[offset - width - 1] + basebayer[offset - width + 1] + basebayer[offset + width - 1] + basebayer[offset + width + 1] + 2) >> 2;
                 offset++, rgboffset += pixelstride;
 
-                for (x = 2; x < width - 2; x += 2)
+                x = 2;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 4,
+                                              DEBAYER_CELL_GRN_RED, DEBAYER_CELL_RED, 1);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 2; x += 2)
                 {
                     /*grn cell*/
                     GRNREDCELL(&red[rgboffset], &basebayer[offset], width);
@@ -3548,7 +3870,16 @@ void DoDEBAYER_ORDER_GRN_RED(
                 offset++, rgboffset += pixelstride;
 
 
-                for (x = 1; x < width - 1; x += 2)
+                x = 1;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 2,
+                                              DEBAYER_CELL_RED, DEBAYER_CELL_GRN_RED, 0);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 1; x += 2)
                 {
                     /*red cell*/
                     grn[rgboffset] = (basebayer[offset - 1] + basebayer[offset + 1] + basebayer[offset - width] + basebayer[offset + width] + 2) >> 2;
@@ -3617,7 +3948,16 @@ void DoDEBAYER_ORDER_GRN_RED(
                 blu[rgboffset] = (basebayer[offset - 1] + basebayer[offset + 1] + 1) >> 1;
                 offset++, rgboffset += pixelstride;
 
-                for (x = 2; x < width - 2; x += 2)
+                x = 2;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 4,
+                                              DEBAYER_CELL_BLU, DEBAYER_CELL_GRN_BLU, 1);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 2; x += 2)
                 {
                     /*blu*/
                     BLUCELL(&red[rgboffset], &basebayer[offset], width);
@@ -3655,7 +3995,16 @@ void DoDEBAYER_ORDER_GRN_RED(
                 blu[rgboffset] = basebayer[offset];
                 offset++, rgboffset += pixelstride;
 
-                for (x = 1; x < width - 1; x += 2)
+                x = 1;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 2,
+                                              DEBAYER_CELL_GRN_BLU, DEBAYER_CELL_BLU, 0);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 1; x += 2)
                 {
                     /*grn*/
                     grn[rgboffset] = basebayer[offset];
@@ -3773,7 +4122,16 @@ void DoDEBAYER_ORDER_BLU_GRN(
                 red[rgboffset] = (basebayer[offset - width] + basebayer[offset + width] + 1) >> 1;
                 offset++, rgboffset += pixelstride;
 
-                for (x = 2; x < width - 2; x += 2)
+                x = 2;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 4,
+                                              DEBAYER_CELL_BLU, DEBAYER_CELL_GRN_BLU, 1);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 2; x += 2)
                 {
                     /*b cell*/
                     BLUCELL(&red[rgboffset], &basebayer[offset], width);
@@ -3811,7 +4169,16 @@ void DoDEBAYER_ORDER_BLU_GRN(
                 red[rgboffset] = (basebayer[offset - width + 1] + basebayer[offset + width + 1] + 1) >> 1;
                 offset++, rgboffset += pixelstride;
 
-                for (x = 1; x < width - 1; x += 2)
+                x = 1;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 2,
+                                              DEBAYER_CELL_GRN_BLU, DEBAYER_CELL_BLU, 0);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 1; x += 2)
                 {
                     /*grn cell*/
                     grn[rgboffset] = basebayer[offset];
@@ -3881,7 +4248,16 @@ void DoDEBAYER_ORDER_BLU_GRN(
                 red[rgboffset] = basebayer[offset];
                 offset++, rgboffset += pixelstride;
 
-                for (x = 2; x < width - 2; x += 2)
+                x = 2;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 4,
+                                              DEBAYER_CELL_GRN_RED, DEBAYER_CELL_RED, 1);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 2; x += 2)
                 {
                     /*grn*/
                     GRNREDCELL(&red[rgboffset], &basebayer[offset], width);
@@ -3919,7 +4295,16 @@ void DoDEBAYER_ORDER_BLU_GRN(
                 red[rgboffset] = basebayer[offset + 1];
                 offset++, rgboffset += pixelstride;
 
-                for (x = 1; x < width - 1; x += 2)
+                x = 1;
+#if _AVX2OPT
+                if (DebayerUseAVX2())
+                {
+                    int done = DebayerRowAVX2(&red[rgboffset], &basebayer[offset], width, width - 2,
+                                              DEBAYER_CELL_RED, DEBAYER_CELL_GRN_RED, 0);
+                    x += done, offset += done, rgboffset += done * pixelstride;
+                }
+#endif
+                for (; x < width - 1; x += 2)
                 {
                     /* r */
                     grn[rgboffset] = (basebayer[offset - 1] + basebayer[offset + 1] + basebayer[offset - width] + basebayer[offset + width] + 2) >> 2;
@@ -3993,6 +4378,116 @@ void DoDEBAYER_ORDER_BLU_GRN(
 
 
 // Send one frame to the Debayer Unit (row pitch is in bytes)
+// Return the color of the Bayer cell at the specified position (0 = red, 1 = green, 2 = blue)
+static int BayerCellColor(DEBAYER_ORDERING order, int row, int column)
+{
+    int red_row = (order == BAYER_FORMAT_GRN_BLU || order == BAYER_FORMAT_BLU_GRN) ? 1 : 0;
+    int red_column = (order == BAYER_FORMAT_GRN_RED || order == BAYER_FORMAT_BLU_GRN) ? 1 : 0;
+
+    if (((row ^ column) & 1) != ((red_row ^ red_column) & 1))
+        return 1;
+
+    return ((row & 1) == red_row) ? 0 : 2;
+}
+
+/*
+	Green at a red or blue cell interpolated along the direction with the smaller gradient
+	and corrected by the second derivative of the center color (Hamilton-Adams).
+*/
+static int EdgeDirectedGreen(unsigned short *bayerptr, int width)
+{
+    int center = 2 * bayerptr[0];
+    int gradH = abs(bayerptr[-1] - bayerptr[1]) + abs(center - bayerptr[-2] - bayerptr[2]);
+    int gradV = abs(bayerptr[-width] - bayerptr[width]) + abs(center - bayerptr[-2 * width] - bayerptr[2 * width]);
+    int estH = 2 * (bayerptr[-1] + bayerptr[1]) + center - bayerptr[-2] - bayerptr[2];
+    int estV = 2 * (bayerptr[-width] + bayerptr[width]) + center - bayerptr[-2 * width] - bayerptr[2 * width];
+    int g;
+
+    if (gradH < gradV)
+        g = estH >> 2;
+    else if (gradV < gradH)
+        g = estV >> 2;
+    else
+        g = (estH + estV) >> 3;
+
+    return SATURATE16(g);
+}
+
+/*
+	Edge-directed demosaic of the two rows starting at linenum.  Green is interpolated with
+	EdgeDirectedGreen and the other colors are interpolated as color differences from green
+	along the direction with the smaller gradient.  The estimate of green at the neighboring
+	cells uses a 7x7 window, so the pixels within three pixels of the image border are left
+	unchanged and must be computed by the caller.
+*/
+static void EdgeDirectedDebayerLine(int width, int height, int linenum,
+                                    unsigned short *basebayer,
+                                    DEBAYER_ORDERING order,
+                                    unsigned short *RGB_output)
+{
+    int row;
+
+    for (row = linenum; row < linenum + 2; row++)
+    {
+        unsigned short *rgbptr = RGB_output + (row - linenum) * width * 3;
+        int x;
+
+        if (row < 3 || row > height - 4)
+            continue;
+
+        for (x = 3; x < width - 3; x++)
+        {
+            unsigned short *bayerptr = &basebayer[row * width + x];
+            int color = BayerCellColor(order, row, x);
+            int rgb[3];
+
+            if (color == 1)
+            {
+                // Green cell with red or blue on the left and right
+                int g = bayerptr[0];
+                int diffL = bayerptr[-1] - EdgeDirectedGreen(bayerptr - 1, width);
+                int diffR = bayerptr[1] - EdgeDirectedGreen(bayerptr + 1, width);
+                int diffU = bayerptr[-width] - EdgeDirectedGreen(bayerptr - width, width);
+                int diffD = bayerptr[width] - EdgeDirectedGreen(bayerptr + width, width);
+                int horizontal = BayerCellColor(order, row, x + 1);
+
+                rgb[1] = g;
+                rgb[horizontal] = g + ((diffL + diffR) >> 1);
+                rgb[2 - horizontal] = g + ((diffU + diffD) >> 1);
+            }
+            else
+            {
+                // Red or blue cell with the opposite color on the diagonals
+                int g = EdgeDirectedGreen(bayerptr, width);
+                int gUL = EdgeDirectedGreen(bayerptr - width - 1, width);
+                int gUR = EdgeDirectedGreen(bayerptr - width + 1, width);
+                int gDL = EdgeDirectedGreen(bayerptr + width - 1, width);
+                int gDR = EdgeDirectedGreen(bayerptr + width + 1, width);
+                int gradN = abs(bayerptr[-width - 1] - bayerptr[width + 1]) + abs(2 * g - gUL - gDR);
+                int gradP = abs(bayerptr[-width + 1] - bayerptr[width - 1]) + abs(2 * g - gUR - gDL);
+                int diffN = (bayerptr[-width - 1] - gUL) + (bayerptr[width + 1] - gDR);
+                int diffP = (bayerptr[-width + 1] - gUR) + (bayerptr[width - 1] - gDL);
+                int opposite;
+
+                if (gradN < gradP)
+                    opposite = g + (diffN >> 1);
+                else if (gradP < gradN)
+                    opposite = g + (diffP >> 1);
+                else
+                    opposite = g + ((diffN + diffP) >> 2);
+
+                rgb[color] = bayerptr[0];
+                rgb[1] = g;
+                rgb[2 - color] = opposite;
+            }
+
+            rgbptr[3 * x + 0] = SATURATE16(rgb[0]);
+            rgbptr[3 * x + 1] = SATURATE16(rgb[1]);
+            rgbptr[3 * x + 2] = SATURATE16(rgb[2]);
+        }
+    }
+}
+
 void DebayerLine(int width, int height, int linenum,
                  unsigned short *bayer_source,
                  DEBAYER_ORDERING order,
@@ -4016,6 +4511,8 @@ void DebayerLine(int width, int height, int linenum,
     int pixelstride = 3;
     //int bayerplanar=0;
     unsigned short *basebayer = (unsigned short *)bayer_source;
+    int edgedirected = (highquality == DEBAYER_EDGE_DIRECTED);
+    int edge_sharpening = sharpening;
 
     red = RGB_output++;
     grn = RGB_output++;
@@ -4023,6 +4520,13 @@ void DebayerLine(int width, int height, int linenum,
 
     RGB_output -= 3;
 
+    // The bilinear filter computes the border pixels that the edge-directed filter skips
+    if (edgedirected)
+    {
+        highquality = 0;
+        sharpening = -1;
+    }
+
     switch (order)
     {
         case BAYER_FORMAT_RED_GRN:
@@ -4082,6 +4586,27 @@ void DebayerLine(int width, int height, int linenum,
             break;
     }
 
+    if (edgedirected)
+    {
+        EdgeDirectedDebayerLine(width, height, linenum, basebayer, order, RGB_output);
+
+        switch (edge_sharpening)
+        {
+            case 0: // just blur
+                FastBlurHinplace(width, &RGB_output[0]);
+                FastBlurHinplace(width, &RGB_output[width * pixelstride]);
+                break;
+            case 1: // blur/sharpen
+            case 2: // blur/sharpen
+            case 3: // blur/sharpen
+                FastSharpeningBlurHinplace(width, &RGB_output[0], edge_sharpening);
+                FastSharpeningBlurHinplace(width, &RGB_output[width * pixelstride], edge_sharpening);
+                break;
+            default:// do nothing
+                break;
+        }
+    }
+
     return;
 }
 
@@ -5029,16 +5554,24 @@ float *LoadCube64_3DLUT(DECODER *decoder, CFHDDATA *cfhddata, int *lutsize)
         }
         else if (decoder->LUTcache != NULL)
         {
-#if _ALLOCATOR
-            Free(decoder->allocator, decoder->LUTcache);
-#else
-            MEMORY_FREE(decoder->LUTcache);
-#endif
+            // Drop the reference to the previous look, other decoders may still use it
+            LUTCacheRelease(decoder->LUTcache);
             decoder->LUTcache = NULL;
             decoder->LUTcacheCRC = 0;
             decoder->LUTcacheSize = 0;
         }
 
+        // Has this look already been loaded by any decoder in the process?
+        LUT = LUTCacheAcquire(cfhddata->user_look_CRC, &size);
+        if (LUT)
+        {
+            *lutsize = size;
+            decoder->LUTcacheCRC = cfhddata->user_look_CRC;
+            decoder->LUTcache = LUT;
+            decoder->LUTcacheSize = size;
+            return LUT;
+        }
+
         if (cfhddata->user_look_CRC == 0x3f6f5788) // Default Protune preview LUT
         {
             *lutsize = size = 32;
@@ -5090,11 +5623,8 @@ float *LoadCube64_3DLUT(DECODER *decoder, CFHDDATA *cfhddata, int *lutsize)
                 1.000000f
             };
 
-#if _ALLOCATOR
-            LUT = (float *)Alloc(decoder->allocator, 4 * size * size * size * 3);
-#else
+            // Look tables are owned by the process-wide cache, not the decoder allocator
             LUT = (float *)MEMORY_ALLOC(4 * size * size * size * 3);
-#endif
             if (LUT)
             {
                 int r, g, b;
@@ -5113,9 +5643,11 @@ float *LoadCube64_3DLUT(DECODER *decoder, CFHDDATA *cfhddata, int *lutsize)
                     }
                 }
 
-                decoder->LUTcacheCRC = cfhddata->user_look_CRC;
+                LUT = LUTCacheInsert(cfhddata->user_look_CRC, LUT, size);
+
+                decoder->LUTcacheCRC = LUT ? cfhddata->user_look_CRC : 0;
                 decoder->LUTcache = LUT;
-                decoder->LUTcacheSize = size;
+                decoder->LUTcacheSize = LUT ? size : 0;
                 return LUT;
             }
         }
@@ -5150,11 +5682,7 @@ float *LoadCube64_3DLUT(DECODER *decoder, CFHDDATA *cfhddata, int *lutsize)
 
                     if (size >= 8 && size <= 65)
                     {
-#if _ALLOCATOR
-                        LUT = (float *)Alloc(decoder->allocator, 4 * size * size * size * 3);
-#else
                         LUT = (float *)MEMORY_ALLOC(4 * size * size * size * 3);
-#endif
                         if (LUT)
                         {
                             fseek(fp, SwapInt32(CFLKhdr.hdrsize), SEEK_SET);
@@ -5170,11 +5698,7 @@ float *LoadCube64_3DLUT(DECODER *decoder, CFHDDATA *cfhddata, int *lutsize)
                             }
                             else
                             {
-#if _ALLOCATOR
-                                Free(decoder->allocator, LUT);
-#else
                                 MEMORY_FREE(LUT);
-#endif
                                 LUT = NULL;
                             }
                         }
@@ -5186,11 +5710,7 @@ float *LoadCube64_3DLUT(DECODER *decoder, CFHDDATA *cfhddata, int *lutsize)
 
                     if (size >= 8 && size <= 65)
                     {
-#if _ALLOCATOR
-                        LUT = (float *)Alloc(decoder->allocator, 4 * size * size * size * 3);
-#else
                         LUT = (float *)MEMORY_ALLOC(4 * size * size * size * 3);
-#endif
                         if (LUT)
                         {
                             fseek(fp, CFLKhdr.hdrsize, SEEK_SET);
@@ -5216,9 +5736,11 @@ float *LoadCube64_3DLUT(DECODER *decoder, CFHDDATA *cfhddata, int *lutsize)
     {
         if (useLUT)
         {
-            decoder->LUTcacheCRC = cfhddata->user_look_CRC;
+            LUT = LUTCacheInsert(cfhddata->user_look_CRC, LUT, *lutsize);
+
+            decoder->LUTcacheCRC = LUT ? cfhddata->user_look_CRC : 0;
             decoder->LUTcache = LUT;
-            decoder->LUTcacheSize = *lutsize;
+            decoder->LUTcacheSize = LUT ? *lutsize : 0;
         }
         else
         {
@@ -5298,6 +5820,47 @@ int CompareTags(unsigned char *ptr1, unsigned char *ptr2, int len)
 }
 
 
+// Keep a copy of the metadata chunk, replacing the copy of a chunk with the same tuples
+void SaveMetadataChunk(DECODER *decoder, unsigned char *ptr, int len)
+{
+    if (decoder->metadatachunks < METADATA_CHUNK_MAX)
+    {
+        int i;
+        bool found = false;
+
+        for (i = 0; i < decoder->metadatachunks; i++)
+        {
+            if (decoder->mdc_size[i] == len)
+            {
+                if (0 == CompareTags(decoder->mdc[i], ptr, len))
+                {
+                    memcpy(decoder->mdc[i], ptr, len); // If same info type is present, use the later info (e.g. latest relevant keyframe.)
+                    found = true;
+                    break;
+                }
+            }
+        }
+
+        if (!found)
+        {
+#if _ALLOCATOR
+            if (decoder->mdc[decoder->metadatachunks])
+                Free(decoder->allocator, decoder->mdc[decoder->metadatachunks]);
+            decoder->mdc[decoder->metadatachunks] = (unsigned char *)Alloc(decoder->allocator, len);
+#else
+            if (decoder->mdc[decoder->metadatachunks])
+                MEMORY_FREE(decoder->mdc[decoder->metadatachunks]);
+            decoder->mdc[decoder->metadatachunks] = (unsigned char *)MEMORY_ALLOC(len);
+#endif
+            if (decoder->mdc[decoder->metadatachunks])
+                memcpy(decoder->mdc[decoder->metadatachunks], ptr, len);
+            decoder->mdc_size[decoder->metadatachunks] = len;
+
+            decoder->metadatachunks++;
+        }
+    }
+}
+
 void UpdateCFHDDATA(DECODER *decoder, unsigned char *ptr, int len, int delta, int priority)
 {
     int chn = 0;
@@ -5322,42 +5885,7 @@ void UpdateCFHDDATA(DECODER *decoder, unsigned char *ptr, int len, int delta, in
         bool terminate = false;
         int localpri = priority;
 
-        if (decoder->metadatachunks < METADATA_CHUNK_MAX)
-        {
-            int i;
-            bool found = false;
-
-            for (i = 0; i < decoder->metadatachunks; i++)
-            {
-                if (decoder->mdc_size[i] == len)
-                {
-                    if (0 == CompareTags(decoder->mdc[i], ptr, len))
-                    {
-                        memcpy(decoder->mdc[i], ptr, len); // If same info type is present, use the later info (e.g. latest relevant keyframe.)
-                        found = true;
-                        break;
-                    }
-                }
-            }
-
-            if (!found)
-            {
-#if _ALLOCATOR
-                if (decoder->mdc[decoder->metadatachunks])
-                    Free(decoder->allocator, decoder->mdc[decoder->metadatachunks]);
-                decoder->mdc[decoder->metadatachunks] = (unsigned char *)Alloc(decoder->allocator, len);
-#else
-                if (decoder->mdc[decoder->metadatachunks])
-                    MEMORY_FREE(decoder->mdc[decoder->metadatachunks]);
-                decoder->mdc[decoder->metadatachunks] = (unsigned char *)MEMORY_ALLOC(len);
-#endif
-                if (decoder->mdc[decoder->metadatachunks])
-                    memcpy(decoder->mdc[decoder->metadatachunks], ptr, len);
-                decoder->mdc_size[decoder->metadatachunks] = len;
-
-                decoder->metadatachunks++;
-            }
-        }
+        SaveMetadataChunk(decoder, ptr, len);
 
         while (pos + 12 <= len && !terminate)
         {
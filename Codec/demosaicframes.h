@@ -31,6 +31,9 @@ typedef int DEBAYER_ORDERING;
 #define BAYER_FORMAT_GRN_BLU		2
 #define BAYER_FORMAT_BLU_GRN		3
 
+// Value of the highquality argument to DebayerLine that selects the edge-directed demosaic
+#define DEBAYER_EDGE_DIRECTED		2
+
 
 #ifdef __cplusplus
 extern "C" {
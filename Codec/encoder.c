@@ -55,6 +55,8 @@
 #include "metadata.h"
 #include "thumbnail.h"
 #include "lutpath.h"
+#include "crc.h"
+#include "frame_threading.h"
 
 #if _RECURSIVE
 #include "recursive.h"
@@ -131,66 +133,6 @@ void SetEncoderAffinityMask(ENCODER *encoder);
 #define ROUNDUP(a, b)	((((a) + ((b) - 1)) / (b)) * b)
 
 
-/* Table of CRCs of all 8-bit messages. */
-uint32_t crc_tableA[256];
-
-/* Flag: has the table been computed? Initially false. */
-int crc_table_computedA = 0;
-
-/* Make the table for a fast CRC. */
-void make_crc_tableA(void)
-{
-    uint32_t c;
-    int n, k;
-
-    for (n = 0; n < 256; n++)
-    {
-        c = (uint32_t)n;
-        for (k = 0; k < 8; k++)
-        {
-            if (c & 1)
-                c = 0xedb88320L ^ (c >> 1);
-            else
-                c = c >> 1;
-        }
-        crc_tableA[n] = c;
-    }
-    crc_table_computedA = 1;
-}
-
-/* Update a running CRC with the bytes buf[0..len-1]--the CRC
-should be initialized to all 1's, and the transmitted value
-is the 1's complement of the final running CRC (see the
-crc() routine below)). */
-
-uint32_t update_crcA(uint32_t crc, unsigned char *buf,
-                     int len)
-{
-    uint32_t c = crc;
-    int n;
-
-    if (!crc_table_computedA)
-        make_crc_tableA();
-    for (n = 0; n < len; n++)
-    {
-        c = crc_tableA[(c ^ buf[n]) & 0xff] ^ (c >> 8);
-    }
-    return c;
-}
-
-/* Return the CRC of the bytes buf[0..len-1]. */
-uint32_t calccrcA(unsigned char *buf, int len)
-{
-    return update_crcA(0xffffffffL, buf, len) ^ 0xffffffffL;
-}
-
-/* Return the CRC of the bytes buf[0..len-1]. */
-uint32_t gencrc(unsigned char *buf, int len)
-{
-    return update_crcA(0xffffffffL, buf, len) ^ 0xffffffffL;
-}
-
-
 
 void InitEncoder(ENCODER *encoder, FILE *logfile, CODESET *cs)
 {
@@ -712,6 +654,27 @@ void ClearEncoder(ENCODER *encoder)
 #endif
         encoder->linebuffer = NULL;
     }
+
+    if (encoder->convert_threads)
+    {
+        DeleteFrameConvertThreads(encoder->convert_threads);
+        encoder->convert_threads = NULL;
+    }
+}
+
+// Return the worker threads for converting the input frame (created on first use)
+static FRAME_CONVERT_THREADS *GetFrameConvertThreads(ENCODER *encoder)
+{
+    if (encoder->convert_threads == NULL)
+    {
+#if _ALLOCATOR
+        encoder->convert_threads = CreateFrameConvertThreads(encoder->allocator);
+#else
+        encoder->convert_threads = CreateFrameConvertThreads();
+#endif
+    }
+
+    return encoder->convert_threads;
 }
 
 // Cleanup the encoder before the program exits
@@ -1930,11 +1893,11 @@ bool EncodeSample(ENCODER *encoder, uint8_t *data, int width, int height, int pi
             seed = *((unsigned int *)frame_base);
             if (encoder->metadata.global.block && encoder->metadata.global.size)
             {
-                seed += calccrcA((uint8_t *)encoder->metadata.global.block, (int)encoder->metadata.global.size);
+                seed += CalculateCRC32(encoder->metadata.global.block, encoder->metadata.global.size);
             }
             if (encoder->metadata.local.block && encoder->metadata.local.size)
             {
-                seed += calccrcA((uint8_t *)encoder->metadata.local.block, (int)encoder->metadata.local.size);
+                seed += CalculateCRC32(encoder->metadata.local.block, encoder->metadata.local.size);
             }
             srand(seed);
 
@@ -2219,8 +2182,8 @@ bool EncodeSample(ENCODER *encoder, uint8_t *data, int width, int height, int pi
                 encoder->encoder_quality |= 0x1a00000;//CFEncode_Temporal_Quality_32;
 
                 // Convert the packed RGB data to planes of YUV 4:2:2 (one byte per pixel)
-                ConvertNV12to10bitYUVFrame(data, pitch, frame, (uint8_t *)buffer, (int)buffer_size,
-                                           encoder->input.color_space, encoder->codec.precision, encoder->progressive);
+                ConvertNV12to10bitYUVFrameThreaded(GetFrameConvertThreads(encoder), data, pitch, frame, (uint8_t *)buffer, (int)buffer_size,
+                                                   encoder->input.color_space, encoder->codec.precision, encoder->progressive);
             }
             break;
 
@@ -2333,14 +2296,14 @@ bool EncodeSample(ENCODER *encoder, uint8_t *data, int width, int height, int pi
                     // Convert to three planes of RGB with 4:4:4 sampling and 12 bit precision
                     codec->precision = CODEC_PRECISION_12BIT;
                     //Does alpha range tweak
-                    ConvertBGRA64ToFrame_4444_16s(data, pitch, frame, (uint8_t *)buffer, codec->precision);
+                    ConvertBGRA64ToFrame_4444_16sThreaded(GetFrameConvertThreads(encoder), data, pitch, frame, (uint8_t *)buffer, codec->precision);
                 }
                 else if (encoded_format == ENCODED_FORMAT_RGBA_4444)
                 {
                     // Convert to three planes of RGB with 4:4:4 sampling and 12 bit precision
                     codec->precision = CODEC_PRECISION_12BIT;
                     //Does alpha range tweak
-                    ConvertBGRA64ToFrame_4444_16s(data, pitch, frame, (uint8_t *)buffer, codec->precision);
+                    ConvertBGRA64ToFrame_4444_16sThreaded(GetFrameConvertThreads(encoder), data, pitch, frame, (uint8_t *)buffer, codec->precision);
                 }
                 else if (encoded_format == ENCODED_FORMAT_YUV_422)
                 {
@@ -2374,7 +2337,7 @@ bool EncodeSample(ENCODER *encoder, uint8_t *data, int width, int height, int pi
                     else
                     {
                         // Convert the packed 10-bit YUV 4:2:2 to planes of 8-bit YUV
-                        ConvertV210ToFrame16s(data, pitch, frame, (uint8_t *)buffer);
+                        ConvertV210ToFrame16sThreaded(GetFrameConvertThreads(encoder), data, pitch, frame, (uint8_t *)buffer);
                         codec->precision = CODEC_PRECISION_10BIT;
                     }
                 }
@@ -2581,13 +2544,13 @@ bool EncodeSample(ENCODER *encoder, uint8_t *data, int width, int height, int pi
                 {
                     int alpha = 0;
                     codec->precision = CODEC_PRECISION_12BIT;
-                    ConvertRGBA64ToFrame16s(data, pitch, frame, (uint8_t *)buffer, codec->precision, origformat, alpha);
+                    ConvertRGBA64ToFrame16sThreaded(GetFrameConvertThreads(encoder), data, pitch, frame, (uint8_t *)buffer, codec->precision, origformat, alpha);
                 }
                 else if (encoded_format == ENCODED_FORMAT_RGBA_4444)
                 {
                     int alpha = 1;
                     codec->precision = CODEC_PRECISION_12BIT;
-                    ConvertRGBA64ToFrame16s(data, pitch, frame, (uint8_t *)buffer, codec->precision, origformat, alpha);
+                    ConvertRGBA64ToFrame16sThreaded(GetFrameConvertThreads(encoder), data, pitch, frame, (uint8_t *)buffer, codec->precision, origformat, alpha);
                 }
                 else if (encoded_format == ENCODED_FORMAT_YUV_422)
                 {
@@ -2649,7 +2612,7 @@ bool EncodeSample(ENCODER *encoder, uint8_t *data, int width, int height, int pi
                     {
                         codec->precision = CODEC_PRECISION_12BIT;
 #if !FAST_RG30
-                        ConvertRGBA64ToFrame16s(data, pitch, frame, (uint8_t *)buffer, codec->precision, origformat, 0 /*alpha*/);
+                        ConvertRGBA64ToFrame16sThreaded(GetFrameConvertThreads(encoder), data, pitch, frame, (uint8_t *)buffer, codec->precision, origformat, 0 /*alpha*/);
 #endif
                     }
                 }
@@ -3260,6 +3223,8 @@ bool EncodeSample(ENCODER *encoder, uint8_t *data, int width, int height, int pi
         video_channels--;
         if (video_channels > 0)
         {
+            // Keep the conversion threads if they were created while encoding the first channel
+            encoder_copy.convert_threads = encoder->convert_threads;
             memcpy(encoder, &encoder_copy, sizeof(ENCODER));
             if (!encoder->preformatted3D) //double height full frame 3D encode
             {
@@ -379,6 +379,9 @@ typedef struct encoder  	// Encoder state (derived from codec)
     //Used by BRY5 unpacking, can be used by
     uint8_t *linebuffer;
 
+    // Worker threads for converting the input frame (created on first use)
+    struct frame_convert_threads *convert_threads;
+
     // use to generate a DPX thumbnail.
     int thumbnail_generate;
 
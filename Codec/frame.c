@@ -38,6 +38,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#if _AVX2OPT
+#include <immintrin.h>		// AVX2 intrinsics
+#include "cpuid.h"
+#endif
+
 #define DEBUG  (1 && _DEBUG)
 #define TIMING (1 && _TIMING)
 #define XMMOPT (1 && _XMMOPT)
@@ -561,59 +566,7 @@ void ConvertNV12to10bitYUVFrame(uint8_t *nv12, int pitch, FRAME *frame,  uint8_t
 
         if (progressive)
         {
-            nv12Yline   = nv12;
-            nv12UVline  = nv12Yline + width * display_height;
-            nv12UVnext  = nv12UVline + width;
-
-            for (row = 0; row < display_height; row++)
-            {
-                int column = 0;
-
-                Y_row16 = (PIXEL *)Y_row;
-                U_row16 = (PIXEL *)U_row;
-                V_row16 = (PIXEL *)V_row;
-
-                if (row == 0 || row >= display_height - 2)
-                {
-                    for (column = 0; column < roi.width; column += 2)
-                    {
-                        Y_row16[column] = nv12Yline[column] << 2;
-                        Y_row16[column + 1] = nv12Yline[column + 1] << 2;
-                        V_row16[column / 2] = nv12UVline[column] << 2;
-                        U_row16[column / 2] = nv12UVline[column + 1] << 2;
-                    }
-                    nv12Yline += width;
-                }
-                else if (row & 1)
-                {
-                    for (column = 0; column < roi.width; column += 2)
-                    {
-                        Y_row16[column] = nv12Yline[column] << 2;
-                        Y_row16[column + 1] = nv12Yline[column + 1] << 2;
-                        V_row16[column / 2] = (nv12UVline[column] * 3 + nv12UVnext[column]);
-                        U_row16[column / 2] = (nv12UVline[column + 1] * 3 + nv12UVnext[column + 1]);
-                    }
-                    nv12Yline += width;
-                }
-                else
-                {
-                    for (column = 0; column < roi.width; column += 2)
-                    {
-                        Y_row16[column] = nv12Yline[column] << 2;
-                        Y_row16[column + 1] = nv12Yline[column + 1] << 2;
-                        V_row16[column / 2] = (nv12UVline[column] + nv12UVnext[column] * 3);
-                        U_row16[column / 2] = (nv12UVline[column + 1] + nv12UVnext[column + 1] * 3);
-                    }
-                    nv12Yline += width;
-                    nv12UVline = nv12UVnext;
-                    nv12UVnext = nv12UVline + width;
-                }
-
-                // Advance the YUV pointers
-                Y_row += Y_pitch;
-                U_row += U_pitch;
-                V_row += V_pitch;
-            }
+            ConvertNV12RowsTo10bitYUVFrame(nv12, frame, 0, height);
         }
         else
         {
@@ -724,32 +677,31 @@ void ConvertNV12to10bitYUVFrame(uint8_t *nv12, int pitch, FRAME *frame,  uint8_t
                 U_row += U_pitch;
                 V_row += V_pitch;
             }
-        }
-
-        for (; row < height; row++)
-        {
-            int column = 0;
 
-            Y_row16 = (PIXEL *)Y_row;
-            U_row16 = (PIXEL *)U_row;
-            V_row16 = (PIXEL *)V_row;
-            for (; column < roi.width; column += 2)
+            for (; row < height; row++)
             {
-                int Y = 64, UV = 512;
+                int column = 0;
 
-                Y_row16[column] = Y;
+                Y_row16 = (PIXEL *)Y_row;
+                U_row16 = (PIXEL *)U_row;
+                V_row16 = (PIXEL *)V_row;
+                for (; column < roi.width; column += 2)
+                {
+                    int Y = 64, UV = 512;
 
-                U_row16[column / 2] = UV;
-                V_row16[column / 2] = UV;
-                Y_row16[column + 1] = Y;
-            }
+                    Y_row16[column] = Y;
 
-            // Advance the YUV pointers
-            Y_row += Y_pitch;
-            U_row += U_pitch;
-            V_row += V_pitch;
-        }
+                    U_row16[column / 2] = UV;
+                    V_row16[column / 2] = UV;
+                    Y_row16[column + 1] = Y;
+                }
 
+                // Advance the YUV pointers
+                Y_row += Y_pitch;
+                U_row += U_pitch;
+                V_row += V_pitch;
+            }
+        }
 
         // Set the image parameters for each channel
         for (i = 0; i < 3; i++)
@@ -774,6 +726,123 @@ void ConvertNV12to10bitYUVFrame(uint8_t *nv12, int pitch, FRAME *frame,  uint8_t
 }
 
 
+#if _AVX2OPT
+// Convert 32 pixels of NV12 per iteration (returns the number of pixels converted)
+TARGET_AVX2 static int ConvertNV12RowTo10bitAVX2(uint8_t *y_input, uint8_t *uv_line, uint8_t *uv_next,
+        int line_weight, int next_weight, int width,
+        PIXEL *y_output, PIXEL *u_output, PIXEL *v_output)
+{
+    const __m256i line_weight_epi16 = _mm256_set1_epi16((short)line_weight);
+    const __m256i next_weight_epi16 = _mm256_set1_epi16((short)next_weight);
+    const __m256i mask_epi16 = _mm256_set1_epi16(0x00FF);
+    int column = 0;
+
+    for (; column + 32 <= width; column += 32)
+    {
+        __m256i y1_epi16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *)&y_input[column]));
+        __m256i y2_epi16 = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *)&y_input[column + 16]));
+        __m256i uv_line_epi16 = _mm256_loadu_si256((__m256i *)&uv_line[column]);
+        __m256i uv_next_epi16 = _mm256_loadu_si256((__m256i *)&uv_next[column]);
+        __m256i u_epi16;
+        __m256i v_epi16;
+
+        // The first chroma value in each pair goes to the third channel
+        v_epi16 = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_and_si256(uv_line_epi16, mask_epi16), line_weight_epi16),
+                                   _mm256_mullo_epi16(_mm256_and_si256(uv_next_epi16, mask_epi16), next_weight_epi16));
+        u_epi16 = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_srli_epi16(uv_line_epi16, 8), line_weight_epi16),
+                                   _mm256_mullo_epi16(_mm256_srli_epi16(uv_next_epi16, 8), next_weight_epi16));
+
+        _mm256_storeu_si256((__m256i *)&y_output[column], _mm256_slli_epi16(y1_epi16, 2));
+        _mm256_storeu_si256((__m256i *)&y_output[column + 16], _mm256_slli_epi16(y2_epi16, 2));
+        _mm256_storeu_si256((__m256i *)&u_output[column / 2], u_epi16);
+        _mm256_storeu_si256((__m256i *)&v_output[column / 2], v_epi16);
+    }
+
+    return column;
+}
+#endif
+
+// Convert a range of rows of progressive NV12 to 10-bit YUV 4:2:2 planes (rows below the display are filled with black)
+void ConvertNV12RowsTo10bitYUVFrame(uint8_t *nv12, FRAME *frame, int first_row, int last_row)
+{
+    int display_height = frame->display_height;
+    int width = frame->width;
+    int roi_width = frame->channel[0]->width;
+    uint8_t *nv12UVplane = nv12 + width * display_height;
+    int row;
+
+    // The frame format should be three channels of YUV (4:2:2 format)
+    assert(frame->num_channels == 3);
+    assert(frame->format == FRAME_FORMAT_YUV);
+
+    for (row = first_row; row < last_row; row++)
+    {
+        PIXEL *Y_row16 = (PIXEL *)((uint8_t *)frame->channel[0]->band[0] + row * frame->channel[0]->pitch);
+        PIXEL *U_row16 = (PIXEL *)((uint8_t *)frame->channel[1]->band[0] + row * frame->channel[1]->pitch);
+        PIXEL *V_row16 = (PIXEL *)((uint8_t *)frame->channel[2]->band[0] + row * frame->channel[2]->pitch);
+        uint8_t *nv12Yline = nv12 + row * width;
+        uint8_t *nv12UVline;
+        uint8_t *nv12UVnext;
+        int line_weight, next_weight;
+        int uv_row;
+        int column = 0;
+
+        if (row >= display_height)
+        {
+            for (; column < roi_width; column += 2)
+            {
+                int Y = 64, UV = 512;
+
+                Y_row16[column] = Y;
+
+                U_row16[column / 2] = UV;
+                V_row16[column / 2] = UV;
+                Y_row16[column + 1] = Y;
+            }
+            continue;
+        }
+
+        // Each chroma row is interpolated for two output rows and repeated at the top and bottom
+        uv_row = ((row < display_height - 2 ? row : display_height - 2) - 1) / 2;
+        if (uv_row < 0) uv_row = 0;
+        nv12UVline = nv12UVplane + uv_row * width;
+        nv12UVnext = nv12UVline + width;
+
+        if (row == 0 || row >= display_height - 2)
+        {
+            line_weight = 4;
+            next_weight = 0;
+            nv12UVnext = nv12UVline;
+        }
+        else if (row & 1)
+        {
+            line_weight = 3;
+            next_weight = 1;
+        }
+        else
+        {
+            line_weight = 1;
+            next_weight = 3;
+        }
+
+#if _AVX2OPT
+        if (GetProcessorFeatures() & _CPU_FEATURE_AVX2)
+        {
+            column = ConvertNV12RowTo10bitAVX2(nv12Yline, nv12UVline, nv12UVnext, line_weight, next_weight,
+                                               roi_width, Y_row16, U_row16, V_row16);
+        }
+#endif
+        for (; column < roi_width; column += 2)
+        {
+            Y_row16[column] = nv12Yline[column] << 2;
+            Y_row16[column + 1] = nv12Yline[column + 1] << 2;
+            V_row16[column / 2] = nv12UVline[column] * line_weight + nv12UVnext[column] * next_weight;
+            U_row16[column / 2] = nv12UVline[column + 1] * line_weight + nv12UVnext[column + 1] * next_weight;
+        }
+    }
+}
+
+
 void ConvertYV12to10bitYUVFrame(uint8_t *nv12, int pitch, FRAME *frame,  uint8_t *scratch, int scratchsize,
                                 int color_space, int precision, int progressive)
 {
@@ -1287,6 +1356,30 @@ void ConvertV210ToFrame8u(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffe
 //#if BUILD_PROSPECT
 // Convert the packed 10-bit YUV 4:2:2 to planes of 16-bit YUV
 void ConvertV210ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer)
+{
+    int i;
+
+    if (frame == NULL) return;
+
+    ConvertV210RowsToFrame16s(data, pitch, frame, buffer, 0, frame->display_height);
+
+    // Set the image parameters for each channel
+    for (i = 0; i < 3; i++)
+    {
+        IMAGE *image = frame->channel[i];
+        int band;
+
+        // Set the image scale
+        for (band = 0; band < IMAGE_NUM_BANDS; band++)
+            image->scale[band] = 1;
+
+        // Set the pixel type
+        image->pixel_type[0] = PIXEL_TYPE_16S;
+    }
+}
+
+// Convert a range of rows of packed 10-bit YUV 4:2:2 to planes of 16-bit YUV
+void ConvertV210RowsToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer, int first_row, int last_row)
 {
     IMAGE *y_image;
     IMAGE *u_image;
@@ -1300,10 +1393,7 @@ void ConvertV210ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *buff
     int u_pitch;
     int v_pitch;
     int width;
-    int height;
     int row;
-    int i;
-    int display_height;
 
     // Process 16 bytes each of luma and chroma per loop iteration
     //const int column_step = 2 * sizeof(__m64);
@@ -1331,16 +1421,20 @@ void ConvertV210ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *buff
     u_pitch = u_image->pitch / sizeof(PIXEL16S);
     v_pitch = v_image->pitch / sizeof(PIXEL16S);
 
-    width = y_image->width;							// Dimensions of the luma image
-    height = y_image->height;
-    display_height = frame->display_height;
+    width = y_image->width;							// Width of the luma image
 
     //post_column = width - (width % column_step);
 
     // The output pitch should be a positive number (no image inversion)
     assert(v210_pitch > 0);
 
-    for (row = 0; row < display_height; row++)
+    // Advance to the first row in the range
+    v210_row_ptr += first_row * v210_pitch;
+    y_row_ptr += first_row * y_pitch;
+    u_row_ptr += first_row * u_pitch;
+    v_row_ptr += first_row * v_pitch;
+
+    for (row = first_row; row < last_row; row++)
     {
 #if 0
         // Start processing the row at the first column
@@ -1392,20 +1486,6 @@ void ConvertV210ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *buff
         u_row_ptr += u_pitch;
         v_row_ptr += v_pitch;
     }
-
-    // Set the image parameters for each channel
-    for (i = 0; i < 3; i++)
-    {
-        IMAGE *image = frame->channel[i];
-        int band;
-
-        // Set the image scale
-        for (band = 0; band < IMAGE_NUM_BANDS; band++)
-            image->scale[band] = 1;
-
-        // Set the pixel type
-        image->pixel_type[0] = PIXEL_TYPE_16S;
-    }
 }
 //#endif
 
@@ -5595,7 +5675,73 @@ void ConvertBYR5ToFrame16s(int bayer_format, uint8_t *uncompressed_chunk, int pi
 }
 
 
+#if _AVX2OPT
+// Convert eight pixels of 16-bit RGBA or ARGB to planes of GRB(A) per iteration (returns the number of pixels converted)
+TARGET_AVX2 static int ConvertRGBA64RowToPlanar16sAVX2(PIXEL16U *input, int width, int shift, bool argb,
+        PIXEL16U *g_output, PIXEL16U *r_output, PIXEL16U *b_output, PIXEL16U *a_output)
+{
+    // Gather the red, green, blue, and alpha values of the two pixels in each lane into pairs
+    const __m256i gather_rgba = _mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15,
+                                0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
+    const __m256i gather_argb = _mm256_setr_epi8(2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15, 0, 1, 8, 9,
+                                2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15, 0, 1, 8, 9);
+    const __m256i gather_epi8 = argb ? gather_argb : gather_rgba;
+    const __m256i order_epi32 = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    const __m128i shift_si128 = _mm_cvtsi32_si128(shift);
+    const __m256i zero_epi32 = _mm256_setzero_si256();
+    const __m256i alpha_max_epi32 = _mm256_set1_epi32(4095);
+    const __m256i alpha_scale_epi32 = _mm256_set1_epi32(223);
+    const __m256i alpha_round_epi32 = _mm256_set1_epi32(128);
+    const __m256i alpha_offset_epi32 = _mm256_set1_epi32(16 << 4);
+    int column = 0;
+
+    for (; column + 8 <= width; column += 8)
+    {
+        __m256i input1_epi16 = _mm256_loadu_si256((__m256i *)&input[column * 4]);
+        __m256i input2_epi16 = _mm256_loadu_si256((__m256i *)&input[column * 4 + 16]);
+        __m256i rg_epi16;
+        __m256i ba_epi16;
+
+        input1_epi16 = _mm256_shuffle_epi8(_mm256_srl_epi16(input1_epi16, shift_si128), gather_epi8);
+        input2_epi16 = _mm256_shuffle_epi8(_mm256_srl_epi16(input2_epi16, shift_si128), gather_epi8);
+
+        // Transpose into eight red, green, blue, and alpha values
+        rg_epi16 = _mm256_permutevar8x32_epi32(_mm256_unpacklo_epi32(input1_epi16, input2_epi16), order_epi32);
+        ba_epi16 = _mm256_permutevar8x32_epi32(_mm256_unpackhi_epi32(input1_epi16, input2_epi16), order_epi32);
+
+        _mm_storeu_si128((__m128i *)&r_output[column], _mm256_castsi256_si128(rg_epi16));
+        _mm_storeu_si128((__m128i *)&g_output[column], _mm256_extracti128_si256(rg_epi16, 1));
+        _mm_storeu_si128((__m128i *)&b_output[column], _mm256_castsi256_si128(ba_epi16));
+
+        if (a_output)
+        {
+            // Apply the alpha encoding curve to the values between the extremes
+            __m256i a_epi32 = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(ba_epi16, 1));
+            __m256i curve_epi32 = _mm256_mullo_epi32(a_epi32, alpha_scale_epi32);
+            __m256i inside_epi32 = _mm256_and_si256(_mm256_cmpgt_epi32(a_epi32, zero_epi32),
+                                                    _mm256_cmpgt_epi32(alpha_max_epi32, a_epi32));
+            curve_epi32 = _mm256_add_epi32(_mm256_srli_epi32(_mm256_add_epi32(curve_epi32, alpha_round_epi32), 8), alpha_offset_epi32);
+            a_epi32 = _mm256_blendv_epi8(a_epi32, curve_epi32, inside_epi32);
+            a_epi32 = _mm256_permute4x64_epi64(_mm256_packus_epi32(a_epi32, a_epi32), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128((__m128i *)&a_output[column], _mm256_castsi256_si128(a_epi32));
+        }
+    }
+
+    return column;
+}
+#endif
+
 void ConvertRGBA64ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer, int precision, int origformat, int alpha)
+{
+    assert(frame != NULL);
+    if (! (frame != NULL)) return;
+
+    ConvertRGBA64RowsToFrame16s(data, pitch, frame, precision, origformat, alpha, 0, frame->channel[0]->height);
+}
+
+// Convert a range of rows of 16-bit RGBA to planes of 16-bit GRB(A) (rows below the display repeat the last row)
+void ConvertRGBA64RowsToFrame16s(uint8_t *data, int pitch, FRAME *frame, int precision, int origformat, int alpha,
+                                 int first_row, int last_row)
 {
     const int num_channels = alpha ? 4 : 3;
 
@@ -5605,7 +5751,6 @@ void ConvertRGBA64ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *bu
     PIXEL *color_plane[4];
     int color_pitch[4];
     int frame_width = 0;
-    int frame_height = 0;
     int display_height;
     int rowp;
     int i;
@@ -5642,7 +5787,6 @@ void ConvertRGBA64ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *bu
         if (i == 0)
         {
             frame_width = image->width;
-            frame_height = image->height;
         }
     }
 
@@ -5659,7 +5803,16 @@ void ConvertRGBA64ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *bu
         a_row_pitch = color_pitch[3];
     }
 
-    for (rowp = 0; rowp < frame_height/*display_height*/; rowp++) //DAN20090215 File the frame with edge to prevent ringing artifacts.
+    // Advance to the first row in the range
+    r_row_ptr += first_row * r_row_pitch;
+    g_row_ptr += first_row * g_row_pitch;
+    b_row_ptr += first_row * b_row_pitch;
+    if (alpha)
+    {
+        a_row_ptr += first_row * a_row_pitch;
+    }
+
+    for (rowp = first_row; rowp < last_row/*display_height*/; rowp++) //DAN20090215 File the frame with edge to prevent ringing artifacts.
     {
         // Start at the leftmost column
         int column = 0;
@@ -5780,6 +5933,18 @@ void ConvertRGBA64ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *bu
         else
         {
             int shift = 16 - precision;
+#if _AVX2OPT
+            if ((GetProcessorFeatures() & _CPU_FEATURE_AVX2) && 0 <= shift && shift < 16)
+            {
+                // The first plane receives green and the second plane receives red
+                column = ConvertRGBA64RowToPlanar16sAVX2(rgb_ptr, frame_width, shift, false, r_ptr, g_ptr, b_ptr, a_ptr);
+                rgb_ptr += column * 4;
+                r_ptr += column;
+                g_ptr += column;
+                b_ptr += column;
+                if (alpha) a_ptr += column;
+            }
+#endif
             // Process the rest of the column
             for (; column < frame_width; column ++)
             {
@@ -6470,6 +6635,20 @@ CODEC_ERROR ConvertBGRA64ToFrame_4444_16s(uint8_t *data, int pitch, FRAME *frame
 {
     //#pragma unused(buffer);
 
+    //TODO: Need to return error codes
+    assert(frame != NULL);
+    if (! (frame != NULL))
+    {
+        return CODEC_ERROR_INVALID_ARGUMENT;
+    }
+
+    return ConvertBGRA64RowsToFrame_4444_16s(data, pitch, frame, precision, 0, frame->display_height);
+}
+
+// Convert a range of rows of b64a to a frame of planar RGBA
+CODEC_ERROR ConvertBGRA64RowsToFrame_4444_16s(uint8_t *data, int pitch, FRAME *frame, int precision,
+        int first_row, int last_row)
+{
     //TODO: Add code to write the alpha channel into the fourth plane
     int num_channels;
 
@@ -6479,8 +6658,6 @@ CODEC_ERROR ConvertBGRA64ToFrame_4444_16s(uint8_t *data, int pitch, FRAME *frame
     PIXEL *color_plane[FRAME_MAX_CHANNELS];
     int color_pitch[FRAME_MAX_CHANNELS];
     int frame_width;
-    int frame_height;
-    int display_height;
     int row;
     int i;
 
@@ -6523,8 +6700,6 @@ CODEC_ERROR ConvertBGRA64ToFrame_4444_16s(uint8_t *data, int pitch, FRAME *frame
 
     //TODO: Set the alpha flag and number of channels using the values in the frame data structure
 
-    display_height = frame->display_height;
-
     // Get pointers to the image planes and set the pitch for each plane
     for (i = 0; i < num_channels; i++)
     {
@@ -6538,7 +6713,6 @@ CODEC_ERROR ConvertBGRA64ToFrame_4444_16s(uint8_t *data, int pitch, FRAME *frame
         if (i == 0)
         {
             frame_width = image->width;
-            frame_height = image->height;
         }
     }
 
@@ -6563,7 +6737,17 @@ CODEC_ERROR ConvertBGRA64ToFrame_4444_16s(uint8_t *data, int pitch, FRAME *frame
         a_row_pitch = color_pitch[3];
     }
 
-    for (row = 0; row < display_height; row++)
+    // Advance to the first row in the range
+    rgb_row_ptr += first_row * rgb_row_pitch;
+    r_row_ptr += first_row * r_row_pitch;
+    g_row_ptr += first_row * g_row_pitch;
+    b_row_ptr += first_row * b_row_pitch;
+    if (alpha_flag)
+    {
+        a_row_ptr += first_row * a_row_pitch;
+    }
+
+    for (row = first_row; row < last_row; row++)
     {
         // Start at the leftmost column
         int column = 0;
@@ -6582,6 +6766,18 @@ CODEC_ERROR ConvertBGRA64ToFrame_4444_16s(uint8_t *data, int pitch, FRAME *frame
         PIXEL16U *b_ptr = (PIXEL16U *)b_row_ptr;
         PIXEL16U *a_ptr = (PIXEL16U *)a_row_ptr;
 
+#if _AVX2OPT
+        if ((GetProcessorFeatures() & _CPU_FEATURE_AVX2) && 0 <= shift && shift < 16)
+        {
+            column = ConvertRGBA64RowToPlanar16sAVX2(rgb_ptr, frame_width, shift, true, g_ptr, r_ptr, b_ptr,
+                     alpha_flag ? a_ptr : NULL);
+            rgb_ptr += column * 4;
+            r_ptr += column;
+            g_ptr += column;
+            b_ptr += column;
+            if (alpha_flag) a_ptr += column;
+        }
+#endif
         // Process the rest of the column
         for (; column < frame_width; column ++)
         {
@@ -117,6 +117,7 @@ void ConvertRGB32to10bitYUVFrame(uint8_t *rgb, int pitch, FRAME *frame, uint8_t
                                  int scratchsize, int colorspace, int precision, int srcHasAlpha, int rgbaswap);
 void ConvertNV12to10bitYUVFrame(uint8_t *rgb, int pitch, FRAME *frame, uint8_t *scratch,
                                 int scratchsize, int colorspace, int precision, int progressive);
+void ConvertNV12RowsTo10bitYUVFrame(uint8_t *nv12, FRAME *frame, int first_row, int last_row);
 void ConvertYV12to10bitYUVFrame(uint8_t *rgb, int pitch, FRAME *frame, uint8_t *scratch,
                                 int scratchsize, int colorspace, int precision, int progressive);
 
@@ -127,6 +128,7 @@ void ConvertV210ToFrame8u(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffe
 
 // Convert the packed 10-bit YUV 4:2:2 to planes of 16-bit YUV
 void ConvertV210ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer);
+void ConvertV210RowsToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer, int first_row, int last_row);
 // Convert the unpacked 16-bit YUV 4:2:2 to planes of 16-bit YUV
 void ConvertYU64ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer);
 
@@ -155,6 +157,8 @@ int ConvertPackedToRawBayer16(int width, int height, uint32_t *uncompressed_chun
 
 void ConvertRGB48ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer, int precision, int origformat);
 void ConvertRGBA64ToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer, int precision, int origformat, int alpha);
+void ConvertRGBA64RowsToFrame16s(uint8_t *data, int pitch, FRAME *frame, int precision, int origformat, int alpha,
+                                 int first_row, int last_row);
 void ConvertRGBtoRGB48(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer, int precision);
 void ConvertRGBAtoRGB48(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer, int precision, int rgbaswap);
 void ConvertRGBAtoRGBA64(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer, int precision, int rgbaswap);
@@ -201,6 +205,8 @@ void ConvertLowpassRGB444ToRGBA64(PIXEL *plane_array[], int pitch_array[],
 // Convert QuickTime b64a to planar RGB with optional alpha channel
 CODEC_ERROR ConvertBGRA64ToFrame_4444_16s(uint8_t *data, int pitch, FRAME *frame,
         uint8_t *buffer, int precision);
+CODEC_ERROR ConvertBGRA64RowsToFrame_4444_16s(uint8_t *data, int pitch, FRAME *frame, int precision,
+        int first_row, int last_row);
 
 // Convert Final Cut Pro 'r4fl' to planar YUV
 void ConvertYUVAFloatToFrame16s(uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer);
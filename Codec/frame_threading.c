@@ -0,0 +1,331 @@
+/*! @file frame_threading.c
+
+*  @brief Row-parallel conversion of the encoder input into planes of 16-bit pixels
+*
+*  The input frame is divided into groups of rows that are converted by a pool
+*  of worker threads.  The pool is created by the encoder the first time that a
+*  large frame is converted and is reused for every frame after that.
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+#include "config.h"
+#include "image.h"
+#include "cpuid.h"
+#include "frame_threading.h"
+
+// Frames with fewer rows than this are converted on the calling thread
+#define FRAME_CONVERT_MIN_ROWS	(4 * FRAME_CONVERT_JOB_ROWS)
+
+
+static void ConvertFrameRows(FRAME_CONVERT_THREADS *threads, int first_row, int last_row, int thread_index)
+{
+    switch (threads->type)
+    {
+        case FRAME_CONVERT_V210:
+        {
+            uint8_t *buffer = threads->row_buffer + thread_index * threads->row_buffer_pitch;
+            ConvertV210RowsToFrame16s(threads->data, threads->pitch, threads->frame, buffer, first_row, last_row);
+        }
+        break;
+
+        case FRAME_CONVERT_NV12:
+            ConvertNV12RowsTo10bitYUVFrame(threads->data, threads->frame, first_row, last_row);
+            break;
+
+        case FRAME_CONVERT_RGBA64:
+            ConvertRGBA64RowsToFrame16s(threads->data, threads->pitch, threads->frame, threads->precision,
+                                        threads->origformat, threads->alpha, first_row, last_row);
+            break;
+
+        case FRAME_CONVERT_B64A:
+            ConvertBGRA64RowsToFrame_4444_16s(threads->data, threads->pitch, threads->frame, threads->precision,
+                                              first_row, last_row);
+            break;
+
+        default:
+            assert(0);
+            break;
+    }
+}
+
+static THREAD_PROC(FrameConvertThreadProc, lpParam)
+{
+    FRAME_CONVERT_THREADS *threads = (FRAME_CONVERT_THREADS *)lpParam;
+    THREAD_ERROR error = THREAD_ERROR_OKAY;
+    int thread_index;
+
+    // Determine the index of this worker thread
+    error = PoolThreadGetIndex(&threads->pool, &thread_index);
+    assert(error == THREAD_ERROR_OKAY);
+
+    for (;;)
+    {
+        THREAD_MESSAGE message = THREAD_MESSAGE_NONE;
+        error = PoolThreadWaitForMessage(&threads->pool, thread_index, &message);
+
+        // Received a signal to begin?
+        if (error == THREAD_ERROR_OKAY && message == THREAD_MESSAGE_START)
+        {
+            for (;;)
+            {
+                int work_index = -1;
+
+                error = PoolThreadWaitForWork(&threads->pool, &work_index, thread_index);
+
+                // Is there another group of rows to convert?
+                if (error == THREAD_ERROR_OKAY)
+                {
+                    int first_row = work_index * FRAME_CONVERT_JOB_ROWS;
+                    int last_row = first_row + FRAME_CONVERT_JOB_ROWS;
+
+                    if (last_row > threads->num_rows) last_row = threads->num_rows;
+
+                    ConvertFrameRows(threads, first_row, last_row, thread_index);
+                }
+                else if (error == THREAD_ERROR_NOWORK)
+                {
+                    PoolThreadSignalDone(&threads->pool, thread_index);
+                    break;
+                }
+            }
+        }
+        else if (error == THREAD_ERROR_OKAY && message == THREAD_MESSAGE_STOP)
+        {
+            // The worker thread has been told to terminate itself
+            break;
+        }
+        else if (error != THREAD_ERROR_OKAY)
+        {
+            // If the wait failed it probably means that the thread pool is shutting down
+            break;
+        }
+    }
+
+    return (THREAD_RETURN_TYPE)error;
+}
+
+// Convert the rows set in the thread data using all of the worker threads
+static void ConvertFrameThreaded(FRAME_CONVERT_THREADS *threads)
+{
+    int work_count = (threads->num_rows + FRAME_CONVERT_JOB_ROWS - 1) / FRAME_CONVERT_JOB_ROWS;
+
+    ThreadPoolSetWorkCount(&threads->pool, work_count);
+    ThreadPoolSendMessage(&threads->pool, THREAD_MESSAGE_START);
+    ThreadPoolWaitAllDone(&threads->pool);
+
+    threads->type = FRAME_CONVERT_NONE;
+    threads->data = NULL;
+    threads->frame = NULL;
+}
+
+// Set the image parameters for each channel of a frame of 16-bit planes
+static void SetFrameParameters16s(FRAME *frame)
+{
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        IMAGE *image = frame->channel[i];
+        int band;
+
+        // Set the image scale
+        for (band = 0; band < IMAGE_NUM_BANDS; band++)
+            image->scale[band] = 1;
+
+        // Set the pixel type
+        image->pixel_type[0] = PIXEL_TYPE_16S;
+    }
+}
+
+#if _ALLOCATOR
+FRAME_CONVERT_THREADS *CreateFrameConvertThreads(ALLOCATOR *allocator)
+#else
+FRAME_CONVERT_THREADS *CreateFrameConvertThreads()
+#endif
+{
+    FRAME_CONVERT_THREADS *threads;
+    int thread_count = GetProcessorCount();
+
+    if (thread_count > FRAME_CONVERT_MAX_THREADS) thread_count = FRAME_CONVERT_MAX_THREADS;
+
+    // Not worth the overhead of handing the rows to other threads
+    if (thread_count < 2) return NULL;
+
+#if _ALLOCATOR
+    threads = (FRAME_CONVERT_THREADS *)Alloc(allocator, sizeof(FRAME_CONVERT_THREADS));
+#else
+    threads = (FRAME_CONVERT_THREADS *)MEMORY_ALLOC(sizeof(FRAME_CONVERT_THREADS));
+#endif
+    if (threads == NULL) return NULL;
+
+    memset(threads, 0, sizeof(FRAME_CONVERT_THREADS));
+
+#if _ALLOCATOR
+    threads->allocator = allocator;
+#endif
+
+    ThreadPoolCreate(&threads->pool, thread_count, FrameConvertThreadProc, threads);
+
+    return threads;
+}
+
+void DeleteFrameConvertThreads(FRAME_CONVERT_THREADS *threads)
+{
+#if _ALLOCATOR
+    ALLOCATOR *allocator;
+#endif
+
+    if (threads == NULL) return;
+
+#if _ALLOCATOR
+    allocator = threads->allocator;
+#endif
+
+    ThreadPoolDelete(&threads->pool);
+
+    if (threads->row_buffer)
+    {
+#if _ALLOCATOR
+        FreeAligned(allocator, threads->row_buffer);
+#else
+        MEMORY_ALIGNED_FREE(threads->row_buffer);
+#endif
+        threads->row_buffer = NULL;
+    }
+
+#if _ALLOCATOR
+    Free(allocator, threads);
+#else
+    MEMORY_FREE(threads);
+#endif
+}
+
+void ConvertV210ToFrame16sThreaded(FRAME_CONVERT_THREADS *threads, uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer)
+{
+    size_t row_buffer_pitch = ALIGN(pitch, _CACHE_LINE_SIZE);
+
+    if (threads == NULL || frame == NULL || frame->display_height < FRAME_CONVERT_MIN_ROWS || pitch <= 0)
+    {
+        ConvertV210ToFrame16s(data, pitch, frame, buffer);
+        return;
+    }
+
+    // Each thread needs its own aligned copy of rows that are not aligned in the input
+    if (!ISALIGNED16(data) || !ISALIGNED16(pitch))
+    {
+        if (threads->row_buffer == NULL || threads->row_buffer_pitch < row_buffer_pitch)
+        {
+#if _ALLOCATOR
+            ALLOCATOR *allocator = threads->allocator;
+
+            if (threads->row_buffer) FreeAligned(allocator, threads->row_buffer);
+            threads->row_buffer = (uint8_t *)AllocAligned(allocator, row_buffer_pitch * threads->pool.thread_count, _CACHE_LINE_SIZE);
+#else
+            if (threads->row_buffer) MEMORY_ALIGNED_FREE(threads->row_buffer);
+            threads->row_buffer = (uint8_t *)MEMORY_ALIGNED_ALLOC(row_buffer_pitch * threads->pool.thread_count, _CACHE_LINE_SIZE);
+#endif
+            threads->row_buffer_pitch = (threads->row_buffer != NULL) ? row_buffer_pitch : 0;
+        }
+
+        if (threads->row_buffer == NULL)
+        {
+            ConvertV210ToFrame16s(data, pitch, frame, buffer);
+            return;
+        }
+    }
+
+    threads->type = FRAME_CONVERT_V210;
+    threads->data = data;
+    threads->pitch = pitch;
+    threads->frame = frame;
+    threads->num_rows = frame->display_height;
+
+    ConvertFrameThreaded(threads);
+
+    SetFrameParameters16s(frame);
+}
+
+void ConvertNV12to10bitYUVFrameThreaded(FRAME_CONVERT_THREADS *threads, uint8_t *nv12, int pitch, FRAME *frame,
+                                        uint8_t *scratch, int scratchsize, int color_space, int precision, int progressive)
+{
+    // Interlaced chroma is interpolated within each field and is converted on the calling thread
+    if (threads == NULL || !progressive || frame->display_height < FRAME_CONVERT_MIN_ROWS)
+    {
+        ConvertNV12to10bitYUVFrame(nv12, pitch, frame, scratch, scratchsize, color_space, precision, progressive);
+        return;
+    }
+
+    threads->type = FRAME_CONVERT_NV12;
+    threads->data = nv12;
+    threads->pitch = pitch;
+    threads->frame = frame;
+    threads->num_rows = frame->height;
+
+    ConvertFrameThreaded(threads);
+
+    SetFrameParameters16s(frame);
+
+#if _MONOCHROME
+    // Continue with the gray channel only (useful for debugging)
+    frame->num_channels = 1;
+    frame->format = FRAME_FORMAT_GRAY;
+#endif
+}
+
+void ConvertRGBA64ToFrame16sThreaded(FRAME_CONVERT_THREADS *threads, uint8_t *data, int pitch, FRAME *frame,
+                                     uint8_t *buffer, int precision, int origformat, int alpha)
+{
+    if (threads == NULL || frame == NULL || frame->display_height < FRAME_CONVERT_MIN_ROWS)
+    {
+        ConvertRGBA64ToFrame16s(data, pitch, frame, buffer, precision, origformat, alpha);
+        return;
+    }
+
+    threads->type = FRAME_CONVERT_RGBA64;
+    threads->data = data;
+    threads->pitch = pitch;
+    threads->frame = frame;
+    threads->precision = precision;
+    threads->origformat = origformat;
+    threads->alpha = alpha;
+    threads->num_rows = frame->channel[0]->height;
+
+    ConvertFrameThreaded(threads);
+}
+
+CODEC_ERROR ConvertBGRA64ToFrame_4444_16sThreaded(FRAME_CONVERT_THREADS *threads, uint8_t *data, int pitch, FRAME *frame,
+        uint8_t *buffer, int precision)
+{
+    // Let the conversion routine report frames that it cannot convert
+    if (threads == NULL || frame == NULL || frame->display_height < FRAME_CONVERT_MIN_ROWS ||
+            !(frame->format == FRAME_FORMAT_RGB || frame->format == FRAME_FORMAT_RGBA) ||
+            pitch * 8 / frame->channel[0]->width == 32)
+    {
+        return ConvertBGRA64ToFrame_4444_16s(data, pitch, frame, buffer, precision);
+    }
+
+    threads->type = FRAME_CONVERT_B64A;
+    threads->data = data;
+    threads->pitch = pitch;
+    threads->frame = frame;
+    threads->precision = precision;
+    threads->num_rows = frame->display_height;
+
+    ConvertFrameThreaded(threads);
+
+    return CODEC_ERROR_OKAY;
+}
@@ -0,0 +1,98 @@
+/*! @file frame_threading.h
+
+*  @brief Row-parallel conversion of the encoder input into planes of 16-bit pixels
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#ifndef _FRAME_THREADING_H
+#define _FRAME_THREADING_H
+
+#include "config.h"
+#include "thread.h"
+#include "allocator.h"
+#include "frame.h"
+
+// Limit on the number of threads (the conversion is bound by memory bandwidth)
+#define FRAME_CONVERT_MAX_THREADS	8
+
+// Number of rows converted by each unit of work
+#define FRAME_CONVERT_JOB_ROWS		16
+
+// Input formats that can be converted by the worker threads
+typedef enum frame_convert_type
+{
+    FRAME_CONVERT_NONE = 0,
+    FRAME_CONVERT_V210,				// Packed 10-bit YUV 4:2:2
+    FRAME_CONVERT_NV12,				// Progressive 8-bit YUV 4:2:0 with interleaved chroma
+    FRAME_CONVERT_RGBA64,			// 16-bit RGBA (with or without alpha)
+    FRAME_CONVERT_B64A,				// 16-bit ARGB to planes of RGB(A) with 4:4:4(:4) sampling
+
+} FRAME_CONVERT_TYPE;
+
+typedef struct frame_convert_threads
+{
+    THREAD_POOL pool;				// Worker threads that convert groups of rows
+
+#if _ALLOCATOR
+    ALLOCATOR *allocator;
+#endif
+
+    // Aligned copy of an input row for each thread (used for unaligned v210 rows)
+    uint8_t *row_buffer;
+    size_t row_buffer_pitch;
+
+    // Parameters for the conversion in progress
+    FRAME_CONVERT_TYPE type;
+    uint8_t *data;
+    int pitch;
+    FRAME *frame;
+    int precision;
+    int origformat;
+    int alpha;
+    int num_rows;
+
+} FRAME_CONVERT_THREADS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Create the worker threads for converting the encoder input (returns NULL if threading is not useful)
+#if _ALLOCATOR
+FRAME_CONVERT_THREADS *CreateFrameConvertThreads(ALLOCATOR *allocator);
+#else
+FRAME_CONVERT_THREADS *CreateFrameConvertThreads();
+#endif
+
+void DeleteFrameConvertThreads(FRAME_CONVERT_THREADS *threads);
+
+// Threaded versions of the input conversion routines (convert on the calling thread if threads is NULL)
+void ConvertV210ToFrame16sThreaded(FRAME_CONVERT_THREADS *threads, uint8_t *data, int pitch, FRAME *frame, uint8_t *buffer);
+
+void ConvertNV12to10bitYUVFrameThreaded(FRAME_CONVERT_THREADS *threads, uint8_t *nv12, int pitch, FRAME *frame,
+                                        uint8_t *scratch, int scratchsize, int color_space, int precision, int progressive);
+
+void ConvertRGBA64ToFrame16sThreaded(FRAME_CONVERT_THREADS *threads, uint8_t *data, int pitch, FRAME *frame,
+                                     uint8_t *buffer, int precision, int origformat, int alpha);
+
+CODEC_ERROR ConvertBGRA64ToFrame_4444_16sThreaded(FRAME_CONVERT_THREADS *threads, uint8_t *data, int pitch, FRAME *frame,
+        uint8_t *buffer, int precision);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,312 @@
+/*!
+ * @file lutcache.c
+ * @brief Process-wide cache of the 3D look tables used by the decoders
+ *
+ * Look tables are identified by the CRC of the look file (user_look_CRC) and
+ * are shared by every decoder instance in the process.  Each decoder holds a
+ * reference to the look table that it is currently using.  Tables that are not
+ * referenced by any decoder are kept in least recently used order until the
+ * cache capacity is exceeded, so that switching between looks does not force
+ * the table to be rebuilt or reloaded.
+ *
+ * (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+ *
+ * Licensed under either:
+ * - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+ * - MIT license, http://opensource.org/licenses/MIT
+ * at your option.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stdafx.h"
+#include "config.h"
+#include "thread.h"
+#include "lutcache.h"
+
+// Smallest and largest look table dimensions accepted by the decoder
+#define LUT_CACHE_MIN_SIZE	8
+#define LUT_CACHE_MAX_SIZE	65
+
+typedef struct lut_cache_entry
+{
+    struct lut_cache_entry *next;	// Next entry in least recently used order
+    uint32_t crc;					// CRC of the look file
+    float *LUT;						// Look table with lutsize^3 RGB triplets
+    int lutsize;					// Number of entries along each axis of the cube
+    int refcount;					// Number of decoders using this look table
+
+} LUT_CACHE_ENTRY;
+
+static struct lut_cache
+{
+    LOCK lock;						// Exclusive access to the cache entries
+    LUT_CACHE_ENTRY *head;			// Most recently used entry
+    int capacity;					// Number of entries retained in the cache
+
+} lut_cache;
+
+#ifdef _WIN32
+static INIT_ONCE lut_cache_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK LUTCacheInitialize(PINIT_ONCE once, PVOID param, PVOID *context)
+{
+    (void) once;
+    (void) param;
+    (void) context;
+
+    CreateLock(&lut_cache.lock);
+    lut_cache.head = NULL;
+    lut_cache.capacity = LUT_CACHE_DEFAULT_CAPACITY;
+    return TRUE;
+}
+
+static void LUTCacheLock(void)
+{
+    InitOnceExecuteOnce(&lut_cache_once, LUTCacheInitialize, NULL, NULL);
+    Lock(&lut_cache.lock);
+}
+#else
+static pthread_once_t lut_cache_once = PTHREAD_ONCE_INIT;
+
+static void LUTCacheInitialize(void)
+{
+    CreateLock(&lut_cache.lock);
+    lut_cache.head = NULL;
+    lut_cache.capacity = LUT_CACHE_DEFAULT_CAPACITY;
+}
+
+static void LUTCacheLock(void)
+{
+    pthread_once(&lut_cache_once, LUTCacheInitialize);
+    Lock(&lut_cache.lock);
+}
+#endif
+
+static void LUTCacheUnlock(void)
+{
+    Unlock(&lut_cache.lock);
+}
+
+// Find the entry for the look table and move it to the front of the list (cache must be locked)
+static LUT_CACHE_ENTRY *LUTCacheFind(uint32_t crc, float *LUT)
+{
+    LUT_CACHE_ENTRY *prev = NULL;
+    LUT_CACHE_ENTRY *entry;
+
+    for (entry = lut_cache.head; entry != NULL; prev = entry, entry = entry->next)
+    {
+        if ((LUT != NULL && entry->LUT == LUT) || (LUT == NULL && entry->crc == crc))
+        {
+            if (prev)
+            {
+                prev->next = entry->next;
+                entry->next = lut_cache.head;
+                lut_cache.head = entry;
+            }
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+// Free the least recently used look tables that exceed the capacity (cache must be locked)
+static void LUTCacheTrim(void)
+{
+    LUT_CACHE_ENTRY **link = &lut_cache.head;
+    int count = 0;
+
+    while (*link != NULL)
+    {
+        LUT_CACHE_ENTRY *entry = *link;
+
+        // Look tables that are in use are never evicted
+        if (count >= lut_cache.capacity && entry->refcount == 0)
+        {
+            *link = entry->next;
+            MEMORY_FREE(entry->LUT);
+            MEMORY_FREE(entry);
+            continue;
+        }
+
+        count++;
+        link = &entry->next;
+    }
+}
+
+float *LUTCacheAcquire(uint32_t crc, int *lutsize)
+{
+    LUT_CACHE_ENTRY *entry;
+    float *LUT = NULL;
+
+    if (crc == 0)
+    {
+        return NULL;
+    }
+
+    LUTCacheLock();
+
+    entry = LUTCacheFind(crc, NULL);
+    if (entry)
+    {
+        entry->refcount++;
+        LUT = entry->LUT;
+        if (lutsize)
+        {
+            *lutsize = entry->lutsize;
+        }
+    }
+
+    LUTCacheUnlock();
+
+    return LUT;
+}
+
+float *LUTCacheInsert(uint32_t crc, float *LUT, int lutsize)
+{
+    LUT_CACHE_ENTRY *entry;
+
+    if (crc == 0 || LUT == NULL)
+    {
+        return NULL;
+    }
+
+    LUTCacheLock();
+
+    // Another decoder may have loaded the same look table in the meantime
+    entry = LUTCacheFind(crc, NULL);
+    if (entry)
+    {
+        if (entry->LUT != LUT)
+        {
+            MEMORY_FREE(LUT);
+        }
+        entry->refcount++;
+        LUT = entry->LUT;
+    }
+    else
+    {
+        entry = (LUT_CACHE_ENTRY *)MEMORY_ALLOC(sizeof(LUT_CACHE_ENTRY));
+        if (entry)
+        {
+            entry->crc = crc;
+            entry->LUT = LUT;
+            entry->lutsize = lutsize;
+            entry->refcount = 1;
+            entry->next = lut_cache.head;
+            lut_cache.head = entry;
+
+            LUTCacheTrim();
+        }
+        else
+        {
+            MEMORY_FREE(LUT);
+            LUT = NULL;
+        }
+    }
+
+    LUTCacheUnlock();
+
+    return LUT;
+}
+
+void LUTCacheRelease(float *LUT)
+{
+    LUT_CACHE_ENTRY *entry;
+
+    if (LUT == NULL)
+    {
+        return;
+    }
+
+    LUTCacheLock();
+
+    entry = LUTCacheFind(0, LUT);
+    assert(entry != NULL && entry->refcount > 0);
+    if (entry && entry->refcount > 0)
+    {
+        entry->refcount--;
+        LUTCacheTrim();
+    }
+
+    LUTCacheUnlock();
+}
+
+bool LUTCachePreload(uint32_t crc, const float *LUT, int lutsize)
+{
+    size_t length;
+    float *copy;
+    float *cached;
+
+    if (crc == 0 || LUT == NULL || lutsize < LUT_CACHE_MIN_SIZE || lutsize > LUT_CACHE_MAX_SIZE)
+    {
+        return false;
+    }
+
+    length = (size_t)lutsize * lutsize * lutsize * 3 * sizeof(float);
+    copy = (float *)MEMORY_ALLOC(length);
+    if (copy == NULL)
+    {
+        return false;
+    }
+    memcpy(copy, LUT, length);
+
+    // Replace any stale table with the same CRC that is not in use
+    LUTCacheLock();
+    {
+        LUT_CACHE_ENTRY **link = &lut_cache.head;
+        while (*link != NULL)
+        {
+            LUT_CACHE_ENTRY *entry = *link;
+            if (entry->crc == crc && entry->refcount == 0)
+            {
+                *link = entry->next;
+                MEMORY_FREE(entry->LUT);
+                MEMORY_FREE(entry);
+                break;
+            }
+            link = &entry->next;
+        }
+    }
+    LUTCacheUnlock();
+
+    // The preloaded table is retained by the cache without a decoder reference
+    cached = LUTCacheInsert(crc, copy, lutsize);
+    if (cached == NULL)
+    {
+        return false;
+    }
+    LUTCacheRelease(cached);
+
+    return true;
+}
+
+void LUTCacheSetCapacity(int capacity)
+{
+    if (capacity < 0)
+    {
+        capacity = 0;
+    }
+
+    LUTCacheLock();
+    lut_cache.capacity = capacity;
+    LUTCacheTrim();
+    LUTCacheUnlock();
+}
+
+void LUTCacheFlush(void)
+{
+    int capacity;
+
+    LUTCacheLock();
+    capacity = lut_cache.capacity;
+    lut_cache.capacity = 0;
+    LUTCacheTrim();
+    lut_cache.capacity = capacity;
+    LUTCacheUnlock();
+}
@@ -0,0 +1,54 @@
+/*!
+ * @file lutcache.h
+ * @brief Process-wide cache of the 3D look tables used by the decoders
+ *
+ * (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+ *
+ * Licensed under either:
+ * - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+ * - MIT license, http://opensource.org/licenses/MIT
+ * at your option.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LUTCACHE_H
+#define _LUTCACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Default number of unreferenced look tables kept in the cache
+#define LUT_CACHE_DEFAULT_CAPACITY	4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Return a reference to the cached look table with the specified CRC (or NULL)
+float *LUTCacheAcquire(uint32_t crc, int *lutsize);
+
+// Add a look table allocated with MEMORY_ALLOC to the cache and return a reference to it
+float *LUTCacheInsert(uint32_t crc, float *LUT, int lutsize);
+
+// Release a reference obtained by LUTCacheAcquire or LUTCacheInsert
+void LUTCacheRelease(float *LUT);
+
+// Copy a look table into the cache so that decoders do not have to build or load it
+bool LUTCachePreload(uint32_t crc, const float *LUT, int lutsize);
+
+// Set the maximum number of look tables retained when no decoder is using them
+void LUTCacheSetCapacity(int capacity);
+
+// Free all look tables that are not in use by a decoder
+void LUTCacheFlush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
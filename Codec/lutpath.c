@@ -126,6 +126,127 @@ void InitializeCFHDDataToDefaults(CFHDDATA *cfhddata, uint32_t colorspace)
     cfhddata->force_metadata_refresh = true;            // first time through
 }
 
+// Maximum number of metadata chunks in a sample that can be checked for changes
+#define METADATA_HASH_CHUNKS 16
+
+// Maximum number of tuples in a sample that change with every frame
+#define METADATA_FRAME_TUPLES 8
+
+static uint64_t HashMetadataBytes(uint64_t hash, const unsigned char *ptr, size_t size)
+{
+    const uint64_t prime = 0x100000001B3ULL;
+    uint64_t word;
+
+    for (; size >= 8; size -= 8, ptr += 8)
+    {
+        memcpy(&word, ptr, sizeof(word));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+
+    for (; size > 0; size--, ptr++)
+    {
+        hash = (hash ^ *ptr) * prime;
+    }
+
+    return hash;
+}
+
+/*!
+    @brief Hash a metadata chunk so that an unchanged chunk can be detected without parsing it again
+
+    The values of the tuples that change with every frame, such as the timecode, are not
+    included in the hash.  The locations of these tuples are returned so that the values
+    can be applied without parsing the rest of the metadata.
+*/
+static bool HashMetadataChunk(uint64_t *hash, unsigned char *ptr, size_t len,
+                              unsigned char **frame_tuple, int *frame_tuple_count)
+{
+    size_t start = 0;
+    size_t pos = 0;
+
+    while (pos + 12 <= len)
+    {
+        uint32_t tag = MAKETAG(ptr[pos + 0], ptr[pos + 1], ptr[pos + 2], ptr[pos + 3]);
+        size_t size = ptr[pos + 4] + (ptr[pos + 5] << 8) + (ptr[pos + 6] << 16);
+
+        if (tag == 0)
+            break;
+
+        if (tag == TAG_UNIQUE_FRAMENUM || tag == TAG_TIMECODE)
+        {
+            if (*frame_tuple_count == METADATA_FRAME_TUPLES)
+                return false;
+
+            // Only the tag, type, and size of the tuple are included in the hash
+            *hash = HashMetadataBytes(*hash, ptr + start, pos + 8 - start);
+            frame_tuple[(*frame_tuple_count)++] = ptr + pos;
+            start = pos + ((8 + size + 3) & 0xfffffc);
+        }
+
+        pos += (8 + size + 3) & 0xfffffc;
+    }
+
+    if (start < len)
+    {
+        *hash = HashMetadataBytes(*hash, ptr + start, len - start);
+    }
+
+    return true;
+}
+
+// Apply the tuples that change with every frame (see the cases in UpdateCFHDDATA)
+static void ApplyFrameMetadata(DECODER *decoder, unsigned char **frame_tuple, int frame_tuple_count)
+{
+    int i;
+
+    for (i = 0; i < frame_tuple_count; i++)
+    {
+        unsigned char *ptr = frame_tuple[i];
+        void *data = (void *)&ptr[8];
+        uint32_t tag = MAKETAG(ptr[0], ptr[1], ptr[2], ptr[3]);
+
+        switch (tag)
+        {
+            case TAG_UNIQUE_FRAMENUM:
+                decoder->codec.unique_framenumber =  *((uint32_t *)data);
+                break;
+
+            case TAG_TIMECODE:
+#ifdef _WIN32
+                strncpy_s(decoder->cfhddata.FileTimecodeData.orgtime, sizeof(decoder->cfhddata.FileTimecodeData.orgtime), (char *)data, 15);
+#else
+                strncpy(decoder->cfhddata.FileTimecodeData.orgtime, (char *)data, 15);
+#endif
+                break;
+        }
+    }
+}
+
+// Save the location of the DSPm objects relative to the metadata chunks that contain them
+static bool SaveMetadataObjects(DECODER *decoder, unsigned char **chunk, size_t *chunk_size, int chunk_count)
+{
+    int i, j;
+
+    for (i = 0; i < decoder->drawmetadataobjects; i++)
+    {
+        for (j = 0; j < chunk_count; j++)
+        {
+            if (decoder->dmo[i] >= chunk[j] && decoder->dmo[i] < chunk[j] + chunk_size[j])
+            {
+                decoder->dmo_chunk[i] = (unsigned char)j;
+                decoder->dmo_offset[i] = (unsigned int)(decoder->dmo[i] - chunk[j]);
+                break;
+            }
+        }
+
+        if (j == chunk_count)
+            return false;
+    }
+
+    return true;
+}
+
 void CopyMetadataChunks(DECODER *decoder, DECODER *parentDecoder)
 {
     int i;
@@ -267,6 +388,7 @@ void OverrideCFHDDATA(DECODER *decoder, unsigned char *lpCurrentBuffer, int nWor
 
             //decoder->codec.unique_framenumber = -1;
             decoder->codec.unique_framenumber = UINT32_MAX;
+            decoder->metadata_hash_valid = false;
         }
         else
             cfhddataInitialized = true;
@@ -274,6 +396,16 @@ void OverrideCFHDDATA(DECODER *decoder, unsigned char *lpCurrentBuffer, int nWor
         if (decoder->image_dev_only || (metadatastart = MetaDataFindFirst(buf, samplesize,
                                         &metadatasize, &tag, &size, &type)))
         {
+            unsigned char *chunk[METADATA_HASH_CHUNKS];
+            size_t chunk_size[METADATA_HASH_CHUNKS];
+            int chunk_count = 0;
+            unsigned char *frame_tuple[METADATA_FRAME_TUPLES];
+            int frame_tuple_count = 0;
+            uint64_t hash = 0xCBF29CE484222325ULL;
+            size_t total_size = 0;
+            bool hashed = !decoder->image_dev_only;
+            int i;
+
             //DAN20080710 -- reset the value before loading them, as some RAW streams didn't have all the
             //value, which causes a database reset to fail (switch color database would not switch for
             //Premiere.)
@@ -282,25 +414,90 @@ void OverrideCFHDDATA(DECODER *decoder, unsigned char *lpCurrentBuffer, int nWor
                 InitializeCFHDDataToDefaults(cfhddata, decoder->frame.colorspace);
                 cfhddata->force_metadata_refresh = false;
             }
-            decoder->metadatachunks = 0;
-            decoder->drawmetadataobjects = 0;
-            decoder->ghost_bust_left = 0;
-            decoder->ghost_bust_right = 0;
-            decoder->preformatted_3D_type = 0;
-            decoder->codec.unique_framenumber = UINT32_MAX;
-            CopyMetadataChunks(decoder, NULL);
 
-            if (!decoder->image_dev_only)
+            if (hashed)
             {
+                // Hash the metadata chunks to find out whether the metadata has changed since the last sample
+                unsigned char *chunkptr = buf;
+                unsigned int remaining = samplesize;
+                void *chunkstart = metadatastart;
+                size_t chunksize = metadatasize;
+
                 do
                 {
-                    buf = (unsigned char *)metadatastart;
-                    buf -= 8; // Point to the tag not the data
+                    chunkptr = (unsigned char *)chunkstart;
+                    chunkptr -= 8; // Point to the tag not the data
+
+                    if (chunk_count == METADATA_HASH_CHUNKS ||
+                            !HashMetadataChunk(&hash, chunkptr, chunksize, frame_tuple, &frame_tuple_count))
+                    {
+                        hashed = false;
+                        break;
+                    }
+
+                    chunk[chunk_count] = chunkptr;
+                    chunk_size[chunk_count] = chunksize;
+                    chunk_count++;
+                    total_size += chunksize;
+
+                    chunkptr += chunksize;
+                    remaining -= (unsigned int)chunksize;
+                } while ((chunkstart = MetaDataFindFirst(chunkptr, remaining, &chunksize, &tag, &size, &type)));
+            }
+
+            // The metadata does not have to be parsed again if neither the metadata nor the state it was applied to has changed
+            if (hashed &&
+                    decoder->metadata_hash_valid &&
+                    decoder->metadata_hash == hash &&
+                    decoder->metadata_size == total_size &&
+                    decoder->metadata_chunk_count == chunk_count &&
+                    memcmp(&decoder->metadata_cfhddata, cfhddata, sizeof(CFHDDATA)) == 0)
+            {
+                // Restore the state that was reset for this sample and point to the objects in this sample
+                decoder->codec.unique_framenumber = decoder->metadata_framenumber;
+                decoder->drawmetadataobjects = decoder->metadata_drawobjects;
+                for (i = 0; i < decoder->drawmetadataobjects; i++)
+                {
+                    decoder->dmo[i] = chunk[decoder->dmo_chunk[i]] + decoder->dmo_offset[i];
+                }
+
+                for (i = 0; i < chunk_count; i++)
+                {
+                    SaveMetadataChunk(decoder, chunk[i], (int)chunk_size[i]);
+                }
+
+                ApplyFrameMetadata(decoder, frame_tuple, frame_tuple_count);
+            }
+            else
+            {
+                decoder->metadatachunks = 0;
+                decoder->drawmetadataobjects = 0;
+                decoder->ghost_bust_left = 0;
+                decoder->ghost_bust_right = 0;
+                decoder->preformatted_3D_type = 0;
+                decoder->codec.unique_framenumber = UINT32_MAX;
+                CopyMetadataChunks(decoder, NULL);
+
+                if (!decoder->image_dev_only)
+                {
+                    do
+                    {
+                        buf = (unsigned char *)metadatastart;
+                        buf -= 8; // Point to the tag not the data
+
+                        UpdateCFHDDATA(decoder, buf, (int)metadatasize, 0, METADATA_PRIORITY_FRAME);
+                        buf += metadatasize;
+                        samplesize -= (unsigned int)metadatasize;
+                    } while ((metadatastart = MetaDataFindFirst(buf, samplesize, &metadatasize, &tag, &size, &type)));
+                }
 
-                    UpdateCFHDDATA(decoder, buf, (int)metadatasize, 0, METADATA_PRIORITY_FRAME);
-                    buf += metadatasize;
-                    samplesize -= (unsigned int)metadatasize;
-                } while ((metadatastart = MetaDataFindFirst(buf, samplesize, &metadatasize, &tag, &size, &type)));
+                // Remember the metadata so that the next sample can be checked for changes
+                decoder->metadata_hash_valid = (hashed && SaveMetadataObjects(decoder, chunk, chunk_size, chunk_count));
+                decoder->metadata_hash = hash;
+                decoder->metadata_size = total_size;
+                decoder->metadata_chunk_count = chunk_count;
+                decoder->metadata_framenumber = decoder->codec.unique_framenumber;
+                decoder->metadata_drawobjects = decoder->drawmetadataobjects;
             }
 
             if (decoder->image_dev_only || memcmp( &lastGUID, &cfhddata->clip_guid, sizeof(cfhddata->clip_guid) ) != 0)
@@ -359,6 +556,12 @@ void OverrideCFHDDATA(DECODER *decoder, unsigned char *lpCurrentBuffer, int nWor
         decoder->thread_cntrl.affinity = cfhddata->cpu_affinity;
         decoder->thread_cntrl.set_thread_params = 1;
     }
+
+    // Any change to the state before the next sample forces the metadata to be applied again
+    if (decoder->metadata_hash_valid)
+    {
+        memcpy(&decoder->metadata_cfhddata, cfhddata, sizeof(CFHDDATA));
+    }
 }
 
 void OverrideCFHDDATAUsingParent(struct decoder *decoder, struct decoder *parentDecoder, unsigned char *lpCurrentBuffer, int nWordsUsed)
@@ -370,6 +573,9 @@ void OverrideCFHDDATAUsingParent(struct decoder *decoder, struct decoder *parent
     int process_path_flags_mask = decoder->cfhddata.process_path_flags_mask;
     myGUID lastGUID = cfhddata->clip_guid;
 
+    // The metadata from the parent is always applied
+    decoder->metadata_hash_valid = false;
+
     decoder->codec.PFrame = IsSampleKeyFrame(lpCurrentBuffer, nWordsUsed) ? 0 : 1;
     if (decoder->codec.PFrame && decoder->codec.unique_framenumber != UINT32_MAX && (decoder->codec.unique_framenumber & 1) == 0)
     {
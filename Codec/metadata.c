@@ -737,6 +737,260 @@ void *MetaDataFindTag(void *data, size_t datasize,
     return NULL;
 }
 
+#if _ALLOCATOR
+void InitMetadataIndex(METADATA_INDEX *index, ALLOCATOR *allocator)
+#else
+void InitMetadataIndex(METADATA_INDEX *index)
+#endif
+{
+    memset(index, 0, sizeof(METADATA_INDEX));
+
+#if _ALLOCATOR
+    index->allocator = allocator;
+#endif
+}
+
+void FreeMetadataIndex(METADATA_INDEX *index)
+{
+    if (index->entries)
+    {
+#if _ALLOCATOR
+        Free(index->allocator, index->entries);
+#else
+        MEMORY_FREE(index->entries);
+#endif
+        index->entries = NULL;
+    }
+
+    index->count = 0;
+    index->capacity = 0;
+    index->valid = false;
+}
+
+void ResetMetadataIndex(METADATA_INDEX *index)
+{
+    index->count = 0;
+    index->valid = false;
+}
+
+static inline int MetadataIndexBucket(METADATA_TAG tag)
+{
+    // Multiplicative hash of the four characters in the tag
+    return (int)((tag * 2654435761U) >> 24) & (METADATA_INDEX_BUCKETS - 1);
+}
+
+static bool AddMetadataIndexEntry(METADATA_INDEX *index, METADATA_TAG tag,
+                                  METADATA_TYPE type, METADATA_SIZE size, void *data)
+{
+    METADATA_INDEX_ENTRY *entry;
+
+    if (index->count == index->capacity)
+    {
+        int capacity = (index->capacity > 0) ? 2 * index->capacity : 64;
+        METADATA_INDEX_ENTRY *entries;
+
+#if _ALLOCATOR
+        entries = (METADATA_INDEX_ENTRY *)Alloc(index->allocator, capacity * sizeof(METADATA_INDEX_ENTRY));
+#else
+        entries = (METADATA_INDEX_ENTRY *)MEMORY_ALLOC(capacity * sizeof(METADATA_INDEX_ENTRY));
+#endif
+        if (entries == NULL)
+        {
+            return false;
+        }
+
+        if (index->entries)
+        {
+            memcpy(entries, index->entries, index->count * sizeof(METADATA_INDEX_ENTRY));
+#if _ALLOCATOR
+            Free(index->allocator, index->entries);
+#else
+            MEMORY_FREE(index->entries);
+#endif
+        }
+
+        index->entries = entries;
+        index->capacity = capacity;
+    }
+
+    entry = &index->entries[index->count++];
+    entry->tag = tag;
+    entry->type = type;
+    entry->size = size;
+    entry->data = data;
+    entry->next = -1;
+
+    return true;
+}
+
+// Add the tuples in one metadata chunk to the index (same walk as MetadataFind)
+static bool IndexMetadataChunk(METADATA_INDEX *index, void *data, size_t datasize)
+{
+    uint32_t *idata = data;
+    size_t pos = 0;
+
+    while (pos + 8 <= datasize)
+    {
+        unsigned int tag = *idata++;
+        unsigned int typesize = *idata++;
+        unsigned char type = (typesize >> 24) & 0xff;
+        int size = typesize & 0xffffff;
+        int offset = (size + 3) & 0xfffffc;
+
+        pos += 8;
+
+        if (!AddMetadataIndexEntry(index, tag, type, size, idata))
+        {
+            return false;
+        }
+
+        pos += offset;
+        idata += (offset >> 2);
+    }
+
+    return true;
+}
+
+CODEC_ERROR BuildMetadataIndex(METADATA_INDEX *index, void *data, size_t datasize)
+{
+    BITSTREAM myinput, *pinput = &myinput;
+    TAGVALUE segment;
+    TAGWORD tag, value;
+    int error = 0;
+    int i;
+
+    ResetMetadataIndex(index);
+
+    if (data == NULL || datasize == 0)
+    {
+        return CODEC_ERROR_INVALID_ARGUMENT;
+    }
+
+    InitBitstreamBuffer(pinput, data, datasize, BITSTREAM_ACCESS_READ);
+
+    // Walk the sample in the same way as MetaDataFindInSample
+    do
+    {
+        int chunksize = 0;
+
+        // Read the next tag value pair from the bitstream
+        segment = GetSegment(pinput);
+
+        tag = segment.tuple.tag;
+        value = segment.tuple.value;
+
+        // Is this an optional tag?
+        if (tag < 0)
+        {
+            tag = NEG(tag);
+        }
+
+        if (tag & 0x2000)
+        {
+            chunksize = value;
+            chunksize &= 0xffff;
+            chunksize += ((tag & 0xff) << 16);
+        }
+        else if (tag & 0x4000)
+        {
+            chunksize = value;
+            chunksize &= 0xffff;
+        }
+        else if (tag == CODEC_TAG_INDEX)
+        {
+            chunksize = value;
+            chunksize &= 0xffff;
+        }
+        else
+        {
+            chunksize = 0;
+        }
+
+        if ((int)(tag) <= ((int)CODEC_TAG_LAST_NON_SIZED) || tag & 0x6000)
+        {
+            int skip = 1;
+            error = 0;
+
+            if (chunksize * 4 > pinput->nWordsUsed || chunksize < 0)
+            {
+                break;
+            }
+
+            if (tag == (int)CODEC_TAG_METADATA || tag == (int)CODEC_TAG_METADATA_LARGE)
+            {
+                if (!IndexMetadataChunk(index, pinput->lpCurrentWord, chunksize * 4))
+                {
+                    ResetMetadataIndex(index);
+                    return CODEC_ERROR_MEMORY_ALLOC;
+                }
+            }
+
+            if ((tag & 0xff00) == 0x2200) //sample size
+                skip = 0;
+            if ((tag & 0xff00) == 0x2300) //uncompressed sample size
+                skip = 1;
+            if ((tag & 0xff00) == 0x2100) //level
+                skip = 0;
+
+            if (chunksize && skip)
+            {
+                pinput->lpCurrentWord += chunksize * 4;
+                pinput->nWordsUsed -= chunksize * 4;
+            }
+        }
+        else
+        {
+            error = 1;
+        }
+    } while (tag != CODEC_TAG_GROUP_TRAILER &&
+             tag != CODEC_TAG_FRAME_TRAILER &&
+             pinput->nWordsUsed > 0 && !error);
+
+    // Link the entries into the hash chains in reverse order so that each chain is in sample order
+    for (i = 0; i < METADATA_INDEX_BUCKETS; i++)
+    {
+        index->buckets[i] = -1;
+    }
+
+    for (i = index->count - 1; i >= 0; i--)
+    {
+        int bucket = MetadataIndexBucket(index->entries[i].tag);
+        index->entries[i].next = index->buckets[bucket];
+        index->buckets[bucket] = i;
+    }
+
+    index->valid = true;
+
+    return CODEC_ERROR_OKAY;
+}
+
+void *MetadataIndexFind(METADATA_INDEX *index,
+                        METADATA_TAG findmetadatatag,
+                        METADATA_SIZE *retsize,
+                        METADATA_TYPE *rettype)
+{
+    int i;
+
+    if (index == NULL || !index->valid)
+    {
+        return NULL;
+    }
+
+    for (i = index->buckets[MetadataIndexBucket(findmetadatatag)]; i >= 0; i = index->entries[i].next)
+    {
+        METADATA_INDEX_ENTRY *entry = &index->entries[i];
+
+        if (entry->tag == findmetadatatag)
+        {
+            *retsize = entry->size;
+            *rettype = entry->type;
+            return entry->data;
+        }
+    }
+
+    return NULL;
+}
+
 bool FindMetadata(METADATA *metadata,
                   METADATA_TAG tag,
                   void **data_out,
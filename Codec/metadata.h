@@ -62,6 +62,45 @@ typedef struct metadata
 #define METADATA_INITIALIZER	{NULL, 0, 0}
 #endif
 
+// Number of hash buckets in the index of the metadata in a sample (must be a power of two)
+#define METADATA_INDEX_BUCKETS	256
+
+// Location of one metadata tuple in a sample
+typedef struct metadata_index_entry
+{
+    METADATA_TAG tag;
+    METADATA_TYPE type;
+    METADATA_SIZE size;
+    void *data;				//!< Metadata value in the sample
+    int next;				//!< Next entry in the same hash bucket (negative at the end of the chain)
+
+} METADATA_INDEX_ENTRY;
+
+/*!
+	@brief Index of the metadata tuples in a sample
+
+	The index is built in one pass over all of the metadata chunks in the sample
+	so that a lookup does not have to parse the sample and walk the metadata tuples.
+	Each hash bucket is a chain of the entries in the order that the tuples occur in
+	the sample, so the first entry for a tag is the same tuple that would be returned
+	by MetaDataFindInSample.
+*/
+typedef struct metadata_index
+{
+#if _ALLOCATOR
+    ALLOCATOR *allocator;
+#endif
+
+    bool valid;				//!< The index describes the current sample
+
+    METADATA_INDEX_ENTRY *entries;
+    int count;
+    int capacity;
+
+    int buckets[METADATA_INDEX_BUCKETS];	//!< First entry in each chain (negative if empty)
+
+} METADATA_INDEX;
+
 #define METADATA_EYE_BOTH		0
 #define METADATA_EYE_LEFT		1
 #define METADATA_EYE_RGHT		2
@@ -142,6 +181,30 @@ void *MetaDataFindTag(void *chunk_data,
                       METADATA_SIZE *retsize,
                       METADATA_TYPE *rettype);
 
+#if _ALLOCATOR
+void InitMetadataIndex(METADATA_INDEX *index, ALLOCATOR *allocator);
+#else
+void InitMetadataIndex(METADATA_INDEX *index);
+#endif
+
+// Release the entries in the index
+void FreeMetadataIndex(METADATA_INDEX *index);
+
+// Mark the index as out of date (the entries are kept for the next sample)
+void ResetMetadataIndex(METADATA_INDEX *index);
+
+// Index all of the metadata tuples in the sample
+CODEC_ERROR BuildMetadataIndex(METADATA_INDEX *index, void *sample_data, size_t sample_size);
+
+/*!
+	Return the first metadata tuple in the sample with the requested tag
+	using an index built by BuildMetadataIndex.
+*/
+void *MetadataIndexFind(METADATA_INDEX *index,
+                        METADATA_TAG findmetadatatag,
+                        METADATA_SIZE *retsize,
+                        METADATA_TYPE *rettype);
+
 // This routine is only defined for C++
 void *MetaDataFindNextExtended(void *sampledata,
                                size_t sampledatasize,
@@ -180,6 +243,7 @@ bool FindMetadataTuple(METADATA *metadata,
 void GetMetadataValue(METADATA *metadata, METADATA_SIZE size, METADATA_TYPE type, void *output);
 void FreeMetadata(METADATA *metadata);
 
+void SaveMetadataChunk(struct decoder *decoder, unsigned char *ptr, int len);
 void UpdateCFHDDATA(struct decoder *decoder, unsigned char *ptr, int len, int delta, int priority);
 
 #ifdef __cplusplus
@@ -0,0 +1,331 @@
+/*! @file stereo.c
+
+*  @brief Split stereo samples into the samples for each eye and combine two samples into a stereo sample
+*
+*  A stereo sample is the sample for the left eye followed by the sample for the right
+*  eye, starting on the next 16 byte boundary.  Both samples carry the number of encoded
+*  video channels and the channel number in the header before the sample size chunk.
+*  Extracting one eye and combining two samples only copies the samples and rewrites
+*  those tags, so the wavelet bands are never decoded.
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+#include "config.h"
+#include "bitstream.h"
+#include "codec.h"
+#include "stereo.h"
+
+// Only the first few tuples are searched for the sample size chunk (same limit as the decoder)
+#define STEREO_HEADER_SEARCH_LIMIT	4096
+
+// The sample for the right eye starts on a 16 byte boundary
+#define STEREO_EYE_ALIGNMENT		16
+
+// Location of the tags in the header of one sample that describe the video channels
+typedef struct stereo_header
+{
+    size_t start;				// Offset to the start of the sample
+    size_t end;					// Offset to the end of the sample size chunk
+
+    size_t channels_offset;		// Offset to the number of encoded channels (zero if not present)
+    int channels;
+    size_t number_offset;		// Offset to the encoded channel number (zero if not present)
+    size_t size_offset;			// Offset to the sample size chunk
+
+    int width;
+    int height;
+    int encoded_format;
+
+} STEREO_HEADER;
+
+
+static inline int GetTagAt(const uint8_t *buffer)
+{
+    return (int16_t)((buffer[0] << 8) | buffer[1]);
+}
+
+static inline int GetValueAt(const uint8_t *buffer)
+{
+    return (buffer[2] << 8) | buffer[3];
+}
+
+static inline void SetTagValueAt(uint8_t *buffer, int tag, int value)
+{
+    buffer[0] = (uint8_t)((tag >> 8) & 0xFF);
+    buffer[1] = (uint8_t)(tag & 0xFF);
+    buffer[2] = (uint8_t)((value >> 8) & 0xFF);
+    buffer[3] = (uint8_t)(value & 0xFF);
+}
+
+// Error returned when the sample does not fit in the output buffer
+static inline CODEC_ERROR StereoOverflow()
+{
+    return (CODEC_ERROR)(CODEC_ERROR_BITSTREAM | BITSTREAM_ERROR_OVERFLOW);
+}
+
+// Find the tags in the sample header that must be rewritten and the end of the sample
+static CODEC_ERROR ParseStereoHeader(const uint8_t *input, size_t input_size, size_t start, STEREO_HEADER *header)
+{
+    size_t limit = start + STEREO_HEADER_SEARCH_LIMIT;
+    size_t offset = start;
+
+    memset(header, 0, sizeof(STEREO_HEADER));
+    header->start = start;
+    header->channels = 1;
+    header->encoded_format = ENCODED_FORMAT_YUV_422;
+
+    if (limit > input_size) limit = input_size;
+
+    if (start + 4 > input_size || abs(GetTagAt(input + start)) != CODEC_TAG_SAMPLE)
+    {
+        return CODEC_ERROR_SAMPLE_TYPE;
+    }
+
+    while (offset + 4 <= limit)
+    {
+        const uint8_t *segment = input + offset;
+        int tag = abs(GetTagAt(segment));
+        int value = GetValueAt(segment);
+
+        if ((tag & 0xFF00) == CODEC_TAG_SAMPLE_SIZE)
+        {
+            size_t chunk_size = (size_t)value + ((size_t)(tag & 0xFF) << 16);
+
+            header->size_offset = offset;
+            header->end = offset + 4 + chunk_size * 4;
+            if (header->end > input_size)
+            {
+                return CODEC_ERROR_INVALID_BITSTREAM;
+            }
+            return CODEC_ERROR_OKAY;
+        }
+
+        switch (tag)
+        {
+            case CODEC_TAG_INDEX:
+                // Skip the channel sizes that follow the index
+                offset += (size_t)value * 4;
+                break;
+
+            case CODEC_TAG_ENCODED_CHANNELS:
+                header->channels_offset = offset;
+                header->channels = value;
+                break;
+
+            case CODEC_TAG_ENCODED_CHANNEL_NUMBER:
+                header->number_offset = offset;
+                break;
+
+            case CODEC_TAG_FRAME_WIDTH:
+                header->width = value;
+                break;
+
+            case CODEC_TAG_FRAME_HEIGHT:
+                header->height = value;
+                break;
+
+            case CODEC_TAG_ENCODED_FORMAT:
+                header->encoded_format = value;
+                break;
+
+            default:
+                if (tag & 0x4000)
+                {
+                    // Skip optional chunks in the header
+                    size_t chunk_size = (size_t)value;
+                    if (tag & 0x2000) chunk_size += (size_t)(tag & 0xFF) << 16;
+                    offset += chunk_size * 4;
+                }
+                else if (tag > CODEC_TAG_LAST_NON_SIZED)
+                {
+                    // Any other chunk before the sample size would hide the end of the sample
+                    return CODEC_ERROR_UNSUPPORTED_FORMAT;
+                }
+                break;
+        }
+
+        offset += 4;
+    }
+
+    // Samples without a sample size chunk (such as the second frame in a group) are not supported
+    return CODEC_ERROR_UNSUPPORTED_FORMAT;
+}
+
+// Find the start of the sample for the second eye (same search as the decoder)
+static size_t FindSecondEye(const uint8_t *input, size_t input_size, size_t offset)
+{
+    for (; offset + 4 <= input_size; offset += 4)
+    {
+        const uint8_t *tag = input + offset;
+        if (tag[0] == 0 && tag[1] == (uint8_t)CODEC_TAG_SAMPLE && tag[2] == 0)
+        {
+            return offset;
+        }
+    }
+
+    return input_size;
+}
+
+CODEC_ERROR ExtractStereoEye(const uint8_t *input, size_t input_size, int eye,
+                             uint8_t *output, size_t output_size, size_t *actual_size_out)
+{
+    STEREO_HEADER header;
+    CODEC_ERROR error = CODEC_ERROR_OKAY;
+    size_t size;
+
+    if (input == NULL || output == NULL || actual_size_out == NULL)
+    {
+        return CODEC_ERROR_NULLPTR;
+    }
+
+    if (eye < 0 || eye > 1)
+    {
+        return CODEC_ERROR_INVALID_ARGUMENT;
+    }
+
+    *actual_size_out = 0;
+
+    error = ParseStereoHeader(input, input_size, 0, &header);
+    if (error != CODEC_ERROR_OKAY) return error;
+
+    if (header.channels != 2)
+    {
+        return CODEC_ERROR_3D_UNKNOWN;
+    }
+
+    if (eye == 1)
+    {
+        size_t start = FindSecondEye(input, input_size, header.end);
+
+        error = ParseStereoHeader(input, input_size, start, &header);
+        if (error != CODEC_ERROR_OKAY) return error;
+    }
+
+    size = header.end - header.start;
+    if (size > output_size)
+    {
+        return StereoOverflow();
+    }
+
+    memcpy(output, input + header.start, size);
+
+    // The channel number is kept so that the decoder still applies the metadata for this eye
+    if (header.channels_offset > 0)
+    {
+        SetTagValueAt(output + header.channels_offset - header.start, NEG(CODEC_TAG_ENCODED_CHANNELS), 1);
+    }
+
+    *actual_size_out = size;
+    return CODEC_ERROR_OKAY;
+}
+
+// Copy one eye into the stereo sample with the tags for the number of channels and the channel number
+static CODEC_ERROR CopyStereoEye(const uint8_t *input, const STEREO_HEADER *header, int eye,
+                                 uint8_t *output, size_t output_size, size_t *output_offset)
+{
+    size_t offset = *output_offset;
+    size_t header_size = header->size_offset;
+    size_t chunk_size = header->end - header->size_offset;
+    size_t required = header_size + 8 + chunk_size;
+    size_t input_offset;
+
+    if (required > output_size - offset)
+    {
+        return StereoOverflow();
+    }
+
+    // Copy the sample header without any tags for the video channels
+    for (input_offset = 0; input_offset < header_size; input_offset += 4)
+    {
+        if (input_offset > 0 && (input_offset == header->channels_offset || input_offset == header->number_offset))
+        {
+            continue;
+        }
+        memcpy(output + offset, input + input_offset, 4);
+        offset += 4;
+    }
+
+    // Insert the tags for the video channels immediately before the sample size chunk
+    SetTagValueAt(output + offset, NEG(CODEC_TAG_ENCODED_CHANNELS), 2);
+    SetTagValueAt(output + offset + 4, NEG(CODEC_TAG_ENCODED_CHANNEL_NUMBER), eye);
+    offset += 8;
+
+    memcpy(output + offset, input + header->size_offset, chunk_size);
+    offset += chunk_size;
+
+    *output_offset = offset;
+    return CODEC_ERROR_OKAY;
+}
+
+CODEC_ERROR MuxStereoSample(const uint8_t *left, size_t left_size,
+                            const uint8_t *right, size_t right_size,
+                            uint8_t *output, size_t output_size, size_t *actual_size_out)
+{
+    STEREO_HEADER left_header;
+    STEREO_HEADER right_header;
+    CODEC_ERROR error = CODEC_ERROR_OKAY;
+    size_t offset = 0;
+
+    if (left == NULL || right == NULL || output == NULL || actual_size_out == NULL)
+    {
+        return CODEC_ERROR_NULLPTR;
+    }
+
+    *actual_size_out = 0;
+
+    error = ParseStereoHeader(left, left_size, 0, &left_header);
+    if (error != CODEC_ERROR_OKAY) return error;
+
+    error = ParseStereoHeader(right, right_size, 0, &right_header);
+    if (error != CODEC_ERROR_OKAY) return error;
+
+    // Each input must be a sample for one eye
+    if (left_header.channels != 1 || right_header.channels != 1)
+    {
+        return CODEC_ERROR_3D_UNKNOWN;
+    }
+
+    // The decoder assumes that both eyes have the same dimensions and format
+    if (left_header.width != right_header.width || left_header.height != right_header.height)
+    {
+        return CODEC_ERROR_FRAME_DIMENSIONS;
+    }
+    if (left_header.encoded_format != right_header.encoded_format)
+    {
+        return CODEC_ERROR_INVALID_FORMAT;
+    }
+
+    error = CopyStereoEye(left, &left_header, 0, output, output_size, &offset);
+    if (error != CODEC_ERROR_OKAY) return error;
+
+    // Pad the left eye so that the right eye starts on the same boundary as in the encoder
+    while (offset % STEREO_EYE_ALIGNMENT)
+    {
+        if (offset + 4 > output_size)
+        {
+            return StereoOverflow();
+        }
+        SetTagValueAt(output + offset, CODEC_TAG_ZERO, 0);
+        offset += 4;
+    }
+
+    error = CopyStereoEye(right, &right_header, 1, output, output_size, &offset);
+    if (error != CODEC_ERROR_OKAY) return error;
+
+    *actual_size_out = offset;
+    return CODEC_ERROR_OKAY;
+}
@@ -0,0 +1,43 @@
+/*! @file stereo.h
+
+*  @brief Split stereo samples into the samples for each eye and combine two samples into a stereo sample
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#ifndef _STEREO_H
+#define _STEREO_H
+
+#include "config.h"
+#include "error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Copy the sample for one eye (0 = left, 1 = right) out of a stereo sample
+CODEC_ERROR ExtractStereoEye(const uint8_t *input, size_t input_size, int eye,
+                             uint8_t *output, size_t output_size, size_t *actual_size_out);
+
+// Combine the samples for the left and right eyes into one stereo sample
+CODEC_ERROR MuxStereoSample(const uint8_t *left, size_t left_size,
+                            const uint8_t *right, size_t right_size,
+                            uint8_t *output, size_t output_size, size_t *actual_size_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,532 @@
+/*! @file streamindex.c
+
+*  @brief Index of the samples in a raw stream of concatenated CineForm samples
+*
+*  The index is built by walking the tags at the start of each sample.  Samples with a
+*  sample size chunk are skipped in one step, so only the sample headers are read.  The
+*  search for the start of the next sample after padding, and after samples without a
+*  size chunk, compares four tags at a time using SSE2 instructions.
+*
+*  Stereo samples are indexed as one frame that contains both eyes.  The second frame
+*  in a group of pictures is a small sample that can only be decoded after the sample
+*  for the group, so seeking to the second frame returns the preceding group sample.
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+#include "config.h"
+#include "bitstream.h"
+#include "codec.h"
+#include "streamindex.h"
+
+#if _XMMOPT
+#include <emmintrin.h>
+#endif
+
+// Only the first few tuples are searched for the sample size chunk (same limit as the decoder)
+#define SAMPLE_HEADER_SEARCH_LIMIT		4096
+
+// Initial number of entries allocated for the index
+#define SAMPLE_INDEX_INITIAL_CAPACITY	1024
+
+// Header of the sidecar file: four character code, version, number of entries, and stream size
+#define SAMPLE_INDEX_FILE_TAG			0x43465349		// "CFSI"
+#define SAMPLE_INDEX_FILE_VERSION		1
+#define SAMPLE_INDEX_HEADER_SIZE		24
+
+// Size of each entry in the sidecar file (in bytes)
+#define SAMPLE_INDEX_ENTRY_SIZE			20
+
+// Number of entries that are written to the sidecar file at a time
+#define SAMPLE_INDEX_FILE_BATCH			1024
+
+
+static inline int GetTagAt(const uint8_t *buffer)
+{
+    return (int16_t)((buffer[0] << 8) | buffer[1]);
+}
+
+static inline int GetValueAt(const uint8_t *buffer)
+{
+    return (buffer[2] << 8) | buffer[3];
+}
+
+// Little endian fields in the sidecar file
+static inline void PutLittleEndian(uint8_t *buffer, uint64_t value, int size)
+{
+    int i;
+    for (i = 0; i < size; i++)
+    {
+        buffer[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static inline uint64_t GetLittleEndian(const uint8_t *buffer, int size)
+{
+    uint64_t value = 0;
+    int i;
+    for (i = size - 1; i >= 0; i--)
+    {
+        value = (value << 8) | buffer[i];
+    }
+    return value;
+}
+
+// Return true if the sample type can start a sample in the stream (not a channel or trailer)
+static bool IsStreamSampleType(int sample_type)
+{
+    switch (sample_type)
+    {
+        case SAMPLE_TYPE_FRAME:
+        case SAMPLE_TYPE_GROUP:
+        case SAMPLE_TYPE_FIRST:
+        case SAMPLE_TYPE_SECOND:
+        case SAMPLE_TYPE_SEQUENCE_HEADER:
+        case SAMPLE_TYPE_SEQUENCE_TRAILER:
+        case SAMPLE_TYPE_IFRAME:
+        case SAMPLE_TYPE_PFRAME:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// Return true if the sample type is a frame that is returned by the decoder
+static bool IsFrameSampleType(int sample_type)
+{
+    return (IsStreamSampleType(sample_type) &&
+            sample_type != SAMPLE_TYPE_SEQUENCE_HEADER &&
+            sample_type != SAMPLE_TYPE_SEQUENCE_TRAILER);
+}
+
+// Return true if the sample can be decoded without the previous sample (same as IsSampleKeyFrame)
+static bool IsKeySampleType(int sample_type)
+{
+    return (sample_type == SAMPLE_TYPE_GROUP ||
+            sample_type == SAMPLE_TYPE_FIRST ||
+            sample_type == SAMPLE_TYPE_IFRAME);
+}
+
+// Find the next sample type tag at or after the offset (which must be a multiple of four)
+static uint64_t FindSampleTag(const uint8_t *stream, uint64_t stream_size, uint64_t offset)
+{
+#if _XMMOPT
+    // Each tuple is the tag (0x0001) and a sample type less than 256 in big endian order
+    const __m128i mask_epi32 = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i tag_epi32 = _mm_set1_epi32(0x00000100);
+
+    while (offset + 16 <= stream_size)
+    {
+        __m128i tuples_epi32 = _mm_loadu_si128((const __m128i *)(stream + offset));
+        int match;
+
+        tuples_epi32 = _mm_and_si128(tuples_epi32, mask_epi32);
+        match = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(tuples_epi32, tag_epi32)));
+
+        if (match != 0)
+        {
+            int i;
+            for (i = 0; i < 4; i++)
+            {
+                if ((match & (1 << i)) && IsStreamSampleType(stream[offset + 4 * i + 3]))
+                {
+                    return offset + 4 * i;
+                }
+            }
+        }
+
+        offset += 16;
+    }
+#endif
+
+    for (; offset + 4 <= stream_size; offset += 4)
+    {
+        const uint8_t *tuple = stream + offset;
+        if (tuple[0] == 0 && tuple[1] == CODEC_TAG_SAMPLE && tuple[2] == 0 && IsStreamSampleType(tuple[3]))
+        {
+            return offset;
+        }
+    }
+
+    return stream_size;
+}
+
+// Walk the sample header to find the end of the sample and the fields for the index entry
+static uint64_t ParseStreamSample(const uint8_t *stream, uint64_t stream_size, uint64_t start,
+                                  SAMPLE_INDEX_ENTRY *entry)
+{
+    uint64_t limit = start + SAMPLE_HEADER_SEARCH_LIMIT;
+    uint64_t offset = start + 4;
+
+    entry->offset = start;
+    entry->sample_type = (uint16_t)GetValueAt(stream + start);
+    entry->frame_number = 0;
+    entry->channels = 1;
+
+    if (limit > stream_size) limit = stream_size;
+
+    while (offset + 4 <= limit)
+    {
+        const uint8_t *segment = stream + offset;
+        int tag = abs(GetTagAt(segment));
+        int value = GetValueAt(segment);
+
+        if ((tag & 0xFF00) == CODEC_TAG_SAMPLE_SIZE)
+        {
+            uint64_t chunk_size = (uint64_t)value + ((uint64_t)(tag & 0xFF) << 16);
+            return offset + 4 + 4 * chunk_size;
+        }
+
+        switch (tag)
+        {
+            case CODEC_TAG_SAMPLE:
+                // Small samples without a size chunk end at the next sample
+                if (IsStreamSampleType(value))
+                {
+                    return offset;
+                }
+                break;
+
+            case CODEC_TAG_INDEX:
+                offset += 4 * (uint64_t)value;
+                break;
+
+            case CODEC_TAG_ENCODED_CHANNELS:
+                entry->channels = (uint8_t)value;
+                break;
+
+            case CODEC_TAG_FRAME_NUMBER:
+                entry->frame_number = value;
+                break;
+
+            default:
+                if (tag & 0x4000)
+                {
+                    // Skip optional chunks in the header
+                    uint64_t chunk_size = (uint64_t)value;
+                    if (tag & 0x2000) chunk_size += (uint64_t)(tag & 0xFF) << 16;
+                    offset += 4 * chunk_size;
+                }
+                else if (tag > CODEC_TAG_LAST_NON_SIZED)
+                {
+                    // Cannot skip the chunk so search for the next sample
+                    return FindSampleTag(stream, stream_size, offset + 4);
+                }
+                break;
+        }
+
+        offset += 4;
+    }
+
+    return FindSampleTag(stream, stream_size, offset);
+}
+
+static CODEC_ERROR AddSampleIndexEntry(SAMPLE_INDEX *index, const SAMPLE_INDEX_ENTRY *entry)
+{
+    if (index->count == index->capacity)
+    {
+        size_t capacity = (index->capacity > 0) ? 2 * index->capacity : SAMPLE_INDEX_INITIAL_CAPACITY;
+        SAMPLE_INDEX_ENTRY *entries;
+
+#if _ALLOCATOR
+        entries = (SAMPLE_INDEX_ENTRY *)Alloc(index->allocator, capacity * sizeof(SAMPLE_INDEX_ENTRY));
+#else
+        entries = (SAMPLE_INDEX_ENTRY *)MEMORY_ALLOC(capacity * sizeof(SAMPLE_INDEX_ENTRY));
+#endif
+        if (entries == NULL)
+        {
+            return CODEC_ERROR_MEMORY_ALLOC;
+        }
+
+        if (index->entries != NULL)
+        {
+            memcpy(entries, index->entries, index->count * sizeof(SAMPLE_INDEX_ENTRY));
+#if _ALLOCATOR
+            Free(index->allocator, index->entries);
+#else
+            MEMORY_FREE(index->entries);
+#endif
+        }
+
+        index->entries = entries;
+        index->capacity = capacity;
+    }
+
+    index->entries[index->count++] = *entry;
+    return CODEC_ERROR_OKAY;
+}
+
+#if _ALLOCATOR
+SAMPLE_INDEX *CreateSampleIndex(ALLOCATOR *allocator)
+#else
+SAMPLE_INDEX *CreateSampleIndex()
+#endif
+{
+    SAMPLE_INDEX *index;
+
+#if _ALLOCATOR
+    index = (SAMPLE_INDEX *)Alloc(allocator, sizeof(SAMPLE_INDEX));
+#else
+    index = (SAMPLE_INDEX *)MEMORY_ALLOC(sizeof(SAMPLE_INDEX));
+#endif
+    if (index == NULL) return NULL;
+
+    memset(index, 0, sizeof(SAMPLE_INDEX));
+#if _ALLOCATOR
+    index->allocator = allocator;
+#endif
+
+    return index;
+}
+
+void DeleteSampleIndex(SAMPLE_INDEX *index)
+{
+    if (index == NULL) return;
+
+#if _ALLOCATOR
+    if (index->entries != NULL) Free(index->allocator, index->entries);
+    Free(index->allocator, index);
+#else
+    if (index->entries != NULL) MEMORY_FREE(index->entries);
+    MEMORY_FREE(index);
+#endif
+}
+
+CODEC_ERROR IndexSampleStream(SAMPLE_INDEX *index, const uint8_t *stream, uint64_t stream_size)
+{
+    uint64_t offset;
+    uint8_t channels = 1;
+
+    if (index == NULL || stream == NULL)
+    {
+        return CODEC_ERROR_NULLPTR;
+    }
+
+    index->count = 0;
+    index->stream_size = stream_size;
+
+    offset = FindSampleTag(stream, stream_size, 0);
+
+    while (offset < stream_size)
+    {
+        SAMPLE_INDEX_ENTRY entry;
+        uint64_t end = ParseStreamSample(stream, stream_size, offset, &entry);
+
+        // The right eye of a stereo sample starts after the left eye
+        if (entry.channels == 2 && end < stream_size)
+        {
+            SAMPLE_INDEX_ENTRY second;
+            uint64_t second_offset = FindSampleTag(stream, stream_size, (end + 3) & ~(uint64_t)3);
+
+            if (second_offset < stream_size && GetValueAt(stream + second_offset) == entry.sample_type)
+            {
+                end = ParseStreamSample(stream, stream_size, second_offset, &second);
+            }
+        }
+
+        // Stop at a sample that was truncated at the end of the stream
+        if (end > stream_size)
+        {
+            break;
+        }
+
+        if (IsFrameSampleType(entry.sample_type))
+        {
+            CODEC_ERROR error;
+
+            if ((end - offset) > UINT32_MAX)
+            {
+                return CODEC_ERROR_INVALID_BITSTREAM;
+            }
+
+            entry.size = (uint32_t)(end - offset);
+            entry.key_frame = IsKeySampleType(entry.sample_type);
+
+            // The second frame in a group has the same number of channels as the group
+            if (entry.key_frame)
+            {
+                channels = entry.channels;
+            }
+            else
+            {
+                entry.channels = channels;
+            }
+
+            error = AddSampleIndexEntry(index, &entry);
+            if (error != CODEC_ERROR_OKAY)
+            {
+                return error;
+            }
+        }
+
+        offset = FindSampleTag(stream, stream_size, (end + 3) & ~(uint64_t)3);
+    }
+
+    return CODEC_ERROR_OKAY;
+}
+
+CODEC_ERROR WriteSampleIndex(SAMPLE_INDEX *index, FILE *file)
+{
+    uint8_t buffer[SAMPLE_INDEX_FILE_BATCH * SAMPLE_INDEX_ENTRY_SIZE];
+    size_t i = 0;
+
+    if (index == NULL || file == NULL)
+    {
+        return CODEC_ERROR_NULLPTR;
+    }
+
+    PutLittleEndian(&buffer[0], SAMPLE_INDEX_FILE_TAG, 4);
+    PutLittleEndian(&buffer[4], SAMPLE_INDEX_FILE_VERSION, 4);
+    PutLittleEndian(&buffer[8], index->count, 8);
+    PutLittleEndian(&buffer[16], index->stream_size, 8);
+    if (fwrite(buffer, SAMPLE_INDEX_HEADER_SIZE, 1, file) != 1)
+    {
+        return CODEC_ERROR_BITSTREAM;
+    }
+
+    while (i < index->count)
+    {
+        size_t batch = index->count - i;
+        size_t j;
+
+        if (batch > SAMPLE_INDEX_FILE_BATCH) batch = SAMPLE_INDEX_FILE_BATCH;
+
+        for (j = 0; j < batch; j++)
+        {
+            const SAMPLE_INDEX_ENTRY *entry = &index->entries[i + j];
+            uint8_t *field = &buffer[j * SAMPLE_INDEX_ENTRY_SIZE];
+
+            PutLittleEndian(&field[0], entry->offset, 8);
+            PutLittleEndian(&field[8], entry->size, 4);
+            PutLittleEndian(&field[12], entry->frame_number, 4);
+            PutLittleEndian(&field[16], entry->sample_type, 2);
+            field[18] = entry->key_frame;
+            field[19] = entry->channels;
+        }
+
+        if (fwrite(buffer, SAMPLE_INDEX_ENTRY_SIZE, batch, file) != batch)
+        {
+            return CODEC_ERROR_BITSTREAM;
+        }
+
+        i += batch;
+    }
+
+    return CODEC_ERROR_OKAY;
+}
+
+CODEC_ERROR ReadSampleIndex(SAMPLE_INDEX *index, FILE *file, uint64_t stream_size)
+{
+    uint8_t buffer[SAMPLE_INDEX_FILE_BATCH * SAMPLE_INDEX_ENTRY_SIZE];
+    uint64_t count;
+    uint64_t i = 0;
+
+    if (index == NULL || file == NULL)
+    {
+        return CODEC_ERROR_NULLPTR;
+    }
+
+    index->count = 0;
+
+    if (fread(buffer, SAMPLE_INDEX_HEADER_SIZE, 1, file) != 1 ||
+            GetLittleEndian(&buffer[0], 4) != SAMPLE_INDEX_FILE_TAG ||
+            GetLittleEndian(&buffer[4], 4) != SAMPLE_INDEX_FILE_VERSION)
+    {
+        return CODEC_ERROR_SAMPLE_INDEX;
+    }
+
+    // The index is out of date if the stream has changed size
+    count = GetLittleEndian(&buffer[8], 8);
+    if (GetLittleEndian(&buffer[16], 8) != stream_size)
+    {
+        return CODEC_ERROR_SAMPLE_INDEX;
+    }
+
+    while (i < count)
+    {
+        size_t batch = (size_t)((count - i < SAMPLE_INDEX_FILE_BATCH) ? (count - i) : SAMPLE_INDEX_FILE_BATCH);
+        size_t j;
+
+        if (fread(buffer, SAMPLE_INDEX_ENTRY_SIZE, batch, file) != batch)
+        {
+            index->count = 0;
+            return CODEC_ERROR_SAMPLE_INDEX;
+        }
+
+        for (j = 0; j < batch; j++)
+        {
+            const uint8_t *field = &buffer[j * SAMPLE_INDEX_ENTRY_SIZE];
+            SAMPLE_INDEX_ENTRY entry;
+            CODEC_ERROR error;
+
+            entry.offset = GetLittleEndian(&field[0], 8);
+            entry.size = (uint32_t)GetLittleEndian(&field[8], 4);
+            entry.frame_number = (uint32_t)GetLittleEndian(&field[12], 4);
+            entry.sample_type = (uint16_t)GetLittleEndian(&field[16], 2);
+            entry.key_frame = field[18];
+            entry.channels = field[19];
+
+            // Every sample must be inside the stream
+            if (entry.offset > stream_size || entry.size > stream_size - entry.offset)
+            {
+                index->count = 0;
+                return CODEC_ERROR_SAMPLE_INDEX;
+            }
+
+            error = AddSampleIndexEntry(index, &entry);
+            if (error != CODEC_ERROR_OKAY)
+            {
+                index->count = 0;
+                return error;
+            }
+        }
+
+        i += batch;
+    }
+
+    index->stream_size = stream_size;
+    return CODEC_ERROR_OKAY;
+}
+
+CODEC_ERROR SeekSampleIndex(SAMPLE_INDEX *index, size_t frame, size_t *key_frame_out)
+{
+    size_t key_frame = frame;
+
+    if (index == NULL || key_frame_out == NULL)
+    {
+        return CODEC_ERROR_NULLPTR;
+    }
+
+    if (frame >= index->count)
+    {
+        return CODEC_ERROR_INVALID_ARGUMENT;
+    }
+
+    while (key_frame > 0 && !index->entries[key_frame].key_frame)
+    {
+        key_frame--;
+    }
+
+    // The stream may start with the second frame of a group
+    if (!index->entries[key_frame].key_frame)
+    {
+        return CODEC_ERROR_FRAME_TYPE;
+    }
+
+    *key_frame_out = key_frame;
+    return CODEC_ERROR_OKAY;
+}
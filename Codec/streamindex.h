@@ -0,0 +1,83 @@
+/*! @file streamindex.h
+
+*  @brief Index of the samples in a raw stream of concatenated CineForm samples
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#ifndef _STREAMINDEX_H
+#define _STREAMINDEX_H
+
+#include <stdio.h>
+
+#include "config.h"
+#include "allocator.h"
+#include "error.h"
+
+// Entry in the index for one frame in the stream
+typedef struct sample_index_entry
+{
+    uint64_t offset;		// Offset to the start of the sample (in bytes)
+    uint32_t size;			// Size of the sample (in bytes)
+    uint32_t frame_number;	// Frame number in the sample header (zero if not present)
+    uint16_t sample_type;	// Type of sample (group, second frame in a group, or intra frame)
+    uint8_t key_frame;		// Nonzero if the sample can be decoded without the previous sample
+    uint8_t channels;		// Number of encoded video channels (two for stereo samples)
+
+} SAMPLE_INDEX_ENTRY;
+
+typedef struct sample_index
+{
+#if _ALLOCATOR
+    ALLOCATOR *allocator;
+#endif
+
+    SAMPLE_INDEX_ENTRY *entries;	// One entry for each frame in stream order
+    size_t count;
+    size_t capacity;
+
+    uint64_t stream_size;			// Size of the stream that was indexed (in bytes)
+
+} SAMPLE_INDEX;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if _ALLOCATOR
+SAMPLE_INDEX *CreateSampleIndex(ALLOCATOR *allocator);
+#else
+SAMPLE_INDEX *CreateSampleIndex();
+#endif
+
+void DeleteSampleIndex(SAMPLE_INDEX *index);
+
+// Build the index by walking the sample headers in a stream that is in memory
+CODEC_ERROR IndexSampleStream(SAMPLE_INDEX *index, const uint8_t *stream, uint64_t stream_size);
+
+// Write the index to a sidecar file
+CODEC_ERROR WriteSampleIndex(SAMPLE_INDEX *index, FILE *file);
+
+// Read an index from a sidecar file (fails if the index was built for a stream of a different size)
+CODEC_ERROR ReadSampleIndex(SAMPLE_INDEX *index, FILE *file, uint64_t stream_size);
+
+// Return the index of the key frame that must be decoded before the specified frame
+CODEC_ERROR SeekSampleIndex(SAMPLE_INDEX *index, size_t frame, size_t *key_frame_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
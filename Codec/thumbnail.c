@@ -24,8 +24,61 @@
 #include "decoder.h"
 #include "encoder.h"
 #include "swap.h"
+#include "cpuid.h"
 #include "thumbnail.h"
 
+#if _XMMOPT
+#include <emmintrin.h>
+#endif
+
+// Maximum number of threads that generate thumbnails for a batch of samples
+#define THUMBNAIL_BATCH_MAX_THREADS		8
+
+// State that is reused when generating thumbnails for many samples
+typedef struct thumbnail_context
+{
+#if _ALLOCATOR
+    ALLOCATOR *allocator;
+#endif
+
+    // Layout of the previous sample header (most samples have the same layout)
+    SAMPLE_LAYOUT layout;
+
+    // Decoder for samples without lowpass bands that can be used for the thumbnail
+    DECODER *decoder;			// Allocated and initialized by the first sample that must be decoded
+    int decoder_width;			// Encoded dimensions used to initialize the decoder
+    int decoder_height;
+    int thread_limit;			// Maximum number of worker threads used by the decoder (zero for no limit)
+
+    // Quarter resolution frame decoded from the sample
+    uint8_t *buffer;
+    size_t buffer_size;
+
+} THUMBNAIL_CONTEXT;
+
+// Worker threads that generate the thumbnails for a batch of samples
+typedef struct thumbnail_batch
+{
+#if _ALLOCATOR
+    ALLOCATOR *allocator;
+#endif
+
+    THREAD_POOL pool;			// Worker threads (not created on single processor machines)
+    int thread_count;
+
+    // Each thread has its own context
+    THUMBNAIL_CONTEXT *context[THUMBNAIL_BATCH_MAX_THREADS];
+
+    // Samples in the batch that is being processed
+    void **sample_ptrs;
+    const size_t *sample_sizes;
+    void **output_buffers;
+    const size_t *output_sizes;
+    uint32_t flags;
+    bool *results;
+
+} THUMBNAIL_BATCH;
+
 
 bool GetThumbnailInfo(void *sample_ptr,
                       size_t sample_size,
@@ -65,114 +118,457 @@ bool GetThumbnailInfo(void *sample_ptr,
     return false;
 }
 
-bool GenerateThumbnail(void *sample_ptr,
-                       size_t sample_size,
-                       void *output_buffer,
-                       size_t output_size,
-                       uint32_t flags, // Now carries the pixelformat
-                       size_t *retWidth,
-                       size_t *retHeight,
-                       size_t *retSize)
+#if _XMMOPT
+
+// Swap the bytes in each 16-bit word
+static inline __m128i SwapBytes16(__m128i x)
 {
-    BITSTREAM input;
-    SAMPLE_HEADER header;
-    uint8_t *ptr = sample_ptr;
-    BITLONG *optr = (BITLONG *)output_buffer;
+    return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
 
-    InitBitstreamBuffer(&input, (BITWORD *)sample_ptr, sample_size, BITSTREAM_ACCESS_READ);
+// Swap the bytes in each 32-bit word
+static inline __m128i SwapBytes32(__m128i x)
+{
+    x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    return SwapBytes16(x);
+}
 
-    memset(&header, 0, sizeof(SAMPLE_HEADER));
-    header.find_lowpass_bands = 1;
+// Pack four 10-bit RGB triples into big endian words with the same layout as the scalar code
+static inline __m128i PackRGB10(__m128i r_epi32, __m128i g_epi32, __m128i b_epi32)
+{
+    __m128i rgb_epi32 = _mm_or_si128(_mm_slli_epi32(r_epi32, 22), _mm_slli_epi32(g_epi32, 12));
+    rgb_epi32 = _mm_or_si128(rgb_epi32, _mm_slli_epi32(b_epi32, 2));
+    return SwapBytes32(rgb_epi32);
+}
 
-    if (ParseSampleHeader(&input, &header))
+#endif
+
+/*
+	Convert the lowpass bands of a YUV 4:2:2 sample into 10-bit RGB thumbnail pixels
+
+	The lowpass bands are stored without padding between rows, so the bands are
+	converted as one long row of luma pairs that share the chroma values.
+*/
+static void ConvertLowpassYUVToRGB10(uint8_t *y_band, uint8_t *u_band, uint8_t *v_band,
+                                     int shift, int pair_count, BITLONG *output)
+{
+    uint32_t *yptr = (uint32_t *)y_band;
+    uint16_t *uptr16 = (uint16_t *)u_band;
+    uint16_t *vptr16 = (uint16_t *)v_band;
+    int pair = 0;
+
+#if _XMMOPT
+    const __m128i mask_epi16 = _mm_set1_epi16(0x3ff);
+    const __m128i luma_offset_epi16 = _mm_set1_epi16(64);
+    const __m128i chroma_offset_epi16 = _mm_set1_epi16(0x200);
+    const __m128i max_epi16 = _mm_set1_epi16(0x3ff);
+    const __m128i zero_si128 = _mm_setzero_si128();
+    const __m128i shift_si128 = _mm_cvtsi32_si128(shift);
+
+    // Coefficients for the pairs of luma and chroma values
+    const __m128i r_coeff_epi16 = _mm_setr_epi16(1192, 1836, 1192, 1836, 1192, 1836, 1192, 1836);
+    const __m128i gu_coeff_epi16 = _mm_setr_epi16(1192, -547, 1192, -547, 1192, -547, 1192, -547);
+    const __m128i gv_coeff_epi16 = _mm_setr_epi16(0, -218, 0, -218, 0, -218, 0, -218);
+    const __m128i b_coeff_epi16 = _mm_setr_epi16(1192, 2166, 1192, 2166, 1192, 2166, 1192, 2166);
+
+    __m128i *outptr = (__m128i *)output;
+
+    // Convert four pairs of luma values (eight pixels) per iteration
+    for (; pair + 4 <= pair_count; pair += 4)
     {
-        uint32_t *yptr;
-        uint16_t *uptr16;
-        uint16_t *vptr16;
-        uint32_t *gptr;
-        uint32_t *gptr2;
-        uint32_t *rptr;
-        uint32_t *rptr2;
-        uint32_t *bptr;
-        uint32_t *bptr2;
-        int x, y, width, height;
+        __m128i y_epi16 = _mm_loadu_si128((__m128i *)&yptr[pair]);
+        __m128i u_epi16 = _mm_loadl_epi64((__m128i *)&uptr16[pair]);
+        __m128i v_epi16 = _mm_loadl_epi64((__m128i *)&vptr16[pair]);
+        __m128i yu_epi16, yv_epi16;
+        __m128i r1_epi32, g1_epi32, b1_epi32;
+        __m128i r2_epi32, g2_epi32, b2_epi32;
+        __m128i r_epi16, g_epi16, b_epi16;
+
+        y_epi16 = _mm_and_si128(_mm_srl_epi16(SwapBytes16(y_epi16), shift_si128), mask_epi16);
+        y_epi16 = _mm_sub_epi16(y_epi16, luma_offset_epi16);
+
+        u_epi16 = _mm_and_si128(_mm_srl_epi16(SwapBytes16(u_epi16), shift_si128), mask_epi16);
+        u_epi16 = _mm_sub_epi16(u_epi16, chroma_offset_epi16);
+        u_epi16 = _mm_unpacklo_epi16(u_epi16, u_epi16);
+
+        v_epi16 = _mm_and_si128(_mm_srl_epi16(SwapBytes16(v_epi16), shift_si128), mask_epi16);
+        v_epi16 = _mm_sub_epi16(v_epi16, chroma_offset_epi16);
+        v_epi16 = _mm_unpacklo_epi16(v_epi16, v_epi16);
+
+        // First four pixels
+        yu_epi16 = _mm_unpacklo_epi16(y_epi16, u_epi16);
+        yv_epi16 = _mm_unpacklo_epi16(y_epi16, v_epi16);
+        r1_epi32 = _mm_srai_epi32(_mm_madd_epi16(yu_epi16, r_coeff_epi16), 10);
+        g1_epi32 = _mm_add_epi32(_mm_madd_epi16(yu_epi16, gu_coeff_epi16), _mm_madd_epi16(yv_epi16, gv_coeff_epi16));
+        g1_epi32 = _mm_srai_epi32(g1_epi32, 10);
+        b1_epi32 = _mm_srai_epi32(_mm_madd_epi16(yv_epi16, b_coeff_epi16), 10);
+
+        // Last four pixels
+        yu_epi16 = _mm_unpackhi_epi16(y_epi16, u_epi16);
+        yv_epi16 = _mm_unpackhi_epi16(y_epi16, v_epi16);
+        r2_epi32 = _mm_srai_epi32(_mm_madd_epi16(yu_epi16, r_coeff_epi16), 10);
+        g2_epi32 = _mm_add_epi32(_mm_madd_epi16(yu_epi16, gu_coeff_epi16), _mm_madd_epi16(yv_epi16, gv_coeff_epi16));
+        g2_epi32 = _mm_srai_epi32(g2_epi32, 10);
+        b2_epi32 = _mm_srai_epi32(_mm_madd_epi16(yv_epi16, b_coeff_epi16), 10);
+
+        // Clamp the RGB values to 10 bits
+        r_epi16 = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(r1_epi32, r2_epi32), zero_si128), max_epi16);
+        g_epi16 = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(g1_epi32, g2_epi32), zero_si128), max_epi16);
+        b_epi16 = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(b1_epi32, b2_epi32), zero_si128), max_epi16);
+
+        _mm_storeu_si128(outptr++, PackRGB10(_mm_unpacklo_epi16(r_epi16, zero_si128),
+                                             _mm_unpacklo_epi16(g_epi16, zero_si128),
+                                             _mm_unpacklo_epi16(b_epi16, zero_si128)));
+        _mm_storeu_si128(outptr++, PackRGB10(_mm_unpackhi_epi16(r_epi16, zero_si128),
+                                             _mm_unpackhi_epi16(g_epi16, zero_si128),
+                                             _mm_unpackhi_epi16(b_epi16, zero_si128)));
+    }
 
-        if (header.hdr_uncompressed == 1 || header.encoded_format == ENCODED_FORMAT_BAYER)
-        {
-            InitBitstreamBuffer(&input, (BITWORD *)sample_ptr, sample_size, BITSTREAM_ACCESS_READ);
+    output = (BITLONG *)outptr;
+#endif
 
-            {
-                bool result;
-                DECODER decoder;
-                int q_width = ((header.width + 7) / 8) * 2;
-                int q_height = ((header.height + 7) / 8) * 2;
-                int q_pitch = q_width * 4;
-#ifdef __APPLE__
-                uint8_t *buffer = malloc(q_pitch * q_height);
-#else
-                uint8_t *buffer = _mm_malloc(q_pitch * q_height, 256);
+    for (; pair < pair_count; pair++)
+    {
+        int y1, u1, v1, y2, r, g, b, rgb, pp;
+
+        pp = _bswap(yptr[pair]);
+        y1 = ((pp >> (shift + 16)) & 0x3ff) - 64;
+        y2 = ((pp >> shift) & 0x3ff) - 64;
+        pp = SwapInt16(uptr16[pair]);
+        u1 = ((pp >> shift) & 0x3ff) - 0x200;
+        pp = SwapInt16(vptr16[pair]);
+        v1 = ((pp >> shift) & 0x3ff) - 0x200;
+
+        r = (1192 * y1 + 1836 * u1) >> 10;
+        g = (1192 * y1 - 547 * u1 - 218 * v1) >> 10;
+        b = (1192 * y1 + 2166 * v1) >> 10;
+        if (r < 0) r = 0;
+        if (r > 0x3ff) r = 0x3ff;
+        if (g < 0) g = 0;
+        if (g > 0x3ff) g = 0x3ff;
+        if (b < 0) b = 0;
+        if (b > 0x3ff) b = 0x3ff;
+        rgb = ((r << 22) | (g << 12) | (b << 2));
+        *(output++) = _bswap(rgb);
+
+        r = (1192 * y2 + 1836 * u1) >> 10;
+        g = (1192 * y2 - 547 * u1 - 218 * v1) >> 10;
+        b = (1192 * y2 + 2166 * v1) >> 10;
+        if (r < 0) r = 0;
+        if (r > 0x3ff) r = 0x3ff;
+        if (g < 0) g = 0;
+        if (g > 0x3ff) g = 0x3ff;
+        if (b < 0) b = 0;
+        if (b > 0x3ff) b = 0x3ff;
+        rgb = ((r << 22) | (g << 12) | (b << 2));
+        *(output++) = _bswap(rgb);
+    }
+}
+
+// Convert the lowpass bands of an RGB 4:4:4 sample into 10-bit RGB thumbnail pixels
+static void ConvertLowpassRGBToRGB10(uint8_t *g_band, uint8_t *r_band, uint8_t *b_band,
+                                     int pair_count, BITLONG *output)
+{
+    uint32_t *gptr = (uint32_t *)g_band;
+    uint32_t *rptr = (uint32_t *)r_band;
+    uint32_t *bptr = (uint32_t *)b_band;
+    int pair = 0;
+
+#if _XMMOPT
+    const __m128i mask_epi16 = _mm_set1_epi16(0x3ff);
+    const __m128i zero_si128 = _mm_setzero_si128();
+    __m128i *outptr = (__m128i *)output;
+
+    // Convert eight pixels per iteration
+    for (; pair + 4 <= pair_count; pair += 4)
+    {
+        __m128i g_epi16 = _mm_loadu_si128((__m128i *)&gptr[pair]);
+        __m128i r_epi16 = _mm_loadu_si128((__m128i *)&rptr[pair]);
+        __m128i b_epi16 = _mm_loadu_si128((__m128i *)&bptr[pair]);
+
+        g_epi16 = _mm_and_si128(_mm_srli_epi16(SwapBytes16(g_epi16), 4), mask_epi16);
+        r_epi16 = _mm_and_si128(_mm_srli_epi16(SwapBytes16(r_epi16), 4), mask_epi16);
+        b_epi16 = _mm_and_si128(_mm_srli_epi16(SwapBytes16(b_epi16), 4), mask_epi16);
+
+        _mm_storeu_si128(outptr++, PackRGB10(_mm_unpacklo_epi16(r_epi16, zero_si128),
+                                             _mm_unpacklo_epi16(g_epi16, zero_si128),
+                                             _mm_unpacklo_epi16(b_epi16, zero_si128)));
+        _mm_storeu_si128(outptr++, PackRGB10(_mm_unpackhi_epi16(r_epi16, zero_si128),
+                                             _mm_unpackhi_epi16(g_epi16, zero_si128),
+                                             _mm_unpackhi_epi16(b_epi16, zero_si128)));
+    }
+
+    output = (BITLONG *)outptr;
 #endif
 
-                if (buffer)
-                {
-                    memset(&decoder, 0, sizeof(DECODER));
+    for (; pair < pair_count; pair++)
+    {
+        int r1, g1, b1, r2, g2, b2, rgb, pp;
+
+        pp = _bswap(gptr[pair]);
+        g1 = (pp >> 20) & 0x3ff;
+        g2 = (pp >> 4) & 0x3ff;
+        pp = _bswap(rptr[pair]);
+        r1 = (pp >> 20) & 0x3ff;
+        r2 = (pp >> 4) & 0x3ff;
+        pp = _bswap(bptr[pair]);
+        b1 = (pp >> 20) & 0x3ff;
+        b2 = (pp >> 4) & 0x3ff;
+        rgb = ((r1 << 22) | (g1 << 12) | (b1 << 2));
+        *(output++) = _bswap(rgb);
+
+        rgb = ((r2 << 22) | (g2 << 12) | (b2 << 2));
+        *(output++) = _bswap(rgb);
+    }
+}
+
+// Return the decoder in the context initialized for the encoded frame dimensions
+static DECODER *GetThumbnailDecoder(THUMBNAIL_CONTEXT *context, int width, int height)
+{
+#if _ALLOCATOR
+    ALLOCATOR *allocator = context->allocator;
+#endif
 
+    if (context->decoder == NULL)
+    {
 #if _ALLOCATOR
-                    DecodeInit(NULL, &decoder, header.width, header.height, DECODED_FORMAT_DPX0, DECODED_RESOLUTION_QUARTER, NULL);
+        context->decoder = (DECODER *)Alloc(allocator, sizeof(DECODER));
 #else
-                    DecodeInit(&decoder, header.width, header.height, DECODED_FORMAT_DPX0, DECODED_RESOLUTION_QUARTER, NULL);
+        context->decoder = (DECODER *)MEMORY_ALLOC(sizeof(DECODER));
 #endif
+        if (context->decoder == NULL)
+        {
+            return NULL;
+        }
+        memset(context->decoder, 0, sizeof(DECODER));
+    }
 
+    if (context->decoder_width != width || context->decoder_height != height)
+    {
+        DECODER *decoder = context->decoder;
 
-                    decoder.basic_only = 1;
-                    decoder.flags = DECODER_FLAGS_RENDER;
+        if (context->decoder_width > 0)
+        {
+            ClearDecoder(decoder);
+            context->decoder_width = 0;
+            context->decoder_height = 0;
+        }
 
-                    // Decode the sample
-                    result = DecodeSample(&decoder, &input, buffer, q_pitch, NULL, NULL);
+        // The thread limit is preserved when the decoder is initialized
+        memset(&decoder->thread_cntrl, 0, sizeof(decoder->thread_cntrl));
+        if (context->thread_limit > 0)
+        {
+            decoder->thread_cntrl.limit = context->thread_limit;
+            decoder->thread_cntrl.set_thread_params = 1;
+        }
 
-                    ClearDecoder(&decoder);
+#if _ALLOCATOR
+        if (!DecodeInit(allocator, decoder, width, height, DECODED_FORMAT_DPX0, DECODED_RESOLUTION_QUARTER, NULL))
+#else
+        if (!DecodeInit(decoder, width, height, DECODED_FORMAT_DPX0, DECODED_RESOLUTION_QUARTER, NULL))
+#endif
+        {
+            return NULL;
+        }
 
-                    if (result != true)
-                    {
+        context->decoder_width = width;
+        context->decoder_height = height;
+    }
+
+    return context->decoder;
+}
+
+/*
+	Decode the sample at quarter resolution and subsample the frame to the thumbnail size
+
+	Returns false if the thumbnail could not be decoded because of a lack of memory, in
+	which case the thumbnail is taken from the lowpass bands.  The result of decoding the
+	sample is returned in the result argument.
+*/
+static bool DecodeQuarterThumbnail(THUMBNAIL_CONTEXT *context, BITSTREAM *input, SAMPLE_HEADER *header,
+                                   BITLONG *optr, bool *result_out)
+{
+    bool result;
+    DECODER *decoder = NULL;
+    int q_width = ((header->width + 7) / 8) * 2;
+    int q_height = ((header->height + 7) / 8) * 2;
+    int q_pitch = q_width * 4;
+    size_t q_size = (size_t)q_pitch * q_height;
+    uint8_t *buffer;
+    int x, y;
+
+    if (context == NULL)
+    {
+        // Initialize a temporary decoder for this sample
+        DECODER local_decoder;
 #ifdef __APPLE__
-                        free(buffer);
+        buffer = malloc(q_size);
 #else
-                        _mm_free(buffer);
+        buffer = _mm_malloc(q_size, 256);
 #endif
-                        return false;
-                    }
-                    else
-                    {
-                        int x, y;
-                        for (y = 0; y < q_height; y += 2)
-                        {
-                            uint32_t *rgbptr;
-                            rgbptr = (uint32_t *)buffer;
-                            rgbptr += y * q_width;
+        if (buffer == NULL)
+        {
+            return false;
+        }
 
-                            for (x = 0; x < q_width; x += 2)
-                            {
-                                uint32_t rgb = *rgbptr;
-                                rgbptr += 2; // two RGB pixels
+        memset(&local_decoder, 0, sizeof(DECODER));
 
-                                *(optr++) = rgb;
-                            }
-                        }
-                    }
+#if _ALLOCATOR
+        DecodeInit(NULL, &local_decoder, header->width, header->height, DECODED_FORMAT_DPX0, DECODED_RESOLUTION_QUARTER, NULL);
+#else
+        DecodeInit(&local_decoder, header->width, header->height, DECODED_FORMAT_DPX0, DECODED_RESOLUTION_QUARTER, NULL);
+#endif
 
-#ifdef __APPLE__
-                    free(buffer);
+        local_decoder.basic_only = 1;
+        local_decoder.flags = DECODER_FLAGS_RENDER;
+
+        // Decode the sample
+        result = DecodeSample(&local_decoder, input, buffer, q_pitch, NULL, NULL);
+
+        ClearDecoder(&local_decoder);
+    }
+    else
+    {
+#if _ALLOCATOR
+        ALLOCATOR *allocator = context->allocator;
+#endif
+        // The decoder in the context would decode the second frame from an unrelated group
+        if (!header->key_frame)
+        {
+            *result_out = false;
+            return true;
+        }
+
+        if (context->buffer_size < q_size)
+        {
+#if _ALLOCATOR
+            if (context->buffer) FreeAligned(allocator, context->buffer);
+            context->buffer = (uint8_t *)AllocAligned(allocator, q_size, 16);
 #else
-                    _mm_free(buffer);
+            if (context->buffer) MEMORY_ALIGNED_FREE(context->buffer);
+            context->buffer = (uint8_t *)MEMORY_ALIGNED_ALLOC(q_size, 16);
 #endif
-                    goto finished;
-                }
+            context->buffer_size = (context->buffer != NULL) ? q_size : 0;
+        }
+
+        buffer = context->buffer;
+        if (buffer != NULL)
+        {
+            decoder = GetThumbnailDecoder(context, header->width, header->height);
+        }
+        if (decoder == NULL)
+        {
+            return false;
+        }
+
+        decoder->basic_only = 1;
+        decoder->flags = DECODER_FLAGS_RENDER;
+
+        // Decode the sample
+        result = DecodeSample(decoder, input, buffer, q_pitch, NULL, NULL);
+    }
+
+    if (result)
+    {
+        for (y = 0; y < q_height; y += 2)
+        {
+            uint32_t *rgbptr;
+            rgbptr = (uint32_t *)buffer;
+            rgbptr += y * q_width;
+
+            for (x = 0; x < q_width; x += 2)
+            {
+                uint32_t rgb = *rgbptr;
+                rgbptr += 2; // two RGB pixels
+
+                *(optr++) = rgb;
             }
         }
+    }
+
+    if (context == NULL)
+    {
+#ifdef __APPLE__
+        free(buffer);
+#else
+        _mm_free(buffer);
+#endif
+    }
+
+    *result_out = result;
+    return true;
+}
+
+static bool GenerateThumbnailInternal(THUMBNAIL_CONTEXT *context,
+                                      void *sample_ptr,
+                                      size_t sample_size,
+                                      void *output_buffer,
+                                      size_t output_size,
+                                      uint32_t flags, // Now carries the pixelformat
+                                      size_t *retWidth,
+                                      size_t *retHeight,
+                                      size_t *retSize)
+{
+    BITSTREAM input;
+    SAMPLE_HEADER header;
+    uint8_t *ptr = sample_ptr;
+    BITLONG *optr = (BITLONG *)output_buffer;
+    bool parsed;
+
+    InitBitstreamBuffer(&input, (BITWORD *)sample_ptr, sample_size, BITSTREAM_ACCESS_READ);
+
+    memset(&header, 0, sizeof(SAMPLE_HEADER));
+    header.find_lowpass_bands = 1;
+
+    if (context != NULL)
+    {
+        parsed = ParseSampleHeaderWithLayout(&input, &header, &context->layout);
+    }
+    else
+    {
+        parsed = ParseSampleHeader(&input, &header);
+    }
+
+    if (!parsed)
+    {
+        // Cannot find the lowpass bands without the sample header
+        return false;
+    }
+    else
+    {
+        uint32_t *gptr;
+        uint32_t *gptr2;
+        uint32_t *rptr;
+        uint32_t *rptr2;
+        uint32_t *bptr;
+        uint32_t *bptr2;
+        int x, y, width, height;
 
         width = (header.width + 7) / 8;
         height = (header.height + 7) / 8;
 
+        if (header.hdr_uncompressed == 1 || header.encoded_format == ENCODED_FORMAT_BAYER)
+        {
+            bool result = false;
+
+            if (output_size < (size_t)width * height * 4)
+            {
+                return false; // failed
+            }
+
+            InitBitstreamBuffer(&input, (BITWORD *)sample_ptr, sample_size, BITSTREAM_ACCESS_READ);
+
+            if (DecodeQuarterThumbnail(context, &input, &header, optr, &result))
+            {
+                if (result != true)
+                {
+                    return false;
+                }
+                goto finished;
+            }
+        }
+
         //if (flags & 3)
         {
             if (output_size < (size_t)width * height * 4)
@@ -180,62 +576,31 @@ bool GenerateThumbnail(void *sample_ptr,
                 return false; // failed
             }
 
+            // The second frame in a group does not contain the lowpass bands
+            if (header.thumbnail_channel_offsets[0] == 0)
+            {
+                return false;
+            }
+
             // Convert the lowpass image to an RGB thumbnail
             switch (header.encoded_format)
             {
                 case ENCODED_FORMAT_UNKNOWN:
                 case ENCODED_FORMAT_YUV_422:
-                    yptr = (uint32_t *)(ptr + header.thumbnail_channel_offsets[0]);
-                    uptr16 = (uint16_t *)(ptr + header.thumbnail_channel_offsets[1]);
-                    vptr16 = (uint16_t *)(ptr + header.thumbnail_channel_offsets[2]);
-                    for (y = 0; y < height; y++)
-                    {
-                        int shift = 4;
-
-                        if (header.key_frame && !header.droppable_frame) // 2 frame GOP
-                            shift = 5;
-                        else if (!header.key_frame)
-                            shift = 5;
+                {
+                    int shift = 4;
 
+                    if (header.key_frame && !header.droppable_frame) // 2 frame GOP
+                        shift = 5;
+                    else if (!header.key_frame)
+                        shift = 5;
 
-                        for (x = 0; x < width; x += 2)
-                        {
-                            int y1, u1, v1, y2, r, g, b, rgb, pp;
-
-                            pp = _bswap(*yptr++);
-                            y1 = ((pp >> (shift + 16)) & 0x3ff) - 64;
-                            y2 = ((pp >> shift) & 0x3ff) - 64;
-                            pp = SwapInt16(*uptr16++);
-                            u1 = ((pp >> shift) & 0x3ff) - 0x200;
-                            pp = SwapInt16(*vptr16++);
-                            v1 = ((pp >> shift) & 0x3ff) - 0x200;
-
-                            r = (1192 * y1 + 1836 * u1) >> 10;
-                            g = (1192 * y1 - 547 * u1 - 218 * v1) >> 10;
-                            b = (1192 * y1 + 2166 * v1) >> 10;
-                            if (r < 0) r = 0;
-                            if (r > 0x3ff) r = 0x3ff;
-                            if (g < 0) g = 0;
-                            if (g > 0x3ff) g = 0x3ff;
-                            if (b < 0) b = 0;
-                            if (b > 0x3ff) b = 0x3ff;
-                            rgb = ((r << 22) | (g << 12) | (b << 2));
-                            *(optr++) = _bswap(rgb);
-
-                            r = (1192 * y2 + 1836 * u1) >> 10;
-                            g = (1192 * y2 - 547 * u1 - 218 * v1) >> 10;
-                            b = (1192 * y2 + 2166 * v1) >> 10;
-                            if (r < 0) r = 0;
-                            if (r > 0x3ff) r = 0x3ff;
-                            if (g < 0) g = 0;
-                            if (g > 0x3ff) g = 0x3ff;
-                            if (b < 0) b = 0;
-                            if (b > 0x3ff) b = 0x3ff;
-                            rgb = ((r << 22) | (g << 12) | (b << 2));
-                            *(optr++) = _bswap(rgb);
-                        }
-                    }
-                    break;
+                    ConvertLowpassYUVToRGB10(ptr + header.thumbnail_channel_offsets[0],
+                                             ptr + header.thumbnail_channel_offsets[1],
+                                             ptr + header.thumbnail_channel_offsets[2],
+                                             shift, height * ((width + 1) / 2), optr);
+                }
+                break;
                 case ENCODED_FORMAT_BAYER:
                     // Expand the Bayer data to the same size as other thumbnails
                     for (y = 0; y < height; y++)
@@ -433,31 +798,10 @@ bool GenerateThumbnail(void *sample_ptr,
                 case ENCODED_FORMAT_RGB_444:
                 case ENCODED_FORMAT_RGBA_4444:
                     // Return an RGB thumbnail
-                    gptr = (uint32_t *)(ptr + header.thumbnail_channel_offsets[0]);
-                    rptr = (uint32_t *)(ptr + header.thumbnail_channel_offsets[1]);
-                    bptr = (uint32_t *)(ptr + header.thumbnail_channel_offsets[2]);
-                    for (y = 0; y < height; y++)
-                    {
-                        for (x = 0; x < width; x += 2)
-                        {
-                            int r1, g1, b1, r2, g2, b2, rgb, pp;
-
-                            pp = _bswap(*gptr++);
-                            g1 = (pp >> 20) & 0x3ff;
-                            g2 = (pp >> 4) & 0x3ff;
-                            pp = _bswap(*rptr++);
-                            r1 = (pp >> 20) & 0x3ff;
-                            r2 = (pp >> 4) & 0x3ff;
-                            pp = _bswap(*bptr++);
-                            b1 = (pp >> 20) & 0x3ff;
-                            b2 = (pp >> 4) & 0x3ff;
-                            rgb = ((r1 << 22) | (g1 << 12) | (b1 << 2));
-                            *(optr++) = _bswap(rgb);
-
-                            rgb = ((r2 << 22) | (g2 << 12) | (b2 << 2));
-                            *(optr++) = _bswap(rgb);
-                        }
-                    }
+                    ConvertLowpassRGBToRGB10(ptr + header.thumbnail_channel_offsets[0],
+                                             ptr + header.thumbnail_channel_offsets[1],
+                                             ptr + header.thumbnail_channel_offsets[2],
+                                             height * ((width + 1) / 2), optr);
                     break;
 
                 default:
@@ -473,7 +817,311 @@ finished:
     if (retHeight)
         *retHeight = (header.height + 7) / 8;
     if (retSize)
-        *retSize = (*retWidth * *retHeight * 4);
+        *retSize = ((header.width + 7) / 8) * ((header.height + 7) / 8) * 4;
+
+    return true;
+}
+
+bool GenerateThumbnail(void *sample_ptr,
+                       size_t sample_size,
+                       void *output_buffer,
+                       size_t output_size,
+                       uint32_t flags,
+                       size_t *retWidth,
+                       size_t *retHeight,
+                       size_t *retSize)
+{
+    return GenerateThumbnailInternal(NULL, sample_ptr, sample_size, output_buffer, output_size,
+                                     flags, retWidth, retHeight, retSize);
+}
+
+bool GenerateThumbnailWithContext(THUMBNAIL_CONTEXT *context,
+                                  void *sample_ptr,
+                                  size_t sample_size,
+                                  void *output_buffer,
+                                  size_t output_size,
+                                  uint32_t flags,
+                                  size_t *retWidth,
+                                  size_t *retHeight,
+                                  size_t *retSize)
+{
+    return GenerateThumbnailInternal(context, sample_ptr, sample_size, output_buffer, output_size,
+                                     flags, retWidth, retHeight, retSize);
+}
+
+#if _ALLOCATOR
+THUMBNAIL_CONTEXT *CreateThumbnailContext(ALLOCATOR *allocator)
+#else
+THUMBNAIL_CONTEXT *CreateThumbnailContext()
+#endif
+{
+    THUMBNAIL_CONTEXT *context;
+
+#if _ALLOCATOR
+    context = (THUMBNAIL_CONTEXT *)Alloc(allocator, sizeof(THUMBNAIL_CONTEXT));
+#else
+    context = (THUMBNAIL_CONTEXT *)MEMORY_ALLOC(sizeof(THUMBNAIL_CONTEXT));
+#endif
+    if (context == NULL) return NULL;
+
+    memset(context, 0, sizeof(THUMBNAIL_CONTEXT));
+
+#if _ALLOCATOR
+    context->allocator = allocator;
+#endif
+
+    return context;
+}
+
+void DeleteThumbnailContext(THUMBNAIL_CONTEXT *context)
+{
+#if _ALLOCATOR
+    ALLOCATOR *allocator;
+#endif
+
+    if (context == NULL) return;
+
+#if _ALLOCATOR
+    allocator = context->allocator;
+#endif
+
+    if (context->decoder)
+    {
+        if (context->decoder_width > 0)
+        {
+            ClearDecoder(context->decoder);
+        }
+#if _ALLOCATOR
+        Free(allocator, context->decoder);
+#else
+        MEMORY_FREE(context->decoder);
+#endif
+    }
+
+    if (context->buffer)
+    {
+#if _ALLOCATOR
+        FreeAligned(allocator, context->buffer);
+#else
+        MEMORY_ALIGNED_FREE(context->buffer);
+#endif
+    }
+
+#if _ALLOCATOR
+    Free(allocator, context);
+#else
+    MEMORY_FREE(context);
+#endif
+}
+
+// Generate the thumbnail for one sample in the batch
+static void GenerateBatchThumbnail(THUMBNAIL_BATCH *batch, int index, THUMBNAIL_CONTEXT *context)
+{
+    if (batch->results[index])
+    {
+        batch->results[index] = GenerateThumbnailWithContext(context,
+                                batch->sample_ptrs[index],
+                                batch->sample_sizes[index],
+                                batch->output_buffers[index],
+                                batch->output_sizes[index],
+                                batch->flags, NULL, NULL, NULL);
+    }
+}
+
+static THREAD_PROC(ThumbnailThreadProc, lpParam)
+{
+    THUMBNAIL_BATCH *batch = (THUMBNAIL_BATCH *)lpParam;
+    THREAD_ERROR error = THREAD_ERROR_OKAY;
+    int thread_index;
+
+    // Determine the index of this worker thread
+    error = PoolThreadGetIndex(&batch->pool, &thread_index);
+    assert(error == THREAD_ERROR_OKAY);
+
+    for (;;)
+    {
+        THREAD_MESSAGE message = THREAD_MESSAGE_NONE;
+        error = PoolThreadWaitForMessage(&batch->pool, thread_index, &message);
+
+        // Received a signal to begin?
+        if (error == THREAD_ERROR_OKAY && message == THREAD_MESSAGE_START)
+        {
+            for (;;)
+            {
+                int work_index = -1;
+
+                error = PoolThreadWaitForWork(&batch->pool, &work_index, thread_index);
+
+                // Is there another sample in the batch?
+                if (error == THREAD_ERROR_OKAY)
+                {
+                    GenerateBatchThumbnail(batch, work_index, batch->context[thread_index]);
+                }
+                else if (error == THREAD_ERROR_NOWORK)
+                {
+                    PoolThreadSignalDone(&batch->pool, thread_index);
+                    break;
+                }
+            }
+        }
+        else if (error == THREAD_ERROR_OKAY && message == THREAD_MESSAGE_STOP)
+        {
+            // The worker thread has been told to terminate itself
+            break;
+        }
+        else if (error != THREAD_ERROR_OKAY)
+        {
+            // If the wait failed it probably means that the thread pool is shutting down
+            break;
+        }
+    }
+
+    return (THREAD_RETURN_TYPE)error;
+}
+
+#if _ALLOCATOR
+THUMBNAIL_BATCH *CreateThumbnailBatch(ALLOCATOR *allocator)
+#else
+THUMBNAIL_BATCH *CreateThumbnailBatch()
+#endif
+{
+    THUMBNAIL_BATCH *batch;
+    int thread_count = GetProcessorCount();
+    int i;
+
+    if (thread_count > THUMBNAIL_BATCH_MAX_THREADS) thread_count = THUMBNAIL_BATCH_MAX_THREADS;
+    if (thread_count < 1) thread_count = 1;
+
+#if _ALLOCATOR
+    batch = (THUMBNAIL_BATCH *)Alloc(allocator, sizeof(THUMBNAIL_BATCH));
+#else
+    batch = (THUMBNAIL_BATCH *)MEMORY_ALLOC(sizeof(THUMBNAIL_BATCH));
+#endif
+    if (batch == NULL) return NULL;
+
+    memset(batch, 0, sizeof(THUMBNAIL_BATCH));
+
+#if _ALLOCATOR
+    batch->allocator = allocator;
+#endif
+
+    for (i = 0; i < thread_count; i++)
+    {
+#if _ALLOCATOR
+        batch->context[i] = CreateThumbnailContext(allocator);
+#else
+        batch->context[i] = CreateThumbnailContext();
+#endif
+        if (batch->context[i] == NULL)
+        {
+            DeleteThumbnailBatch(batch);
+            return NULL;
+        }
+
+        // Samples are processed in parallel so each decoder uses the calling thread
+        if (thread_count > 1)
+        {
+            batch->context[i]->thread_limit = 1;
+        }
+    }
+
+    batch->thread_count = thread_count;
+
+    if (thread_count > 1)
+    {
+        ThreadPoolCreate(&batch->pool, thread_count, ThumbnailThreadProc, batch);
+    }
+
+    return batch;
+}
+
+void DeleteThumbnailBatch(THUMBNAIL_BATCH *batch)
+{
+#if _ALLOCATOR
+    ALLOCATOR *allocator;
+#endif
+    int i;
+
+    if (batch == NULL) return;
+
+#if _ALLOCATOR
+    allocator = batch->allocator;
+#endif
+
+    if (batch->thread_count > 1)
+    {
+        ThreadPoolDelete(&batch->pool);
+    }
+
+    for (i = 0; i < THUMBNAIL_BATCH_MAX_THREADS; i++)
+    {
+        DeleteThumbnailContext(batch->context[i]);
+    }
+
+#if _ALLOCATOR
+    Free(allocator, batch);
+#else
+    MEMORY_FREE(batch);
+#endif
+}
+
+bool GenerateThumbnailBatch(THUMBNAIL_BATCH *batch,
+                            int sample_count,
+                            void **sample_ptrs,
+                            const size_t *sample_sizes,
+                            void **output_buffers,
+                            const size_t *output_sizes,
+                            uint32_t flags,
+                            bool *results)
+{
+    int index;
+
+    if (batch == NULL || sample_ptrs == NULL || sample_sizes == NULL ||
+            output_buffers == NULL || output_sizes == NULL || results == NULL)
+    {
+        return false;
+    }
+
+    // Samples without a sample or output buffer are skipped
+    for (index = 0; index < sample_count; index++)
+    {
+        results[index] = (sample_ptrs[index] != NULL && sample_sizes[index] > 0 && output_buffers[index] != NULL);
+    }
+
+    batch->sample_ptrs = sample_ptrs;
+    batch->sample_sizes = sample_sizes;
+    batch->output_buffers = output_buffers;
+    batch->output_sizes = output_sizes;
+    batch->flags = flags;
+    batch->results = results;
+
+    if (batch->thread_count > 1 && sample_count > 1)
+    {
+        ThreadPoolSetWorkCount(&batch->pool, sample_count);
+        ThreadPoolSendMessage(&batch->pool, THREAD_MESSAGE_START);
+        ThreadPoolWaitAllDone(&batch->pool);
+    }
+    else
+    {
+        for (index = 0; index < sample_count; index++)
+        {
+            GenerateBatchThumbnail(batch, index, batch->context[0]);
+        }
+    }
+
+    batch->sample_ptrs = NULL;
+    batch->sample_sizes = NULL;
+    batch->output_buffers = NULL;
+    batch->output_sizes = NULL;
+    batch->results = NULL;
+
+    for (index = 0; index < sample_count; index++)
+    {
+        if (!results[index])
+        {
+            return false;
+        }
+    }
 
     return true;
 }
@@ -65,6 +65,12 @@ typedef enum modify_lowpass_flags
 
 } MODIFY_LOWPASS_FLAGS;
 
+// State that is reused when generating thumbnails for many samples (defined in thumbnail.c)
+typedef struct thumbnail_context THUMBNAIL_CONTEXT;
+
+// Worker threads that generate the thumbnails for a batch of samples (defined in thumbnail.c)
+typedef struct thumbnail_batch THUMBNAIL_BATCH;
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -86,6 +92,43 @@ bool GenerateThumbnail(void *sample_ptr,
                        size_t *actual_height_out,
                        size_t *actual_size_out);
 
+#if _ALLOCATOR
+THUMBNAIL_CONTEXT *CreateThumbnailContext(ALLOCATOR *allocator);
+#else
+THUMBNAIL_CONTEXT *CreateThumbnailContext();
+#endif
+
+void DeleteThumbnailContext(THUMBNAIL_CONTEXT *context);
+
+// Generate the thumbnail using the sample layout and decoder saved in the context
+bool GenerateThumbnailWithContext(THUMBNAIL_CONTEXT *context,
+                                  void *sample_ptr,
+                                  size_t sample_size,
+                                  void *output_buffer,
+                                  size_t output_size,
+                                  uint32_t flags,
+                                  size_t *actual_width_out,
+                                  size_t *actual_height_out,
+                                  size_t *actual_size_out);
+
+#if _ALLOCATOR
+THUMBNAIL_BATCH *CreateThumbnailBatch(ALLOCATOR *allocator);
+#else
+THUMBNAIL_BATCH *CreateThumbnailBatch();
+#endif
+
+void DeleteThumbnailBatch(THUMBNAIL_BATCH *batch);
+
+// Generate the thumbnails for an array of samples (returns true if every thumbnail was generated)
+bool GenerateThumbnailBatch(THUMBNAIL_BATCH *batch,
+                            int sample_count,
+                            void **sample_ptrs,
+                            const size_t *sample_sizes,
+                            void **output_buffers,
+                            const size_t *output_sizes,
+                            uint32_t flags,
+                            bool *results);
+
 // Get the lowpass image with the encoded dimensions and format
 bool GetLowpassThumbnail(void *sample_ptr,
                          size_t sample_size,
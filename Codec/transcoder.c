@@ -0,0 +1,1060 @@
+/*! @file transcoder.c
+
+*  @brief Requantize the highpass bands of an encoded sample to a lower quality
+*
+*  The transcoder walks the tags in the encoded sample and copies the sample header,
+*  the metadata, and the lowpass bands without change.  Each highpass band that can be
+*  requantized is entropy decoded into a buffer of coefficients, quantized again with
+*  the quantization for the target quality, and entropy coded with the same codebook.
+*  The wavelet transform is never inverted, so transcoding is much faster than decoding
+*  the frame and encoding it again.
+*
+*  The size fields of the enclosing chunks and the channel sizes in the sample index
+*  are updated to match the size of the requantized bands.
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "stdafx.h"
+#include "config.h"
+#include "bitstream.h"
+#include "codec.h"
+#include "codebooks.h"
+#include "decoder.h"
+#include "encoder.h"
+#include "quantize.h"
+#include "transcoder.h"
+
+// Maximum number of nested chunks (sample, level, and band)
+#define TRANSCODER_MAX_CHUNKS		NESTING_LEVELS
+
+// Maximum number of entries in the channel size index
+#define TRANSCODER_MAX_CHANNELS		16
+
+// Extra space after the band for runs that the decoder writes past the end of a damaged band
+#define TRANSCODER_BAND_SLACK		(16 * 1024)
+
+// Extra space for the band end code and padding after the encoded coefficients
+#define TRANSCODER_CODE_SLACK		64
+
+// Number of decoded magnitudes in the table used for requantization
+#define TRANSCODER_REQUANT_TABLE_LENGTH		1024
+
+// Codebook that is used for peaks and difference coding
+#define TRANSCODER_PEAKS_CODEBOOK	2
+
+// Routines in the decoder and encoder that are not declared in the header files
+#if _DEBUG
+bool DecodeBandFSM16sNoGap(FSM *fsm, BITSTREAM *stream, PIXEL16S *image, int width, int height, int pitch, FILE *logfile);
+#else
+bool DecodeBandFSM16sNoGap(FSM *fsm, BITSTREAM *stream, PIXEL16S *image, int width, int height, int pitch);
+#endif
+void EncodeQuantLongRuns(ENCODER *encoder, BITSTREAM *stream, PIXEL *image,
+                         int width, int height, int pitch, int divisor, int active_codebook);
+
+// The quantizer changes the midpoint used by the encoder as a side effect
+extern int g_midpoint_prequant;
+
+
+// Chunk with a size field that must be updated after the chunk has been copied
+typedef struct transcode_chunk
+{
+    size_t input_end;		// Offset to the end of the chunk in the input sample
+    size_t output_offset;	// Offset to the chunk size tag in the output sample
+    int tag;				// Chunk tag without the upper bits of the size
+    bool optional;			// Was the chunk size tag optional?
+
+} TRANSCODE_CHUNK;
+
+// Type of band that is being copied
+enum
+{
+    TRANSCODE_BAND_NONE = 0,
+    TRANSCODE_BAND_LOWPASS,
+    TRANSCODE_BAND_HIGHPASS,
+};
+
+// State of the transcoder while copying one sample
+typedef struct transcode_state
+{
+    const uint8_t *input;
+    size_t input_size;
+
+    uint8_t *output;
+    size_t output_size;
+    size_t output_offset;
+
+    // Stack of chunks with sizes that must be updated
+    TRANSCODE_CHUNK chunk[TRANSCODER_MAX_CHUNKS];
+    int chunk_count;
+
+    // Channel size index from the most recent sample header
+    size_t index_input_offset;
+    size_t index_output_offset;
+    int index_count;
+    int32_t channel_delta[TRANSCODER_MAX_CHANNELS];
+    int channel;
+
+    // Parameters from the sample header that determine the quantization
+    int source_quality;
+    int target_quality;
+    int precision;
+    int encoded_format;
+    bool progressive;
+    int num_frames;
+
+    // Quantization tables for luma and chroma at the source and target qualities
+    bool quant_tables_valid;
+    int source_quant[2][MAX_QUANT_SUBBANDS];
+    int target_quant[2][MAX_QUANT_SUBBANDS];
+
+    // Parameters of the band that is being copied
+    int band_type;
+    bool lowpass_data;
+    int band_width;
+    int band_height;
+    int band_subband;
+    int band_encoding;
+    int band_codebook;
+    bool band_difference;
+    int band_quant;
+    int band_requant;
+    int band_quant_tag;
+    size_t band_quant_offset;
+
+} TRANSCODE_STATE;
+
+
+static inline int GetTagAt(const uint8_t *buffer)
+{
+    return (int16_t)((buffer[0] << 8) | buffer[1]);
+}
+
+static inline int GetValueAt(const uint8_t *buffer)
+{
+    return (buffer[2] << 8) | buffer[3];
+}
+
+static inline void SetTagValueAt(uint8_t *buffer, int tag, int value)
+{
+    buffer[0] = (uint8_t)((tag >> 8) & 0xFF);
+    buffer[1] = (uint8_t)(tag & 0xFF);
+    buffer[2] = (uint8_t)((value >> 8) & 0xFF);
+    buffer[3] = (uint8_t)(value & 0xFF);
+}
+
+static inline uint32_t GetLongAt(const uint8_t *buffer)
+{
+    return ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) | ((uint32_t)buffer[2] << 8) | buffer[3];
+}
+
+static inline void SetLongAt(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = (uint8_t)(value >> 24);
+    buffer[1] = (uint8_t)(value >> 16);
+    buffer[2] = (uint8_t)(value >> 8);
+    buffer[3] = (uint8_t)value;
+}
+
+// Error returned when the transcoded sample does not fit in the output buffer
+static inline CODEC_ERROR TranscodeOverflow()
+{
+    return (CODEC_ERROR)(CODEC_ERROR_BITSTREAM | BITSTREAM_ERROR_OVERFLOW);
+}
+
+static bool CopyToOutput(TRANSCODE_STATE *state, const uint8_t *data, size_t size)
+{
+    if (size > state->output_size - state->output_offset)
+    {
+        return false;
+    }
+
+    memcpy(state->output + state->output_offset, data, size);
+    state->output_offset += size;
+    return true;
+}
+
+static bool PutTagValueOutput(TRANSCODE_STATE *state, int tag, int value)
+{
+    if (state->output_size - state->output_offset < 4)
+    {
+        return false;
+    }
+
+    SetTagValueAt(state->output + state->output_offset, tag, value);
+    state->output_offset += 4;
+    return true;
+}
+
+// Compute the quantization tables used by the encoder for the specified quality
+static void ComputeQuantTables(TRANSCODE_STATE *state, int quality, int quant[2][MAX_QUANT_SUBBANDS])
+{
+    QUANTIZER quantizer;
+    bool chroma_full_res = (state->encoded_format != ENCODED_FORMAT_YUV_422);
+    int midpoint_prequant = g_midpoint_prequant;
+
+    memset(&quantizer, 0, sizeof(quantizer));
+    InitQuantizer(&quantizer);
+    QuantizationSetQuality(&quantizer, quality, state->progressive, state->precision,
+                           state->num_frames, chroma_full_res, NULL, 0, 1);
+
+    // Restore the midpoint so that the transcoder does not change the encoder
+    g_midpoint_prequant = midpoint_prequant;
+
+    memcpy(quant[0], quantizer.quantLuma, sizeof(quant[0]));
+    memcpy(quant[1], quantizer.quantChroma, sizeof(quant[1]));
+}
+
+// Choose the quantization for the current band at the target quality
+static int TargetBandQuantization(TRANSCODE_STATE *state)
+{
+    int source_quant = state->band_quant;
+    int target_quant;
+    int table = (state->channel > 0) ? 1 : 0;
+    int subband = state->band_subband;
+    int64_t scaled;
+
+    // Only bands encoded with the default run length codebooks can be requantized
+    if (state->band_type != TRANSCODE_BAND_HIGHPASS ||
+            state->band_encoding != BAND_ENCODING_RUNLENGTHS ||
+            state->band_codebook < 0 || state->band_codebook >= CODEC_NUM_CODESETS ||
+            state->band_codebook == TRANSCODER_PEAKS_CODEBOOK ||
+            state->band_difference ||
+            source_quant <= 0 ||
+            subband <= 0 || subband >= MAX_QUANT_SUBBANDS)
+    {
+        return source_quant;
+    }
+
+    if (!state->quant_tables_valid)
+    {
+        ComputeQuantTables(state, state->source_quality, state->source_quant);
+        ComputeQuantTables(state, state->target_quality, state->target_quant);
+        state->quant_tables_valid = true;
+    }
+
+    if (state->source_quant[table][subband] <= 0 || state->target_quant[table][subband] <= 0)
+    {
+        return source_quant;
+    }
+
+    // The band quantization includes adjustments by the encoder that do not depend on the quality
+    scaled = (int64_t)source_quant * state->target_quant[table][subband];
+    scaled = (scaled + state->source_quant[table][subband] / 2) / state->source_quant[table][subband];
+    target_quant = (int)((scaled > DEFAULT_QUANT_LIMIT) ? DEFAULT_QUANT_LIMIT : scaled);
+
+    // Never increase the precision of the coefficients
+    if (target_quant < source_quant)
+    {
+        target_quant = source_quant;
+    }
+
+    return target_quant;
+}
+
+// Update the size field of the innermost chunk after all of its contents have been copied
+static CODEC_ERROR PopChunk(TRANSCODE_STATE *state)
+{
+    TRANSCODE_CHUNK *chunk;
+    size_t chunk_size;
+    int tag;
+
+    assert(state->chunk_count > 0);
+    chunk = &state->chunk[--state->chunk_count];
+
+    // Size of the chunk in four byte words not counting the chunk size tag
+    chunk_size = (state->output_offset - chunk->output_offset) / 4 - 1;
+    if (chunk_size > 0xFFFFFF)
+    {
+        return CODEC_ERROR_INVALID_BITSTREAM;
+    }
+
+    tag = chunk->tag | (int)(chunk_size >> 16);
+    if (chunk->optional)
+    {
+        tag = OPTIONALTAG(tag);
+    }
+
+    SetTagValueAt(state->output + chunk->output_offset, tag, (int)(chunk_size & 0xFFFF));
+
+    return CODEC_ERROR_OKAY;
+}
+
+// Update the channel sizes in the most recent sample index
+static CODEC_ERROR UpdateChannelIndex(TRANSCODE_STATE *state)
+{
+    int i;
+
+    for (i = 0; i < state->index_count; i++)
+    {
+        const uint8_t *input_entry = state->input + state->index_input_offset + 4 * i;
+        uint8_t *output_entry = state->output + state->index_output_offset + 4 * i;
+        int64_t channel_size = (int64_t)GetLongAt(input_entry) + state->channel_delta[i];
+
+        if (channel_size < 0 || channel_size > UINT32_MAX)
+        {
+            return CODEC_ERROR_SAMPLE_INDEX;
+        }
+
+        SetLongAt(output_entry, (uint32_t)channel_size);
+        state->channel_delta[i] = 0;
+    }
+
+    state->index_count = 0;
+
+    return CODEC_ERROR_OKAY;
+}
+
+// Quantize the decoded coefficients again with the target quantization
+static void RequantizeBand(PIXEL *band, int width, int height, int pitch, int source_quant, int target_quant)
+{
+    // Table of requantized values indexed by the signed decoded value
+    PIXEL table[2 * TRANSCODER_REQUANT_TABLE_LENGTH];
+    const int offset = TRANSCODER_REQUANT_TABLE_LENGTH;
+    int midpoint = target_quant / 2 - 1;
+    int row, column;
+    int i;
+
+    if (midpoint < 0) midpoint = 0;
+
+    for (i = 0; i < TRANSCODER_REQUANT_TABLE_LENGTH; i++)
+    {
+        PIXEL magnitude = (PIXEL)((i * source_quant + midpoint) / target_quant);
+        table[offset + i] = magnitude;
+        table[offset - i] = -magnitude;
+    }
+
+    // Convert the pitch from bytes to pixels
+    pitch /= sizeof(PIXEL);
+
+    for (row = 0; row < height; row++)
+    {
+        PIXEL *rowptr = band + row * pitch;
+
+        for (column = 0; column < width; column++)
+        {
+            int value = rowptr[column];
+
+            if (-TRANSCODER_REQUANT_TABLE_LENGTH < value && value < TRANSCODER_REQUANT_TABLE_LENGTH)
+            {
+                rowptr[column] = table[offset + value];
+            }
+            else
+            {
+                int magnitude = (abs(value) * source_quant + midpoint) / target_quant;
+                rowptr[column] = (PIXEL)((value < 0) ? -magnitude : magnitude);
+            }
+        }
+    }
+}
+
+// Allocate the buffers for decoding and encoding a band of the specified size
+static bool AllocTranscodeBuffers(TRANSCODER *transcoder, size_t band_size, size_t code_size)
+{
+#if _ALLOCATOR
+    ALLOCATOR *allocator = transcoder->allocator;
+#endif
+
+    if (transcoder->band_buffer_size < band_size)
+    {
+        if (transcoder->band_buffer)
+        {
+#if _ALLOCATOR
+            FreeAligned(allocator, transcoder->band_buffer);
+#else
+            MEMORY_ALIGNED_FREE(transcoder->band_buffer);
+#endif
+        }
+
+        // The decoder clears the band with aligned stores
+#if _ALLOCATOR
+        transcoder->band_buffer = (PIXEL *)AllocAligned(allocator, band_size, 16);
+#else
+        transcoder->band_buffer = (PIXEL *)MEMORY_ALIGNED_ALLOC(band_size, 16);
+#endif
+        transcoder->band_buffer_size = (transcoder->band_buffer != NULL) ? band_size : 0;
+        if (transcoder->band_buffer == NULL) return false;
+    }
+
+    if (transcoder->code_buffer_size < code_size)
+    {
+        if (transcoder->code_buffer)
+        {
+#if _ALLOCATOR
+            FreeAligned(allocator, transcoder->code_buffer);
+#else
+            MEMORY_ALIGNED_FREE(transcoder->code_buffer);
+#endif
+        }
+
+#if _ALLOCATOR
+        transcoder->code_buffer = (uint8_t *)AllocAligned(allocator, code_size, 16);
+#else
+        transcoder->code_buffer = (uint8_t *)MEMORY_ALIGNED_ALLOC(code_size, 16);
+#endif
+        transcoder->code_buffer_size = (transcoder->code_buffer != NULL) ? code_size : 0;
+        if (transcoder->code_buffer == NULL) return false;
+    }
+
+    return true;
+}
+
+/*!
+	@brief Requantize the highpass band that starts at the band header
+
+	The band must be enclosed in a subband size chunk so that the band trailer
+	can be found without trusting the decoder to stop at the end of the band.
+	Returns the offset to the band trailer in the input sample.
+*/
+static CODEC_ERROR TranscodeBand(TRANSCODER *transcoder, TRANSCODE_STATE *state, size_t offset, size_t *trailer_offset_out)
+{
+    TRANSCODE_CHUNK *chunk;
+    BITSTREAM stream;
+    size_t data_offset = offset + 4;
+    size_t trailer_offset;
+    size_t encoded_size;
+    size_t band_size;
+    size_t code_size;
+    int width = state->band_width;
+    int height = state->band_height;
+    int codebook = state->band_codebook;
+    int pitch;
+    bool result;
+
+    if (state->chunk_count == 0 || state->chunk[state->chunk_count - 1].tag != CODEC_TAG_SUBBAND_SIZE)
+    {
+        return CODEC_ERROR_UNSUPPORTED_FORMAT;
+    }
+    chunk = &state->chunk[state->chunk_count - 1];
+
+    if (width <= 0 || height <= 0)
+    {
+        return CODEC_ERROR_INVALID_BITSTREAM;
+    }
+
+    // The band trailer is the last tag in the subband chunk
+    if (chunk->input_end < data_offset + 4)
+    {
+        return CODEC_ERROR_BAND_END_MARKER;
+    }
+    trailer_offset = chunk->input_end - 4;
+    if (GetTagAt(state->input + trailer_offset) != CODEC_TAG_BAND_TRAILER)
+    {
+        return CODEC_ERROR_BAND_END_MARKER;
+    }
+
+    // Use the same pitch as the wavelet bands in the encoder
+    pitch = (int)ALIGN16(width * sizeof(PIXEL));
+    band_size = (size_t)pitch * height + TRANSCODER_BAND_SLACK;
+    code_size = (size_t)(pitch / sizeof(PIXEL)) * height * transcoder->max_code_size[codebook] / 8 + TRANSCODER_CODE_SLACK;
+
+    if (!AllocTranscodeBuffers(transcoder, band_size, code_size))
+    {
+        return CODEC_ERROR_MEMORY_ALLOC;
+    }
+
+    // Decode the coefficients without dequantization
+    InitBitstreamBuffer(&stream, (uint8_t *)state->input + data_offset, trailer_offset - data_offset, BITSTREAM_ACCESS_READ);
+#if _DEBUG
+    result = DecodeBandFSM16sNoGap(&transcoder->decoder->fsm[codebook], &stream, transcoder->band_buffer,
+                                   width, height, pitch, NULL);
+#else
+    result = DecodeBandFSM16sNoGap(&transcoder->decoder->fsm[codebook], &stream, transcoder->band_buffer,
+                                   width, height, pitch);
+#endif
+    if (!result || stream.lpCurrentWord > state->input + trailer_offset)
+    {
+        return CODEC_ERROR_DECODING_SUBBAND;
+    }
+
+    RequantizeBand(transcoder->band_buffer, width, height, pitch, state->band_quant, state->band_requant);
+
+    // Encode the requantized coefficients with the same codebook
+    InitBitstreamBuffer(&stream, transcoder->code_buffer, transcoder->code_buffer_size, BITSTREAM_ACCESS_WRITE);
+    EncodeQuantLongRuns(transcoder->encoder, &stream, transcoder->band_buffer, width, height, pitch, 1, codebook);
+    FinishEncodeBand(&stream, transcoder->encoder->band_end_code[codebook], transcoder->encoder->band_end_size[codebook]);
+    PadBitsTag(&stream);
+
+    encoded_size = stream.lpCurrentWord - transcoder->code_buffer;
+    assert(encoded_size <= transcoder->code_buffer_size);
+
+    // Copy the band header followed by the encoded band
+    if (!CopyToOutput(state, state->input + offset, 4) ||
+            !CopyToOutput(state, transcoder->code_buffer, encoded_size))
+    {
+        return TranscodeOverflow();
+    }
+
+    if (state->channel < TRANSCODER_MAX_CHANNELS)
+    {
+        state->channel_delta[state->channel] += (int32_t)encoded_size - (int32_t)(trailer_offset - data_offset);
+    }
+
+    *trailer_offset_out = trailer_offset;
+
+    return CODEC_ERROR_OKAY;
+}
+
+static void ResetBandState(TRANSCODE_STATE *state, int band_type)
+{
+    state->band_type = band_type;
+    state->lowpass_data = false;
+    state->band_width = 0;
+    state->band_height = 0;
+    state->band_subband = 0;
+    state->band_encoding = 0;
+    state->band_codebook = 0;
+    state->band_difference = false;
+    state->band_quant = 0;
+    state->band_requant = 0;
+    state->band_quant_tag = 0;
+    state->band_quant_offset = 0;
+}
+
+#if _ALLOCATOR
+TRANSCODER *CreateTranscoder(ALLOCATOR *allocator)
+#else
+TRANSCODER *CreateTranscoder()
+#endif
+{
+    TRANSCODER *transcoder;
+    DECODER *decoder;
+    ENCODER *encoder;
+    int i, j;
+
+#if _ALLOCATOR
+    transcoder = (TRANSCODER *)Alloc(allocator, sizeof(TRANSCODER));
+#else
+    transcoder = (TRANSCODER *)MEMORY_ALLOC(sizeof(TRANSCODER));
+#endif
+    if (transcoder == NULL) return NULL;
+
+    memset(transcoder, 0, sizeof(TRANSCODER));
+
+#if _ALLOCATOR
+    transcoder->allocator = allocator;
+    decoder = (DECODER *)Alloc(allocator, sizeof(DECODER));
+    encoder = (ENCODER *)Alloc(allocator, sizeof(ENCODER));
+#else
+    decoder = (DECODER *)MEMORY_ALLOC(sizeof(DECODER));
+    encoder = (ENCODER *)MEMORY_ALLOC(sizeof(ENCODER));
+#endif
+    transcoder->decoder = decoder;
+    transcoder->encoder = encoder;
+    if (decoder == NULL || encoder == NULL)
+    {
+        DeleteTranscoder(transcoder);
+        return NULL;
+    }
+
+    // The decoder saves the thread parameters before clearing the data structure
+    memset(decoder, 0, sizeof(DECODER));
+
+#if CODEC_NUM_CODESETS == 3
+    memcpy(&transcoder->codesets[0], &CURRENT_CODESET, sizeof(CODESET));
+    memcpy(&transcoder->codesets[1], &SECOND_CODESET, sizeof(CODESET));
+    memcpy(&transcoder->codesets[2], &THIRD_CODESET, sizeof(CODESET));
+#elif CODEC_NUM_CODESETS == 2
+    memcpy(&transcoder->codesets[0], &CURRENT_CODESET, sizeof(CODESET));
+    memcpy(&transcoder->codesets[1], &SECOND_CODESET, sizeof(CODESET));
+#else
+    memcpy(&transcoder->codesets[0], &CURRENT_CODESET, sizeof(CODESET));
+#endif
+
+    InitDecoder(decoder, NULL, transcoder->codesets);
+
+#if _ALLOCATOR
+    decoder->allocator = allocator;
+    if (!InitCodebooks(allocator, transcoder->codesets))
+#else
+    if (!InitCodebooks(transcoder->codesets))
+#endif
+    {
+        DeleteTranscoder(transcoder);
+        return NULL;
+    }
+
+    // Initialize the finite state machines for decoding the highpass bands
+    if (!InitDecoderFSM(decoder, transcoder->codesets))
+    {
+        DeleteTranscoder(transcoder);
+        return NULL;
+    }
+
+    for (i = 0; i < CODEC_NUM_CODESETS; i++)
+    {
+        InitFSM(&decoder->fsm[i], transcoder->codesets[i].fsm_table);
+#if _COMPANDING
+        ScaleFSM(&decoder->fsm[i].table);
+#endif
+    }
+
+    // The encoder uses the codebooks in the codesets owned by the transcoder
+    InitEncoder(encoder, NULL, transcoder->codesets);
+
+    // Determine the longest code in each codebook for allocating the encoding buffer
+    for (i = 0; i < CODEC_NUM_CODESETS; i++)
+    {
+        RLCBOOK *runsbook = encoder->codebook_runbook[i];
+        VALBOOK *valuebook = encoder->valuebook[i];
+        RLC *rlc = (RLC *)((char *)runsbook + sizeof(RLCBOOK));
+        VLE *table = (VLE *)((char *)valuebook + sizeof(VALBOOK));
+        int max_code_size = 0;
+
+        for (j = 0; j < runsbook->length; j++)
+        {
+            if (max_code_size < rlc[j].size) max_code_size = rlc[j].size;
+        }
+
+        for (j = 0; j < VALUE_TABLE_LENGTH; j++)
+        {
+            int code_size = (int)(table[j].entry >> VLE_CODESIZE_SHIFT);
+            if (max_code_size < code_size) max_code_size = code_size;
+        }
+
+        transcoder->max_code_size[i] = max_code_size;
+    }
+
+    return transcoder;
+}
+
+void DeleteTranscoder(TRANSCODER *transcoder)
+{
+    int i;
+#if _ALLOCATOR
+    ALLOCATOR *allocator;
+#endif
+
+    if (transcoder == NULL) return;
+
+#if _ALLOCATOR
+    allocator = transcoder->allocator;
+#endif
+
+    if (transcoder->decoder)
+    {
+        if (transcoder->decoder->fsm[0].table.num_states > 0)
+        {
+            FreeCodebooks(transcoder->decoder);
+        }
+#if _ALLOCATOR
+        Free(allocator, transcoder->decoder);
+#else
+        MEMORY_FREE(transcoder->decoder);
+#endif
+    }
+
+    if (transcoder->encoder)
+    {
+#if _ALLOCATOR
+        Free(allocator, transcoder->encoder);
+#else
+        MEMORY_FREE(transcoder->encoder);
+#endif
+    }
+
+    for (i = 0; i < CODEC_NUM_CODESETS; i++)
+    {
+#if _ALLOCATOR
+        Free(allocator, transcoder->codesets[i].codebook_runbook);
+        Free(allocator, transcoder->codesets[i].fastbook);
+        Free(allocator, transcoder->codesets[i].valuebook);
+#else
+        MEMORY_FREE(transcoder->codesets[i].codebook_runbook);
+        MEMORY_FREE(transcoder->codesets[i].fastbook);
+        MEMORY_FREE(transcoder->codesets[i].valuebook);
+#endif
+    }
+
+    if (transcoder->band_buffer)
+    {
+#if _ALLOCATOR
+        FreeAligned(allocator, transcoder->band_buffer);
+#else
+        MEMORY_ALIGNED_FREE(transcoder->band_buffer);
+#endif
+    }
+
+    if (transcoder->code_buffer)
+    {
+#if _ALLOCATOR
+        FreeAligned(allocator, transcoder->code_buffer);
+#else
+        MEMORY_ALIGNED_FREE(transcoder->code_buffer);
+#endif
+    }
+
+#if _ALLOCATOR
+    Free(allocator, transcoder);
+#else
+    MEMORY_FREE(transcoder);
+#endif
+}
+
+CODEC_ERROR TranscodeSample(TRANSCODER *transcoder,
+                            const uint8_t *input, size_t input_size,
+                            int quality,
+                            uint8_t *output, size_t output_size,
+                            size_t *actual_size_out)
+{
+    TRANSCODE_STATE state;
+    CODEC_ERROR error = CODEC_ERROR_OKAY;
+    size_t offset = 0;
+
+    if (transcoder == NULL || input == NULL || output == NULL || actual_size_out == NULL)
+    {
+        return CODEC_ERROR_NULLPTR;
+    }
+
+    // The target must be one of the compressed quality levels
+    if ((quality & 0xFF) == 0 || (quality & 0xFF00) != 0)
+    {
+        return CODEC_ERROR_INVALID_ARGUMENT;
+    }
+
+    *actual_size_out = 0;
+
+    if (input_size < 4 || abs(GetTagAt(input)) != CODEC_TAG_SAMPLE)
+    {
+        return CODEC_ERROR_SAMPLE_TYPE;
+    }
+
+    memset(&state, 0, sizeof(state));
+    state.input = input;
+    state.input_size = input_size;
+    state.output = output;
+    state.output_size = output_size;
+    state.precision = CODEC_PRECISION_DEFAULT;
+    state.encoded_format = ENCODED_FORMAT_YUV_422;
+    state.progressive = true;
+    state.num_frames = 1;
+
+    while (offset + 4 <= input_size)
+    {
+        const uint8_t *segment = input + offset;
+        int tag = GetTagAt(segment);
+        int value = GetValueAt(segment);
+        bool optional = (tag < 0);
+        size_t next_offset = offset + 4;
+
+        // Update the sizes of the chunks that end at this tag
+        while (state.chunk_count > 0 && state.chunk[state.chunk_count - 1].input_end <= offset)
+        {
+            error = PopChunk(&state);
+            if (error != CODEC_ERROR_OKAY) return error;
+        }
+
+        if (optional) tag = NEG(tag);
+
+        // The lowpass coefficients must be in a subband chunk so that the end can be found
+        if (state.lowpass_data && (tag & 0xFF00) != CODEC_TAG_SUBBAND_SIZE)
+        {
+            return CODEC_ERROR_UNSUPPORTED_FORMAT;
+        }
+
+        if (tag & 0x4000)
+        {
+            // Copy metadata and other skippable chunks without change
+            size_t chunk_size = value;
+            if (tag & 0x2000) chunk_size += (size_t)(tag & 0xFF) << 16;
+
+            next_offset += 4 * chunk_size;
+            if (next_offset > input_size)
+            {
+                return CODEC_ERROR_INVALID_BITSTREAM;
+            }
+
+            if (!CopyToOutput(&state, segment, next_offset - offset))
+            {
+                return TranscodeOverflow();
+            }
+
+            offset = next_offset;
+            continue;
+        }
+
+        if (tag & 0x2000)
+        {
+            int chunk_tag = (tag & 0xFF00);
+            size_t chunk_end = offset + 4 + 4 * (value + ((size_t)(tag & 0xFF) << 16));
+
+            if (chunk_end > input_size ||
+                    (state.chunk_count > 0 && chunk_end > state.chunk[state.chunk_count - 1].input_end))
+            {
+                return CODEC_ERROR_INVALID_BITSTREAM;
+            }
+
+            if (chunk_tag == CODEC_TAG_UNCOMPRESS)
+            {
+                return CODEC_ERROR_UNSUPPORTED_FORMAT;
+            }
+
+            if (chunk_tag == CODEC_TAG_SUBBAND_SIZE &&
+                    (state.lowpass_data || state.band_requant == state.band_quant))
+            {
+                // Copy the lowpass band or a highpass band that is not requantized
+                if (!CopyToOutput(&state, segment, chunk_end - offset))
+                {
+                    return TranscodeOverflow();
+                }
+
+                if (state.lowpass_data)
+                {
+                    ResetBandState(&state, TRANSCODE_BAND_NONE);
+                }
+
+                offset = chunk_end;
+                continue;
+            }
+
+            if (chunk_tag == CODEC_TAG_SUBBAND_SIZE ||
+                    chunk_tag == CODEC_TAG_LEVEL_SIZE ||
+                    chunk_tag == CODEC_TAG_SAMPLE_SIZE)
+            {
+                // Remember the chunk so that the size can be updated after the chunk is copied
+                TRANSCODE_CHUNK *chunk;
+
+                if (state.chunk_count == TRANSCODER_MAX_CHUNKS)
+                {
+                    return CODEC_ERROR_INVALID_BITSTREAM;
+                }
+
+                chunk = &state.chunk[state.chunk_count++];
+                chunk->input_end = chunk_end;
+                chunk->output_offset = state.output_offset;
+                chunk->tag = chunk_tag;
+                chunk->optional = optional;
+
+                if (!CopyToOutput(&state, segment, 4))
+                {
+                    return TranscodeOverflow();
+                }
+
+                offset = next_offset;
+                continue;
+            }
+
+            // Copy other chunks without change
+            if (!CopyToOutput(&state, segment, chunk_end - offset))
+            {
+                return TranscodeOverflow();
+            }
+
+            offset = chunk_end;
+            continue;
+        }
+
+        switch (tag)
+        {
+            case CODEC_TAG_INDEX:
+                // Update the channel sizes in the previous sample
+                error = UpdateChannelIndex(&state);
+                if (error != CODEC_ERROR_OKAY) return error;
+
+                if (value > TRANSCODER_MAX_CHANNELS)
+                {
+                    return CODEC_ERROR_NUM_CHANNELS;
+                }
+
+                next_offset += 4 * (size_t)value;
+                if (next_offset > input_size)
+                {
+                    return CODEC_ERROR_SAMPLE_INDEX;
+                }
+
+                state.index_input_offset = offset + 4;
+                state.index_output_offset = state.output_offset + 4;
+                state.index_count = value;
+                state.channel = 0;
+
+                if (!CopyToOutput(&state, segment, next_offset - offset))
+                {
+                    return TranscodeOverflow();
+                }
+
+                offset = next_offset;
+                continue;
+
+            case CODEC_TAG_QUALITY_L:
+                state.source_quality = (state.source_quality & ~0xFFFF) | value;
+                state.quant_tables_valid = false;
+                break;
+
+            case CODEC_TAG_QUALITY_H:
+                state.source_quality = (state.source_quality & 0xFFFF) | (value << 16);
+                state.quant_tables_valid = false;
+                break;
+
+            case CODEC_TAG_PRECISION:
+                state.precision = value;
+                state.quant_tables_valid = false;
+                break;
+
+            case CODEC_TAG_ENCODED_FORMAT:
+                state.encoded_format = value;
+                state.quant_tables_valid = false;
+                break;
+
+            case CODEC_TAG_SAMPLE_FLAGS:
+                state.progressive = ((value & SAMPLE_FLAGS_PROGRESSIVE) != 0);
+                state.quant_tables_valid = false;
+                break;
+
+            case CODEC_TAG_NUM_FRAMES:
+                state.num_frames = value;
+                state.quant_tables_valid = false;
+                break;
+
+            case CODEC_TAG_CHANNEL:
+                state.channel = value;
+                break;
+
+            case CODEC_TAG_LOWPASS_SUBBAND:
+                ResetBandState(&state, TRANSCODE_BAND_LOWPASS);
+                break;
+
+            case CODEC_TAG_PIXEL_DEPTH:
+                // The lowpass coefficients follow the pixel depth
+                if (state.band_type == TRANSCODE_BAND_LOWPASS)
+                {
+                    state.lowpass_data = true;
+                }
+                break;
+
+            case CODEC_TAG_BAND_NUMBER:
+                ResetBandState(&state, TRANSCODE_BAND_HIGHPASS);
+                break;
+
+            case CODEC_TAG_BAND_CODING_FLAGS:
+                state.band_codebook = value & 0x0F;
+                state.band_difference = ((value >> 4) & 1) != 0;
+                break;
+
+            case CODEC_TAG_BAND_WIDTH:
+                state.band_width = value;
+                break;
+
+            case CODEC_TAG_BAND_HEIGHT:
+                state.band_height = value;
+                break;
+
+            case CODEC_TAG_BAND_SUBBAND:
+                state.band_subband = value;
+                break;
+
+            case CODEC_TAG_BAND_ENCODING:
+                state.band_encoding = value;
+                break;
+
+            case CODEC_TAG_BAND_QUANTIZATION:
+                state.band_quant = value;
+                state.band_requant = value;
+                if (state.band_type == TRANSCODE_BAND_HIGHPASS)
+                {
+                    // The target quality must have the same flags as the source quality
+                    if ((state.source_quality & 0xFF) == 0 || (state.source_quality & 0xFF00) != 0)
+                    {
+                        return CODEC_ERROR_UNSUPPORTED_FORMAT;
+                    }
+                    state.target_quality = (state.source_quality & ~0xFF) | (quality & 0xFF);
+
+                    state.band_requant = TargetBandQuantization(&state);
+                    state.band_quant_tag = optional ? NEG(tag) : tag;
+                    state.band_quant_offset = state.output_offset;
+
+                    if (!PutTagValueOutput(&state, state.band_quant_tag, state.band_requant))
+                    {
+                        return TranscodeOverflow();
+                    }
+
+                    offset = next_offset;
+                    continue;
+                }
+                break;
+
+            case CODEC_TAG_PEAK_LEVEL:
+            case CODEC_TAG_PEAK_TABLE_OFFSET_L:
+            case CODEC_TAG_PEAK_TABLE_OFFSET_H:
+                // Bands with peak tables are copied without change
+                if (state.band_requant != state.band_quant)
+                {
+                    SetTagValueAt(output + state.band_quant_offset, state.band_quant_tag, state.band_quant);
+                    state.band_requant = state.band_quant;
+                }
+                break;
+
+            case CODEC_TAG_BAND_HEADER:
+                if (state.band_type == TRANSCODE_BAND_HIGHPASS && state.band_requant != state.band_quant)
+                {
+                    size_t trailer_offset = 0;
+
+                    error = TranscodeBand(transcoder, &state, offset, &trailer_offset);
+                    if (error != CODEC_ERROR_OKAY) return error;
+
+                    // Continue with the band trailer
+                    offset = trailer_offset;
+                    continue;
+                }
+                else if (state.band_type == TRANSCODE_BAND_HIGHPASS)
+                {
+                    // The end of the band cannot be found without decoding the band
+                    return CODEC_ERROR_UNSUPPORTED_FORMAT;
+                }
+                break;
+
+            case CODEC_TAG_BAND_TRAILER:
+                ResetBandState(&state, TRANSCODE_BAND_NONE);
+                break;
+
+            default:
+                break;
+        }
+
+        // Copy the tag value pair
+        if (tag == CODEC_TAG_QUALITY_L)
+        {
+            if (!PutTagValueOutput(&state, optional ? NEG(tag) : tag, (value & ~0xFF) | (quality & 0xFF)))
+            {
+                return TranscodeOverflow();
+            }
+        }
+        else if (!CopyToOutput(&state, segment, 4))
+        {
+            return TranscodeOverflow();
+        }
+
+        offset = next_offset;
+    }
+
+    // Update the chunks that extend to the end of the sample
+    while (state.chunk_count > 0)
+    {
+        error = PopChunk(&state);
+        if (error != CODEC_ERROR_OKAY) return error;
+    }
+
+    error = UpdateChannelIndex(&state);
+    if (error != CODEC_ERROR_OKAY) return error;
+
+    // Copy any bytes after the last tag
+    if (offset < input_size && !CopyToOutput(&state, input + offset, input_size - offset))
+    {
+        return TranscodeOverflow();
+    }
+
+    *actual_size_out = state.output_offset;
+
+    return CODEC_ERROR_OKAY;
+}
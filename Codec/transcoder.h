@@ -0,0 +1,80 @@
+/*! @file transcoder.h
+
+*  @brief Requantize the highpass bands of an encoded sample to a lower quality
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#ifndef _TRANSCODER_H
+#define _TRANSCODER_H
+
+#include "config.h"
+#include "allocator.h"
+#include "codec.h"
+#include "codebooks.h"
+#include "error.h"
+
+// Forward references to the decoder and encoder data structures
+struct decoder;
+struct encoder;
+
+typedef struct transcoder
+{
+#if _ALLOCATOR
+    ALLOCATOR *allocator;
+#endif
+
+    struct decoder *decoder;		// Finite state machines for decoding the highpass bands
+    struct encoder *encoder;		// Codebooks for encoding the requantized bands
+
+    CODESET codesets[CODEC_NUM_CODESETS];
+
+    // Maximum number of bits used to encode one coefficient with each codebook
+    int max_code_size[CODEC_NUM_CODESETS];
+
+    // Coefficients of the highpass band that is being requantized
+    PIXEL *band_buffer;
+    size_t band_buffer_size;
+
+    // Entropy coded coefficients of the requantized band
+    uint8_t *code_buffer;
+    size_t code_buffer_size;
+
+} TRANSCODER;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if _ALLOCATOR
+TRANSCODER *CreateTranscoder(ALLOCATOR *allocator);
+#else
+TRANSCODER *CreateTranscoder();
+#endif
+
+void DeleteTranscoder(TRANSCODER *transcoder);
+
+// Requantize an encoded sample to the specified encoding quality without decoding the frame
+CODEC_ERROR TranscodeSample(TRANSCODER *transcoder,
+                            const uint8_t *input, size_t input_size,
+                            int quality,
+                            uint8_t *output, size_t output_size,
+                            size_t *actual_size_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -537,7 +537,7 @@ typedef struct tagCFHDDATA_NEW
     //              6 - CF Advanced Detail 3
 
 
-    uint32_t demosaic_type;	// 0= unused, 1-bilinear, 2-5x5 Enh, 3-Advanced Smooth, 4-6-Advanced Detail 1-3
+    uint32_t demosaic_type;	// 0= unused, 1-bilinear, 2-5x5 Enh, 3-Advanced Smooth, 4-6-Advanced Detail 1-3, 7-9 Bilinear Smooth/Detail 1-2, 10-Edge directed
     uint32_t MSChannel_type_value; //0
     // Channel = 0,1 = normal, 2 = channel 2 of 3D/multicam, 3 = 1+2 channel mix, etc.
     // Type = 0<<8 - none,
@@ -0,0 +1,126 @@
+/*!
+ * @file CFHDArena.h
+ * @brief Pooled allocator provided by the CineForm SDKs
+ *
+ * The arena allocator implements the CFHD_ALLOCATOR interface and can be
+ * passed to CFHD_OpenDecoder, CFHD_OpenEncoder, the decoder and encoder
+ * pools, and CFHD_OpenSampleIndex.  Blocks are rounded up to a size class
+ * and recycled through free lists instead of being returned to the system,
+ * so repeated allocations of wavelets, frame buffers, and scratch buffers
+ * are served from memory that has already been obtained.
+ *
+ * (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+ *
+ * Licensed under either:
+ * - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+ * - MIT license, http://opensource.org/licenses/MIT
+ * at your option.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CFHD_ARENA_H
+#define CFHD_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "CFHDError.h"
+#include "CFHDAllocator.h"
+
+#ifdef _WIN32
+#ifndef DYNAMICLIB
+#define CFHDARENA_API
+#else
+#ifdef ARENADLL_EXPORTS
+// Export the entry points for the arena allocator
+#define CFHDARENA_API __declspec(dllexport)
+#else
+// Declare the entry points to the arena allocator
+#define CFHDARENA_API __declspec(dllimport)
+#endif
+#endif
+#else
+#ifdef ARENADLL_EXPORTS
+#define CFHDARENA_API __attribute__((visibility("default")))
+#else
+#define CFHDARENA_API
+#endif
+#endif
+
+//! Flags that control the behavior of the arena allocator
+typedef enum CFHD_ArenaFlags
+{
+    CFHD_ARENA_FLAGS_NONE				= 0,
+
+    // Do not keep a cache of small blocks for each thread (all blocks use the shared free lists)
+    CFHD_ARENA_FLAGS_NO_THREAD_CACHE	= 1 << 0,
+
+    // Request transparent huge pages for blocks of 2 MB or more (Linux only, ignored elsewhere)
+    CFHD_ARENA_FLAGS_HUGE_PAGES			= 1 << 1,
+
+} CFHD_ArenaFlags;
+
+//! Allocation statistics returned by CFHD_GetArenaAllocatorStats
+typedef struct CFHD_ArenaStats
+{
+    uint64_t bytesInUse;			//!< Usable bytes in blocks that have not been freed
+    uint64_t peakBytesInUse;		//!< Largest value of bytesInUse since the allocator was created
+    uint64_t bytesReserved;			//!< Bytes obtained from the system, including free blocks
+    uint64_t allocCount;			//!< Number of allocations
+    uint64_t freeCount;				//!< Number of blocks that have been freed
+    uint64_t reuseCount;			//!< Allocations served by a block from a free list
+    uint64_t systemAllocCount;		//!< Allocations that obtained memory from the system
+    uint64_t systemFreeCount;		//!< Blocks that have been returned to the system
+
+} CFHD_ArenaStats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * \brief Create an arena allocator.
+ * \param flags: Combination of CFHD_ArenaFlags.
+ * \param allocatorOut: Returns the allocator interface.
+ * \return Returns a CFHD error code.
+ *
+ * Every block is aligned to a 64 byte cache line.  The allocator can be
+ * shared by several decoders and encoders running on different threads and
+ * must not be released until every decoder, encoder, pool, and sample index
+ * that uses it has been closed.
+ */
+CFHDARENA_API CFHD_Error
+CFHD_CreateArenaAllocator(uint32_t flags,
+                          CFHD_ALLOCATOR **allocatorOut);
+
+//! Return the allocation statistics for an arena allocator
+CFHDARENA_API CFHD_Error
+CFHD_GetArenaAllocatorStats(CFHD_ALLOCATOR *allocator,
+                            CFHD_ArenaStats *statsOut);
+
+/*!
+ * \brief Return the free blocks held by an arena allocator to the system.
+ * \param allocator: An allocator created by CFHD_CreateArenaAllocator.
+ * \return Returns a CFHD error code.
+ *
+ * Call after closing a decoder or changing to a smaller format to release
+ * the memory that is no longer needed.  Blocks cached by other threads are
+ * kept until those threads exit or the allocator is released.
+ */
+CFHDARENA_API CFHD_Error
+CFHD_TrimArenaAllocator(CFHD_ALLOCATOR *allocator);
+
+//! Release an arena allocator and the memory that it holds
+CFHDARENA_API CFHD_Error
+CFHD_ReleaseArenaAllocator(CFHD_ALLOCATOR *allocator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CFHD_ARENA_H
@@ -51,6 +51,22 @@
 //! Opaque datatype for the CineForm HD decoder
 typedef void *CFHD_DecoderRef;
 
+//! Opaque datatype for a pool of asynchronous decoders
+typedef void *CFHD_DecoderPoolRef;
+
+//! Opaque datatype for the index of the samples in a raw CineForm stream
+typedef void *CFHD_SampleIndexRef;
+
+//! Description of one frame in a raw CineForm stream
+typedef struct CFHD_SampleIndexEntry
+{
+    uint64_t offset;		//!< Offset to the sample from the start of the stream (in bytes)
+    uint32_t size;			//!< Size of the sample (in bytes)
+    uint32_t frameNumber;	//!< Frame number recorded in the sample (zero if not recorded)
+    uint8_t keyFrame;		//!< Nonzero if the sample can be decoded without the previous sample
+    uint8_t channels;		//!< Number of encoded video channels (two for stereo samples)
+} CFHD_SampleIndexEntry;
+
 // Interface to the codec library for use with either C or C++
 #ifdef __cplusplus
 extern "C" {
@@ -302,6 +318,126 @@ CFHD_DecodeSample(CFHD_DecoderRef decoderRef,
                   void *outputBuffer,
                   int32_t outputPitch);
 
+/*!
+ * \brief Decode an array of samples in one call.
+ * \param decoderRef: A reference to a decoder that was initialized by a call to CFHD_PrepareToDecode.
+ * \param sampleCount: Number of samples in the arrays.
+ * \param samplePtrs: Array of pointers to the encoded samples.
+ * \param sampleSizes: Array of the sizes of the encoded samples.
+ * \param outputBuffers: Array of buffers that receive the decoded frames (see @ref CFHD_DecodeSample).
+ * \param outputPitches: Array of the pitches of the output buffers in bytes.
+ * \param errors: Array that receives the error code for each sample.
+ * \return Returns the first error code in the array of errors, or CFHD_ERROR_OKAY if
+ *  every sample was decoded.
+ *
+ * Every sample must have the dimensions and format of the sample passed to
+ * CFHD_PrepareToDecode.  Batches of small frames are decoded in parallel with
+ * each sample decoded on its own thread, which is faster than decoding the samples
+ * one at a time when the frames have too few rows to keep all of the processors
+ * busy.  Larger frames, or batches decoded with a region of interest or a decoded
+ * rows callback, are decoded one after another as if by CFHD_DecodeSample.
+ * A sample that cannot be decoded does not stop the other samples in the batch.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_DecodeSamples(CFHD_DecoderRef decoderRef,
+                   uint32_t sampleCount,
+                   void **samplePtrs,
+                   const size_t *sampleSizes,
+                   void **outputBuffers,
+                   const int32_t *outputPitches,
+                   CFHD_Error *errors);
+
+/*!
+ * \brief Begin decoding a sample before it is passed to CFHD_DecodeSample.
+ * \param decoderRef: A decoder prepared with the CFHD_DECODING_FLAGS_PIPELINED flag.
+ * \param samplePtr: Pointer to the next sample that will be passed to CFHD_DecodeSample.
+ * \param sampleSize: Size of the encoded sample.
+ * \param outputBuffer: Buffer that will be passed to CFHD_DecodeSample with the sample.
+ * \param outputPitch: Pitch that will be passed to CFHD_DecodeSample with the sample.
+ * \return Returns a CFHD error code.
+ *
+ * The decoder starts decoding the prefetched sample into the output buffer while
+ * the caller decodes the current sample, so entropy decoding of the next frame
+ * overlaps the reconstruction of the current frame.  For sequential playback,
+ * prefetch sample N+1 before calling CFHD_DecodeSample for sample N.  The call to
+ * CFHD_DecodeSample with the same arguments waits for the prefetched sample.
+ * The sample and the buffer must remain valid until that call returns.
+ * Active metadata set on the decoder is not applied to prefetched samples.
+ * Returns CFHD_ERROR_NOT_FINISHED if too many samples have been prefetched.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_PrefetchSample(CFHD_DecoderRef decoderRef,
+                    void *samplePtr,
+                    size_t sampleSize,
+                    void *outputBuffer,
+                    int32_t outputPitch);
+
+/*!
+ * \brief Decode only a rectangle of the frame.
+ * \param decoderRef: A reference to a decoder that was initialized by a call to CFHD_PrepareToDecode.
+ * \param left: Column of the first pixel in the region (must be even).
+ * \param top: Row of the first pixel in the region (must be even).
+ * \param width: Width of the region (must be even), or zero to decode the entire frame.
+ * \param height: Height of the region (must be even), or zero to decode the entire frame.
+ * \return Returns a CFHD error code.
+ *
+ * The region applies to the frame dimensions returned by CFHD_PrepareToDecode
+ * and is cleared by the next call to CFHD_PrepareToDecode.  The output buffer
+ * passed to CFHD_DecodeSample receives only the region, so the buffer can be
+ * allocated for the width and height of the region.  Where the decoder supports
+ * it, the last wavelet level and the color conversion are computed only for the
+ * rows and columns in the region; otherwise the region is copied from the full frame.
+ * Scaled output and planar pixel formats are not supported.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_SetRegionOfInterest(CFHD_DecoderRef decoderRef,
+                         int left,
+                         int top,
+                         int width,
+                         int height);
+
+/*!
+ * \brief Receive the rows of each decoded frame before the entire frame is decoded.
+ * \param decoderRef: A reference to a decoder that was initialized by a call to CFHD_PrepareToDecode.
+ * \param callback: Function that is called with each band of rows, or NULL to stop reporting rows.
+ * \param param: Argument that is passed to the callback.
+ * \param bandRows: Minimum number of rows in each band except the last band (zero for one row).
+ * \return Returns a CFHD error code.
+ *
+ * During each call to CFHD_DecodeSample, the callback receives contiguous bands of
+ * rows in the output buffer in order from the first row to the last row.  The row
+ * pointer is the address of the first row in the band.  When the final stage of
+ * decoding writes directly into the output buffer, the bands are reported by the
+ * worker threads as soon as the rows are written, so the callback must return
+ * quickly and must not call the decoder.  Otherwise the entire frame is reported
+ * as one band before CFHD_DecodeSample returns.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_SetDecodedRowsCallback(CFHD_DecoderRef decoderRef,
+                            CFHD_DecodedRowsCallback callback,
+                            void *param,
+                            int bandRows);
+
+/*!
+ * \brief Keep the decoded frames from recently used groups of frames.
+ * \param decoderRef: A reference to a decoder created by a call to @ref CFHD_OpenDecoder.
+ * \param groupCount: Number of groups of frames that are cached (zero to disable the cache).
+ * \return Returns a CFHD error code.
+ *
+ * Video encoded with a group of two frames is decoded from one sample for both
+ * frames followed by a small sample for the second frame.  Random access and
+ * reverse playback decode the same group again for each frame.  With the cache
+ * enabled, both output frames are saved when a group is decoded, and a group
+ * sample that matches a cached group (same size and content hash) is copied
+ * from the cache without decoding.  The second frame is also copied from the
+ * cache after the group sample.  Groups are replaced in least recently used
+ * order.  The cache is discarded when the decoder is prepared again, the region
+ * of interest is changed, or the active metadata is changed.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_SetFrameCacheCapacity(CFHD_DecoderRef decoderRef,
+                           int groupCount);
+
 /*!
  * \brief Set the metadata rules for the decoder.
  * \param decoderRef: An opaque reference to a decoder created by a call to @ref CFHD_OpenDecoder.
@@ -353,11 +489,245 @@ CFHD_GetThumbnail(CFHD_DecoderRef decoderRef,
                   size_t *retHeight,
                   size_t *retSize);
 
+/*!
+ * \brief Generate the thumbnails for an array of samples in one call.
+ * \param decoderRef: An opaque reference to a decoder created by a call to @ref CFHD_OpenDecoder.
+ * \param sampleCount: Number of samples in the arrays.
+ * \param samplePtrs: Array of pointers to the encoded samples.
+ * \param sampleSizes: Array of the sizes of the encoded samples.
+ * \param outputBuffers: Array of buffers that receive the thumbnails (see @ref CFHD_GetThumbnail).
+ * \param outputBufferSizes: Array of the sizes of the output buffers in bytes.
+ * \param flags: future usage.
+ * \param errors: Array that receives the error code for each sample.
+ * \return Returns the first error code in the array of errors, or CFHD_ERROR_OKAY if
+ *  every thumbnail was generated.
+ *
+ * The samples are divided among worker threads that keep their decoder state between
+ * samples, so a batch is faster than calling CFHD_GetThumbnail for each sample.  The
+ * thumbnail for the second frame in a group of frames cannot be generated.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_GetThumbnails(CFHD_DecoderRef decoderRef,
+                   uint32_t sampleCount,
+                   void **samplePtrs,
+                   const size_t *sampleSizes,
+                   void **outputBuffers,
+                   const size_t *outputBufferSizes,
+                   uint32_t flags,
+                   CFHD_Error *errors);
+
 //! Clear the metadata rules for the decoder
 CFHDDECODER_API CFHD_Error
 CFHD_ClearActiveMetadata(CFHD_DecoderRef decoderRef,
                          CFHD_MetadataRef metadataRef);
 
+/*!
+ * \brief Add a 3D look table to the look cache shared by all decoders in the process.
+ * \param lookCRC: The CRC of the look file, as stored in the TAG_LOOK_CRC metadata.
+ * \param lutData: lutSize^3 RGB triplets of floats, blue varying fastest.
+ * \param lutSize: Number of entries along each axis of the cube (8 to 65).
+ * \return Returns a CFHD error code.
+ *
+ * Decoders that encounter a sample with a matching look CRC use the preloaded
+ * table instead of loading the look themselves.  The data is copied, so the
+ * caller may free the buffer after this call returns.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_PreloadLook(uint32_t lookCRC,
+                 const float *lutData,
+                 int lutSize);
+
+/*!
+ * \brief Set the number of look tables that are retained in the shared look cache.
+ * \param capacity: Maximum number of cached look tables, zero to keep only the looks in use.
+ * \return Returns a CFHD error code.
+ *
+ * Look tables that are in use by a decoder are never evicted.  Other look tables
+ * are released in least recently used order when the capacity is exceeded.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_SetLookCacheCapacity(int capacity);
+
+//! Release all look tables in the shared look cache that are not in use by a decoder
+CFHDDECODER_API CFHD_Error
+CFHD_FlushLookCache(void);
+
+/*!
+ * \brief Create a pool of decoders for decoding samples asynchronously.
+ * \param decoderPoolRefOut: An opaque reference to the decoder pool returned by this function.
+ * \param decoderThreadCount: Number of decoders in the pool, or zero for one decoder per processor.
+ * \param jobQueueLength: Maximum number of samples in the pool that have not been returned, or zero for the default.
+ * \param allocator: Optional CFHD_ALLOCATOR structure used by all of the decoders in the pool.
+ * \return Returns a CFHD error code.
+ *
+ * Each decoder in the pool has its own worker thread.  The processors are divided
+ * between the decoders, so each decoder uses fewer threads within a frame than a
+ * decoder created by @ref CFHD_OpenDecoder.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_CreateDecoderPool(CFHD_DecoderPoolRef *decoderPoolRefOut,
+                       int decoderThreadCount,
+                       int jobQueueLength,
+                       CFHD_ALLOCATOR *allocator);
+
+//! Return a list of output formats in decreasing order of preference (see @ref CFHD_GetOutputFormats)
+CFHDDECODER_API CFHD_Error
+CFHD_GetAsyncOutputFormats(CFHD_DecoderPoolRef decoderPoolRef,
+                           void *samplePtr,
+                           size_t sampleSize,
+                           CFHD_PixelFormat *outputFormatArray,
+                           int outputFormatArrayLength,
+                           int *actualOutputFormatCountOut);
+
+/*!
+ * \brief Prepare all of the decoders in the pool for decoding.
+ *
+ * The arguments are the same as @ref CFHD_PrepareToDecode.  The pool must be
+ * prepared before it is started and cannot be prepared again while it is running.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_PrepareDecoderPool(CFHD_DecoderPoolRef decoderPoolRef,
+                        int outputWidth,
+                        int outputHeight,
+                        CFHD_PixelFormat outputFormat,
+                        CFHD_DecodedResolution decodedResolution,
+                        CFHD_DecodingFlags decodingFlags,
+                        void *samplePtr,
+                        size_t sampleSize,
+                        int *actualWidthOut,
+                        int *actualHeightOut,
+                        CFHD_PixelFormat *actualFormatOut);
+
+//! Start the worker threads for the decoders in the pool
+CFHDDECODER_API CFHD_Error
+CFHD_StartDecoderPool(CFHD_DecoderPoolRef decoderPoolRef);
+
+//! Stop the worker threads after decoding all of the samples that have been submitted
+CFHDDECODER_API CFHD_Error
+CFHD_StopDecoderPool(CFHD_DecoderPoolRef decoderPoolRef);
+
+/*!
+ * \brief Submit a sample for asynchronous decoding.
+ * \param decoderPoolRef: A reference to a decoder pool that has been started.
+ * \param frameNumber: Number returned with the decoded frame to identify the sample.
+ * \param samplePtr: Pointer to a sample containing one frame of encoded video.
+ * \param sampleSize: Size of the encoded sample.
+ * \param outputBuffer: Buffer that will receive the decoded frame (see @ref CFHD_DecodeSample).
+ * \param outputPitch: Pitch of the output buffer in bytes.
+ * \return Returns a CFHD error code.
+ *
+ * The sample and the output buffer must remain valid until the decoded frame is
+ * returned by @ref CFHD_WaitForDecodedFrame or @ref CFHD_TestForDecodedFrame.
+ * This call blocks if the job queue is full until a decoded frame is returned.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_DecodeAsyncSample(CFHD_DecoderPoolRef decoderPoolRef,
+                       uint32_t frameNumber,
+                       void *samplePtr,
+                       size_t sampleSize,
+                       void *outputBuffer,
+                       int32_t outputPitch);
+
+/*!
+ * \brief Wait until the next decoded frame is ready.
+ * \param decoderPoolRef: A reference to a decoder pool.
+ * \param frameNumberOut: Returns the frame number passed with the sample.
+ * \param outputBufferOut: Returns the output buffer passed with the sample.
+ * \return Returns the error code from decoding the sample.
+ *
+ * Frames are returned in the order in which the samples were submitted.  The
+ * frame number and output buffer are returned even if decoding failed.
+ * Returns CFHD_ERROR_UNEXPECTED if there are no samples in the pool.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_WaitForDecodedFrame(CFHD_DecoderPoolRef decoderPoolRef,
+                         uint32_t *frameNumberOut,
+                         void **outputBufferOut);
+
+//! Return the next decoded frame if it is ready, otherwise return CFHD_ERROR_NOT_FINISHED
+CFHDDECODER_API CFHD_Error
+CFHD_TestForDecodedFrame(CFHD_DecoderPoolRef decoderPoolRef,
+                         uint32_t *frameNumberOut,
+                         void **outputBufferOut);
+
+//! Stop the decoders and release the decoder pool
+CFHDDECODER_API CFHD_Error
+CFHD_ReleaseDecoderPool(CFHD_DecoderPoolRef decoderPoolRef);
+
+/*!
+ * \brief Open a raw stream of concatenated CineForm samples for random access.
+ * \param streamPath: Pathname of the file that contains the stream.
+ * \param indexPath: Optional pathname of the sidecar file for the index (may be NULL).
+ * \param allocator: Optional CFHD_ALLOCATOR structure for the memory used by the index.
+ * \param indexRefOut: An opaque reference to the sample index returned by this function.
+ * \return Returns a CFHD error code.
+ *
+ * The stream is mapped into memory and the index is built by walking the
+ * sample headers, so only the pages that contain the headers are read.
+ * If the sidecar file exists and was written for a stream of the same size,
+ * the index is read from the sidecar file instead; otherwise the index is
+ * written to the sidecar file after it is built.  The stream remains mapped
+ * until the index is closed.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_OpenSampleIndex(const char *streamPath,
+                     const char *indexPath,
+                     CFHD_ALLOCATOR *allocator,
+                     CFHD_SampleIndexRef *indexRefOut);
+
+//! Return the number of frames in the stream
+CFHDDECODER_API CFHD_Error
+CFHD_GetSampleIndexCount(CFHD_SampleIndexRef indexRef,
+                         uint32_t *frameCountOut);
+
+/*!
+ * \brief Return the sample for one frame in the stream.
+ * \param indexRef: A reference to a sample index opened by CFHD_OpenSampleIndex.
+ * \param frame: Index of the frame in stream order.
+ * \param samplePtrOut: Returns the address of the sample in the mapped stream (may be NULL).
+ * \param sampleSizeOut: Returns the size of the sample in bytes (may be NULL).
+ * \param entryOut: Returns the index entry for the frame (may be NULL).
+ * \return Returns a CFHD error code.
+ *
+ * The sample can be passed directly to CFHD_DecodeSample and remains valid
+ * until the index is closed.  The second frame in a group of frames is
+ * decoded from the sample for the group, so decode the sample returned by
+ * CFHD_SeekSampleIndex first when seeking to a frame that is not a key frame.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_GetIndexedSample(CFHD_SampleIndexRef indexRef,
+                      uint32_t frame,
+                      void **samplePtrOut,
+                      size_t *sampleSizeOut,
+                      CFHD_SampleIndexEntry *entryOut);
+
+//! Return the key frame that must be decoded to decode the specified frame
+CFHDDECODER_API CFHD_Error
+CFHD_SeekSampleIndex(CFHD_SampleIndexRef indexRef,
+                     uint32_t frame,
+                     uint32_t *keyFrameOut);
+
+//! Release the index and unmap the stream
+CFHDDECODER_API CFHD_Error
+CFHD_CloseSampleIndex(CFHD_SampleIndexRef indexRef);
+
+/*!
+ * \brief Compute a checksum of an encoded sample for integrity checks.
+ * \param samplePtr: Pointer to a sample containing one frame of encoded video.
+ * \param sampleSize: Size of the encoded sample.
+ * \param checksumOut: Returns the CRC-32C of the sample.
+ * \return Returns a CFHD error code.
+ *
+ * The checksum does not require a decoder, so it can be computed when samples
+ * are written and again when they are read to detect corrupted samples.  The
+ * CRC-32C instruction is used on processors that support SSE4.2, which is fast
+ * enough to check every sample in real time.
+ */
+CFHDDECODER_API CFHD_Error
+CFHD_GetSampleChecksum(void *samplePtr,
+                       size_t sampleSize,
+                       uint32_t *checksumOut);
+
 /*!
  * \brief Close an instance of the CineForm HD decoder and release all resources.
  * \param decoderRef: A reference to a decoder that was initialized by a call to CFHD_PrepareToDecode.
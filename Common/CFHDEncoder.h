@@ -186,6 +186,96 @@ CFHD_GetEncodeThumbnail(CFHD_EncoderRef encoderRef,
                         size_t *retHeight,
                         size_t *retSize);
 
+/*!
+ * \brief Transcode an encoded sample to a lower encoding quality.
+ * \param encoderRef: Reference to an encoder created by a call to @ref CFHD_OpenEncoder.
+ * \param samplePtr: Pointer to a sample containing one frame of encoded video in the CineForm HD format.
+ * \param sampleSize: Size of the encoded sample.
+ * \param encodingQuality: Quality level of the transcoded sample (low through film scan 3).
+ * \param outputBuffer: Buffer that will receive the transcoded sample.
+ * \param outputBufferSize: Size of the output buffer (the size of the input sample is always enough).
+ * \param retSize: If successful contains the size of the transcoded sample in bytes.
+ * \return Returns a CFHD error code.
+ *
+ * The highpass bands are requantized in the wavelet domain without decoding the frame,
+ * which is much faster than decoding the sample and encoding the frame again.  The
+ * encoder does not have to be prepared for encoding.  Bands that are already quantized
+ * more coarsely than the target quality, and bands with peak tables, are copied unchanged.
+ */
+CFHDENCODER_API CFHD_Error
+CFHD_TranscodeSample(CFHD_EncoderRef encoderRef,
+                     void *samplePtr,
+                     size_t sampleSize,
+                     CFHD_EncodingQuality encodingQuality,
+                     void *outputBuffer,
+                     size_t outputBufferSize,
+                     size_t *retSize);
+
+/*!
+ * \brief Encode a half resolution proxy of an encoded sample.
+ * \param encoderRef: Reference to an encoder created by a call to @ref CFHD_OpenEncoder.
+ * \param samplePtr: Pointer to a sample containing one frame of encoded video in the CineForm HD format.
+ * \param sampleSize: Size of the encoded sample.
+ * \return Returns a CFHD error code.
+ *
+ * The encoder must be prepared by a call to @ref CFHD_PrepareToEncode with half the
+ * width and height of the encoded sample.  The sample is decoded at half resolution
+ * into the input pixel format of the encoder, which skips entropy decoding of the
+ * finest wavelet level and its inverse transform, and the result is encoded as a new
+ * sample.  Call @ref CFHD_GetSampleData to obtain the encoded proxy.  Bayer input
+ * formats are not supported since the decoder does not output half resolution Bayer.
+ */
+CFHDENCODER_API CFHD_Error
+CFHD_EncodeProxySample(CFHD_EncoderRef encoderRef,
+                       void *samplePtr,
+                       size_t sampleSize);
+
+/*!
+ * \brief Extract the sample for one eye from a stereo sample.
+ * \param samplePtr: Pointer to a stereo sample containing the encoded left and right eyes.
+ * \param sampleSize: Size of the encoded sample.
+ * \param eye: Eye to extract (VIDEO_SELECT_LEFT_EYE or VIDEO_SELECT_RIGHT_EYE).
+ * \param outputBuffer: Buffer that will receive the sample for the eye.
+ * \param outputBufferSize: Size of the output buffer (the size of the stereo sample is always enough).
+ * \param retSize: If successful contains the size of the extracted sample in bytes.
+ * \return Returns a CFHD error code.
+ *
+ * The sample for the eye is copied and the number of encoded channels in the sample
+ * header is changed to one, so the result can be decoded as a 2D sample.  The channel
+ * number is retained so that the metadata for the eye is still applied when decoding.
+ */
+CFHDENCODER_API CFHD_Error
+CFHD_ExtractStereoEye(void *samplePtr,
+                      size_t sampleSize,
+                      CFHD_VideoSelect eye,
+                      void *outputBuffer,
+                      size_t outputBufferSize,
+                      size_t *retSize);
+
+/*!
+ * \brief Combine the samples for the left and right eyes into one stereo sample.
+ * \param leftSamplePtr: Pointer to the encoded sample for the left eye.
+ * \param leftSampleSize: Size of the sample for the left eye.
+ * \param rightSamplePtr: Pointer to the encoded sample for the right eye.
+ * \param rightSampleSize: Size of the sample for the right eye.
+ * \param outputBuffer: Buffer that will receive the stereo sample.
+ * \param outputBufferSize: Size of the output buffer (the size of both samples plus 32 bytes is always enough).
+ * \param retSize: If successful contains the size of the stereo sample in bytes.
+ * \return Returns a CFHD error code.
+ *
+ * Both samples must be intra frames with the same dimensions and encoded format.
+ * The samples are copied without decoding and the tags for the number of encoded
+ * channels and the channel number are inserted into each sample header.
+ */
+CFHDENCODER_API CFHD_Error
+CFHD_MuxStereoSample(void *leftSamplePtr,
+                     size_t leftSampleSize,
+                     void *rightSamplePtr,
+                     size_t rightSampleSize,
+                     void *outputBuffer,
+                     size_t outputBufferSize,
+                     size_t *retSize);
+
 /*!
  * \brief Opens a handle for attaching metadata.
  * \param metadataRefOut: Pointer to the variable that will receive the metadata reference.
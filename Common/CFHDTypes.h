@@ -54,6 +54,15 @@ typedef enum CFHD_PixelFormat
     CFHD_PIXEL_FORMAT_DPX0 = CFHD_FCC('D', 'P', 'X', '0'),	// DPX packed format
     CFHD_PIXEL_FORMAT_NV12 = CFHD_FCC('N', 'V', '1', '2'),	// Planar YUV 4:2:0 format for MPEG-2
     CFHD_PIXEL_FORMAT_YV12 = CFHD_FCC('Y', 'V', '1', '2'),	// Planar YUV 4:2:0 format for MPEG-2
+    CFHD_PIXEL_FORMAT_P010 = CFHD_FCC('P', '0', '1', '0'),	// Luma and interleaved chroma planes 4:2:0 with 10-bits per component
+    CFHD_PIXEL_FORMAT_P016 = CFHD_FCC('P', '0', '1', '6'),	// Luma and interleaved chroma planes 4:2:0 with 16-bits per component
+    CFHD_PIXEL_FORMAT_P210 = CFHD_FCC('P', '2', '1', '0'),	// Luma and interleaved chroma planes 4:2:2 with 10-bits per component
+    CFHD_PIXEL_FORMAT_P216 = CFHD_FCC('P', '2', '1', '6'),	// Luma and interleaved chroma planes 4:2:2 with 16-bits per component
+    CFHD_PIXEL_FORMAT_GBRP16 = CFHD_FCC('G', 'B', 'P', '6'),	// Planes of G, B, and R 4:4:4 with 16-bits per component
+    CFHD_PIXEL_FORMAT_GBRAP16 = CFHD_FCC('G', 'B', 'A', '6'),// Planes of G, B, R, and A 4:4:4:4 with 16-bits per component
+    CFHD_PIXEL_FORMAT_RGBA_HALF = CFHD_FCC('R', 'G', 'h', 'A'),	// RGBA 4:4:4:4 with 16-bit floating-point components
+    CFHD_PIXEL_FORMAT_RGBA_FLOAT = CFHD_FCC('R', 'G', 'f', 'A'),	// RGBA 4:4:4:4 with 32-bit floating-point components
+    CFHD_PIXEL_FORMAT_GBRAP_FLOAT = CFHD_FCC('G', 'B', 'A', 'f'),	// Planes of G, B, R, and A 4:4:4:4 with 32-bit floating-point components
     CFHD_PIXEL_FORMAT_R408 = CFHD_FCC('R', '4', '0', '8'),	// Component Y'CbCrA 8-bit 4:4:4:4 (alpha is not populated.)
     CFHD_PIXEL_FORMAT_V408 = CFHD_FCC('V', '4', '0', '8'),	// Component Y'CbCrA 8-bit 4:4:4:4 (alpha is not populate
     CFHD_PIXEL_FORMAT_BYR4 = CFHD_FCC('B', 'Y', 'R', '4'),	// Raw bayer 16-bits per componentd.)
@@ -224,6 +233,10 @@ enum
     DEMOSAIC_ADVANCED_DETAIL1 = 4,
     DEMOSAIC_ADVANCED_DETAIL2 = 5,
     DEMOSAIC_ADVANCED_DETAIL3 = 6,
+    DEMOSAIC_BILINEAR_SMOOTH = 7,
+    DEMOSAIC_BILINEAR_DETAIL1 = 8,
+    DEMOSAIC_BILINEAR_DETAIL2 = 9,
+    DEMOSAIC_EDGE_DIRECTED = 10,	//!< Gradient-corrected edge-directed interpolation for final renders
 };
 
 
@@ -335,6 +348,8 @@ typedef enum CFHD_DecodedResolution
     CFHD_DECODED_RESOLUTION_HALF = 2,
     CFHD_DECODED_RESOLUTION_QUARTER = 3,
     CFHD_DECODED_RESOLUTION_THUMBNAIL = 4,
+    CFHD_DECODED_RESOLUTION_EIGHTH = 5,		// Decode only the lowpass bands
+    CFHD_DECODED_RESOLUTION_SIXTEENTH = 6,	// Lowpass bands reduced by two in each dimension
 
     CFHD_DECODED_RESOLUTION_DEFAULT = CFHD_DECODED_RESOLUTION_FULL,
 
@@ -350,6 +365,10 @@ enum
     CFHD_DECODING_FLAGS_MUST_SCALE      = (1 << 1),
     CFHD_DECODING_FLAGS_USE_RESOLUTION  = (1 << 2),
     CFHD_DECODING_FLAGS_INTERNAL_ONLY   = (1 << 3),
+    CFHD_DECODING_FLAGS_PIPELINED       = (1 << 4),		//!< Decode prefetched samples concurrently (see CFHD_PrefetchSample)
 };
 
+//! Callback that receives contiguous bands of decoded rows in order (see CFHD_SetDecodedRowsCallback)
+typedef void (* CFHD_DecodedRowsCallback)(void *param, int firstRow, int rowCount, void *rowPtr);
+
 #endif // CFHD_TYPES_H
@@ -75,6 +75,7 @@ public:
         THREAD_COMMAND_START,
         THREAD_COMMAND_STOP,
         THREAD_COMMAND_ENCODE,
+        THREAD_COMMAND_DECODE,
     };
 
     ThreadMessage() :
@@ -156,6 +156,7 @@ public:
         {
             return CFHD_ERROR_THREAD_WAIT_FAILED;
         }
+        running = false;
         return CFHD_ERROR_OKAY;
     }
 
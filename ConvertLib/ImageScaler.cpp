@@ -37,6 +37,16 @@
 #include "swap.h"
 #include "cpuid.h"
 
+#ifndef _XMMOPT
+#define _XMMOPT 1					// Use SIMD instructions in this program
+#endif
+
+#define XMMOPT (1 && _XMMOPT)		// Use SIMD instructions in this module
+
+#if XMMOPT
+#include <emmintrin.h>				// Include support for SSE2 intrinsics
+#endif
+
 #define CONVERT_709_TO_601	1
 
 #if _MSVC_VER
@@ -4312,6 +4322,550 @@ void CImageScalerConverterYUV::ScaleToCbYCrY_422_8u(void *inputBuffer,
     FreeScratchMemory();
 }
 
+
+THREAD_PROC(CImageScalerStrip::ScalerProc, lpParam)
+{
+    CImageScalerStrip *myclass = (CImageScalerStrip *)lpParam;
+    MAILBOX *mailbox = (MAILBOX *)&myclass->mailbox;
+    THREAD_ERROR error = THREAD_ERROR_OKAY;
+    int thread_index;
+
+    // Determine the index of this worker thread
+    error = PoolThreadGetIndex(&mailbox->pool, &thread_index);
+    assert(error == THREAD_ERROR_OKAY);
+
+    // Check that the thread index is consistent with the size of the thread pool
+    assert(0 <= thread_index && thread_index < mailbox->pool.thread_count);
+
+    // The worker thread stays active while waiting for a message to start processing
+    for (;;)
+    {
+        // Wait for the signal to begin processing a frame
+        THREAD_MESSAGE message = THREAD_MESSAGE_NONE;
+        error = PoolThreadWaitForMessage(&mailbox->pool, thread_index, &message);
+
+        if (error == THREAD_ERROR_OKAY && message == THREAD_MESSAGE_START)
+        {
+            for (;;)
+            {
+                int work_index;
+
+                // Wait for the next strip of output rows
+                error = PoolThreadWaitForWork(&mailbox->pool, &work_index, thread_index);
+
+                if (error == THREAD_ERROR_OKAY)
+                {
+                    switch (mailbox->jobtype)
+                    {
+                        case ScaleStripThreadID:
+                            myclass->ScaleStripThread(work_index, thread_index);
+                            break;
+                    }
+                }
+                else
+                {
+                    // No more work to do
+                    break;
+                }
+            }
+
+            // Signal that this thread is done
+            PoolThreadSignalDone(&mailbox->pool, thread_index);
+        }
+        else if (error == THREAD_ERROR_OKAY && message == THREAD_MESSAGE_STOP)
+        {
+            // The worker thread has been told to terminate itself
+            break;
+        }
+        else
+        {
+            // If the wait failed it probably means that the thread pool is shutting down
+            break;
+        }
+    }
+
+    return (THREAD_RETURN_TYPE)error;
+}
+
+bool CImageScalerStrip::AllocScratchMemory(int inputWidth, int inputHeight, int outputWidth, int outputHeight,
+        int componentCount, int threadCount)
+{
+    // Each output column has the number of pairs of samples followed by two input columns and two weights per pair
+    size_t row_factors_size = (size_t)outputWidth * (3 * STRIP_SCALER_MAX_SAMPLES / 2 + 1) * sizeof(int);
+    size_t column_factors_size = (size_t)outputHeight * STRIP_SCALER_MAX_SAMPLES * sizeof(lanczosmix);
+    lanczosmix lm[STRIP_SCALER_MAX_SAMPLES];
+    int limit = -1;
+
+    FreeScratchMemory();
+
+    rowFactors = (int *)Alloc(row_factors_size);
+    columnFactors = (lanczosmix *)Alloc(column_factors_size);
+    columnSamples = (int *)Alloc(outputHeight * sizeof(int));
+    columnLimit = (int *)Alloc(outputHeight * sizeof(int));
+    if (rowFactors == NULL || columnFactors == NULL || columnSamples == NULL || columnLimit == NULL)
+    {
+        return false;
+    }
+
+    // Pair the samples for each output column and pad the last pair with a zero weight
+    int *factors = rowFactors;
+    for (int column = 0; column < outputWidth; column++)
+    {
+        int samples = LanczosCoeff(inputWidth, outputWidth, column, lm, false, false, 3);
+
+        assert(0 < samples && samples < STRIP_SCALER_MAX_SAMPLES);
+
+        if (samples & 1)
+        {
+            lm[samples].srcline = lm[samples - 1].srcline;
+            lm[samples].mixval = 0;
+            samples++;
+        }
+
+        *(factors++) = samples / 2;
+
+        for (int i = 0; i < samples; i += 2)
+        {
+            *(factors++) = lm[i].srcline * componentCount;
+            *(factors++) = lm[i + 1].srcline * componentCount;
+            *(factors++) = (lm[i + 1].mixval << 16) | (lm[i].mixval & 0xFFFF);
+        }
+    }
+
+    // The window must hold every input row between the first input row used by an output row
+    // and the last input row that has been scaled to complete the output rows above it
+    windowRows = 1;
+    for (int row = 0; row < outputHeight; row++)
+    {
+        lanczosmix *lmY = &columnFactors[row * STRIP_SCALER_MAX_SAMPLES];
+        int samples = LanczosCoeff(inputHeight, outputHeight, row, lmY, false, false, 3);
+        int first = inputHeight;
+
+        assert(0 < samples && samples < STRIP_SCALER_MAX_SAMPLES);
+
+        for (int i = 0; i < samples; i++)
+        {
+            if (lmY[i].srcline < first) first = lmY[i].srcline;
+            if (lmY[i].srcline > limit) limit = lmY[i].srcline;
+        }
+
+        columnSamples[row] = samples;
+        columnLimit[row] = limit;
+
+        if (limit - first + 1 > windowRows)
+        {
+            windowRows = limit - first + 1;
+        }
+    }
+
+    // Allocate the window of horizontally scaled rows for each thread
+    windowPitch = (outputWidth * componentCount + 7) & ~7;
+    windowSize = (size_t)windowRows * windowPitch;
+    window = (short *)Alloc(windowSize * threadCount * sizeof(short));
+    if (window == NULL)
+    {
+        return false;
+    }
+
+    // Scratch memory has been successfully allocated
+    return true;
+}
+
+void CImageScalerStrip::FreeScratchMemory()
+{
+    if (rowFactors)
+    {
+        Free((char *)rowFactors);
+        rowFactors = NULL;
+    }
+
+    if (columnFactors)
+    {
+        Free((char *)columnFactors);
+        columnFactors = NULL;
+    }
+
+    if (columnSamples)
+    {
+        Free((char *)columnSamples);
+        columnSamples = NULL;
+    }
+
+    if (columnLimit)
+    {
+        Free((char *)columnLimit);
+        columnLimit = NULL;
+    }
+
+    if (window)
+    {
+        Free((char *)window);
+        window = NULL;
+    }
+}
+
+/*
+	The window holds the horizontally scaled values as signed 16-bit values offset by 32768.
+	Components with 16 bits are offset before scaling so that pairs of samples can be weighted
+	with signed multiply and add instructions.  The weights for each output value add up to 256,
+	so the offset is removed by adding 256 * 32768 to the weighted sum.  Components with 8 bits
+	are scaled to 16 bits with eight bits of fraction.
+*/
+
+#if XMMOPT
+
+// Load the components of one pixel into the lower four 16-bit lanes
+template <typename PixelType, int componentCount>
+static inline __m128i LoadStripPixel(const PixelType *pixel);
+
+template <>
+inline __m128i LoadStripPixel<unsigned short, 4>(const unsigned short *pixel)
+{
+    return _mm_xor_si128(_mm_loadl_epi64((__m128i *)pixel), _mm_set1_epi16((short)0x8000));
+}
+
+template <>
+inline __m128i LoadStripPixel<unsigned short, 3>(const unsigned short *pixel)
+{
+    int first;
+    memcpy(&first, pixel, sizeof(first));
+    __m128i value = _mm_insert_epi16(_mm_cvtsi32_si128(first), pixel[2], 2);
+    return _mm_xor_si128(value, _mm_set1_epi16((short)0x8000));
+}
+
+template <>
+inline __m128i LoadStripPixel<unsigned char, 4>(const unsigned char *pixel)
+{
+    int value;
+    memcpy(&value, pixel, sizeof(value));
+    return _mm_unpacklo_epi8(_mm_cvtsi32_si128(value), _mm_setzero_si128());
+}
+
+template <>
+inline __m128i LoadStripPixel<unsigned char, 3>(const unsigned char *pixel)
+{
+    int value = pixel[0] | (pixel[1] << 8) | (pixel[2] << 16);
+    return _mm_unpacklo_epi8(_mm_cvtsi32_si128(value), _mm_setzero_si128());
+}
+
+// Scale a row of pixels into a row of the window
+template <typename PixelType, int componentCount>
+static void ScaleStripRow(const PixelType *input, short *output, const int *factors, int outputWidth)
+{
+    for (int column = 0; column < outputWidth; column++)
+    {
+        __m128i sum_epi32 = _mm_setzero_si128();
+        int pairs = *(factors++);
+
+        for (; pairs > 0; pairs--)
+        {
+            __m128i pixel1_epi16 = LoadStripPixel<PixelType, componentCount>(input + factors[0]);
+            __m128i pixel2_epi16 = LoadStripPixel<PixelType, componentCount>(input + factors[1]);
+            __m128i mix_epi16 = _mm_set1_epi32(factors[2]);
+
+            pixel1_epi16 = _mm_unpacklo_epi16(pixel1_epi16, pixel2_epi16);
+            sum_epi32 = _mm_add_epi32(sum_epi32, _mm_madd_epi16(pixel1_epi16, mix_epi16));
+            factors += 3;
+        }
+
+        if (sizeof(PixelType) == 1)
+        {
+            // Offset the values that have eight bits of fraction
+            sum_epi32 = _mm_sub_epi32(sum_epi32, _mm_set1_epi32(32768));
+        }
+        else
+        {
+            // The offset has already been subtracted from the input values
+            sum_epi32 = _mm_srai_epi32(sum_epi32, 8);
+        }
+
+        // Saturate to the range of the offset values
+        sum_epi32 = _mm_packs_epi32(sum_epi32, sum_epi32);
+
+        if (componentCount == 4)
+        {
+            _mm_storel_epi64((__m128i *)output, sum_epi32);
+        }
+        else
+        {
+            int value = _mm_cvtsi128_si32(sum_epi32);
+            memcpy(output, &value, sizeof(value));
+            output[2] = (short)_mm_extract_epi16(sum_epi32, 2);
+        }
+
+        output += componentCount;
+    }
+}
+
+#else
+
+// Scale a row of pixels into a row of the window
+template <typename PixelType, int componentCount>
+static void ScaleStripRow(const PixelType *input, short *output, const int *factors, int outputWidth)
+{
+    const int offset = (sizeof(PixelType) == 1) ? 0 : 32768;
+
+    for (int column = 0; column < outputWidth; column++)
+    {
+        int sum[4] = {0, 0, 0, 0};
+        int pairs = *(factors++);
+
+        for (; pairs > 0; pairs--)
+        {
+            const PixelType *pixel1 = input + factors[0];
+            const PixelType *pixel2 = input + factors[1];
+            int mix1 = (short)(factors[2] & 0xFFFF);
+            int mix2 = factors[2] >> 16;
+
+            for (int i = 0; i < componentCount; i++)
+            {
+                sum[i] += (pixel1[i] - offset) * mix1 + (pixel2[i] - offset) * mix2;
+            }
+            factors += 3;
+        }
+
+        for (int i = 0; i < componentCount; i++)
+        {
+            int value = (sizeof(PixelType) == 1) ? sum[i] - 32768 : sum[i] >> 8;
+            if (value < SHRT_MIN) value = SHRT_MIN;
+            else if (value > SHRT_MAX) value = SHRT_MAX;
+            output[i] = value;
+        }
+
+        output += componentCount;
+    }
+}
+
+#endif
+
+void CImageScalerStrip::ScaleRowValues(unsigned char *inputRow, short *windowRow)
+{
+    if (componentSize == 1)
+    {
+        if (componentCount == 4)
+            ScaleStripRow<unsigned char, 4>(inputRow, windowRow, rowFactors, outputWidth);
+        else
+            ScaleStripRow<unsigned char, 3>(inputRow, windowRow, rowFactors, outputWidth);
+    }
+    else
+    {
+        if (componentCount == 4)
+            ScaleStripRow<unsigned short, 4>((unsigned short *)inputRow, windowRow, rowFactors, outputWidth);
+        else
+            ScaleStripRow<unsigned short, 3>((unsigned short *)inputRow, windowRow, rowFactors, outputWidth);
+    }
+}
+
+void CImageScalerStrip::ScaleColumnValues(int row, short *windowBase, unsigned char *outputRow)
+{
+    lanczosmix *lmY = &columnFactors[row * STRIP_SCALER_MAX_SAMPLES];
+    int samples = columnSamples[row];
+    int length = outputWidth * componentCount;
+    short *windowRow[STRIP_SCALER_MAX_SAMPLES];
+    int mix[STRIP_SCALER_MAX_SAMPLES];
+    int pairs = (samples + 1) / 2;
+
+    // Pair the rows in the window and pad the last pair with a zero weight
+    for (int i = 0; i < samples; i++)
+    {
+        windowRow[i] = windowBase + (lmY[i].srcline % windowRows) * windowPitch;
+        mix[i] = lmY[i].mixval;
+    }
+
+    if (samples & 1)
+    {
+        windowRow[samples] = windowRow[samples - 1];
+        mix[samples] = 0;
+    }
+
+#if XMMOPT
+    __m128i mix_epi16[STRIP_SCALER_MAX_SAMPLES / 2];
+
+    for (int i = 0; i < pairs; i++)
+    {
+        mix_epi16[i] = _mm_set1_epi32((mix[2 * i + 1] << 16) | (mix[2 * i] & 0xFFFF));
+    }
+
+    // The window rows are padded to a multiple of eight values
+    for (int column = 0; column < length; column += 8)
+    {
+        __m128i sum1_epi32 = _mm_setzero_si128();
+        __m128i sum2_epi32 = _mm_setzero_si128();
+        __m128i result_epi16;
+
+        for (int i = 0; i < pairs; i++)
+        {
+            __m128i row1_epi16 = _mm_load_si128((__m128i *)&windowRow[2 * i][column]);
+            __m128i row2_epi16 = _mm_load_si128((__m128i *)&windowRow[2 * i + 1][column]);
+
+            sum1_epi32 = _mm_add_epi32(sum1_epi32, _mm_madd_epi16(_mm_unpacklo_epi16(row1_epi16, row2_epi16), mix_epi16[i]));
+            sum2_epi32 = _mm_add_epi32(sum2_epi32, _mm_madd_epi16(_mm_unpackhi_epi16(row1_epi16, row2_epi16), mix_epi16[i]));
+        }
+
+        if (componentSize == 1)
+        {
+            // Remove the offset and the sixteen bits of fraction
+            const __m128i rounding_epi32 = _mm_set1_epi32((32768 << 8) + (1 << 15));
+            sum1_epi32 = _mm_srai_epi32(_mm_add_epi32(sum1_epi32, rounding_epi32), 16);
+            sum2_epi32 = _mm_srai_epi32(_mm_add_epi32(sum2_epi32, rounding_epi32), 16);
+            result_epi16 = _mm_packs_epi32(sum1_epi32, sum2_epi32);
+            result_epi16 = _mm_packus_epi16(result_epi16, result_epi16);
+
+            if (column + 8 <= length)
+            {
+                _mm_storel_epi64((__m128i *)&outputRow[column], result_epi16);
+            }
+            else
+            {
+                uint8_t buffer[16];
+                _mm_storeu_si128((__m128i *)buffer, result_epi16);
+                memcpy(&outputRow[column], buffer, length - column);
+            }
+        }
+        else
+        {
+            // Remove the eight bits of fraction and restore the offset after saturation
+            const __m128i rounding_epi32 = _mm_set1_epi32(1 << 7);
+            sum1_epi32 = _mm_srai_epi32(_mm_add_epi32(sum1_epi32, rounding_epi32), 8);
+            sum2_epi32 = _mm_srai_epi32(_mm_add_epi32(sum2_epi32, rounding_epi32), 8);
+            result_epi16 = _mm_packs_epi32(sum1_epi32, sum2_epi32);
+            result_epi16 = _mm_xor_si128(result_epi16, _mm_set1_epi16((short)0x8000));
+
+            if (column + 8 <= length)
+            {
+                _mm_storeu_si128((__m128i *)&outputRow[column * 2], result_epi16);
+            }
+            else
+            {
+                uint16_t buffer[8];
+                _mm_storeu_si128((__m128i *)buffer, result_epi16);
+                memcpy(&outputRow[column * 2], buffer, (length - column) * 2);
+            }
+        }
+    }
+#else
+    for (int column = 0; column < length; column++)
+    {
+        int sum = 0;
+
+        for (int i = 0; i < 2 * pairs; i++)
+        {
+            sum += windowRow[i][column] * mix[i];
+        }
+
+        if (componentSize == 1)
+        {
+            int value = (sum + (32768 << 8) + (1 << 15)) >> 16;
+            if (value < 0) value = 0;
+            else if (value > UCHAR_MAX) value = UCHAR_MAX;
+            outputRow[column] = value;
+        }
+        else
+        {
+            int value = ((sum + (1 << 7)) >> 8) + 32768;
+            if (value < 0) value = 0;
+            else if (value > USHRT_MAX) value = USHRT_MAX;
+            ((unsigned short *)outputRow)[column] = value;
+        }
+    }
+#endif
+}
+
+void CImageScalerStrip::ScaleStrip(int firstRow, int lastRow, short *windowBase)
+{
+    int nextRow = inputHeight;
+
+    // Find the first input row used by the strip
+    for (int row = firstRow; row < lastRow; row++)
+    {
+        lanczosmix *lmY = &columnFactors[row * STRIP_SCALER_MAX_SAMPLES];
+
+        for (int i = 0; i < columnSamples[row]; i++)
+        {
+            if (lmY[i].srcline < nextRow) nextRow = lmY[i].srcline;
+        }
+    }
+
+    for (int row = firstRow; row < lastRow; row++)
+    {
+        // Scale the input rows that are required for this output row
+        while (nextRow <= columnLimit[row])
+        {
+            ScaleRowValues(input + (size_t)nextRow * inputPitch, windowBase + (nextRow % windowRows) * windowPitch);
+            nextRow++;
+        }
+
+        ScaleColumnValues(row, windowBase, output + (size_t)row * outputPitch);
+    }
+}
+
+void CImageScalerStrip::ScaleStripThread(int index, int thread_index)
+{
+    int firstRow = index * STRIP_SCALER_ROWS;
+    int lastRow = firstRow + STRIP_SCALER_ROWS;
+
+    if (lastRow > outputHeight) lastRow = outputHeight;
+
+    ScaleStrip(firstRow, lastRow, window + windowSize * thread_index);
+}
+
+bool CImageScalerStrip::ScaleImage(unsigned char *inputBuffer,
+                                   int inputWidth,
+                                   int inputHeight,
+                                   int inputPitch,
+                                   unsigned char *outputBuffer,
+                                   int outputWidth,
+                                   int outputHeight,
+                                   int outputPitch,
+                                   int componentCount,
+                                   int componentSize)
+{
+    assert(componentCount == 3 || componentCount == 4);
+    assert(componentSize == 1 || componentSize == 2);
+
+    if (mailbox.pool.thread_count == 0)
+    {
+        mailbox.cpus = GetProcessorCount();
+        CreateLock(&mailbox.lock);
+        ThreadPoolCreate(&mailbox.pool,
+                         mailbox.cpus,
+                         ScalerProc,
+                         this);
+    }
+
+    if (!AllocScratchMemory(inputWidth, inputHeight, outputWidth, outputHeight,
+                            componentCount, mailbox.pool.thread_count))
+    {
+        FreeScratchMemory();
+        return false;
+    }
+
+    this->input = inputBuffer;
+    this->inputPitch = inputPitch;
+    this->output = outputBuffer;
+    this->outputPitch = outputPitch;
+    this->inputHeight = inputHeight;
+    this->outputWidth = outputWidth;
+    this->outputHeight = outputHeight;
+    this->componentCount = componentCount;
+    this->componentSize = componentSize;
+
+    // Post a message to the mailbox
+    mailbox.jobtype = ScaleStripThreadID;
+
+    // Set the work count to the number of strips to process
+    ThreadPoolSetWorkCount(&mailbox.pool, (outputHeight + STRIP_SCALER_ROWS - 1) / STRIP_SCALER_ROWS);
+    // Start the worker threads
+    ThreadPoolSendMessage(&mailbox.pool, THREAD_MESSAGE_START);
+    // Wait for all of the worker threads to finish
+    ThreadPoolWaitAllDone(&mailbox.pool);
+
+    // Free the scratch buffers used for interpolation
+    FreeScratchMemory();
+
+    return true;
+}
+
 //#pragma mark C routines
 //
 //
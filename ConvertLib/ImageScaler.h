@@ -1074,6 +1074,108 @@ public:
     static THREAD_PROC(ScalerProc, lpParam);
 };
 
+
+// Number of output rows in each strip of the output image
+#define STRIP_SCALER_ROWS			32
+
+// Maximum number of input samples that contribute to each output sample
+#define STRIP_SCALER_MAX_SAMPLES	64
+
+// Scale images with 8-bit or 16-bit unsigned components without changing the pixel format
+class CImageScalerStrip : public CLanczosScaler
+{
+public:
+    CImageScalerStrip(IMemAlloc *pMemAlloc) :
+        CLanczosScaler(pMemAlloc),
+        rowFactors(NULL),
+        columnFactors(NULL),
+        columnSamples(NULL),
+        columnLimit(NULL),
+        window(NULL),
+        windowRows(0),
+        windowPitch(0),
+        windowSize(0)
+    {
+        memset(&mailbox, 0, sizeof(MAILBOX));
+    }
+
+    ~CImageScalerStrip()
+    {
+        // Free the scratch buffers used by the scaling routines
+        FreeScratchMemory();
+        if (mailbox.pool.thread_count > 0)
+        {
+            ThreadPoolDelete(&mailbox.pool);
+            DeleteLock(&mailbox.lock);
+        }
+    }
+
+    // Scale the input image into the output image one strip of output rows at a time
+    bool ScaleImage(unsigned char *inputBuffer,
+                    int inputWidth,
+                    int inputHeight,
+                    int inputPitch,
+                    unsigned char *outputBuffer,
+                    int outputWidth,
+                    int outputHeight,
+                    int outputPitch,
+                    int componentCount,
+                    int componentSize);
+
+#define ScaleStripThreadID			1
+    void ScaleStripThread(int index, int thread_index);
+
+    MAILBOX mailbox;
+    static THREAD_PROC(ScalerProc, lpParam);
+
+protected:
+
+    // Allocate the scale factors and the window of horizontally scaled rows for each thread
+    bool AllocScratchMemory(int inputWidth, int inputHeight, int outputWidth, int outputHeight,
+                            int componentCount, int threadCount);
+
+    // Free scratch memory used by the scaling routines
+    void FreeScratchMemory();
+
+    // Scale one input row into a row of the window
+    void ScaleRowValues(unsigned char *inputRow, short *windowRow);
+
+    // Compute one output row from the rows in the window
+    void ScaleColumnValues(int row, short *windowBase, unsigned char *outputRow);
+
+    // Compute the output rows in the specified range using the window for one thread
+    void ScaleStrip(int firstRow, int lastRow, short *windowBase);
+
+protected:
+
+    // Pairs of input columns and weights for each output column
+    int *rowFactors;
+
+    // Scale factors for each output row
+    lanczosmix *columnFactors;
+    int *columnSamples;
+
+    // Last input row required by each output row and all of the rows above it
+    int *columnLimit;
+
+    // Window of horizontally scaled rows for each thread
+    short *window;
+    int windowRows;
+    int windowPitch;
+    size_t windowSize;
+
+    // Dimensions and format of the images that are being scaled
+    unsigned char *input;
+    int inputPitch;
+    unsigned char *output;
+    int outputPitch;
+    int inputHeight;
+    int outputWidth;
+    int outputHeight;
+    int componentCount;
+    int componentSize;
+};
+
 //
 //	C interface to the same functions.
 //
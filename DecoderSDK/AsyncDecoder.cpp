@@ -0,0 +1,93 @@
+/*! @file AsyncDecoder.cpp
+
+*  @brief Worker thread for an asynchronous decoder in the decoder pool
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "StdAfx.h"
+
+// Include files from the codec library
+#include "decoder.h"
+
+// Include files for the decoder DLL
+#include "CFHDDecoder.h"
+#include "IAllocator.h"
+#include "ISampleDecoder.h"
+#include "SampleDecoder.h"
+
+// Include the declarations for the thread pool
+#include "Lock.h"
+#include "Condition.h"
+#include "ThreadMessage.h"
+#include "MessageQueue.h"
+#include "ThreadPool.h"
+
+// Include the declarations for the asynchronous decoder and the decoder pool
+#include "DecoderQueue.h"
+#include "AsyncDecoder.h"
+#include "DecoderPool.h"
+
+
+CThread::ThreadReturnType STDCALL CAsyncDecoder::WorkerThreadProc(void *param)
+{
+    // The thread parameter is the asynchronous decoder for this worker thread
+    CAsyncDecoder *decoder = reinterpret_cast<CAsyncDecoder *>(param);
+    assert(decoder != NULL);
+    if (! (decoder != NULL))
+    {
+        return (CThread::ThreadReturnType)CFHD_ERROR_UNEXPECTED;
+    }
+
+    // Process messages that are sent to this asynchronous decoder
+    return (CThread::ThreadReturnType)decoder->MessageLoop();
+}
+
+CFHD_Error CAsyncDecoder::MessageLoop()
+{
+    CFHD_Error error = CFHD_ERROR_OKAY;
+
+    for (;;)
+    {
+        DecoderMessage message;
+        DecoderJob *job = NULL;
+
+        error = queue.WaitForMessage(message);
+        if (error != CFHD_ERROR_OKAY)
+        {
+            return error;
+        }
+
+        switch (message.Command())
+        {
+            case ThreadMessage::THREAD_COMMAND_STOP:
+                // Terminate this thread
+                return CFHD_ERROR_OKAY;
+
+            case ThreadMessage::THREAD_COMMAND_DECODE:
+                job = message.Job();
+                assert(job != NULL);
+                error = DecodeSample(job->samplePtr, job->sampleSize, job->outputBuffer, job->outputPitch);
+
+                // Record the result and wake the thread waiting for decoded frames
+                pool->SignalJobFinished(job, error);
+                break;
+
+            default:
+                // Ignore this message
+                break;
+        }
+    }
+}
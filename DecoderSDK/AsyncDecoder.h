@@ -0,0 +1,84 @@
+/*! @file AsyncDecoder.h
+
+*  @brief Sample decoder with a worker thread for decoding samples asynchronously
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#pragma once
+
+// Forward reference to the decoder pool
+class CDecoderPool;
+
+/*!
+	@brief Asynchronous decoder with a message queue of decoder jobs
+
+	Each asynchronous decoder is associated with a worker thread that allows
+	samples to be decoded asynchronously.  The asynchronous decoder extends the
+	sample decoder with a message queue that contains decoding jobs assigned to
+	the decoder and control messages that stop the worker thread.
+*/
+class CAsyncDecoder : public CSampleDecoder
+{
+    //! Decoder pool that manages this asynchronous decoder
+    CDecoderPool *pool;
+
+    //! Queue of control messages and decoding requests
+    CDecoderMessageQueue queue;
+
+    //! Worker thread for this asynchronous decoder
+    CThread thread;
+
+public:
+
+    CAsyncDecoder(CDecoderPool *decoderPool, CFHD_ALLOCATOR *allocator) :
+        CSampleDecoder(allocator),
+        pool(decoderPool)
+    {
+    }
+
+    //! Start the worker thread for this asynchronous decoder
+    CFHD_Error Start(void *param)
+    {
+        return thread.Start(WorkerThreadProc, param);
+    }
+
+    //! Stop the worker thread after the jobs already in the message queue
+    CFHD_Error Stop()
+    {
+        DecoderMessage message(ThreadMessage::THREAD_COMMAND_STOP);
+        return queue.AddMessage(message);
+    }
+
+    //! Wait for the worker thread to terminate
+    CFHD_Error Wait()
+    {
+        return thread.Wait();
+    }
+
+    //! Post a decoder message to the queue for this asynchronous decoder
+    CFHD_Error SendMessage(DecoderMessage &message)
+    {
+        return queue.AddMessage(message);
+    }
+
+protected:
+
+    //! Procedure executed by the worker thread for this asynchronous decoder
+    static CThread::ThreadReturnType STDCALL WorkerThreadProc(void *param);
+
+    //! Process messages sent to this asynchronous decoder
+    CFHD_Error MessageLoop();
+};
@@ -0,0 +1,110 @@
+/*! @file CFHDArena.cpp
+
+*  @brief This module implements the C functions for the arena allocator.
+*
+*  The arena is implemented in the codec library so that it can be shared
+*  by the decoder and encoder SDKs.  These functions check the arguments
+*  and translate the statistics into the public data structure.
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "StdAfx.h"
+
+// Export the interface to the arena allocator
+#define ARENADLL_EXPORTS	1
+
+// Include files from the codec library
+#include "arena.h"
+
+#include "CFHDArena.h"
+
+
+CFHDARENA_API CFHD_Error
+CFHD_CreateArenaAllocator(uint32_t flags,
+                          CFHD_ALLOCATOR **allocatorOut)
+{
+    if (allocatorOut == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    uint32_t arenaFlags = ARENA_FLAGS_NONE;
+    if (flags & CFHD_ARENA_FLAGS_NO_THREAD_CACHE)
+    {
+        arenaFlags |= ARENA_FLAGS_NO_THREAD_CACHE;
+    }
+    if (flags & CFHD_ARENA_FLAGS_HUGE_PAGES)
+    {
+        arenaFlags |= ARENA_FLAGS_HUGE_PAGES;
+    }
+
+    CFHD_ALLOCATOR *allocator = CreateArena(arenaFlags);
+    if (allocator == NULL)
+    {
+        return CFHD_ERROR_OUTOFMEMORY;
+    }
+
+    *allocatorOut = allocator;
+    return CFHD_ERROR_OKAY;
+}
+
+CFHDARENA_API CFHD_Error
+CFHD_GetArenaAllocatorStats(CFHD_ALLOCATOR *allocator,
+                            CFHD_ArenaStats *statsOut)
+{
+    if (!IsArena(allocator) || statsOut == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    ARENA_STATS stats;
+    GetArenaStats(allocator, &stats);
+
+    statsOut->bytesInUse = stats.bytes_in_use;
+    statsOut->peakBytesInUse = stats.peak_bytes_in_use;
+    statsOut->bytesReserved = stats.bytes_reserved;
+    statsOut->allocCount = stats.alloc_count;
+    statsOut->freeCount = stats.free_count;
+    statsOut->reuseCount = stats.reuse_count;
+    statsOut->systemAllocCount = stats.system_alloc_count;
+    statsOut->systemFreeCount = stats.system_free_count;
+
+    return CFHD_ERROR_OKAY;
+}
+
+CFHDARENA_API CFHD_Error
+CFHD_TrimArenaAllocator(CFHD_ALLOCATOR *allocator)
+{
+    if (!IsArena(allocator))
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    TrimArena(allocator);
+    return CFHD_ERROR_OKAY;
+}
+
+CFHDARENA_API CFHD_Error
+CFHD_ReleaseArenaAllocator(CFHD_ALLOCATOR *allocator)
+{
+    if (!IsArena(allocator))
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    ReleaseArena(allocator);
+    return CFHD_ERROR_OKAY;
+}
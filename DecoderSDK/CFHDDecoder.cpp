@@ -62,6 +62,8 @@ extern "C" {
 #include "decoder.h"
 #include "swap.h"
 #include "thumbnail.h"
+#include "lutcache.h"
+#include "crc.h"
 
 // Include declarations for the decoder component
 #include "CFHDDecoder.h"
@@ -414,8 +416,7 @@ CFHDDECODER_API CFHD_Error
 CFHD_GetImageSize(uint32_t imageWidth, uint32_t imageHeight, CFHD_PixelFormat pixelFormat,
                   CFHD_VideoSelect videoselect,	CFHD_Stereo3DType stereotype, uint32_t *imageSizeOut)
 {
-    uint32_t imagePitch = GetFramePitch(imageWidth, pixelFormat);
-    uint32_t imageSize = imagePitch * imageHeight;
+    uint32_t imageSize = (uint32_t)GetFrameSize(imageWidth, imageHeight, pixelFormat);
 
     if (stereotype == STEREO3D_TYPE_DEFAULT && videoselect == VIDEO_SELECT_BOTH_EYES)
         imageSize *= 2;
@@ -429,24 +430,9 @@ CFHD_GetImageSize(uint32_t imageWidth, uint32_t imageHeight, CFHD_PixelFormat pi
     return CFHD_ERROR_INVALID_ARGUMENT;
 }
 
-CFHDDECODER_API CFHD_Error
-CFHD_DecodeSample(CFHD_DecoderRef decoderRef,
-                  void *samplePtr,
-                  size_t sampleSize,
-                  void *outputBuffer,
-                  int outputPitch)
+// Test that the memory buffer provided by the caller is large enough for the decoded frame
+static bool TestOutputBuffer(CSampleDecoder *decoder, void *outputBuffer, int outputPitch)
 {
-    CFHD_Error errorCode = CFHD_ERROR_OKAY;
-
-    // Check the input arguments
-    if (decoderRef == NULL)
-    {
-        return CFHD_ERROR_INVALID_ARGUMENT;
-    }
-
-    CSampleDecoder *decoder = (CSampleDecoder *)decoderRef;
-
-    // Test the memory buffer provided for the required size
     try
     {
         uint32_t length = 0;
@@ -469,6 +455,32 @@ CFHD_DecodeSample(CFHD_DecoderRef decoderRef,
 #ifdef _WIN32
         OutputDebugString("Target memory buffer is an invalid size");
 #endif
+        return false;
+    }
+
+    return true;
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_DecodeSample(CFHD_DecoderRef decoderRef,
+                  void *samplePtr,
+                  size_t sampleSize,
+                  void *outputBuffer,
+                  int outputPitch)
+{
+    CFHD_Error errorCode = CFHD_ERROR_OKAY;
+
+    // Check the input arguments
+    if (decoderRef == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    CSampleDecoder *decoder = (CSampleDecoder *)decoderRef;
+
+    // Test the memory buffer provided for the required size (unless a prefetched sample is decoded into it)
+    if (!decoder->IsPrefetchedBuffer(outputBuffer) && !TestOutputBuffer(decoder, outputBuffer, outputPitch))
+    {
         return CFHD_ERROR_DECODE_BUFFER_SIZE;
     }
 
@@ -482,80 +494,210 @@ CFHD_DecodeSample(CFHD_DecoderRef decoderRef,
 }
 
 CFHDDECODER_API CFHD_Error
-CFHD_CloseDecoder(CFHD_DecoderRef decoderRef)
+CFHD_DecodeSamples(CFHD_DecoderRef decoderRef,
+                   uint32_t sampleCount,
+                   void **samplePtrs,
+                   const size_t *sampleSizes,
+                   void **outputBuffers,
+                   const int32_t *outputPitches,
+                   CFHD_Error *errors)
 {
-    //CFHD_Error errorCode = CFHD_ERROR_OKAY;
+    // Check the input arguments
+    if (decoderRef == NULL || samplePtrs == NULL || sampleSizes == NULL ||
+            outputBuffers == NULL || outputPitches == NULL || errors == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (sampleCount == 0)
+    {
+        return CFHD_ERROR_OKAY;
+    }
 
+    CSampleDecoder *decoder = (CSampleDecoder *)decoderRef;
+
+    // Samples with an invalid output buffer are not decoded
+    for (uint32_t index = 0; index < sampleCount; index++)
+    {
+        errors[index] = CFHD_ERROR_OKAY;
+
+        if (samplePtrs[index] == NULL || sampleSizes[index] == 0)
+        {
+            errors[index] = CFHD_ERROR_INVALID_ARGUMENT;
+        }
+        else if (!TestOutputBuffer(decoder, outputBuffers[index], outputPitches[index]))
+        {
+            errors[index] = CFHD_ERROR_DECODE_BUFFER_SIZE;
+        }
+    }
+
+    return decoder->DecodeSamples(sampleCount, samplePtrs, sampleSizes, outputBuffers, outputPitches, errors);
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_PrefetchSample(CFHD_DecoderRef decoderRef,
+                    void *samplePtr,
+                    size_t sampleSize,
+                    void *outputBuffer,
+                    int32_t outputPitch)
+{
     // Check the input arguments
-    if (decoderRef == NULL)
+    if (decoderRef == NULL || samplePtr == NULL || sampleSize == 0 || outputBuffer == NULL)
     {
         return CFHD_ERROR_INVALID_ARGUMENT;
     }
 
     CSampleDecoder *decoder = (CSampleDecoder *)decoderRef;
 
-    delete decoder;
+    if (!decoder->IsPipelined())
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
 
-    return CFHD_ERROR_OKAY;
+    // Test the memory buffer before the decoders in the pipeline can write into it
+    if (!decoder->IsPrefetchedBuffer(outputBuffer) && !TestOutputBuffer(decoder, outputBuffer, outputPitch))
+    {
+        return CFHD_ERROR_DECODE_BUFFER_SIZE;
+    }
+
+    return decoder->PrefetchSample(samplePtr, sampleSize, outputBuffer, outputPitch);
 }
 
+CFHDDECODER_API CFHD_Error
+CFHD_SetRegionOfInterest(CFHD_DecoderRef decoderRef,
+                         int left,
+                         int top,
+                         int width,
+                         int height)
+{
+    // Check the input arguments
+    if (decoderRef == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
 
-#include "CFHDMetadata.h"
-#include "SampleMetadata.h"
-#include "../Codec/metadata.h"
+    CSampleDecoder *decoder = (CSampleDecoder *)decoderRef;
 
-//! Table of CRCs of all 8-bit messages.
-uint32_t crc_table[256];
+    return decoder->SetRegionOfInterest(left, top, width, height);
+}
 
-//! Flag: has the table been computed? Initially false.
-int crc_table_computed = 0;
+CFHDDECODER_API CFHD_Error
+CFHD_SetDecodedRowsCallback(CFHD_DecoderRef decoderRef,
+                            CFHD_DecodedRowsCallback callback,
+                            void *param,
+                            int bandRows)
+{
+    // Check the input arguments
+    if (decoderRef == NULL || bandRows < 0)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
 
-//! Make the table for a fast CRC.
-void make_crc_table(void)
+    CSampleDecoder *decoder = (CSampleDecoder *)decoderRef;
+
+    return decoder->SetDecodedRowsCallback(callback, param, bandRows);
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_SetFrameCacheCapacity(CFHD_DecoderRef decoderRef,
+                           int groupCount)
 {
-    uint32_t c;
-    int n, k;
+    // Check the input arguments
+    if (decoderRef == NULL || groupCount < 0)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    CSampleDecoder *decoder = (CSampleDecoder *)decoderRef;
+
+    return decoder->SetFrameCacheCapacity(groupCount);
+}
 
-    for (n = 0; n < 256; n++)
+CFHDDECODER_API CFHD_Error
+CFHD_PreloadLook(uint32_t lookCRC,
+                 const float *lutData,
+                 int lutSize)
+{
+    // Check the input arguments
+    if (lookCRC == 0 || lutData == NULL)
     {
-        c = (uint32_t) n;
-        for (k = 0; k < 8; k++)
-        {
-            if (c & 1)
-                c = 0xedb88320L ^ (c >> 1);
-            else
-                c = c >> 1;
-        }
-        crc_table[n] = c;
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (lutSize < 8 || lutSize > 65)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!LUTCachePreload(lookCRC, lutData, lutSize))
+    {
+        return CFHD_ERROR_OUTOFMEMORY;
     }
-    crc_table_computed = 1;
+
+    return CFHD_ERROR_OKAY;
 }
 
-/*!
- * Update a running CRC with the bytes buf[0..len-1]--the CRC should be initialized
- * to all 1's, and the transmitted value is the 1's complement of the final running
- * CRC (see the crc() routine below)).
- */
-uint32_t update_crc(uint32_t crc, unsigned char *buf, int len)
+CFHDDECODER_API CFHD_Error
+CFHD_SetLookCacheCapacity(int capacity)
 {
-    uint32_t c = crc;
+    // Check the input arguments
+    if (capacity < 0)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    LUTCacheSetCapacity(capacity);
+
+    return CFHD_ERROR_OKAY;
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_FlushLookCache(void)
+{
+    LUTCacheFlush();
 
-    if (!crc_table_computed)
-        make_crc_table();
-    for (int n = 0; n < len; n++)
+    return CFHD_ERROR_OKAY;
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_CloseDecoder(CFHD_DecoderRef decoderRef)
+{
+    //CFHD_Error errorCode = CFHD_ERROR_OKAY;
+
+    // Check the input arguments
+    if (decoderRef == NULL)
     {
-        c = crc_table[(c ^ buf[n]) & 0xff] ^ (c >> 8);
+        return CFHD_ERROR_INVALID_ARGUMENT;
     }
 
-    return c;
+    CSampleDecoder *decoder = (CSampleDecoder *)decoderRef;
+
+    delete decoder;
+
+    return CFHD_ERROR_OKAY;
 }
 
-//! Return the CRC of the bytes buf[0..len-1].
-uint32_t calccrc(unsigned char *buf, int len)
+CFHDDECODER_API CFHD_Error
+CFHD_GetSampleChecksum(void *samplePtr,
+                       size_t sampleSize,
+                       uint32_t *checksumOut)
 {
-    return update_crc(0xffffffffL, buf, len) ^ 0xffffffffL;
+    // Check the input arguments
+    if (samplePtr == NULL || sampleSize == 0 || checksumOut == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    *checksumOut = CalculateCRC32C(samplePtr, sampleSize);
+
+    return CFHD_ERROR_OKAY;
 }
 
+
+#include "CFHDMetadata.h"
+#include "SampleMetadata.h"
+#include "../Codec/metadata.h"
+
 CFHDDECODER_API CFHD_Error
 CFHD_SetActiveMetadata(	CFHD_DecoderRef decoderRef,
                         CFHD_MetadataRef metadataRef,
@@ -587,6 +729,9 @@ CFHD_SetActiveMetadata(	CFHD_DecoderRef decoderRef,
     //Hack, pass the decoders custom allocator on to CSampleMetadata
     metadata->SetAllocator(decoder->GetAllocator());
 
+    // Frames decoded with the previous metadata are not returned from the frame cache
+    decoder->ReleaseFrameCache();
+
     //if(metadata->m_overrideSize == 0)
     {
         if (metadata->m_metadataTrack & METADATAFLAG_MODIFIED)
@@ -780,6 +925,7 @@ CFHD_ClearActiveMetadata(CFHD_DecoderRef decoderRef,
     CSampleDecoder *decoder = (CSampleDecoder *)decoderRef;
 
     metadata->FreeDatabase();
+    decoder->ReleaseFrameCache();
 
     return errorCode;
 }
@@ -832,6 +978,52 @@ CFHD_GetThumbnail(CFHD_DecoderRef decoderRef,
     return errorCode;
 }
 
+CFHDDECODER_API CFHD_Error
+CFHD_GetThumbnails(CFHD_DecoderRef decoderRef,
+                   uint32_t sampleCount,
+                   void **samplePtrs,
+                   const size_t *sampleSizes,
+                   void **outputBuffers,
+                   const size_t *outputBufferSizes,
+                   uint32_t flags,
+                   CFHD_Error *errors)
+{
+    // Check the input arguments
+    if (decoderRef == NULL || samplePtrs == NULL || sampleSizes == NULL ||
+            outputBuffers == NULL || outputBufferSizes == NULL || errors == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (sampleCount == 0)
+    {
+        return CFHD_ERROR_OKAY;
+    }
+
+    CSampleDecoder *decoder = reinterpret_cast<CSampleDecoder *>(decoderRef);
+
+    // Samples without a sample or output buffer are skipped
+    for (uint32_t index = 0; index < sampleCount; index++)
+    {
+        errors[index] = CFHD_ERROR_OKAY;
+
+        if (samplePtrs[index] == NULL || sampleSizes[index] == 0 || outputBuffers[index] == NULL)
+        {
+            errors[index] = CFHD_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    // Have the thumbnail flags been set?
+    if (flags == THUMBNAIL_FLAGS_NONE)
+    {
+        // Use the default thumbnail flags
+        flags = THUMBNAIL_FLAGS_DEFAULT;
+    }
+
+    return decoder->GetThumbnails((int)sampleCount, samplePtrs, sampleSizes,
+                                  outputBuffers, outputBufferSizes, flags, errors);
+}
+
 #ifdef __cplusplus
 }
 #endif
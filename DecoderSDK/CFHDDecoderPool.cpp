@@ -0,0 +1,251 @@
+/*! @file CFHDDecoderPool.cpp
+
+*  @brief This module implements the C functions for the asynchronous decoder API.
+*
+*  The asynchronous decoder uses a pool of asynchronous decoders for decoding samples
+*  concurrently.  The decoder pool contains a queue of decoding jobs in the order in
+*  which the samples were submitted.  Each job carries the output buffer supplied by
+*  the caller and decoded frames are removed from the queue in submission order.
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "StdAfx.h"
+
+#if _WIN32 || __APPLE__
+
+// Export the interface to the decoder
+#define DECODERDLL_EXPORTS	1
+
+#endif
+
+// Include files from the codec library
+#include "decoder.h"
+
+// Include files for the decoder DLL
+#include "CFHDDecoder.h"
+#include "IAllocator.h"
+#include "ISampleDecoder.h"
+#include "SampleDecoder.h"
+
+// Include the declarations for the thread pool
+#include "Lock.h"
+#include "Condition.h"
+#include "ThreadMessage.h"
+#include "MessageQueue.h"
+#include "ThreadPool.h"
+
+// Include the declarations for the asynchronous decoder and the decoder pool
+#include "DecoderQueue.h"
+#include "AsyncDecoder.h"
+#include "DecoderPool.h"
+
+
+static CDecoderPool *GetDecoderPool(CFHD_DecoderPoolRef decoderPoolRef)
+{
+    CDecoderPool *decoderPool = reinterpret_cast<CDecoderPool *>(decoderPoolRef);
+    if (decoderPool == NULL)
+    {
+        throw CFHD_ERROR_UNEXPECTED;
+    }
+    return decoderPool;
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_CreateDecoderPool(CFHD_DecoderPoolRef *decoderPoolRefOut,
+                       int decoderThreadCount,
+                       int jobQueueLength,
+                       CFHD_ALLOCATOR *allocator)
+{
+    CDecoderPool *decoderPool = NULL;
+
+    if (decoderPoolRefOut == NULL || decoderThreadCount < 0 || jobQueueLength < 0)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    try
+    {
+        decoderPool = new CDecoderPool(decoderThreadCount, jobQueueLength, allocator);
+        if (decoderPool == NULL)
+        {
+            return CFHD_ERROR_OUTOFMEMORY;
+        }
+
+        *decoderPoolRefOut = reinterpret_cast<CFHD_DecoderPoolRef>(decoderPool);
+
+        return CFHD_ERROR_OKAY;
+    }
+    catch (...)
+    {
+        if (decoderPool != NULL)
+        {
+            delete decoderPool;
+            decoderPool = NULL;
+        }
+
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_GetAsyncOutputFormats(CFHD_DecoderPoolRef decoderPoolRef,
+                           void *samplePtr,
+                           size_t sampleSize,
+                           CFHD_PixelFormat *outputFormatArray,
+                           int outputFormatArrayLength,
+                           int *actualOutputFormatCountOut)
+{
+    try
+    {
+        CDecoderPool *decoderPool = GetDecoderPool(decoderPoolRef);
+        return decoderPool->GetOutputFormats(samplePtr,
+                                             sampleSize,
+                                             outputFormatArray,
+                                             outputFormatArrayLength,
+                                             actualOutputFormatCountOut);
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_PrepareDecoderPool(CFHD_DecoderPoolRef decoderPoolRef,
+                        int outputWidth,
+                        int outputHeight,
+                        CFHD_PixelFormat outputFormat,
+                        CFHD_DecodedResolution decodedResolution,
+                        CFHD_DecodingFlags decodingFlags,
+                        void *samplePtr,
+                        size_t sampleSize,
+                        int *actualWidthOut,
+                        int *actualHeightOut,
+                        CFHD_PixelFormat *actualFormatOut)
+{
+    try
+    {
+        CDecoderPool *decoderPool = GetDecoderPool(decoderPoolRef);
+        return decoderPool->PrepareToDecode(outputWidth,
+                                            outputHeight,
+                                            outputFormat,
+                                            decodedResolution,
+                                            decodingFlags,
+                                            samplePtr,
+                                            sampleSize,
+                                            actualWidthOut,
+                                            actualHeightOut,
+                                            actualFormatOut);
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_StartDecoderPool(CFHD_DecoderPoolRef decoderPoolRef)
+{
+    try
+    {
+        CDecoderPool *decoderPool = GetDecoderPool(decoderPoolRef);
+        return decoderPool->StartDecoders();
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_StopDecoderPool(CFHD_DecoderPoolRef decoderPoolRef)
+{
+    try
+    {
+        CDecoderPool *decoderPool = GetDecoderPool(decoderPoolRef);
+        return decoderPool->StopDecoders();
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_DecodeAsyncSample(CFHD_DecoderPoolRef decoderPoolRef,
+                       uint32_t frameNumber,
+                       void *samplePtr,
+                       size_t sampleSize,
+                       void *outputBuffer,
+                       int32_t outputPitch)
+{
+    try
+    {
+        CDecoderPool *decoderPool = GetDecoderPool(decoderPoolRef);
+        return decoderPool->DecodeSample(frameNumber, samplePtr, sampleSize, outputBuffer, outputPitch);
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_WaitForDecodedFrame(CFHD_DecoderPoolRef decoderPoolRef,
+                         uint32_t *frameNumberOut,
+                         void **outputBufferOut)
+{
+    try
+    {
+        CDecoderPool *decoderPool = GetDecoderPool(decoderPoolRef);
+        return decoderPool->WaitForFrame(frameNumberOut, outputBufferOut);
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_TestForDecodedFrame(CFHD_DecoderPoolRef decoderPoolRef,
+                         uint32_t *frameNumberOut,
+                         void **outputBufferOut)
+{
+    try
+    {
+        CDecoderPool *decoderPool = GetDecoderPool(decoderPoolRef);
+        return decoderPool->TestForFrame(frameNumberOut, outputBufferOut);
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_ReleaseDecoderPool(CFHD_DecoderPoolRef decoderPoolRef)
+{
+    try
+    {
+        CDecoderPool *decoderPool = GetDecoderPool(decoderPoolRef);
+        delete decoderPool;
+        return CFHD_ERROR_OKAY;
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
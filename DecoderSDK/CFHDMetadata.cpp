@@ -38,58 +38,7 @@
 #include "SampleMetadata.h"
 #include "../Codec/metadata.h"
 #include "../Codec/lutpath.h"
-
-//! Table of CRCs of all 8-bit messages.
-static uint32_t crc_table[256];
-
-//! Flag: has the table been computed? Initially false.
-static int crc_table_computed = 0;
-
-//! Make the table for a fast CRC.
-static void make_crc_table(void)
-{
-    uint32_t c;
-    int n, k;
-
-    for (n = 0; n < 256; n++)
-    {
-        c = (uint32_t) n;
-        for (k = 0; k < 8; k++)
-        {
-            if (c & 1)
-                c = 0xedb88320L ^ (c >> 1);
-            else
-                c = c >> 1;
-        }
-        crc_table[n] = c;
-    }
-    crc_table_computed = 1;
-}
-
-/*!
- * Update a running CRC with the bytes buf[0..len-1]--the CRC should be initialized
- * to all 1's, and the transmitted value is the 1's complement of the final running
- * CRC (see the crc() routine below)).
- */
-static uint32_t update_crc(uint32_t crc, unsigned char *buf, int len)
-{
-    uint32_t c = crc;
-
-    if (!crc_table_computed)
-        make_crc_table();
-    for (int n = 0; n < len; n++)
-    {
-        c = crc_table[(c ^ buf[n]) & 0xff] ^ (c >> 8);
-    }
-
-    return c;
-}
-
-//! Return the CRC of the bytes buf[0..len-1].
-static uint32_t calccrc(unsigned char *buf, int len)
-{
-    return update_crc(0xffffffffL, buf, len) ^ 0xffffffffL;
-}
+#include "../Codec/crc.h"
 
 CFHDMETADATA_API CFHD_Error
 CFHD_OpenMetadata(CFHD_MetadataRef *metadataRefOut)
@@ -142,6 +91,9 @@ CFHD_InitSampleMetadata(CFHD_MetadataRef metadataRef,
     metadata->m_currentUFRM = -1;
     metadata->m_CPLastOffset = 0;
 
+    // The metadata in the sample is indexed by the first lookup
+    ResetMetadataIndex(&metadata->m_sampleIndex);
+
     return errorCode;
 }
 
@@ -329,8 +281,7 @@ bool CSampleMetadata::GetClipDatabase()
         METADATA_SIZE size;
         METADATA_TYPE type;
 
-        data = MetaDataFindInSample(m_sampleData, m_sampleSize,
-                                    TAG_CLIP_GUID, &size, &type);
+        data = FindInSample(TAG_CLIP_GUID, &size, &type);
         if (data)
         {
             if (size == sizeof(m_currentClipGUID))
@@ -466,8 +417,7 @@ CFHD_ReadMetadata(CFHD_MetadataRef metadataRef,
             METADATA_TYPE type;
             METADATA_SIZE size;
 
-            data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-                                        TAG_PROCESS_PATH, &size, &type);
+            data = metadata->FindInSample(TAG_PROCESS_PATH, &size, &type);
             if (data)
             {
                 metadata->m_active_mask = *((unsigned int *)data);
@@ -606,8 +556,7 @@ CFHD_ReadMetadata(CFHD_MetadataRef metadataRef,
                         void *data = NULL;
                         METADATA_TYPE type;
                         METADATA_SIZE size;
-                        data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-                                                    TAG_UNIQUE_FRAMENUM, &size, &type);
+                        data = metadata->FindInSample(TAG_UNIQUE_FRAMENUM, &size, &type);
                         if (data)
                         {
                             metadata->m_currentUFRM = *(int *)data;
@@ -770,8 +719,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
                 METADATA_TYPE type;
                 METADATA_SIZE size;
                 //unsigned int tag;
-                data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-                                            TAG_PROCESS_PATH, &size, &type);
+                data = metadata->FindInSample(TAG_PROCESS_PATH, &size, &type);
                 if (data)
                 {
                     metadata->m_active_mask = *((unsigned int *)data);
@@ -809,8 +757,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
 
                 if (metadata->m_sampleData && metadata->m_sampleSize) // which is absolutely should have
                 {
-                    data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-                                                TAG_CLIP_GUID, &size, &type);
+                    data = metadata->FindInSample(TAG_CLIP_GUID, &size, &type);
                     if (data)
                     {
                         if (size == sizeof(metadata->m_currentClipGUID))
@@ -823,7 +770,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
 
             if (tag == TAG_CLIP_HASH)
             {
-                metadata->m_hash =  calccrc((unsigned char *)&metadata->m_currentClipGUID, (int)16);
+                metadata->m_hash =  CalculateCRC32(&metadata->m_currentClipGUID, 16);
             }
 
             if (tag == TAG_SMART_RENDER_OK)
@@ -834,8 +781,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
 
                 if (metadata->m_sampleData && metadata->m_sampleSize) // which is absolutely should have
                 {
-                    data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-                                                TAG_CLIP_GUID, &size, &type);
+                    data = metadata->FindInSample(TAG_CLIP_GUID, &size, &type);
                     if (data)
                     {
                         uint16_t *sptr = (uint16_t *)data;
@@ -860,8 +806,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
             //	OutputDebugString(t);
 
             //fprintf(stdout,"Call MetaDataFindInSample\n");
-            *data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-                                         tag, size, &ctype);
+            *data = metadata->FindInSample(tag, size, &ctype);
             //fprintf(stdout, "Metadata is at %08x\n",*data);
         }
 
@@ -882,7 +827,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
 
                 if (tag == TAG_CLIP_HASH && metadata->m_databaseSize)
                 {
-                    metadata->m_hash ^= calccrc((unsigned char *)metadata->m_databaseData, (int)metadata->m_databaseSize);
+                    metadata->m_hash ^= CalculateCRC32(metadata->m_databaseData, metadata->m_databaseSize);
                 }
                 else if (tag == TAG_CONTROL_POINT)
                 {
@@ -936,8 +881,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
                             void *data = NULL;
                             METADATA_TYPE type;
                             METADATA_SIZE size;
-                            data = MetaDataFindInSample(metadata->m_sampleData, metadata->m_sampleSize,
-                                                        TAG_UNIQUE_FRAMENUM, &size, &type);
+                            data = metadata->FindInSample(TAG_UNIQUE_FRAMENUM, &size, &type);
                             if (data)
                             {
                                 metadata->m_currentUFRM = *(int *)data;
@@ -976,7 +920,7 @@ CFHD_FindMetadata(CFHD_MetadataRef metadataRef,
 
             if (tag == TAG_CLIP_HASH && metadata->m_overrideSize)
             {
-                metadata->m_hash ^= calccrc((unsigned char *)metadata->m_overrideData, (int)metadata->m_overrideSize);
+                metadata->m_hash ^= CalculateCRC32(metadata->m_overrideData, metadata->m_overrideSize);
             }
             else
             {
@@ -1035,6 +979,7 @@ CFHD_CloseMetadata(CFHD_MetadataRef metadataRef)
     CSampleMetadata *metadata = (CSampleMetadata *)metadataRef;
 
     metadata->FreeDatabase();
+    FreeMetadataIndex(&metadata->m_sampleIndex);
     delete metadata;
 
     return CFHD_ERROR_OKAY;
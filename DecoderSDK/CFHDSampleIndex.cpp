@@ -0,0 +1,170 @@
+/*! @file CFHDSampleIndex.cpp
+
+*  @brief This module implements the C functions for random access to raw CineForm streams.
+*
+*  A raw stream is a file of concatenated samples without a container.  The sample
+*  index maps the stream into memory, finds the start and size of each frame, and
+*  returns pointers to the samples that can be passed to the decoder.
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "StdAfx.h"
+
+#if _WIN32 || __APPLE__
+
+// Export the interface to the decoder
+#define DECODERDLL_EXPORTS	1
+
+#endif
+
+// Include files from the codec library
+#include "streamindex.h"
+
+// Include files for the decoder DLL
+#include "CFHDDecoder.h"
+#include "SampleIndex.h"
+
+
+static CSampleIndex *GetSampleIndex(CFHD_SampleIndexRef indexRef)
+{
+    CSampleIndex *sampleIndex = reinterpret_cast<CSampleIndex *>(indexRef);
+    if (sampleIndex == NULL)
+    {
+        throw CFHD_ERROR_UNEXPECTED;
+    }
+    return sampleIndex;
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_OpenSampleIndex(const char *streamPath,
+                     const char *indexPath,
+                     CFHD_ALLOCATOR *allocator,
+                     CFHD_SampleIndexRef *indexRefOut)
+{
+    CSampleIndex *sampleIndex = NULL;
+
+    if (streamPath == NULL || indexRefOut == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    *indexRefOut = NULL;
+
+    try
+    {
+        sampleIndex = new CSampleIndex(allocator);
+        if (sampleIndex == NULL)
+        {
+            return CFHD_ERROR_OUTOFMEMORY;
+        }
+
+        CFHD_Error error = sampleIndex->Open(streamPath, indexPath);
+        if (error != CFHD_ERROR_OKAY)
+        {
+            delete sampleIndex;
+            return error;
+        }
+
+        *indexRefOut = reinterpret_cast<CFHD_SampleIndexRef>(sampleIndex);
+
+        return CFHD_ERROR_OKAY;
+    }
+    catch (...)
+    {
+        if (sampleIndex != NULL)
+        {
+            delete sampleIndex;
+            sampleIndex = NULL;
+        }
+
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_GetSampleIndexCount(CFHD_SampleIndexRef indexRef,
+                         uint32_t *frameCountOut)
+{
+    if (frameCountOut == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    try
+    {
+        CSampleIndex *sampleIndex = GetSampleIndex(indexRef);
+        *frameCountOut = sampleIndex->FrameCount();
+        return CFHD_ERROR_OKAY;
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_GetIndexedSample(CFHD_SampleIndexRef indexRef,
+                      uint32_t frame,
+                      void **samplePtrOut,
+                      size_t *sampleSizeOut,
+                      CFHD_SampleIndexEntry *entryOut)
+{
+    try
+    {
+        CSampleIndex *sampleIndex = GetSampleIndex(indexRef);
+        return sampleIndex->GetSample(frame, samplePtrOut, sampleSizeOut, entryOut);
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_SeekSampleIndex(CFHD_SampleIndexRef indexRef,
+                     uint32_t frame,
+                     uint32_t *keyFrameOut)
+{
+    if (keyFrameOut == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    try
+    {
+        CSampleIndex *sampleIndex = GetSampleIndex(indexRef);
+        return sampleIndex->Seek(frame, keyFrameOut);
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
+
+CFHDDECODER_API CFHD_Error
+CFHD_CloseSampleIndex(CFHD_SampleIndexRef indexRef)
+{
+    try
+    {
+        CSampleIndex *sampleIndex = GetSampleIndex(indexRef);
+        delete sampleIndex;
+        return CFHD_ERROR_OKAY;
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+}
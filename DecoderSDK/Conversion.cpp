@@ -358,6 +358,47 @@ bail:
     return error;
 }
 
+// Return the layout of the decoded formats that are scaled without changing the pixel format
+static bool GetScaledPixelLayout(int inputFormat, CFHD_PixelFormat outputFormat,
+                                 int *componentCountOut, int *componentSizeOut)
+{
+    static const struct
+    {
+        int inputFormat;
+        CFHD_PixelFormat outputFormat;
+        int componentCount;
+        int componentSize;
+    }
+    layoutTable[] =
+    {
+        {DECODED_FORMAT_B64A, CFHD_PIXEL_FORMAT_B64A, 4, 2},
+        {DECODED_FORMAT_RG48, CFHD_PIXEL_FORMAT_RG48, 3, 2},
+        {DECODED_FORMAT_RGB32, CFHD_PIXEL_FORMAT_BGRA, 4, 1},
+        {DECODED_FORMAT_RGB32_INVERTED, CFHD_PIXEL_FORMAT_BGRa, 4, 1},
+        {DECODED_FORMAT_RGB24, CFHD_PIXEL_FORMAT_RG24, 3, 1},
+    };
+
+    const int tableLength = sizeof(layoutTable) / sizeof(layoutTable[0]);
+
+    for (int index = 0; index < tableLength; index++)
+    {
+        if (layoutTable[index].inputFormat == inputFormat &&
+                layoutTable[index].outputFormat == outputFormat)
+        {
+            if (componentCountOut) *componentCountOut = layoutTable[index].componentCount;
+            if (componentSizeOut) *componentSizeOut = layoutTable[index].componentSize;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool IsScaledOutputFormat(int inputFormat, CFHD_PixelFormat outputFormat)
+{
+    return GetScaledPixelLayout(inputFormat, outputFormat, NULL, NULL);
+}
+
 // Scale the input image to fit the dimensions of the output image
 CFHD_Error ScaleToOutputBuffer(void *inputBuffer, int inputWidth, int inputHeight,
                                int inputPitch, int inputFormat,
@@ -370,7 +411,22 @@ CFHD_Error ScaleToOutputBuffer(void *inputBuffer, int inputWidth, int inputHeigh
     // Use the memory allocator provided by ConvertLib
     CMemAlloc allocator;
 
-    if (inputFormat == DECODED_FORMAT_YU64)
+    int componentCount;
+    int componentSize;
+
+    if (GetScaledPixelLayout(inputFormat, outputFormat, &componentCount, &componentSize))
+    {
+        // Scale the decoded frame in strips of output rows without changing the pixel format
+        CImageScalerStrip scaler(&allocator);
+
+        if (!scaler.ScaleImage((unsigned char *)inputBuffer, inputWidth, inputHeight, inputPitch,
+                               (unsigned char *)outputBuffer, outputWidth, outputHeight, outputPitch,
+                               componentCount, componentSize))
+        {
+            error = CFHD_ERROR_OUTOFMEMORY;
+        }
+    }
+    else if (inputFormat == DECODED_FORMAT_YU64)
     {
         // Allocate and initialize an image scaler with color conversion
         CImageScalerConverterYU64ToRGB scaler(&allocator);
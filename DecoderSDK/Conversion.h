@@ -92,6 +92,9 @@ CFHD_Error ConvertToOutputBuffer(void *inputBuffer, int inputPitch, int inputFor
                                  void *outputBuffer, int outputPitch, CFHD_PixelFormat outputFormat,
                                  int width, int height, int byte_swap_flag);
 
+// Return true if the decoded format can be scaled into the output format without conversion
+bool IsScaledOutputFormat(int inputFormat, CFHD_PixelFormat outputFormat);
+
 // Scale the input image to fit the dimensions of the output image
 CFHD_Error ScaleToOutputBuffer(void *inputBuffer, int inputWidth, int inputHeight,
                                int inputPitch, int inputFormat,
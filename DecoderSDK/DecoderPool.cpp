@@ -0,0 +1,371 @@
+/*! @file DecoderPool.cpp
+
+*  @brief Pool of asynchronous decoders that deliver decoded frames in order
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "StdAfx.h"
+
+// Include files from the codec library
+#include "decoder.h"
+#include "cpuid.h"
+
+// Include files for the decoder DLL
+#include "CFHDDecoder.h"
+#include "IAllocator.h"
+#include "ISampleDecoder.h"
+#include "SampleDecoder.h"
+
+// Include the declarations for the thread pool
+#include "Lock.h"
+#include "Condition.h"
+#include "ThreadMessage.h"
+#include "MessageQueue.h"
+#include "ThreadPool.h"
+
+// Include the declarations for the asynchronous decoder and the decoder pool
+#include "DecoderQueue.h"
+#include "AsyncDecoder.h"
+#include "DecoderPool.h"
+
+
+// Use one asynchronous decoder per processor if the thread count is not specified
+static size_t DecoderThreadCount(size_t decoderThreadCount)
+{
+    if (decoderThreadCount == 0)
+    {
+        int processorCount = GetProcessorCount();
+        decoderThreadCount = (processorCount > 0) ? processorCount : 1;
+    }
+
+    return decoderThreadCount;
+}
+
+CDecoderPool::CDecoderPool(size_t decoderThreadCount,
+                           size_t decoderJobQueueSize,
+                           CFHD_ALLOCATOR *allocator) :
+    m_decoderJobQueue(decoderJobQueueSize),
+    m_decoderList(DecoderThreadCount(decoderThreadCount), this, allocator),
+    m_decodingStarted(false),
+    m_decodingPrepared(false),
+    m_decoderIndex(0)
+{
+    // Divide the processors between the decoders so that the total number of threads is bounded
+    int processorCount = GetProcessorCount();
+    int decoderCount = (int)m_decoderList.size();
+    int threadLimit = (decoderCount > 0) ? processorCount / decoderCount : 0;
+    if (threadLimit < 1)
+    {
+        threadLimit = 1;
+    }
+
+    for (AsyncDecoderList::iterator p = m_decoderList.begin();
+            p != m_decoderList.end();
+            p++)
+    {
+        (*p)->SetThreadLimit(threadLimit);
+    }
+}
+
+CDecoderPool::~CDecoderPool()
+{
+    StopDecoders();
+
+    // The pool of asynchronous decoders will be deallocated automatically
+    // The decoder job queue will be deallocated automatically
+}
+
+/*!
+	@brief Return a list of output formats in decreasing order of preference
+
+	Since all of the asynchronous decoders are identical, the first decoder
+	is used to process this request.
+*/
+CFHD_Error CDecoderPool::GetOutputFormats(void *samplePtr,
+        size_t sampleSize,
+        CFHD_PixelFormat *outputFormatArray,
+        int outputFormatArrayLength,
+        int *actualOutputFormatCountOut)
+{
+    if (m_decoderList.size() == 0)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+
+    return m_decoderList[0]->GetOutputFormats(samplePtr,
+            sampleSize,
+            outputFormatArray,
+            outputFormatArrayLength,
+            actualOutputFormatCountOut);
+}
+
+/*!
+	@brief Prepare each of the decoders in the pool for decoding
+
+	The decoders cannot be changed while the worker threads are running,
+	so the pool must be stopped before it can be prepared again.
+*/
+CFHD_Error CDecoderPool::PrepareToDecode(int outputWidth,
+        int outputHeight,
+        CFHD_PixelFormat outputFormat,
+        CFHD_DecodedResolution decodedResolution,
+        CFHD_DecodingFlags decodingFlags,
+        void *samplePtr,
+        size_t sampleSize,
+        int *actualWidthOut,
+        int *actualHeightOut,
+        CFHD_PixelFormat *actualFormatOut)
+{
+    CFHD_Error error = CFHD_ERROR_OKAY;
+
+    if (m_decodingStarted)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+
+    if (m_decoderList.size() == 0)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+
+    m_decodingPrepared = false;
+
+    // Initialize each of the decoders
+    for (AsyncDecoderList::iterator p = m_decoderList.begin();
+            p != m_decoderList.end();
+            p++)
+    {
+        int actualWidth = 0;
+        int actualHeight = 0;
+        CFHD_PixelFormat actualFormat = CFHD_PIXEL_FORMAT_UNKNOWN;
+
+        error = (*p)->PrepareDecoder(outputWidth,
+                                     outputHeight,
+                                     outputFormat,
+                                     decodedResolution,
+                                     decodingFlags,
+                                     samplePtr,
+                                     sampleSize,
+                                     &actualWidth,
+                                     &actualHeight,
+                                     &actualFormat);
+        if (error != CFHD_ERROR_OKAY)
+        {
+            return error;
+        }
+
+        // All of the decoders have the same output dimensions and format
+        if (p == m_decoderList.begin())
+        {
+            if (actualWidthOut != NULL)
+            {
+                *actualWidthOut = actualWidth;
+            }
+            if (actualHeightOut != NULL)
+            {
+                *actualHeightOut = actualHeight;
+            }
+            if (actualFormatOut != NULL)
+            {
+                *actualFormatOut = actualFormat;
+            }
+        }
+    }
+
+    m_decodingPrepared = true;
+
+    return CFHD_ERROR_OKAY;
+}
+
+//! Start the decoder worker threads
+CFHD_Error CDecoderPool::StartDecoders()
+{
+    if (m_decodingStarted || !m_decodingPrepared)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+
+    // Start the worker thread for each decoder in the pool
+    for (AsyncDecoderList::iterator p = m_decoderList.begin();
+            p != m_decoderList.end();
+            p++)
+    {
+        CFHD_Error error = CFHD_ERROR_OKAY;
+        CAsyncDecoder *decoder = (*p);
+        void *param = reinterpret_cast<void *>(decoder);
+
+        error = decoder->Start(param);
+        if (error != CFHD_ERROR_OKAY)
+        {
+            // Stop the worker threads that were started
+            for (AsyncDecoderList::iterator q = m_decoderList.begin(); q != p; q++)
+            {
+                (*q)->Stop();
+                (*q)->Wait();
+            }
+            return error;
+        }
+    }
+
+    m_decodingStarted = true;
+
+    return CFHD_ERROR_OKAY;
+}
+
+/*!
+	@brief Stop the decoder worker threads
+
+	The stop message is queued after the jobs that have already been assigned
+	to each decoder, so every submitted sample is decoded before the threads
+	terminate and the decoded frames can still be retrieved from the pool.
+*/
+CFHD_Error CDecoderPool::StopDecoders()
+{
+    if (!m_decodingStarted)
+    {
+        return CFHD_ERROR_OKAY;
+    }
+
+    // Send stop messages to all of the asynchronous decoders
+    for (AsyncDecoderList::iterator p = m_decoderList.begin();
+            p != m_decoderList.end();
+            p++)
+    {
+        (*p)->Stop();
+    }
+
+    // Wait for the asynchronous decoders to terminate
+    for (AsyncDecoderList::iterator p = m_decoderList.begin();
+            p != m_decoderList.end();
+            p++)
+    {
+        (*p)->Wait();
+    }
+
+    m_decodingStarted = false;
+
+    return CFHD_ERROR_OKAY;
+}
+
+/*!
+	@brief Submit a sample for decoding into the output buffer
+
+	The call blocks if the job queue is full until a decoded frame is removed
+	from the queue.  The sample and the output buffer must remain valid until
+	the decoded frame has been returned by @ref WaitForFrame or @ref TestForFrame.
+*/
+CFHD_Error CDecoderPool::DecodeSample(uint32_t frameNumber,
+                                      void *samplePtr,
+                                      size_t sampleSize,
+                                      void *outputBuffer,
+                                      int32_t outputPitch)
+{
+    CFHD_Error error = CFHD_ERROR_OKAY;
+
+    if (!m_decodingStarted)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+
+    if (samplePtr == NULL || sampleSize == 0 || outputBuffer == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Create a new decoder job
+    DecoderJob *job = new DecoderJob(frameNumber, samplePtr, sampleSize, outputBuffer, outputPitch);
+    if (job == NULL)
+    {
+        return CFHD_ERROR_OUTOFMEMORY;
+    }
+
+    // Add the new job to the end of the decoder job queue
+    error = m_decoderJobQueue.AddDecoderJob(job);
+    if (error != CFHD_ERROR_OKAY)
+    {
+        delete job;
+        return error;
+    }
+
+    // The other frames in a group are decoded by the decoder that decoded the key frame
+    if (IsSampleKeyFrame((uint8_t *)samplePtr, sampleSize))
+    {
+        // Advance to the next decoder
+        m_decoderIndex = (m_decoderIndex + 1) % m_decoderList.size();
+    }
+    assert(m_decoderIndex < m_decoderList.size());
+
+    // Add the job to the message queue for the asynchronous decoder
+    DecoderMessage message(job);
+    return m_decoderList[m_decoderIndex]->SendMessage(message);
+}
+
+//! Wait until the next decoded frame is ready
+CFHD_Error CDecoderPool::WaitForFrame(uint32_t *frameNumberOut,
+                                      void **outputBufferOut)
+{
+    // The jobs already in the queue are always decoded, even if the pool is stopped
+    DecoderJob *job = m_decoderJobQueue.WaitForFinishedJob();
+    if (job == NULL)
+    {
+        // There are no samples waiting to be decoded
+        return CFHD_ERROR_UNEXPECTED;
+    }
+
+    return ReturnFinishedJob(job, frameNumberOut, outputBufferOut);
+}
+
+//! Test whether the next decoded frame is ready
+CFHD_Error CDecoderPool::TestForFrame(uint32_t *frameNumberOut,
+                                      void **outputBufferOut)
+{
+    DecoderJob *job = m_decoderJobQueue.TestForFinishedJob();
+    if (job == NULL)
+    {
+        return CFHD_ERROR_NOT_FINISHED;
+    }
+
+    return ReturnFinishedJob(job, frameNumberOut, outputBufferOut);
+}
+
+/*!
+	@brief Return the decoded frame and error code from a finished job
+
+	The frame number and output buffer are returned even if the sample could
+	not be decoded so that the caller can reclaim the output buffer.
+*/
+CFHD_Error CDecoderPool::ReturnFinishedJob(DecoderJob *job,
+        uint32_t *frameNumberOut,
+        void **outputBufferOut)
+{
+    assert(job->status == DECODER_JOB_STATUS_FINISHED);
+
+    if (frameNumberOut != NULL)
+    {
+        *frameNumberOut = job->frameNumber;
+    }
+
+    if (outputBufferOut != NULL)
+    {
+        *outputBufferOut = job->outputBuffer;
+    }
+
+    CFHD_Error error = job->error;
+
+    // Free the decoder job and return
+    delete job;
+    return error;
+}
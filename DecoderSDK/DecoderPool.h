@@ -0,0 +1,148 @@
+/*! @file DecoderPool.h
+
+*  @brief Pool of asynchronous decoders that deliver decoded frames in order
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#pragma once
+
+/*!
+	@brief List of asynchronous decoders managed by the decoder pool
+*/
+class AsyncDecoderList : public std::vector<CAsyncDecoder *>
+{
+public:
+
+    AsyncDecoderList(size_t length, CDecoderPool *pool, CFHD_ALLOCATOR *allocator = NULL)
+    {
+        for (size_t index = 0; index < length; index++)
+        {
+            CAsyncDecoder *decoder = new CAsyncDecoder(pool, allocator);
+            assert(decoder);
+            if (decoder)
+            {
+                push_back(decoder);
+            }
+        }
+    }
+
+    ~AsyncDecoderList()
+    {
+        // Delete all of the asynchronous decoders in the list
+        for (iterator p = begin(); p != end(); p++)
+        {
+            delete *p;
+        }
+    }
+};
+
+/*! @class CDecoderPool
+
+	@brief Manager of a pool of asynchronous decoders
+
+	This class is the decoding counterpart of the encoder pool.  Each
+	asynchronous decoder has its own worker thread and message queue.
+	Every sample submitted to the pool is recorded in the queue of
+	decoder jobs and sent to one of the asynchronous decoders, which
+	decodes the sample into the output buffer supplied with the job.
+
+	Key frames are sent to the asynchronous decoders in round robin order
+	and the other samples in a group of frames are sent to the decoder that
+	received the key frame, since the decoder keeps the state of the group.
+
+	Decoded frames are returned in the order in which the samples were
+	submitted to the pool.  Each decoder limits the number of threads that
+	it uses within a frame so that the decoders in the pool share the
+	processors instead of oversubscribing them.
+*/
+class CDecoderPool
+{
+    //! Queue of decoder jobs in submission order
+    DecoderJobQueue m_decoderJobQueue;
+
+    //! Pool of asynchronous decoders that can decode samples concurrently
+    AsyncDecoderList m_decoderList;
+
+    //! True if the worker threads in the asynchronous decoders are running
+    bool m_decodingStarted;
+
+    //! True if the decoders have been prepared for decoding
+    bool m_decodingPrepared;
+
+    //! Index of the asynchronous decoder that received the most recent key frame
+    size_t m_decoderIndex;
+
+public:
+
+    CDecoderPool(size_t decoderThreadCount,
+                 size_t decoderJobQueueSize,
+                 CFHD_ALLOCATOR *allocator = NULL);
+
+    ~CDecoderPool();
+
+    //! Return a list of output formats in decreasing order of preference
+    CFHD_Error GetOutputFormats(void *samplePtr,
+                                size_t sampleSize,
+                                CFHD_PixelFormat *outputFormatArray,
+                                int outputFormatArrayLength,
+                                int *actualOutputFormatCountOut);
+
+    //! Prepare each of the decoders in the pool for decoding
+    CFHD_Error PrepareToDecode(int outputWidth,
+                               int outputHeight,
+                               CFHD_PixelFormat outputFormat,
+                               CFHD_DecodedResolution decodedResolution,
+                               CFHD_DecodingFlags decodingFlags,
+                               void *samplePtr,
+                               size_t sampleSize,
+                               int *actualWidthOut,
+                               int *actualHeightOut,
+                               CFHD_PixelFormat *actualFormatOut);
+
+    //! Start the asynchronous decoder worker threads
+    CFHD_Error StartDecoders();
+
+    //! Stop the asynchronous decoder worker threads
+    CFHD_Error StopDecoders();
+
+    //! Submit a sample for decoding into the output buffer
+    CFHD_Error DecodeSample(uint32_t frameNumber,
+                            void *samplePtr,
+                            size_t sampleSize,
+                            void *outputBuffer,
+                            int32_t outputPitch);
+
+    //! Wait until the next decoded frame is ready
+    CFHD_Error WaitForFrame(uint32_t *frameNumberOut,
+                            void **outputBufferOut);
+
+    //! Test whether the next decoded frame is ready
+    CFHD_Error TestForFrame(uint32_t *frameNumberOut,
+                            void **outputBufferOut);
+
+    //! Signal that a decoder job has finished
+    void SignalJobFinished(DecoderJob *job, CFHD_Error error)
+    {
+        m_decoderJobQueue.FinishJob(job, error);
+    }
+
+protected:
+
+    //! Return the decoded frame and error code from a finished job and free the job
+    CFHD_Error ReturnFinishedJob(DecoderJob *job,
+                                 uint32_t *frameNumberOut,
+                                 void **outputBufferOut);
+};
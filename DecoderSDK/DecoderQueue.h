@@ -0,0 +1,274 @@
+/*! @file DecoderQueue.h
+
+*  @brief Declaration of decoder jobs and the job queue for asynchronous decoders
+*
+*  Each asynchronous decoder has a message queue.  The decoder pool creates a decoder
+*  job for each decoding request and adds the decoder job to the message queue for the
+*  asynchronous decoder that is assigned to decode the sample.
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#pragma once
+
+/*!
+	@brief Status of a decoder job
+
+	Every decoder job is waiting to be assigned to a decoder, has been
+	assigned to a decoder, or the sample has been decoded into the output
+	buffer and the frame is ready to be delivered.
+*/
+enum DecoderJobStatus
+{
+    DECODER_JOB_STATUS_UNKNOWN = 0,		//!< Decoder job status is not known
+    DECODER_JOB_STATUS_UNASSIGNED,		//!< Job has not been assigned to a decoder
+    DECODER_JOB_STATUS_DECODING,		//!< Decoding is in progress
+    DECODER_JOB_STATUS_FINISHED,		//!< The decoded frame is ready
+};
+
+/*!
+	@brief Data structure for a decoder job
+
+	The encoded sample and the output buffer belong to the caller and must
+	remain valid until the decoded frame has been returned by the pool.
+*/
+struct DecoderJob
+{
+    DecoderJob() :
+        status(DECODER_JOB_STATUS_UNKNOWN),
+        error(CFHD_ERROR_OKAY),
+        frameNumber(0),
+        samplePtr(NULL),
+        sampleSize(0),
+        outputBuffer(NULL),
+        outputPitch(0)
+    {
+    }
+
+    DecoderJob(uint32_t frameNumber,
+               void *samplePtr,
+               size_t sampleSize,
+               void *outputBuffer,
+               int32_t outputPitch) :
+        status(DECODER_JOB_STATUS_UNASSIGNED),
+        error(CFHD_ERROR_OKAY),
+        frameNumber(frameNumber),
+        samplePtr(samplePtr),
+        sampleSize(sampleSize),
+        outputBuffer(outputBuffer),
+        outputPitch(outputPitch)
+    {
+    }
+
+    DecoderJobStatus status;			//!< Status of the decoding job
+    CFHD_Error error;					//!< Error code from the sample decoder
+    uint32_t frameNumber;				//!< Frame number that identifies the decoding job
+    void *samplePtr;					//!< Address of the encoded sample
+    size_t sampleSize;					//!< Size of the encoded sample (in bytes)
+    void *outputBuffer;					//!< Buffer that receives the decoded frame
+    int32_t outputPitch;				//!< Pitch of the output buffer (in bytes)
+};
+
+/*!
+	@class DecoderJobQueue
+
+	@brief Queue of decoder jobs in the order in which the samples were submitted
+
+	Decoded frames are removed from the front of the queue, so frames are
+	always delivered in submission order even though the asynchronous decoders
+	may finish the jobs out of order.
+*/
+class DecoderJobQueue
+{
+protected:
+    typedef std::deque<DecoderJob *> JobQueue;
+    static const size_t DEFAULT_QUEUE_LENGTH = 16;
+
+public:
+    DecoderJobQueue(size_t length) :
+        available(length)
+    {
+        if (! (length > 0))
+        {
+            available = DEFAULT_QUEUE_LENGTH;
+        }
+    }
+
+    ~DecoderJobQueue()
+    {
+        // Delete all of the jobs in the queue
+        while (!queue.empty())
+        {
+            DecoderJob *job = queue.front();
+            queue.pop_front();
+            delete job;
+        }
+    }
+
+    //! Add a decoding job to the end of the queue
+    CFHD_Error AddDecoderJob(DecoderJob *job)
+    {
+        // Available space in the decoder job queue?
+        CAutoLock lock(mutex);
+        while (available == 0)
+        {
+            // Wait until there is space in the queue
+            space.Wait(mutex);
+        }
+        assert(available > 0);
+
+        // Add the decoder job to the end of the queue
+        job->status = DECODER_JOB_STATUS_DECODING;
+        queue.push_back(job);
+        available--;
+
+        return CFHD_ERROR_OKAY;
+    }
+
+    //! Remove the oldest job from the queue after it has finished (NULL if the queue is empty)
+    DecoderJob *WaitForFinishedJob()
+    {
+        CAutoLock lock(mutex);
+        if (queue.empty())
+        {
+            return NULL;
+        }
+
+        while (queue.front()->status != DECODER_JOB_STATUS_FINISHED)
+        {
+            // Wait until the oldest decoding job has finished
+            ready.Wait(mutex);
+        }
+
+        return RemoveFinishedJob();
+    }
+
+    //! Remove the oldest job from the queue if it has finished
+    DecoderJob *TestForFinishedJob()
+    {
+        CAutoLock lock(mutex);
+        if (queue.empty() || queue.front()->status != DECODER_JOB_STATUS_FINISHED)
+        {
+            return NULL;
+        }
+
+        return RemoveFinishedJob();
+    }
+
+    //! Record the result of a decoding job and wake the thread waiting for frames
+    void FinishJob(DecoderJob *job, CFHD_Error error)
+    {
+        // The status must be changed while holding the lock so that the wakeup is not lost
+        CAutoLock lock(mutex);
+        job->error = error;
+        job->status = DECODER_JOB_STATUS_FINISHED;
+        ready.Wake();
+    }
+
+    //! Return true if there are no jobs in the queue
+    bool IsEmpty()
+    {
+        CAutoLock lock(mutex);
+        return queue.empty();
+    }
+
+private:
+
+    //! Called with the lock held after the oldest job has finished
+    DecoderJob *RemoveFinishedJob()
+    {
+        DecoderJob *job = queue.front();
+        queue.pop_front();
+
+        // Increase the amount of space in the decoder job queue
+        available++;
+        space.Wake();
+
+        return job;
+    }
+
+    //! Array of decoder jobs in the queue
+    JobQueue queue;
+
+    //! Amount of available space in the decoder job queue
+    size_t available;
+
+    //! Wait until space is available in the decoder job queue
+    ConditionVariable space;
+
+    //! Wait until the next decoder job in the queue has finished
+    ConditionVariable ready;
+
+    //! Exclusive access to the decoder job queue
+    CSimpleLock mutex;
+};
+
+/*!
+	@brief Definition of the payload of messages sent to a decoder
+
+	The decoder message contains a pointer to the decoder job that
+	specifies the sample to be decoded.
+*/
+class DecoderMessage : public ThreadMessage
+{
+public:
+
+    DecoderMessage() :
+        ThreadMessage(ThreadMessage::THREAD_COMMAND_NULL),
+        decoderJob(NULL)
+    {
+    }
+
+    DecoderMessage(ThreadMessage::ThreadCommand command) :
+        ThreadMessage(command),
+        decoderJob(NULL)
+    {
+    }
+
+    DecoderMessage(DecoderJob *job) :
+        ThreadMessage(THREAD_COMMAND_DECODE),
+        decoderJob(job)
+    {
+    }
+
+    // Must define a copy constructor for this class and the base class
+    DecoderMessage(const DecoderMessage &message) :
+        ThreadMessage(message),
+        decoderJob(message.decoderJob)
+    {
+    }
+
+    // Must define an assignment operator for this class and the base class
+    const DecoderMessage &operator= (const DecoderMessage &message)
+    {
+        if (&message != this)
+        {
+            decoderJob = message.decoderJob;
+            ThreadMessage::operator=(message);
+        }
+        return *this;
+    }
+
+    DecoderJob *Job()
+    {
+        return decoderJob;
+    }
+
+private:
+    DecoderJob *decoderJob;
+};
+
+//! Each asynchronous decoder has its own message queue
+typedef class MessageQueue<DecoderMessage> CDecoderMessageQueue;
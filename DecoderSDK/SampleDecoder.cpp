@@ -58,6 +58,7 @@
 #include "decoder.h"
 #include "thumbnail.h"
 #include "metadata.h"
+#include "cpuid.h"
 
 // Include files for the encoder DLL
 #include "CFHDDecoder.h"
@@ -66,6 +67,28 @@
 #include "SampleDecoder.h"
 #include "Conversion.h"
 
+// Include the declarations for the decoder pool used by the pipelined mode
+#include "Lock.h"
+#include "Condition.h"
+#include "ThreadMessage.h"
+#include "MessageQueue.h"
+#include "ThreadPool.h"
+#include "DecoderQueue.h"
+#include "AsyncDecoder.h"
+#include "DecoderPool.h"
+
+// Number of decoders that decode prefetched samples concurrently in the pipelined mode
+#define SAMPLE_PIPELINE_DECODERS	2
+
+// Maximum number of prefetched samples that have not been decoded
+#define SAMPLE_PIPELINE_LENGTH		4
+
+// Batches of frames with no more pixels than this are decoded in parallel across samples
+#define SAMPLE_BATCH_MAX_PIXELS		(1280 * 720)
+
+// Number of samples in a batch that are submitted to each decoder before waiting for frames
+#define SAMPLE_BATCH_JOBS_PER_DECODER	2
+
 typedef struct decodedFormatKey
 {
     CFHD_PixelFormat outputFormat;		// The requested output pixel format
@@ -192,6 +215,63 @@ static struct decodedFormatEntry
     {{CFHD_PIXEL_FORMAT_CT_10BIT_2_8, ENCODED_FORMAT_RGBA_4444}, DECODED_FORMAT_YU64, 4},		// av28
     {{CFHD_PIXEL_FORMAT_CT_10BIT_2_8, ENCODED_FORMAT_BAYER}, DECODED_FORMAT_YU64, 4},			// av28
 
+    // YUV 4:2:0 formats are produced from the rows output by the inverse transform
+    {{CFHD_PIXEL_FORMAT_NV12, ENCODED_FORMAT_YUV_422},	 DECODED_FORMAT_NV12, 1},	// NV12
+    {{CFHD_PIXEL_FORMAT_NV12, ENCODED_FORMAT_RGB_444},	 DECODED_FORMAT_NV12, 1},	// NV12
+    {{CFHD_PIXEL_FORMAT_NV12, ENCODED_FORMAT_RGBA_4444}, DECODED_FORMAT_NV12, 1},	// NV12
+    {{CFHD_PIXEL_FORMAT_NV12, ENCODED_FORMAT_BAYER},	 DECODED_FORMAT_NV12, 1},	// NV12
+
+    {{CFHD_PIXEL_FORMAT_YV12, ENCODED_FORMAT_YUV_422},	 DECODED_FORMAT_YV12, 1},	// YV12
+    {{CFHD_PIXEL_FORMAT_YV12, ENCODED_FORMAT_RGB_444},	 DECODED_FORMAT_YV12, 1},	// YV12
+    {{CFHD_PIXEL_FORMAT_YV12, ENCODED_FORMAT_RGBA_4444}, DECODED_FORMAT_YV12, 1},	// YV12
+    {{CFHD_PIXEL_FORMAT_YV12, ENCODED_FORMAT_BAYER},	 DECODED_FORMAT_YV12, 1},	// YV12
+
+    // Planar formats with 16-bit components are produced from the rows output by the inverse transform
+    {{CFHD_PIXEL_FORMAT_P010, ENCODED_FORMAT_YUV_422},	 DECODED_FORMAT_P010, 2},	// P010
+    {{CFHD_PIXEL_FORMAT_P010, ENCODED_FORMAT_RGB_444},	 DECODED_FORMAT_P010, 2},	// P010
+    {{CFHD_PIXEL_FORMAT_P010, ENCODED_FORMAT_RGBA_4444}, DECODED_FORMAT_P010, 2},	// P010
+    {{CFHD_PIXEL_FORMAT_P010, ENCODED_FORMAT_BAYER},	 DECODED_FORMAT_P010, 2},	// P010
+
+    {{CFHD_PIXEL_FORMAT_P016, ENCODED_FORMAT_YUV_422},	 DECODED_FORMAT_P016, 2},	// P016
+    {{CFHD_PIXEL_FORMAT_P016, ENCODED_FORMAT_RGB_444},	 DECODED_FORMAT_P016, 2},	// P016
+    {{CFHD_PIXEL_FORMAT_P016, ENCODED_FORMAT_RGBA_4444}, DECODED_FORMAT_P016, 2},	// P016
+    {{CFHD_PIXEL_FORMAT_P016, ENCODED_FORMAT_BAYER},	 DECODED_FORMAT_P016, 2},	// P016
+
+    {{CFHD_PIXEL_FORMAT_P210, ENCODED_FORMAT_YUV_422},	 DECODED_FORMAT_P210, 2},	// P210
+    {{CFHD_PIXEL_FORMAT_P210, ENCODED_FORMAT_RGB_444},	 DECODED_FORMAT_P210, 2},	// P210
+    {{CFHD_PIXEL_FORMAT_P210, ENCODED_FORMAT_RGBA_4444}, DECODED_FORMAT_P210, 2},	// P210
+    {{CFHD_PIXEL_FORMAT_P210, ENCODED_FORMAT_BAYER},	 DECODED_FORMAT_P210, 2},	// P210
+
+    {{CFHD_PIXEL_FORMAT_P216, ENCODED_FORMAT_YUV_422},	 DECODED_FORMAT_P216, 2},	// P216
+    {{CFHD_PIXEL_FORMAT_P216, ENCODED_FORMAT_RGB_444},	 DECODED_FORMAT_P216, 2},	// P216
+    {{CFHD_PIXEL_FORMAT_P216, ENCODED_FORMAT_RGBA_4444}, DECODED_FORMAT_P216, 2},	// P216
+    {{CFHD_PIXEL_FORMAT_P216, ENCODED_FORMAT_BAYER},	 DECODED_FORMAT_P216, 2},	// P216
+
+    {{CFHD_PIXEL_FORMAT_GBRP16, ENCODED_FORMAT_YUV_422},	 DECODED_FORMAT_GBRP16, 2},	// GBRP16
+    {{CFHD_PIXEL_FORMAT_GBRP16, ENCODED_FORMAT_RGB_444},	 DECODED_FORMAT_GBRP16, 2},	// GBRP16
+    {{CFHD_PIXEL_FORMAT_GBRP16, ENCODED_FORMAT_RGBA_4444}, DECODED_FORMAT_GBRP16, 2},	// GBRP16
+    {{CFHD_PIXEL_FORMAT_GBRP16, ENCODED_FORMAT_BAYER},	 DECODED_FORMAT_GBRP16, 2},	// GBRP16
+
+    {{CFHD_PIXEL_FORMAT_GBRAP16, ENCODED_FORMAT_YUV_422},	 DECODED_FORMAT_GBRAP16, 2},	// GBRAP16
+    {{CFHD_PIXEL_FORMAT_GBRAP16, ENCODED_FORMAT_RGB_444},	 DECODED_FORMAT_GBRAP16, 2},	// GBRAP16
+    {{CFHD_PIXEL_FORMAT_GBRAP16, ENCODED_FORMAT_RGBA_4444}, DECODED_FORMAT_GBRAP16, 2},	// GBRAP16
+    {{CFHD_PIXEL_FORMAT_GBRAP16, ENCODED_FORMAT_BAYER},	 DECODED_FORMAT_GBRAP16, 2},	// GBRAP16
+
+    {{CFHD_PIXEL_FORMAT_RGBA_HALF, ENCODED_FORMAT_YUV_422},	 DECODED_FORMAT_RGBA_HALF, 8},	// RGBA_HALF
+    {{CFHD_PIXEL_FORMAT_RGBA_HALF, ENCODED_FORMAT_RGB_444},	 DECODED_FORMAT_RGBA_HALF, 8},	// RGBA_HALF
+    {{CFHD_PIXEL_FORMAT_RGBA_HALF, ENCODED_FORMAT_RGBA_4444}, DECODED_FORMAT_RGBA_HALF, 8},	// RGBA_HALF
+    {{CFHD_PIXEL_FORMAT_RGBA_HALF, ENCODED_FORMAT_BAYER},		 DECODED_FORMAT_RGBA_HALF, 8},	// RGBA_HALF
+
+    {{CFHD_PIXEL_FORMAT_RGBA_FLOAT, ENCODED_FORMAT_YUV_422},	 DECODED_FORMAT_RGBA_FLOAT, 16},	// RGBA_FLOAT
+    {{CFHD_PIXEL_FORMAT_RGBA_FLOAT, ENCODED_FORMAT_RGB_444},	 DECODED_FORMAT_RGBA_FLOAT, 16},	// RGBA_FLOAT
+    {{CFHD_PIXEL_FORMAT_RGBA_FLOAT, ENCODED_FORMAT_RGBA_4444}, DECODED_FORMAT_RGBA_FLOAT, 16},	// RGBA_FLOAT
+    {{CFHD_PIXEL_FORMAT_RGBA_FLOAT, ENCODED_FORMAT_BAYER},		 DECODED_FORMAT_RGBA_FLOAT, 16},	// RGBA_FLOAT
+
+    {{CFHD_PIXEL_FORMAT_GBRAP_FLOAT, ENCODED_FORMAT_YUV_422},	 DECODED_FORMAT_GBRAP_FLOAT, 4},	// GBRAP_FLOAT
+    {{CFHD_PIXEL_FORMAT_GBRAP_FLOAT, ENCODED_FORMAT_RGB_444},	 DECODED_FORMAT_GBRAP_FLOAT, 4},	// GBRAP_FLOAT
+    {{CFHD_PIXEL_FORMAT_GBRAP_FLOAT, ENCODED_FORMAT_RGBA_4444}, DECODED_FORMAT_GBRAP_FLOAT, 4},	// GBRAP_FLOAT
+    {{CFHD_PIXEL_FORMAT_GBRAP_FLOAT, ENCODED_FORMAT_BAYER},		 DECODED_FORMAT_GBRAP_FLOAT, 4},	// GBRAP_FLOAT
+
     //TODO: Add support for decoding Bayer to other Avid pixel formats
 
 };
@@ -259,12 +339,161 @@ bool GetDecodedFormat(ENCODED_FORMAT encodedFormat,
     return false;
 }
 
+// Return true if the decoded format is only produced by the row output of the active metadata decoder
+static bool IsRowOutputDecodedFormat(DECODED_FORMAT decodedFormat)
+{
+    switch (decodedFormat)
+    {
+        case DECODED_FORMAT_NV12:
+        case DECODED_FORMAT_YV12:
+        case DECODED_FORMAT_P010:
+        case DECODED_FORMAT_P016:
+        case DECODED_FORMAT_P210:
+        case DECODED_FORMAT_P216:
+        case DECODED_FORMAT_GBRP16:
+        case DECODED_FORMAT_GBRAP16:
+        case DECODED_FORMAT_RGBA_HALF:
+        case DECODED_FORMAT_RGBA_FLOAT:
+        case DECODED_FORMAT_GBRAP_FLOAT:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// Return true if the decoded format is one of the Avid CbYCrY formats
+static bool IsAvidDecodedFormat(DECODED_FORMAT decodedFormat)
+{
+    switch (decodedFormat)
+    {
+        case DECODED_FORMAT_CT_UCHAR:
+        case DECODED_FORMAT_CT_SHORT:
+        case DECODED_FORMAT_CT_10Bit_2_8:
+        case DECODED_FORMAT_CT_SHORT_2_14:
+        case DECODED_FORMAT_CT_USHORT_10_6:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// Return true if the output dimensions are a wavelet level with a few lines removed from the bottom
+static bool IsCroppedResolution(int encodedWidth, int encodedHeight, int outputWidth, int outputHeight)
+{
+    int levelWidth = encodedWidth;
+    int levelHeight = encodedHeight;
+
+    for (int level = 0; level < 5; level++)
+    {
+        if (outputWidth == levelWidth && outputHeight < levelHeight && levelHeight - outputHeight < 8)
+        {
+            return true;
+        }
+
+        levelWidth /= 2;
+        levelHeight /= 2;
+    }
+
+    return false;
+}
+
+// Return the smallest decoded resolution that is at least as large as the output dimensions
+static int ScaledResolution(int encodedWidth, int encodedHeight, int outputWidth, int outputHeight,
+                            ENCODED_FORMAT encodedFormat, int *decodedWidthOut, int *decodedHeightOut)
+{
+    static const int levelResolution[] =
+    {
+        DECODED_RESOLUTION_FULL,
+        DECODED_RESOLUTION_HALF,
+        DECODED_RESOLUTION_QUARTER,
+        DECODED_RESOLUTION_LOWPASS_ONLY,
+        DECODED_RESOLUTION_LOWPASS_ONLY,
+    };
+
+    const int levelCount = sizeof(levelResolution) / sizeof(levelResolution[0]);
+
+    int decodedResolution = DECODED_RESOLUTION_FULL;
+    int levelWidth = encodedWidth;
+    int levelHeight = encodedHeight;
+
+    *decodedWidthOut = encodedWidth;
+    *decodedHeightOut = encodedHeight;
+
+    for (int level = 1; level < levelCount; level++)
+    {
+        levelWidth /= 2;
+        levelHeight /= 2;
+
+        if (levelWidth < outputWidth || levelHeight < outputHeight)
+        {
+            break;
+        }
+
+        // Bayer data is not output from the lowpass bands at the top of the wavelet tree
+        if (levelResolution[level] == DECODED_RESOLUTION_LOWPASS_ONLY && encodedFormat == ENCODED_FORMAT_BAYER)
+        {
+            break;
+        }
+
+        decodedResolution = levelResolution[level];
+        *decodedWidthOut = levelWidth;
+        *decodedHeightOut = levelHeight;
+    }
+
+    return decodedResolution;
+}
+
 
 // Convenience methods for computing frame dimensions and formats
 size_t GetFrameSize(int width, int height, CFHD_PixelFormat format)
 {
     size_t framePitch = GetFramePitch(width, format);
-    return (height * framePitch);
+    size_t frameSize = height * framePitch;
+
+    // Add the size of the planes that follow the plane described by the pitch
+    switch (format)
+    {
+        case CFHD_PIXEL_FORMAT_NV12:
+        case CFHD_PIXEL_FORMAT_YV12:
+            // Chroma planes with 4:2:0 sampling below the luma plane
+            frameSize += ((height + 1) / 2) * framePitch;
+            break;
+
+        case CFHD_PIXEL_FORMAT_P010:
+        case CFHD_PIXEL_FORMAT_P016:
+            // Interleaved chroma plane with 4:2:0 sampling below the luma plane
+            frameSize += ((height + 1) / 2) * framePitch;
+            break;
+
+        case CFHD_PIXEL_FORMAT_P210:
+        case CFHD_PIXEL_FORMAT_P216:
+            // Interleaved chroma plane with 4:2:2 sampling below the luma plane
+            frameSize += height * framePitch;
+            break;
+
+        case CFHD_PIXEL_FORMAT_GBRP16:
+            // Blue and red planes below the green plane
+            frameSize += 2 * height * framePitch;
+            break;
+
+        case CFHD_PIXEL_FORMAT_GBRAP16:
+        case CFHD_PIXEL_FORMAT_GBRAP_FLOAT:
+            // Blue, red, and alpha planes below the green plane
+            frameSize += 3 * height * framePitch;
+            break;
+
+        case CFHD_PIXEL_FORMAT_CT_10BIT_2_8:
+            // Plane of 2-bit pixels above the plane of 8-bit pixels
+            frameSize += ((size_t)width * height) / 2;
+            break;
+
+        default:
+            break;
+    }
+
+    return frameSize;
 }
 
 int32_t GetFramePitch(int width, CFHD_PixelFormat format)
@@ -293,12 +522,24 @@ int GetPixelSize(CFHD_PixelFormat format)
     // Compute the pixel size
     switch (format)
     {
+        case CFHD_PIXEL_FORMAT_NV12:				// Size of the pixels in the luma plane
+        case CFHD_PIXEL_FORMAT_YV12:
+            pixelSize = 1;
+            break;
+
         case CFHD_PIXEL_FORMAT_YUY2:
         case CFHD_PIXEL_FORMAT_2VUY:
         case CFHD_PIXEL_FORMAT_YUYV:
         case CFHD_PIXEL_FORMAT_BYR2:
         case CFHD_PIXEL_FORMAT_BYR4:
+        case CFHD_PIXEL_FORMAT_CT_UCHAR:			// Avid 8-bit CbYCrY 4:2:2
         case CFHD_PIXEL_FORMAT_CT_10BIT_2_8:		// Avid format with two planes of 2-bit and 8-bit pixels
+        case CFHD_PIXEL_FORMAT_P010:				// Size of the pixels in the first plane
+        case CFHD_PIXEL_FORMAT_P016:
+        case CFHD_PIXEL_FORMAT_P210:
+        case CFHD_PIXEL_FORMAT_P216:
+        case CFHD_PIXEL_FORMAT_GBRP16:
+        case CFHD_PIXEL_FORMAT_GBRAP16:
             pixelSize = 2;
             break;
 
@@ -319,6 +560,7 @@ int GetPixelSize(CFHD_PixelFormat format)
         case CFHD_PIXEL_FORMAT_CT_SHORT_2_14:		// Avid fixed point 2.14 pixel format
         case CFHD_PIXEL_FORMAT_CT_USHORT_10_6:		// Avid fixed point 10.6 pixel format
         case CFHD_PIXEL_FORMAT_CT_SHORT:			// Avid 16-bit signed pixels
+        case CFHD_PIXEL_FORMAT_GBRAP_FLOAT:			// Size of the pixels in the first plane
             pixelSize = 4;
             break;
 
@@ -330,9 +572,14 @@ int GetPixelSize(CFHD_PixelFormat format)
         case CFHD_PIXEL_FORMAT_RG64:
         case CFHD_PIXEL_FORMAT_B64A:
         case CFHD_PIXEL_FORMAT_W13A:
+        case CFHD_PIXEL_FORMAT_RGBA_HALF:
             pixelSize = 8;
             break;
 
+        case CFHD_PIXEL_FORMAT_RGBA_FLOAT:
+            pixelSize = 16;
+            break;
+
         case CFHD_PIXEL_FORMAT_RG24:
             pixelSize = 3;
             break;
@@ -382,12 +629,35 @@ CSampleDecoder::CSampleDecoder(CFHD_ALLOCATOR *allocator, FILE *logfile) :
     m_decodedFrameBuffer(NULL),
     m_decodedFrameSize(0),
     m_decodedFramePitch(0),
+    m_regionLeft(0),
+    m_regionTop(0),
+    m_regionWidth(0),
+    m_regionHeight(0),
+    m_decodedPixelSize(0),
     m_decodingFlags(CFHD_DECODING_FLAGS_NONE),
     m_preparedForThumbnails(false),
     m_channelsActive(1),
-    m_channelMix(0)
+    m_channelMix(0),
+    m_threadLimit(0),
+    m_rowsCallback(NULL),
+    m_rowsParam(NULL),
+    m_rowsBand(0),
+    m_rowsOutput(NULL),
+    m_rowsPitch(0),
+    m_preparedWidth(0),
+    m_preparedHeight(0),
+    m_preparedFormat(CFHD_PIXEL_FORMAT_UNKNOWN),
+    m_preparedResolution(0),
+    m_batchDecoders(NULL),
+    m_pipeline(NULL),
+    m_frameCacheCapacity(0),
+    m_frameCacheCurrent(-1),
+    m_frameCacheDecoded(false),
+    m_frameCacheClock(0),
+    m_thumbnailContext(NULL),
+    m_thumbnailBatch(NULL)
 {
-    //
+    memset(&m_sampleLayout, 0, sizeof(m_sampleLayout));
 }
 
 /*!
@@ -405,6 +675,18 @@ CSampleDecoder::CSampleDecoder(CFHD_ALLOCATOR *allocator, FILE *logfile) :
 CSampleDecoder::~CSampleDecoder()
 {
     ReleaseDecoder();
+
+    if (m_thumbnailContext)
+    {
+        DeleteThumbnailContext(m_thumbnailContext);
+        m_thumbnailContext = NULL;
+    }
+
+    if (m_thumbnailBatch)
+    {
+        DeleteThumbnailBatch(m_thumbnailBatch);
+        m_thumbnailBatch = NULL;
+    }
 }
 
 
@@ -443,6 +725,17 @@ CSampleDecoder::GetOutputFormats(void *samplePtr,
         CFHD_PIXEL_FORMAT_BGRA,			// RGBA 8-bit 4:4:4:4 inverted
         CFHD_PIXEL_FORMAT_BGRa,			// RGBA 8-bit 4:4:4:4
         CFHD_PIXEL_FORMAT_RG24,			// RGB 8-bit 4:4:4
+        CFHD_PIXEL_FORMAT_NV12,			// Component Y'CbCr 8-bit 4:2:0 with interleaved chroma
+        CFHD_PIXEL_FORMAT_YV12,			// Component Y'CbCr 8-bit 4:2:0 with planar chroma
+        CFHD_PIXEL_FORMAT_P010,			// Component Y'CbCr 10-bit 4:2:0 with interleaved chroma
+        CFHD_PIXEL_FORMAT_P016,			// Component Y'CbCr 16-bit 4:2:0 with interleaved chroma
+        CFHD_PIXEL_FORMAT_P210,			// Component Y'CbCr 10-bit 4:2:2 with interleaved chroma
+        CFHD_PIXEL_FORMAT_P216,			// Component Y'CbCr 16-bit 4:2:2 with interleaved chroma
+        CFHD_PIXEL_FORMAT_GBRP16,		// Planar RGB with 16-bits per component
+        CFHD_PIXEL_FORMAT_GBRAP16,		// Planar RGBA with 16-bits per component
+        CFHD_PIXEL_FORMAT_RGBA_HALF,	// RGBA with 16-bit floating-point components
+        CFHD_PIXEL_FORMAT_RGBA_FLOAT,	// RGBA with 32-bit floating-point components
+        CFHD_PIXEL_FORMAT_GBRAP_FLOAT,	// Planar RGBA with 32-bit floating-point components
     };
     const static int outputFormatYUV422Length = sizeof(outputFormatYUV422) / sizeof(outputFormatYUV422[0]);
 
@@ -464,6 +757,17 @@ CSampleDecoder::GetOutputFormats(void *samplePtr,
         CFHD_PIXEL_FORMAT_V210,			// Component Y'CbCr 10-bit 4:2:2
         CFHD_PIXEL_FORMAT_2VUY,			// Component Y'CbCr 8-bit 4:2:2
         CFHD_PIXEL_FORMAT_YUY2,			// Component Y'CbCr 8-bit 4:2:2
+        CFHD_PIXEL_FORMAT_NV12,			// Component Y'CbCr 8-bit 4:2:0 with interleaved chroma
+        CFHD_PIXEL_FORMAT_YV12,			// Component Y'CbCr 8-bit 4:2:0 with planar chroma
+        CFHD_PIXEL_FORMAT_P010,			// Component Y'CbCr 10-bit 4:2:0 with interleaved chroma
+        CFHD_PIXEL_FORMAT_P016,			// Component Y'CbCr 16-bit 4:2:0 with interleaved chroma
+        CFHD_PIXEL_FORMAT_P210,			// Component Y'CbCr 10-bit 4:2:2 with interleaved chroma
+        CFHD_PIXEL_FORMAT_P216,			// Component Y'CbCr 16-bit 4:2:2 with interleaved chroma
+        CFHD_PIXEL_FORMAT_GBRP16,		// Planar RGB with 16-bits per component
+        CFHD_PIXEL_FORMAT_GBRAP16,		// Planar RGBA with 16-bits per component
+        CFHD_PIXEL_FORMAT_RGBA_HALF,	// RGBA with 16-bit floating-point components
+        CFHD_PIXEL_FORMAT_RGBA_FLOAT,	// RGBA with 32-bit floating-point components
+        CFHD_PIXEL_FORMAT_GBRAP_FLOAT,	// Planar RGBA with 32-bit floating-point components
     };
     const static int outputFormatRGB444Length = sizeof(outputFormatRGB444) / sizeof(outputFormatRGB444[0]);
 
@@ -487,6 +791,17 @@ CSampleDecoder::GetOutputFormats(void *samplePtr,
         CFHD_PIXEL_FORMAT_V210,			// Component Y'CbCr 10-bit 4:2:2
         CFHD_PIXEL_FORMAT_2VUY,			// Component Y'CbCr 8-bit 4:2:2
         CFHD_PIXEL_FORMAT_YUY2,			// Component Y'CbCr 8-bit 4:2:2
+        CFHD_PIXEL_FORMAT_NV12,			// Component Y'CbCr 8-bit 4:2:0 with interleaved chroma
+        CFHD_PIXEL_FORMAT_YV12,			// Component Y'CbCr 8-bit 4:2:0 with planar chroma
+        CFHD_PIXEL_FORMAT_P010,			// Component Y'CbCr 10-bit 4:2:0 with interleaved chroma
+        CFHD_PIXEL_FORMAT_P016,			// Component Y'CbCr 16-bit 4:2:0 with interleaved chroma
+        CFHD_PIXEL_FORMAT_P210,			// Component Y'CbCr 10-bit 4:2:2 with interleaved chroma
+        CFHD_PIXEL_FORMAT_P216,			// Component Y'CbCr 16-bit 4:2:2 with interleaved chroma
+        CFHD_PIXEL_FORMAT_GBRP16,		// Planar RGB with 16-bits per component
+        CFHD_PIXEL_FORMAT_GBRAP16,		// Planar RGBA with 16-bits per component
+        CFHD_PIXEL_FORMAT_RGBA_HALF,	// RGBA with 16-bit floating-point components
+        CFHD_PIXEL_FORMAT_RGBA_FLOAT,	// RGBA with 32-bit floating-point components
+        CFHD_PIXEL_FORMAT_GBRAP_FLOAT,	// Planar RGBA with 32-bit floating-point components
     };
     const static int outputFormatBayerLength = sizeof(outputFormatBayer) / sizeof(outputFormatBayer[0]);
 
@@ -585,6 +900,17 @@ bool IsSameFormat(DECODED_FORMAT decodedFormat, CFHD_PixelFormat outputFormat)
         {DECODED_FORMAT_CT_10Bit_2_8, CFHD_PIXEL_FORMAT_CT_10BIT_2_8},
         {DECODED_FORMAT_CT_SHORT_2_14, CFHD_PIXEL_FORMAT_CT_SHORT_2_14},
         {DECODED_FORMAT_CT_USHORT_10_6, CFHD_PIXEL_FORMAT_CT_USHORT_10_6},
+        {DECODED_FORMAT_NV12, CFHD_PIXEL_FORMAT_NV12},
+        {DECODED_FORMAT_YV12, CFHD_PIXEL_FORMAT_YV12},
+        {DECODED_FORMAT_P010, CFHD_PIXEL_FORMAT_P010},
+        {DECODED_FORMAT_P016, CFHD_PIXEL_FORMAT_P016},
+        {DECODED_FORMAT_P210, CFHD_PIXEL_FORMAT_P210},
+        {DECODED_FORMAT_P216, CFHD_PIXEL_FORMAT_P216},
+        {DECODED_FORMAT_GBRP16, CFHD_PIXEL_FORMAT_GBRP16},
+        {DECODED_FORMAT_GBRAP16, CFHD_PIXEL_FORMAT_GBRAP16},
+        {DECODED_FORMAT_RGBA_HALF, CFHD_PIXEL_FORMAT_RGBA_HALF},
+        {DECODED_FORMAT_RGBA_FLOAT, CFHD_PIXEL_FORMAT_RGBA_FLOAT},
+        {DECODED_FORMAT_GBRAP_FLOAT, CFHD_PIXEL_FORMAT_GBRAP_FLOAT},
 
         //TODO: Add more entries to the format equivalence table
     };
@@ -672,6 +998,16 @@ bool CSampleDecoder::IsDecoderObsolete(int outputWidth,
                         outputHeight /= 4;
                         break;
 
+                    case CFHD_DECODED_RESOLUTION_EIGHTH:
+                        outputWidth /= 8;
+                        outputHeight /= 8;
+                        break;
+
+                    case CFHD_DECODED_RESOLUTION_SIXTEENTH:
+                        outputWidth /= 16;
+                        outputHeight /= 16;
+                        break;
+
                     default:
                         // Do not change the output dimensions
                         break;
@@ -719,7 +1055,7 @@ CSampleDecoder::GetSampleInfo(
     SAMPLE_HEADER header;
     memset(&header, 0, sizeof(SAMPLE_HEADER));
 
-    result = ::ParseSampleHeader(&bitstream, &header);
+    result = ::ParseSampleHeaderWithLayout(&bitstream, &header, &m_sampleLayout);
     if (result)
     {
         // The frame dimensions must be obtained from the encoded sample
@@ -815,6 +1151,16 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
     ENCODED_FORMAT encodedFormat = ENCODED_FORMAT_UNKNOWN;
     DECODED_FORMAT decodedFormat = DECODED_FORMAT_UNSUPPORTED;
 
+    // Samples prefetched for the previous output format are decoded before the decoder is prepared again
+    ReleasePipeline();
+    ReleaseBatchDecoders();
+    ReleaseFrameCache();
+
+    m_preparedWidth = outputWidth;
+    m_preparedHeight = outputHeight;
+    m_preparedFormat = outputFormat;
+    m_preparedResolution = decodedResolution;
+
     // Catch any errors in the decoder
     try
     {
@@ -867,7 +1213,7 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
             memset(&header, 0, sizeof(SAMPLE_HEADER));
 
             // Decode the sample header
-            result = ::ParseSampleHeader(&bitstream, &header);
+            result = ::ParseSampleHeaderWithLayout(&bitstream, &header, &m_sampleLayout);
             if (!result)
             {
                 // The frame dimensions must be obtained from the encoded sample
@@ -962,6 +1308,16 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
                         outputHeight /= 4;
                         break;
 
+                    case CFHD_DECODED_RESOLUTION_EIGHTH:
+                        outputWidth /= 8;
+                        outputHeight /= 8;
+                        break;
+
+                    case CFHD_DECODED_RESOLUTION_SIXTEENTH:
+                        outputWidth /= 16;
+                        outputHeight /= 16;
+                        break;
+
                     default:
                         // Do not change the output dimensions
                         break;
@@ -982,6 +1338,16 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
                     outputHeight /= 4;
                     break;
 
+                case CFHD_DECODED_RESOLUTION_EIGHTH:
+                    outputWidth /= 8;
+                    outputHeight /= 8;
+                    break;
+
+                case CFHD_DECODED_RESOLUTION_SIXTEENTH:
+                    outputWidth /= 16;
+                    outputHeight /= 16;
+                    break;
+
                 default:
                     // Do not change the output dimensions
                     break;
@@ -992,14 +1358,27 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
 
         // Compute the decoded resolution without arbitrary frame scaling
         decodedResolution = DecodedResolution(encodedWidth, encodedHeight, outputWidth, outputHeight);
-        if (decodedResolution == DECODED_RESOLUTION_UNSUPPORTED)
+        if (decodedResolution == DECODED_RESOLUTION_UNSUPPORTED &&
+                IsScaledOutputFormat(decodedFormat, outputFormat) &&
+                !IsCroppedResolution(encodedWidth, encodedHeight, outputWidth, outputHeight))
+        {
+            // Decode the smallest wavelet level that covers the output dimensions and scale the decoded frame
+            decodedResolution = ScaledResolution(encodedWidth, encodedHeight, outputWidth, outputHeight,
+                                                 encodedFormat, &decodedWidth, &decodedHeight);
+        }
+        else if (decodedResolution == DECODED_RESOLUTION_UNSUPPORTED)
         {
             // Force the output dimensions to be the encoded dimensions
             outputWidth = encodedWidth;
             outputHeight = encodedHeight;
             decodedResolution = DECODED_RESOLUTION_FULL;
+        }
 
-            //TODO: Use the decoded resolution argument to adjust the output dimensions
+        if (decodedWidth == 0 || decodedHeight == 0)
+        {
+            // The frame is decoded at the output dimensions
+            decodedWidth = outputWidth;
+            decodedHeight = outputHeight;
         }
 
         if (decodedFormat == DECODED_FORMAT_UNSUPPORTED)
@@ -1008,6 +1387,24 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
             goto finish;
         }
 
+        // The quarter resolution output of the lowpass bands cannot be converted to the row output formats
+        if (IsRowOutputDecodedFormat(decodedFormat) &&
+                decodedResolution == DECODED_RESOLUTION_QUARTER && encodedFormat != ENCODED_FORMAT_BAYER)
+        {
+            errorCode = CFHD_ERROR_BADFORMAT;
+            goto finish;
+        }
+
+        // Bayer data is not output from the lowpass bands at the top of the wavelet tree and
+        // the Avid formats cannot be converted from the rows of YUV 4:2:2 lowpass pixels
+        if (decodedResolution == DECODED_RESOLUTION_LOWPASS_ONLY &&
+                (decodedFormat == DECODED_FORMAT_BYR2 || decodedFormat == DECODED_FORMAT_BYR4 ||
+                 (IsAvidDecodedFormat(decodedFormat) && encodedFormat == ENCODED_FORMAT_YUV_422)))
+        {
+            errorCode = CFHD_ERROR_BADFORMAT;
+            goto finish;
+        }
+
         //char formatString[5];
         //ConvertFourccToString(pixelFormat, formatString);
         //fprintf(m_logfile, "CFHD_DecompressorBeginBand, glob: 0x%08X, pixel format: %s, decoded format: %d, decoded resolution: %d\n",
@@ -1020,12 +1417,17 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
             if (encodedWidth != m_encodedWidth   ||
                     encodedHeight != m_encodedHeight ||
                     decodedFormat != m_decodedFormat ||
-                    decodedResolution != m_decodedResolution)
+                    decodedResolution != m_decodedResolution ||
+                    (decodedResolution == DECODED_RESOLUTION_LOWPASS_ONLY &&
+                     (decodedWidth != m_decodedWidth || decodedHeight != m_decodedHeight)))
             {
                 // Safest method is to destroy the decoder and let it be rebuilt
                 DecodeRelease(m_decoder, NULL, 0);
                 Free(m_decoder);
                 m_decoder = NULL;
+
+                // The buffer for the decoded frame may be the wrong size
+                ReleaseFrameBuffer();
             }
         }
 
@@ -1045,6 +1447,13 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
             //TODO: Fix bug in InitDecoder which sets the CPU parameters before clearing the decoder data structure
             memset(m_decoder, 0, DecoderSize());
 
+            // The thread limit is preserved when the decoder is initialized
+            if (m_threadLimit > 0)
+            {
+                m_decoder->thread_cntrl.limit = m_threadLimit;
+                m_decoder->thread_cntrl.set_thread_params = 1;
+            }
+
 #if _ALLOCATOR
             // Initialize the decoder using a memory allocator
             ALLOCATOR *allocator = (ALLOCATOR *)m_allocator;
@@ -1062,6 +1471,12 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
                 goto finish;
             }
 
+            // The lowpass bands are output at eighth or sixteenth resolution
+            if (decodedResolution == DECODED_RESOLUTION_LOWPASS_ONLY)
+            {
+                SetDecoderFormat(m_decoder, decodedWidth, decodedHeight, decodedFormat, decodedResolution);
+            }
+
             // Assume video systems 709 color space
             SetDecoderColorFlags(m_decoder, COLOR_SPACE_CG_709);
 
@@ -1076,52 +1491,20 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
             // Assume that the frame will be rendered
             //m_willRender = true;
 
-            // Assume that the decoded dimensions are the same as the output dimensions
-            decodedWidth = outputWidth;
-            decodedHeight = outputHeight;
-
             // Remember the decoded dimensions
             m_decodedWidth = decodedWidth;
             m_decodedHeight = decodedHeight;
         }
 #if 1
         // Allocate the buffer for the decoded frame
-        if (!IsSameFormat(decodedFormat, outputFormat) && m_decodedFrameBuffer == NULL)
+        if ((!IsSameFormat(decodedFormat, outputFormat) ||
+                decodedWidth != outputWidth || decodedHeight != outputHeight) && m_decodedFrameBuffer == NULL)
         {
-            int widthRoundedUp;
-            int heightRoundedUp;
-            //size_t pixelSize;
-            int32_t decodedRowSize;
-            uint32_t decodedFrameSize;
-            //int rowBytes;
-
-            // Compute the aligned dimensions
-            widthRoundedUp = (int)Align16(decodedWidth);
-            heightRoundedUp = (int)Align16(decodedHeight);
-
-            decodedRowSize = (int32_t)GetFramePitch(widthRoundedUp, outputFormat);
-            decodedFrameSize = heightRoundedUp * decodedRowSize;
-
-            assert(decodedRowSize > 0 && decodedFrameSize > 0);
-            if (! (decodedRowSize > 0 && decodedFrameSize > 0))
+            errorCode = AllocateFrameBuffer(decodedWidth, decodedHeight, outputFormat);
+            if (errorCode != CFHD_ERROR_OKAY)
             {
-                errorCode = CFHD_ERROR_CODEC_ERROR;
-                goto finish;
-            }
-
-            // Allocate an aligned buffer for the decoded frame
-            //m_decodedFrameBuffer = (char *)_mm_malloc(decodedFrameSize, 16);
-            m_decodedFrameBuffer = (char *)AlignAlloc(decodedFrameSize, 16);
-            assert(m_decodedFrameBuffer != NULL);
-            if (! (m_decodedFrameBuffer != NULL))
-            {
-                errorCode = CFHD_ERROR_OUTOFMEMORY;
                 goto finish;
             }
-
-            // Remember the size and stride of the decoding buffer
-            m_decodedFrameSize = decodedFrameSize;
-            m_decodedFramePitch = decodedRowSize;
         }
 #endif
         // Remember the output dimensions and format
@@ -1132,6 +1515,25 @@ CSampleDecoder::PrepareDecoder(int outputWidth,
         // Save the decoding flags for use when actually decoding a sample
         m_decodingFlags = decodingFlags;
 
+        // The region of interest must be set again after the decoder is prepared
+        m_regionLeft = m_regionTop = 0;
+        m_regionWidth = m_regionHeight = 0;
+        if (m_decoder)
+        {
+            SetDecoderRegion(m_decoder, 0, 0, 0, 0);
+        }
+
+        // Start the decoders for prefetched samples
+        if (decodingFlags & CFHD_DECODING_FLAGS_PIPELINED)
+        {
+            errorCode = PreparePipeline(outputWidth, outputHeight, outputFormat, decodedResolution,
+                                        decodingFlags & ~CFHD_DECODING_FLAGS_PIPELINED, samplePtr, sampleSize);
+            if (errorCode != CFHD_ERROR_OKAY)
+            {
+                goto finish;
+            }
+        }
+
         // Return the actual output dimensions and format
         if (actualWidthOut != NULL)
         {
@@ -1243,7 +1645,7 @@ CSampleDecoder::ParseSampleHeader(void *samplePtr,
         memset(&header, 0, sizeof(SAMPLE_HEADER));
 
         // Decode the sample header
-        bool result = ::ParseSampleHeader(&bitstream, &header);
+        bool result = ::ParseSampleHeaderWithLayout(&bitstream, &header, &m_sampleLayout);
         if (!result)
         {
             // The frame dimensions must be obtained from the encoded sample
@@ -1296,6 +1698,20 @@ CSampleDecoder::DecodeSample(void *samplePtr,
                              void *outputBuffer,
                              int outputPitch)
 {
+    // Was the sample decoded ahead of this call by the pipeline?
+    if (m_pipeline != NULL && !m_prefetchQueue.empty())
+    {
+        CFHD_Error errorCode = CFHD_ERROR_OKAY;
+        if (WaitForPrefetchedSample(samplePtr, sampleSize, outputBuffer, outputPitch, errorCode))
+        {
+            if (errorCode == CFHD_ERROR_OKAY)
+            {
+                ReportDecodedFrame(outputBuffer, outputPitch);
+            }
+            return errorCode;
+        }
+    }
+
     // Catch any errors in the decoder
     try
     {
@@ -1325,7 +1741,16 @@ CSampleDecoder::DecodeSample(void *samplePtr,
             if (!rawThumbnailPix)
                 return CFHD_ERROR_OUTOFMEMORY;
 
-            if (!GenerateThumbnail(samplePtr, sampleSize, rawThumbnailPix, rawThumbnailNumPix * sizeof(uint32_t), THUMBNAIL_FLAGS_DEFAULT, NULL, NULL, NULL))
+            if (m_thumbnailContext == NULL)
+            {
+#if _ALLOCATOR
+                m_thumbnailContext = CreateThumbnailContext((ALLOCATOR *)m_allocator);
+#else
+                m_thumbnailContext = CreateThumbnailContext();
+#endif
+            }
+
+            if (!GenerateThumbnailWithContext(m_thumbnailContext, samplePtr, sampleSize, rawThumbnailPix, rawThumbnailNumPix * sizeof(uint32_t), THUMBNAIL_FLAGS_DEFAULT, NULL, NULL, NULL))
             {
                 if (m_allocator)
                     ::Free(m_allocator, rawThumbnailPix);
@@ -1381,6 +1806,8 @@ CSampleDecoder::DecodeSample(void *samplePtr,
                 delete [] rawThumbnailPix;
             rawThumbnailPix = NULL;
 
+            ReportDecodedFrame(outputBuffer, outputPitch);
+
             return CFHD_ERROR_OKAY;
         }
 
@@ -1413,12 +1840,33 @@ CSampleDecoder::DecodeSample(void *samplePtr,
             return CFHD_ERROR_INVALID_ARGUMENT;
         }
 
+        // Index of the decoded frame in the group of frames that is saved in the frame cache
+        int cachedFrameIndex = -1;
+
+        // Was this frame in a group of frames already decoded?
+        if (m_frameCacheCapacity > 0 && (m_decodingFlags & CFHD_DECODING_FLAGS_IGNORE_OUTPUT) == 0)
+        {
+            bool frameCopied = false;
+            CFHD_Error errorCode = CopyCachedFrame(samplePtr, sampleSize, outputBuffer, outputPitch,
+                                                   frameCopied, cachedFrameIndex);
+            if (errorCode != CFHD_ERROR_OKAY)
+            {
+                return errorCode;
+            }
+            if (frameCopied)
+            {
+                ReportDecodedFrame(outputBuffer, outputPitch);
+                return CFHD_ERROR_OKAY;
+            }
+        }
+
         // Initialize a bitstream to the sample data
         BITSTREAM bitstream;
         InitBitstreamBuffer(&bitstream, (uint8_t *)samplePtr, sampleSize, BITSTREAM_ACCESS_READ);
 
         // Set the decoding flags
-        decoding_flags = ((m_decodingFlags & CFHD_DECODING_FLAGS_IGNORE_OUTPUT) ? 0 : DECODER_FLAGS_RENDER | m_decodingFlags);
+        decoding_flags = ((m_decodingFlags & CFHD_DECODING_FLAGS_IGNORE_OUTPUT) ? 0 :
+                          DECODER_FLAGS_RENDER | (m_decodingFlags & ~CFHD_DECODING_FLAGS_PIPELINED));
         SetDecoderFlags(m_decoder, decoding_flags);
 
         // Buffer used for the decoded frame
@@ -1426,8 +1874,19 @@ CSampleDecoder::DecodeSample(void *samplePtr,
         int decodedFramePitch;
         bool conversionIsRequired;
 
+        // Is only a region of the frame copied to the output buffer?
+        bool regionIsRequired = (m_regionWidth > 0 && m_regionHeight > 0);
+
         // Can the sample be decoded directly to the output buffer?
-        if (IsSameFormat(m_decodedFormat, m_outputFormat))
+        if (regionIsRequired)
+        {
+            // The codec may decode the entire frame so the region is copied from the decoding buffer
+            decodedFrameBuffer = (uint8_t *)m_decodedFrameBuffer;
+            decodedFramePitch = m_decodedFramePitch;
+            conversionIsRequired = false;
+        }
+        else if (IsSameFormat(m_decodedFormat, m_outputFormat) &&
+                 m_decodedWidth == m_outputWidth && m_decodedHeight == m_outputHeight)
         {
             // Decode the sample into the output buffer
             decodedFrameBuffer = (uint8_t *)outputBuffer;
@@ -1461,6 +1920,17 @@ CSampleDecoder::DecodeSample(void *samplePtr,
             return CFHD_ERROR_INTERNAL;
         }
 
+        // Can the rows be reported as they are written into the output buffer?
+        bool rowsAreStreamed = false;
+        if (m_rowsCallback != NULL && (m_decodingFlags & CFHD_DECODING_FLAGS_IGNORE_OUTPUT) == 0 &&
+                !conversionIsRequired && !regionIsRequired && m_outputFormat != CFHD_PIXEL_FORMAT_W13A)
+        {
+            m_rowsOutput = (uint8_t *)outputBuffer;
+            m_rowsPitch = outputPitch;
+            rowsAreStreamed = ::StartDecodedRows(m_decoder, DecodedRowsProc, this, m_rowsBand,
+                                                 decodedFrameBuffer, m_outputHeight);
+        }
+
         try
         {
             // Decode the sample
@@ -1469,6 +1939,9 @@ CSampleDecoder::DecodeSample(void *samplePtr,
         }
         catch (...)
         {
+            ::FinishDecodedRows(m_decoder, false);
+            m_frameCacheCurrent = -1;
+
 #if _WIN32
             // #if DEBUG
             OutputDebugString("::DecodeSample: Unexpected error");
@@ -1496,6 +1969,11 @@ CSampleDecoder::DecodeSample(void *samplePtr,
 
         if (!result)
         {
+            ::FinishDecodedRows(m_decoder, false);
+
+            // The transforms in the codec no longer hold the current group of frames
+            m_frameCacheCurrent = -1;
+
             assert(0);
             return CFHD_ERROR_CODEC_ERROR;
         }
@@ -1517,6 +1995,27 @@ CSampleDecoder::DecodeSample(void *samplePtr,
             }
         }
 
+        if (regionIsRequired)
+        {
+            // Copy or convert the region of the decoded frame into the output buffer
+            CopyRegionToOutputBuffer(outputBuffer, outputPitch);
+        }
+
+        if (cachedFrameIndex >= 0)
+        {
+            StoreCachedFrame(cachedFrameIndex, outputBuffer, outputPitch);
+        }
+
+        if (rowsAreStreamed)
+        {
+            // Report the rows that were not written by the final stage of the codec
+            ::FinishDecodedRows(m_decoder, true);
+        }
+        else if ((m_decodingFlags & CFHD_DECODING_FLAGS_IGNORE_OUTPUT) == 0)
+        {
+            ReportDecodedFrame(outputBuffer, outputPitch);
+        }
+
         // Indicate that the frame has been decoded
         return CFHD_ERROR_OKAY;
     }
@@ -1619,63 +2118,850 @@ CFHD_Error CSampleDecoder::CopyToOutputBuffer(void *decodedBuffer, int decodedPi
 
 }
 
-CFHD_Error
-CSampleDecoder::GetThumbnail(void *samplePtr,
-                             size_t sampleSize,
-                             void *outputBuffer,
-                             size_t outputSize,
-                             size_t flags,
-                             size_t *retWidth,
-                             size_t *retHeight,
-                             size_t *retSize)
+// Allocate the buffer for decoding frames that are converted or cropped into the output buffer
+CFHD_Error CSampleDecoder::AllocateFrameBuffer(int width, int height, CFHD_PixelFormat format)
 {
-    if (GenerateThumbnail(
-                samplePtr,
-                sampleSize,
-                outputBuffer,
-                outputSize,
-                (int)flags,
-                retWidth,
-                retHeight,
-                retSize))
-        return CFHD_ERROR_OKAY;
-    else
+    // Compute the aligned dimensions
+    int widthRoundedUp = (int)Align16(width);
+    int heightRoundedUp = (int)Align16(height);
+
+    int32_t decodedRowSize = (int32_t)GetFramePitch(widthRoundedUp, format);
+    uint32_t decodedFrameSize = heightRoundedUp * decodedRowSize;
+
+    assert(decodedRowSize > 0 && decodedFrameSize > 0);
+    if (! (decodedRowSize > 0 && decodedFrameSize > 0))
+    {
         return CFHD_ERROR_CODEC_ERROR;
-}
+    }
 
+    ReleaseFrameBuffer();
 
-// Return the dimensions and format of the output frame
-CFHD_Error CSampleDecoder::GetFrameFormat(int &width, int &height, CFHD_PixelFormat &format)
-{
-    width = m_outputWidth;
-    height = m_outputHeight;
-    format = m_outputFormat;
+    // Allocate an aligned buffer for the decoded frame
+    m_decodedFrameBuffer = (char *)AlignAlloc(decodedFrameSize, 16);
+    assert(m_decodedFrameBuffer != NULL);
+    if (! (m_decodedFrameBuffer != NULL))
+    {
+        return CFHD_ERROR_OUTOFMEMORY;
+    }
+
+    // Remember the size and stride of the decoding buffer
+    m_decodedFrameSize = decodedFrameSize;
+    m_decodedFramePitch = decodedRowSize;
 
     return CFHD_ERROR_OKAY;
 }
 
-CFHD_Error CSampleDecoder::GetRequiredBufferSize(uint32_t &bytes)
+CFHD_Error CSampleDecoder::SetRegionOfInterest(int left, int top, int width, int height)
 {
-    int channels = 1;
-    uint32_t active = 0;
-    uint32_t mix = 0;
+    DECODED_FORMAT decodedFormat = DECODED_FORMAT_UNSUPPORTED;
+    uint32_t decodedPixelSize = 0;
 
-    bytes = 0;
+    if (m_decoder == NULL || m_preparedForThumbnails)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
 
-    GetChannelsActive(active);
-    GetChannelMix(mix);
-    if (active == 3 && mix == 0)
-        channels = 2;
+    // Samples prefetched before the region was set are decoded again when they are requested
+    if (m_pipeline != NULL)
+    {
+        CFHD_Error errorCode = CFHD_ERROR_OKAY;
+        WaitForPrefetchedSample(NULL, 0, NULL, 0, errorCode);
+    }
 
-    int decodedRowSize =  (int)GetFramePitch(m_decodedWidth, m_outputFormat);
-    bytes = m_decodedHeight * decodedRowSize * channels;
+    // The cached frames were copied from the previous region
+    ReleaseFrameCache();
 
+    // Decode the entire frame
+    if (width == 0 || height == 0)
+    {
+        m_regionLeft = m_regionTop = 0;
+        m_regionWidth = m_regionHeight = 0;
+        SetDecoderRegion(m_decoder, 0, 0, 0, 0);
+        return CFHD_ERROR_OKAY;
+    }
 
-    return CFHD_ERROR_OKAY;
-}
+    // The region must be inside the frame and aligned to pairs of rows and chroma samples
+    if (left < 0 || top < 0 || width < 0 || height < 0 ||
+            ((left | top | width | height) & 1) != 0 ||
+            left + width > m_decodedWidth ||
+            top + height > m_decodedHeight)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    // The region is not scaled to the output dimensions
+    if (m_decodedWidth != m_outputWidth || m_decodedHeight != m_outputHeight)
+    {
+        return CFHD_ERROR_BADSCALING;
+    }
+
+    // Both eyes of a stereo frame are not decoded into the same region
+    if (m_channelsActive == 3 && m_channelMix == 0)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Only pixel formats with a single plane of pixels that have a fixed size can be cropped
+    if (GetPixelSize(m_outputFormat) == 0 ||
+            GetFrameSize(m_outputWidth, m_outputHeight, m_outputFormat) != (size_t)m_outputHeight * GetFramePitch(m_outputWidth, m_outputFormat) ||
+            !GetDecodedFormat(m_encodedFormat, m_outputFormat, &decodedFormat, &decodedPixelSize) ||
+            decodedPixelSize == 0)
+    {
+        return CFHD_ERROR_BADFORMAT;
+    }
+
+    // The frame is decoded into a temporary buffer even if the output format is the same
+    if (m_decodedFrameBuffer == NULL)
+    {
+        CFHD_Error errorCode = AllocateFrameBuffer(m_decodedWidth, m_decodedHeight, m_outputFormat);
+        if (errorCode != CFHD_ERROR_OKAY)
+        {
+            return errorCode;
+        }
+    }
+
+    m_regionLeft = left;
+    m_regionTop = top;
+    m_regionWidth = width;
+    m_regionHeight = height;
+    m_decodedPixelSize = decodedPixelSize;
+
+    SetDecoderRegion(m_decoder, left, top, width, height);
+
+    return CFHD_ERROR_OKAY;
+}
+
+CFHD_Error CSampleDecoder::SetDecodedRowsCallback(CFHD_DecodedRowsCallback callback, void *param, int bandRows)
+{
+    m_rowsCallback = callback;
+    m_rowsParam = param;
+    m_rowsBand = bandRows;
+
+    return CFHD_ERROR_OKAY;
+}
+
+void CSampleDecoder::DecodedRowsProc(void *param, int first_row, int row_count)
+{
+    CSampleDecoder *decoder = (CSampleDecoder *)param;
+    uint8_t *rowPtr = decoder->m_rowsOutput + (intptr_t)first_row * decoder->m_rowsPitch;
+
+    decoder->m_rowsCallback(decoder->m_rowsParam, first_row, row_count, rowPtr);
+}
+
+void CSampleDecoder::ReportDecodedFrame(void *outputBuffer, int outputPitch)
+{
+    if (m_rowsCallback != NULL && m_outputHeight > 0)
+    {
+        int rowCount = (m_regionHeight > 0) ? m_regionHeight : m_outputHeight;
+        m_rowsCallback(m_rowsParam, 0, rowCount, outputBuffer);
+    }
+}
+
+// Hash of the sample used to recognize a group of frames that is in the frame cache
+static uint64_t SampleHash(const void *samplePtr, size_t sampleSize)
+{
+    const uint64_t prime = 0x100000001B3ULL;
+    const uint8_t *data = (const uint8_t *)samplePtr;
+    uint64_t lane[4] = {0xCBF29CE484222325ULL, 0x84222325CBF29CE4ULL, 0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL};
+    size_t offset = 0;
+
+    // Four independent lanes so that the multiplies are not serialized
+    for (; offset + 32 <= sampleSize; offset += 32)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            uint64_t word;
+            memcpy(&word, data + offset + 8 * i, sizeof(word));
+            lane[i] = (lane[i] ^ word) * prime;
+        }
+    }
+
+    uint64_t hash = lane[0] ^ (lane[1] << 1) ^ (lane[2] << 2) ^ (lane[3] << 3) ^ sampleSize;
+    for (; offset < sampleSize; offset++)
+    {
+        hash = (hash ^ data[offset]) * prime;
+    }
+
+    return hash;
+}
+
+CFHD_Error CSampleDecoder::SetFrameCacheCapacity(int groupCount)
+{
+    if (groupCount < 0)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    // The groups cached for the previous capacity are discarded
+    ReleaseFrameCache();
+    m_frameCacheCapacity = groupCount;
+
+    return CFHD_ERROR_OKAY;
+}
+
+void CSampleDecoder::ReleaseFrameCache()
+{
+    for (size_t index = 0; index < m_frameCache.size(); index++)
+    {
+        for (int frame = 0; frame < 2; frame++)
+        {
+            if (m_frameCache[index].frameBuffer[frame] != NULL)
+            {
+                AlignFree(m_frameCache[index].frameBuffer[frame]);
+            }
+        }
+    }
+
+    m_frameCache.clear();
+    m_frameCacheCurrent = -1;
+}
+
+/*!
+	@brief Copy the frame from the frame cache if the frame was decoded before
+
+	A sample that encodes a group of two frames is entropy decoded and the temporal
+	transform is inverted once for both frames.  The first frame is returned and
+	the second frame is reconstructed from the wavelets that remain in the codec
+	when the next sample (which only carries the frame header) is decoded.  Random
+	access and reverse playback request the same group again for each frame, so
+	both output frames are kept for the most recently used groups.  The group is
+	recognized by the size and a hash of the sample.
+
+	If the frame was not copied into the output buffer, the frame index is set to the
+	index of the frame in the group that must be saved in the cache after the sample
+	is decoded, or a negative value if the frame is not cached.
+*/
+CFHD_Error CSampleDecoder::CopyCachedFrame(void *samplePtr, size_t sampleSize, void *outputBuffer, int outputPitch,
+        bool &frameCopied, int &frameIndex)
+{
+    const uint8_t *sample = (const uint8_t *)samplePtr;
+    int sampleType = SAMPLE_TYPE_NONE;
+
+    frameCopied = false;
+    frameIndex = -1;
+
+    // The first tag in the sample is the sample type
+    if (sampleSize >= 4 && sample[0] == 0 && sample[1] == CODEC_TAG_SAMPLE)
+    {
+        sampleType = (sample[2] << 8) | sample[3];
+    }
+
+    if (sampleType == SAMPLE_TYPE_FRAME)
+    {
+        // The second frame in the group of frames from the previous sample
+        if (m_frameCacheCurrent < 0)
+        {
+            return CFHD_ERROR_OKAY;
+        }
+
+        CachedFrameGroup &group = m_frameCache[m_frameCacheCurrent];
+        if (group.frameValid[1] && group.outputPitch == outputPitch)
+        {
+            memcpy(outputBuffer, group.frameBuffer[1], group.frameSize);
+            frameCopied = true;
+            return CFHD_ERROR_OKAY;
+        }
+
+        // The codec does not have the wavelets for a group of frames that was copied from the cache
+        if (!m_frameCacheDecoded)
+        {
+            return CFHD_ERROR_UNEXPECTED;
+        }
+
+        frameIndex = 1;
+        return CFHD_ERROR_OKAY;
+    }
+
+    // Any other type of sample replaces the group of frames in the codec
+    m_frameCacheCurrent = -1;
+
+    if (sampleType != SAMPLE_TYPE_GROUP || outputPitch <= 0)
+    {
+        return CFHD_ERROR_OKAY;
+    }
+
+    uint64_t sampleHash = SampleHash(samplePtr, sampleSize);
+    size_t entry = m_frameCache.size();
+    size_t leastRecent = 0;
+
+    for (size_t index = 0; index < m_frameCache.size(); index++)
+    {
+        if (m_frameCache[index].sampleHash == sampleHash && m_frameCache[index].sampleSize == sampleSize)
+        {
+            entry = index;
+            break;
+        }
+        if (m_frameCache[index].lastUse < m_frameCache[leastRecent].lastUse)
+        {
+            leastRecent = index;
+        }
+    }
+
+    if (entry < m_frameCache.size())
+    {
+        CachedFrameGroup &group = m_frameCache[entry];
+        group.lastUse = ++m_frameCacheClock;
+        m_frameCacheCurrent = (int)entry;
+
+        // Both frames must be cached since the codec will not have the wavelets for the second frame
+        if (group.frameValid[0] && group.frameValid[1] && group.outputPitch == outputPitch)
+        {
+            memcpy(outputBuffer, group.frameBuffer[0], group.frameSize);
+            m_frameCacheDecoded = false;
+            frameCopied = true;
+            return CFHD_ERROR_OKAY;
+        }
+    }
+    else
+    {
+        if (m_frameCache.size() < (size_t)m_frameCacheCapacity)
+        {
+            CachedFrameGroup group;
+            memset(&group, 0, sizeof(group));
+            m_frameCache.push_back(group);
+        }
+        else
+        {
+            // Replace the least recently used group
+            entry = leastRecent;
+        }
+
+        CachedFrameGroup &group = m_frameCache[entry];
+        group.sampleHash = sampleHash;
+        group.sampleSize = sampleSize;
+        group.lastUse = ++m_frameCacheClock;
+        m_frameCacheCurrent = (int)entry;
+    }
+
+    // Decode the group and save the first frame
+    m_frameCache[entry].frameValid[0] = false;
+    m_frameCache[entry].frameValid[1] = false;
+    m_frameCacheDecoded = true;
+    frameIndex = 0;
+    return CFHD_ERROR_OKAY;
+}
+
+void CSampleDecoder::StoreCachedFrame(int frameIndex, void *outputBuffer, int outputPitch)
+{
+    if (m_frameCacheCurrent < 0)
+    {
+        return;
+    }
+
+    CachedFrameGroup &group = m_frameCache[m_frameCacheCurrent];
+
+    // Compute the extent of the frame in the output buffer
+    int width = (m_regionWidth > 0 && m_regionHeight > 0) ? m_regionWidth : m_outputWidth;
+    size_t framePitch = GetFramePitch(width, m_outputFormat);
+    uint32_t requiredSize = 0;
+    size_t frameSize = 0;
+
+    GetRequiredBufferSize(requiredSize);
+
+    if (framePitch > 0 && requiredSize % framePitch == 0 && (size_t)outputPitch >= framePitch)
+    {
+        // All planes have the same pitch so the last row can be shorter than the output pitch
+        size_t rowCount = requiredSize / framePitch;
+        frameSize = (rowCount - 1) * outputPitch + framePitch;
+    }
+    else if ((size_t)outputPitch == framePitch)
+    {
+        frameSize = requiredSize;
+    }
+
+    if (frameSize == 0)
+    {
+        // Cannot determine the layout of the frame in the output buffer
+        group.frameValid[0] = group.frameValid[1] = false;
+        m_frameCacheCurrent = -1;
+        return;
+    }
+
+    // Discard the frames that were cached for a different layout of the output buffer
+    if (group.outputPitch != outputPitch || group.frameSize != frameSize)
+    {
+        for (int frame = 0; frame < 2; frame++)
+        {
+            if (group.frameBuffer[frame] != NULL)
+            {
+                AlignFree(group.frameBuffer[frame]);
+                group.frameBuffer[frame] = NULL;
+            }
+            group.frameValid[frame] = false;
+        }
+        group.outputPitch = outputPitch;
+        group.frameSize = frameSize;
+    }
+
+    if (group.frameBuffer[frameIndex] == NULL)
+    {
+        group.frameBuffer[frameIndex] = (uint8_t *)AlignAlloc(frameSize, 16);
+        if (group.frameBuffer[frameIndex] == NULL)
+        {
+            return;
+        }
+    }
+
+    memcpy(group.frameBuffer[frameIndex], outputBuffer, frameSize);
+    group.frameValid[frameIndex] = true;
+}
+
+CFHD_Error CSampleDecoder::CopyRegionToOutputBuffer(void *outputBuffer, int outputPitch)
+{
+    uint8_t *regionBuffer = (uint8_t *)m_decodedFrameBuffer;
+    int regionPitch = m_decodedFramePitch;
+    bool byte_swap_flag;
+
+#if _WIN32
+    // Do not swap bytes on Windows
+    byte_swap_flag = false;
+#else
+    // Always swap bytes on the Macintosh
+    byte_swap_flag = true;
+#endif
+
+    // Crop the region if the codec decoded the entire frame
+    if (!IsRegionDecoded(m_decoder))
+    {
+        int row = m_regionTop;
+
+        // The rows in these formats are stored from the bottom of the frame to the top
+        if (m_decodedFormat == DECODED_FORMAT_RGB24 || m_decodedFormat == DECODED_FORMAT_RGB32)
+        {
+            row = m_decodedHeight - m_regionTop - m_regionHeight;
+        }
+
+        regionBuffer += (size_t)row * regionPitch + (size_t)m_regionLeft * m_decodedPixelSize;
+    }
+
+    if (IsSameFormat(m_decodedFormat, m_outputFormat))
+    {
+        size_t rowSize = (size_t)m_regionWidth * GetPixelSize(m_outputFormat);
+        uint8_t *outputRowPtr = (uint8_t *)outputBuffer;
+
+        for (int row = 0; row < m_regionHeight; row++)
+        {
+            memcpy(outputRowPtr, regionBuffer, rowSize);
+            regionBuffer += regionPitch;
+            outputRowPtr += outputPitch;
+        }
+
+        return CFHD_ERROR_OKAY;
+    }
+
+    return ConvertToOutputBuffer(regionBuffer, regionPitch, m_decodedFormat,
+                                 outputBuffer, outputPitch, m_outputFormat,
+                                 m_regionWidth, m_regionHeight, byte_swap_flag);
+}
+
+CFHD_Error
+CSampleDecoder::GetThumbnail(void *samplePtr,
+                             size_t sampleSize,
+                             void *outputBuffer,
+                             size_t outputSize,
+                             size_t flags,
+                             size_t *retWidth,
+                             size_t *retHeight,
+                             size_t *retSize)
+{
+    if (m_thumbnailContext == NULL)
+    {
+#if _ALLOCATOR
+        m_thumbnailContext = CreateThumbnailContext((ALLOCATOR *)m_allocator);
+#else
+        m_thumbnailContext = CreateThumbnailContext();
+#endif
+    }
+
+    // Use the decoder state from previous thumbnails if it could be allocated
+    if (m_thumbnailContext == NULL)
+    {
+        if (GenerateThumbnail(
+                    samplePtr,
+                    sampleSize,
+                    outputBuffer,
+                    outputSize,
+                    (int)flags,
+                    retWidth,
+                    retHeight,
+                    retSize))
+            return CFHD_ERROR_OKAY;
+        else
+            return CFHD_ERROR_CODEC_ERROR;
+    }
+
+    if (GenerateThumbnailWithContext(
+                m_thumbnailContext,
+                samplePtr,
+                sampleSize,
+                outputBuffer,
+                outputSize,
+                (int)flags,
+                retWidth,
+                retHeight,
+                retSize))
+        return CFHD_ERROR_OKAY;
+    else
+        return CFHD_ERROR_CODEC_ERROR;
+}
+
+CFHD_Error
+CSampleDecoder::GetThumbnails(int sampleCount,
+                              void **samplePtrs,
+                              const size_t *sampleSizes,
+                              void **outputBuffers,
+                              const size_t *outputSizes,
+                              size_t flags,
+                              CFHD_Error *errors)
+{
+    CFHD_Error error = CFHD_ERROR_OKAY;
+    bool *results = NULL;
+
+    if (m_thumbnailBatch == NULL)
+    {
+#if _ALLOCATOR
+        m_thumbnailBatch = CreateThumbnailBatch((ALLOCATOR *)m_allocator);
+#else
+        m_thumbnailBatch = CreateThumbnailBatch();
+#endif
+        if (m_thumbnailBatch == NULL)
+        {
+            return CFHD_ERROR_OUTOFMEMORY;
+        }
+    }
+
+    try
+    {
+        results = new bool[sampleCount];
+    }
+    catch (...)
+    {
+        return CFHD_ERROR_OUTOFMEMORY;
+    }
+
+    GenerateThumbnailBatch(m_thumbnailBatch, sampleCount, samplePtrs, sampleSizes,
+                           outputBuffers, outputSizes, (uint32_t)flags, results);
+
+    // Report the first sample that failed
+    for (int index = 0; index < sampleCount; index++)
+    {
+        if (errors[index] == CFHD_ERROR_OKAY && !results[index])
+        {
+            errors[index] = CFHD_ERROR_CODEC_ERROR;
+        }
+        if (error == CFHD_ERROR_OKAY)
+        {
+            error = errors[index];
+        }
+    }
+
+    delete [] results;
+
+    return error;
+}
+
+
+// Return the dimensions and format of the output frame
+CFHD_Error CSampleDecoder::GetFrameFormat(int &width, int &height, CFHD_PixelFormat &format)
+{
+    width = (m_regionWidth > 0) ? m_regionWidth : m_outputWidth;
+    height = (m_regionHeight > 0) ? m_regionHeight : m_outputHeight;
+    format = m_outputFormat;
+
+    return CFHD_ERROR_OKAY;
+}
+
+CFHD_Error CSampleDecoder::GetRequiredBufferSize(uint32_t &bytes)
+{
+    int channels = 1;
+    uint32_t active = 0;
+    uint32_t mix = 0;
+
+    bytes = 0;
+
+    GetChannelsActive(active);
+    GetChannelMix(mix);
+    if (active == 3 && mix == 0)
+        channels = 2;
+
+    if (m_regionWidth > 0 && m_regionHeight > 0)
+        bytes = (uint32_t)GetFrameSize(m_regionWidth, m_regionHeight, m_outputFormat);
+    else
+        bytes = (uint32_t)GetFrameSize(m_outputWidth, m_outputHeight, m_outputFormat) * channels;
+
+
+    return CFHD_ERROR_OKAY;
+}
+
+/*!
+	@brief Begin decoding a sample that will be passed to a later call to DecodeSample
+
+	In the pipelined mode, prefetched samples are decoded by a pool of decoders so
+	that the entropy decoding of the next sample overlaps the reconstruction and
+	output conversion of the current sample.  Each decoder in the pool has its own
+	transform state.  The sample is decoded into the output buffer provided with
+	the sample, which must be the same buffer that is passed to DecodeSample.
+*/
+CFHD_Error CSampleDecoder::PrefetchSample(void *samplePtr,
+        size_t sampleSize,
+        void *outputBuffer,
+        int outputPitch)
+{
+    // The region of interest is only applied by this decoder
+    if (m_pipeline == NULL || m_regionWidth > 0)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+
+    // The caller must decode the samples that have already been prefetched
+    if (m_prefetchQueue.size() >= SAMPLE_PIPELINE_LENGTH)
+    {
+        return CFHD_ERROR_NOT_FINISHED;
+    }
+
+    CFHD_Error errorCode = m_pipeline->DecodeSample(0, samplePtr, sampleSize, outputBuffer, outputPitch);
+    if (errorCode == CFHD_ERROR_OKAY)
+    {
+        PrefetchedSample prefetched = {samplePtr, sampleSize, outputBuffer, outputPitch};
+        m_prefetchQueue.push_back(prefetched);
+    }
+
+    return errorCode;
+}
+
+CFHD_Error CSampleDecoder::PreparePipeline(int outputWidth,
+        int outputHeight,
+        CFHD_PixelFormat outputFormat,
+        int decodedResolution,
+        CFHD_DecodingFlags decodingFlags,
+        void *samplePtr,
+        size_t sampleSize)
+{
+    CFHD_Error errorCode = CFHD_ERROR_OKAY;
+
+    m_pipeline = new CDecoderPool(SAMPLE_PIPELINE_DECODERS, SAMPLE_PIPELINE_LENGTH, m_allocator);
+    if (m_pipeline == NULL)
+    {
+        return CFHD_ERROR_OUTOFMEMORY;
+    }
+
+    // The decoders in the pool produce frames with the same dimensions and format as this decoder
+    errorCode = m_pipeline->PrepareToDecode(outputWidth, outputHeight, outputFormat,
+                                            (CFHD_DecodedResolution)decodedResolution, decodingFlags,
+                                            samplePtr, sampleSize, NULL, NULL, NULL);
+    if (errorCode == CFHD_ERROR_OKAY)
+    {
+        errorCode = m_pipeline->StartDecoders();
+    }
+
+    if (errorCode != CFHD_ERROR_OKAY)
+    {
+        ReleasePipeline();
+    }
+
+    return errorCode;
+}
+
+void CSampleDecoder::ReleasePipeline()
+{
+    if (m_pipeline)
+    {
+        // The output buffers of the pending samples must not be written after this call
+        delete m_pipeline;
+        m_pipeline = NULL;
+    }
+
+    m_prefetchQueue.clear();
+}
+
+/*!
+	@brief Finish the prefetched samples up to and including the specified sample
+
+	Prefetched samples are decoded in order, so a sample that was prefetched after
+	samples the caller did not decode is found by waiting for the earlier samples.
+	If the sample was not prefetched, the pending samples that write into the same
+	output buffer are finished so that the buffer is not written after this call.
+	Passing a null output buffer finishes all of the pending samples.
+*/
+bool CSampleDecoder::WaitForPrefetchedSample(void *samplePtr,
+        size_t sampleSize,
+        void *outputBuffer,
+        int outputPitch,
+        CFHD_Error &errorCode)
+{
+    size_t count = 0;
+    bool found = false;
+
+    // Find the number of pending samples that must be finished
+    for (size_t index = 0; index < m_prefetchQueue.size(); index++)
+    {
+        const PrefetchedSample &prefetched = m_prefetchQueue[index];
+
+        if (prefetched.samplePtr == samplePtr && prefetched.sampleSize == sampleSize &&
+                prefetched.outputBuffer == outputBuffer && prefetched.outputPitch == outputPitch)
+        {
+            count = index + 1;
+            found = true;
+            break;
+        }
+
+        if (outputBuffer == NULL || prefetched.outputBuffer == outputBuffer)
+        {
+            count = index + 1;
+        }
+    }
+
+    while (count-- > 0)
+    {
+        m_prefetchQueue.pop_front();
+        errorCode = m_pipeline->WaitForFrame(NULL, NULL);
+    }
+
+    return found;
+}
+
+/*!
+	@brief Decode an array of samples into the corresponding output buffers
+
+	Small frames do not have enough rows to keep the worker threads busy, so
+	batches of small frames are decoded by a pool of decoders that each decode
+	entire samples on one thread.  Larger frames are decoded one at a time by
+	this decoder using all of the worker threads within each frame.  The error
+	code for each sample is returned in the array of errors and the first error
+	is returned by this method.
+*/
+CFHD_Error CSampleDecoder::DecodeSamples(uint32_t sampleCount,
+        void **samplePtrs,
+        const size_t *sampleSizes,
+        void **outputBuffers,
+        const int32_t *outputPitches,
+        CFHD_Error *errors)
+{
+    CFHD_Error errorCode = CFHD_ERROR_OKAY;
+    uint32_t index;
+
+    // The pipeline must not write into the output buffers after this call
+    if (m_pipeline != NULL)
+    {
+        WaitForPrefetchedSample(NULL, 0, NULL, 0, errorCode);
+    }
+
+    // The pool of decoders does not apply the region of interest or report rows
+    bool decodeInParallel = (sampleCount > 1 && GetProcessorCount() > 1 &&
+                             m_outputWidth * m_outputHeight <= SAMPLE_BATCH_MAX_PIXELS &&
+                             m_regionWidth == 0 && m_rowsCallback == NULL &&
+                             (m_decodingFlags & CFHD_DECODING_FLAGS_IGNORE_OUTPUT) == 0);
+
+    if (decodeInParallel && m_batchDecoders == NULL)
+    {
+        // Decode the samples one at a time if the pool of decoders cannot be started
+        decodeInParallel = (PrepareBatchDecoders(samplePtrs[0], sampleSizes[0]) == CFHD_ERROR_OKAY);
+    }
+
+    if (!decodeInParallel)
+    {
+        for (index = 0; index < sampleCount; index++)
+        {
+            if (errors[index] == CFHD_ERROR_OKAY)
+            {
+                errors[index] = DecodeSample(samplePtrs[index], sampleSizes[index],
+                                             outputBuffers[index], outputPitches[index]);
+            }
+        }
+    }
+    else
+    {
+        // Do not submit more jobs than the decoders can hold without blocking
+        size_t jobLimit = SAMPLE_BATCH_JOBS_PER_DECODER * GetProcessorCount();
+        size_t pending = 0;
+
+        index = 0;
+        while (index < sampleCount || pending > 0)
+        {
+            if (index < sampleCount && pending < jobLimit)
+            {
+                if (errors[index] == CFHD_ERROR_OKAY)
+                {
+                    errors[index] = m_batchDecoders->DecodeSample(index, samplePtrs[index], sampleSizes[index],
+                                                                  outputBuffers[index], outputPitches[index]);
+                    if (errors[index] == CFHD_ERROR_OKAY)
+                    {
+                        pending++;
+                    }
+                }
+                index++;
+            }
+            else
+            {
+                // Frames are returned in the order that the samples were submitted
+                uint32_t frameNumber = 0;
+                CFHD_Error error = m_batchDecoders->WaitForFrame(&frameNumber, NULL);
+                assert(frameNumber < sampleCount);
+                if (frameNumber < sampleCount)
+                {
+                    errors[frameNumber] = error;
+                }
+                pending--;
+            }
+        }
+    }
+
+    for (index = 0; index < sampleCount; index++)
+    {
+        if (errors[index] != CFHD_ERROR_OKAY)
+        {
+            return errors[index];
+        }
+    }
+
+    return CFHD_ERROR_OKAY;
+}
+
+CFHD_Error CSampleDecoder::PrepareBatchDecoders(void *samplePtr, size_t sampleSize)
+{
+    CFHD_Error errorCode = CFHD_ERROR_OKAY;
+    int decoderCount = GetProcessorCount();
+
+    m_batchDecoders = new CDecoderPool(decoderCount, SAMPLE_BATCH_JOBS_PER_DECODER * decoderCount, m_allocator);
+    if (m_batchDecoders == NULL)
+    {
+        return CFHD_ERROR_OUTOFMEMORY;
+    }
+
+    // The decoders in the pool are prepared with the same arguments as this decoder
+    errorCode = m_batchDecoders->PrepareToDecode(m_preparedWidth, m_preparedHeight, m_preparedFormat,
+                (CFHD_DecodedResolution)m_preparedResolution,
+                (CFHD_DecodingFlags)(m_decodingFlags & ~CFHD_DECODING_FLAGS_PIPELINED),
+                samplePtr, sampleSize, NULL, NULL, NULL);
+    if (errorCode == CFHD_ERROR_OKAY)
+    {
+        errorCode = m_batchDecoders->StartDecoders();
+    }
+
+    if (errorCode != CFHD_ERROR_OKAY)
+    {
+        ReleaseBatchDecoders();
+    }
+
+    return errorCode;
+}
+
+void CSampleDecoder::ReleaseBatchDecoders()
+{
+    if (m_batchDecoders)
+    {
+        delete m_batchDecoders;
+        m_batchDecoders = NULL;
+    }
+}
+
+CFHD_Error CSampleDecoder::ReleaseDecoder()
+{
+    // Stop the decoders used for prefetched samples and batches
+    ReleasePipeline();
+    ReleaseBatchDecoders();
+    ReleaseFrameCache();
 
-CFHD_Error CSampleDecoder::ReleaseDecoder()
-{
     // Release the decoder
     if (m_decoder)
     {
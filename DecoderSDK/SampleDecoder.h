@@ -38,6 +38,32 @@ typedef struct decoder DECODER;
 typedef enum decoded_format DECODED_FORMAT;
 typedef enum decoded_resolution DECODED_RESOLUTION;
 typedef enum encoded_format ENCODED_FORMAT;
+typedef struct thumbnail_context THUMBNAIL_CONTEXT;
+typedef struct thumbnail_batch THUMBNAIL_BATCH;
+
+// Pool of decoders used for decoding prefetched samples in the pipelined mode
+class CDecoderPool;
+
+// Sample submitted by the caller for decoding ahead of the call to decode the sample
+struct PrefetchedSample
+{
+    void *samplePtr;
+    size_t sampleSize;
+    void *outputBuffer;
+    int outputPitch;
+};
+
+// Decoded frames in a group of frames that are kept for later requests for the same frames
+struct CachedFrameGroup
+{
+    uint64_t sampleHash;		// Hash of the sample that encoded the group of frames
+    size_t sampleSize;
+    int outputPitch;			// Pitch of the cached frames (same as the output buffer)
+    size_t frameSize;			// Size of each cached frame (in bytes)
+    uint8_t *frameBuffer[2];	// Frames in the output format (allocated when the frame is cached)
+    bool frameValid[2];
+    uint32_t lastUse;			// Used to find the least recently used group
+};
 
 
 class CSampleDecoder : public ISampleDecoder
@@ -90,6 +116,14 @@ public:
                             size_t *retHeight,
                             size_t *retSize);
 
+    CFHD_Error GetThumbnails(int sampleCount,
+                             void **samplePtrs,
+                             const size_t *sampleSizes,
+                             void **outputBuffers,
+                             const size_t *outputSizes,
+                             size_t flags,
+                             CFHD_Error *errors);
+
     CFHD_Error SetAllocator(CFHD_ALLOCATOR *allocator)
     {
         m_allocator = allocator;
@@ -114,15 +148,23 @@ public:
 
     CFHD_Error GetRequiredBufferSize(uint32_t &bytes);
 
+    // Set the region of the decoded frame that is output (zero width or height for the entire frame)
+    CFHD_Error SetRegionOfInterest(int left, int top, int width, int height);
+
+    // Set the callback that receives bands of decoded rows in order (NULL to stop reporting rows)
+    CFHD_Error SetDecodedRowsCallback(CFHD_DecodedRowsCallback callback, void *param, int bandRows);
+
 
     CFHD_Error SetChannelsActive(uint32_t data)
     {
         m_channelsActive = data;
+        ReleaseFrameCache();
         return CFHD_ERROR_OKAY;
     }
     CFHD_Error SetChannelMix(uint32_t data)
     {
         m_channelMix = data;
+        ReleaseFrameCache();
         return CFHD_ERROR_OKAY;
     }
 
@@ -137,6 +179,52 @@ public:
         return CFHD_ERROR_OKAY;
     }
 
+    // Keep the decoded frames from the most recently used groups of frames (zero to disable the cache)
+    CFHD_Error SetFrameCacheCapacity(int groupCount);
+
+    // Discard the cached frames (the output format or the active metadata has changed)
+    void ReleaseFrameCache();
+
+    // Limit the number of worker threads used within each frame (zero for no limit)
+    CFHD_Error SetThreadLimit(int limit)
+    {
+        m_threadLimit = limit;
+        return CFHD_ERROR_OKAY;
+    }
+
+    // Begin decoding a sample that will be passed to a later call to DecodeSample (pipelined mode only)
+    CFHD_Error PrefetchSample(void *samplePtr,
+                              size_t sampleSize,
+                              void *outputBuffer,
+                              int outputPitch);
+
+    // Decode an array of samples (samples with an error code already set in the array are skipped)
+    CFHD_Error DecodeSamples(uint32_t sampleCount,
+                             void **samplePtrs,
+                             const size_t *sampleSizes,
+                             void **outputBuffers,
+                             const int32_t *outputPitches,
+                             CFHD_Error *errors);
+
+    // Return true if the decoder was prepared with the pipelined decoding flag
+    bool IsPipelined()
+    {
+        return (m_pipeline != NULL);
+    }
+
+    // Return true if a prefetched sample that has not been returned is decoded into the buffer
+    bool IsPrefetchedBuffer(void *outputBuffer)
+    {
+        for (size_t index = 0; index < m_prefetchQueue.size(); index++)
+        {
+            if (m_prefetchQueue[index].outputBuffer == outputBuffer)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
     CFHD_Error ReleaseDecoder();
 
     bool IsDecoderObsolete(int outputWidth,
@@ -152,6 +240,47 @@ protected:
                                   void *outputBuffer, int outputPitch);
     CFHD_Error ConvertWhitePoint(void *decodedBuffer, int decodedPitch);
 
+    CFHD_Error AllocateFrameBuffer(int width, int height, CFHD_PixelFormat format);
+    CFHD_Error CopyRegionToOutputBuffer(void *outputBuffer, int outputPitch);
+
+    // Pass a band of rows reported by the codec to the decoded rows callback
+    static void DecodedRowsProc(void *param, int first_row, int row_count);
+
+    // Report the entire frame to the decoded rows callback
+    void ReportDecodedFrame(void *outputBuffer, int outputPitch);
+
+    // Create and start the decoders for prefetched samples using the arguments to PrepareDecoder
+    CFHD_Error PreparePipeline(int outputWidth,
+                               int outputHeight,
+                               CFHD_PixelFormat outputFormat,
+                               int decodedResolution,
+                               CFHD_DecodingFlags decodingFlags,
+                               void *samplePtr,
+                               size_t sampleSize);
+
+    // Stop the decoders for prefetched samples after the pending samples are decoded
+    void ReleasePipeline();
+
+    // Create and start the decoders that decode the samples in a batch concurrently
+    CFHD_Error PrepareBatchDecoders(void *samplePtr, size_t sampleSize);
+
+    // Stop the decoders for batches of samples
+    void ReleaseBatchDecoders();
+
+    // Copy the frame from the frame cache or return the index of the frame in the group to cache after decoding
+    CFHD_Error CopyCachedFrame(void *samplePtr, size_t sampleSize, void *outputBuffer, int outputPitch,
+                               bool &frameCopied, int &frameIndex);
+
+    // Save a copy of the decoded frame in the entry for the current group of frames
+    void StoreCachedFrame(int frameIndex, void *outputBuffer, int outputPitch);
+
+    // Finish the prefetched samples up to the specified sample (returns false if it was not prefetched)
+    bool WaitForPrefetchedSample(void *samplePtr,
+                                 size_t sampleSize,
+                                 void *outputBuffer,
+                                 int outputPitch,
+                                 CFHD_Error &errorCode);
+
     void ReleaseFrameBuffer()
     {
         if (m_decodedFrameBuffer)
@@ -270,6 +399,15 @@ private:
     // Pitch of the decoded frame in bytes
     int m_decodedFramePitch;
 
+    // Region of the decoded frame that is copied to the output buffer (zero width for the entire frame)
+    int m_regionLeft;
+    int m_regionTop;
+    int m_regionWidth;
+    int m_regionHeight;
+
+    // Size of the pixels in the decoded frame (used to crop the region from the entire frame)
+    uint32_t m_decodedPixelSize;
+
     // Decoding flags used when the decoder was initialized
     CFHD_DecodingFlags m_decodingFlags;
 
@@ -281,6 +419,47 @@ private:
 
     uint32_t m_channelsActive;
     uint32_t m_channelMix;
+
+    // Maximum number of worker threads used by the codec decoder (zero for no limit)
+    int m_threadLimit;
+
+    // Callback that receives bands of decoded rows (NULL if rows are not reported)
+    CFHD_DecodedRowsCallback m_rowsCallback;
+    void *m_rowsParam;
+    int m_rowsBand;
+
+    // Output buffer for the rows reported during the current call to DecodeSample
+    uint8_t *m_rowsOutput;
+    int m_rowsPitch;
+
+    // Arguments to the most recent call to PrepareDecoder (used to prepare the decoders for batches)
+    int m_preparedWidth;
+    int m_preparedHeight;
+    CFHD_PixelFormat m_preparedFormat;
+    int m_preparedResolution;
+
+    // Decoders for batches of small samples (allocated by the first batch that is decoded in parallel)
+    CDecoderPool *m_batchDecoders;
+
+    // Decoders for prefetched samples (only allocated in the pipelined mode)
+    CDecoderPool *m_pipeline;
+
+    // Samples submitted to the pipeline in the order that they will be decoded
+    std::deque<PrefetchedSample> m_prefetchQueue;
+
+    // Decoded frames from recently used groups of frames
+    std::vector<CachedFrameGroup> m_frameCache;
+    int m_frameCacheCapacity;
+    int m_frameCacheCurrent;		// Entry for the most recent group sample (negative if none)
+    bool m_frameCacheDecoded;		// The codec has the wavelets for the most recent group
+    uint32_t m_frameCacheClock;
+
+    // Layout of the most recent sample header (used to parse the headers of samples from the same stream)
+    SAMPLE_LAYOUT m_sampleLayout;
+
+    // Decoder state and worker threads reused for thumbnails (allocated by the first thumbnail)
+    THUMBNAIL_CONTEXT *m_thumbnailContext;
+    THUMBNAIL_BATCH *m_thumbnailBatch;
 };
 
 #endif //_SAMPLE_DEC_H
@@ -0,0 +1,280 @@
+/*! @file SampleIndex.cpp
+
+*  @brief Index of the samples in a raw CineForm stream that is mapped into memory
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#include "StdAfx.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Include files from the codec library
+#include "streamindex.h"
+
+// Include files for the decoder DLL
+#include "CFHDDecoder.h"
+#include "SampleIndex.h"
+
+
+CSampleIndex::CSampleIndex(CFHD_ALLOCATOR *allocator) :
+    m_allocator(allocator),
+    m_index(NULL),
+    m_stream(NULL),
+    m_streamSize(0)
+#ifdef _WIN32
+    ,
+    m_file(INVALID_HANDLE_VALUE),
+    m_mapping(NULL)
+#endif
+{
+}
+
+CSampleIndex::~CSampleIndex()
+{
+    if (m_index != NULL)
+    {
+        DeleteSampleIndex(m_index);
+        m_index = NULL;
+    }
+
+    UnmapStream();
+}
+
+CFHD_Error CSampleIndex::Open(const char *streamPath, const char *indexPath)
+{
+    CFHD_Error error = CFHD_ERROR_OKAY;
+    FILE *file;
+
+    // The index can only be opened once
+    if (m_index != NULL || m_stream != NULL)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+
+    error = MapStream(streamPath);
+    if (error != CFHD_ERROR_OKAY)
+    {
+        return error;
+    }
+
+#if _ALLOCATOR
+    m_index = CreateSampleIndex((ALLOCATOR *)m_allocator);
+#else
+    m_index = CreateSampleIndex();
+#endif
+    if (m_index == NULL)
+    {
+        return CFHD_ERROR_OUTOFMEMORY;
+    }
+
+    // Use the sidecar file if it was written for this stream
+    if (indexPath != NULL && (file = fopen(indexPath, "rb")) != NULL)
+    {
+        CODEC_ERROR result = ReadSampleIndex(m_index, file, m_streamSize);
+        fclose(file);
+
+        if (result == CODEC_ERROR_OKAY)
+        {
+            return CFHD_ERROR_OKAY;
+        }
+    }
+
+    if (IndexSampleStream(m_index, m_stream, m_streamSize) != CODEC_ERROR_OKAY)
+    {
+        return CFHD_ERROR_BADSAMPLE;
+    }
+
+    // Failure to write the sidecar file is not an error since the index is in memory
+    if (indexPath != NULL && (file = fopen(indexPath, "wb")) != NULL)
+    {
+        CODEC_ERROR result = WriteSampleIndex(m_index, file);
+        fclose(file);
+
+        if (result != CODEC_ERROR_OKAY)
+        {
+            remove(indexPath);
+        }
+    }
+
+    return CFHD_ERROR_OKAY;
+}
+
+CFHD_Error CSampleIndex::GetSample(uint32_t frame, void **samplePtrOut, size_t *sampleSizeOut,
+                                   CFHD_SampleIndexEntry *entryOut)
+{
+    if (m_index == NULL || frame >= m_index->count)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    const SAMPLE_INDEX_ENTRY *entry = &m_index->entries[frame];
+
+    if (samplePtrOut != NULL)
+    {
+        *samplePtrOut = m_stream + entry->offset;
+    }
+
+    if (sampleSizeOut != NULL)
+    {
+        *sampleSizeOut = entry->size;
+    }
+
+    if (entryOut != NULL)
+    {
+        entryOut->offset = entry->offset;
+        entryOut->size = entry->size;
+        entryOut->frameNumber = entry->frame_number;
+        entryOut->keyFrame = entry->key_frame;
+        entryOut->channels = entry->channels;
+    }
+
+    return CFHD_ERROR_OKAY;
+}
+
+CFHD_Error CSampleIndex::Seek(uint32_t frame, uint32_t *keyFrameOut)
+{
+    size_t keyFrame = 0;
+
+    if (m_index == NULL)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+
+    CODEC_ERROR error = SeekSampleIndex(m_index, frame, &keyFrame);
+    if (error == CODEC_ERROR_INVALID_ARGUMENT)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+    if (error != CODEC_ERROR_OKAY)
+    {
+        return CFHD_ERROR_BADSAMPLE;
+    }
+
+    *keyFrameOut = (uint32_t)keyFrame;
+    return CFHD_ERROR_OKAY;
+}
+
+#ifdef _WIN32
+
+CFHD_Error CSampleIndex::MapStream(const char *streamPath)
+{
+    LARGE_INTEGER size;
+
+    m_file = CreateFileA(streamPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                         FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+    {
+        return CFHD_ERROR_BADSAMPLE;
+    }
+
+    m_mapping = CreateFileMapping(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping == NULL)
+    {
+        return CFHD_ERROR_OUTOFMEMORY;
+    }
+
+    m_stream = (uint8_t *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (m_stream == NULL)
+    {
+        return CFHD_ERROR_OUTOFMEMORY;
+    }
+
+    m_streamSize = size.QuadPart;
+    return CFHD_ERROR_OKAY;
+}
+
+void CSampleIndex::UnmapStream()
+{
+    if (m_stream != NULL)
+    {
+        UnmapViewOfFile(m_stream);
+        m_stream = NULL;
+    }
+
+    if (m_mapping != NULL)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = NULL;
+    }
+
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+
+    m_streamSize = 0;
+}
+
+#else
+
+CFHD_Error CSampleIndex::MapStream(const char *streamPath)
+{
+    struct stat info;
+    void *address;
+
+    int fd = open(streamPath, O_RDONLY);
+    if (fd < 0)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return CFHD_ERROR_BADSAMPLE;
+    }
+
+    address = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    // The mapping remains valid after the file is closed
+    close(fd);
+
+    if (address == MAP_FAILED)
+    {
+        return CFHD_ERROR_OUTOFMEMORY;
+    }
+
+    // The index is built by reading the stream from start to end
+    madvise(address, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+    m_stream = (uint8_t *)address;
+    m_streamSize = (uint64_t)info.st_size;
+    return CFHD_ERROR_OKAY;
+}
+
+void CSampleIndex::UnmapStream()
+{
+    if (m_stream != NULL)
+    {
+        munmap(m_stream, (size_t)m_streamSize);
+        m_stream = NULL;
+    }
+
+    m_streamSize = 0;
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*! @file SampleIndex.h
+
+*  @brief Index of the samples in a raw CineForm stream that is mapped into memory
+*
+*  (C) Copyright 2017 GoPro Inc (http://gopro.com/).
+*
+*  Licensed under either:
+*  - Apache License, Version 2.0, http://www.apache.org/licenses/LICENSE-2.0
+*  - MIT license, http://opensource.org/licenses/MIT
+*  at your option.
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*
+*/
+
+#pragma once
+
+/*! @class CSampleIndex
+
+	@brief Random access to the frames in a raw stream of concatenated samples
+
+	The stream is mapped into memory so that building the index only touches
+	the pages that contain sample headers.  The index is loaded from a sidecar
+	file if one exists for a stream of the same size, otherwise the index is
+	built and written to the sidecar file.  The mapping remains open so that
+	the samples can be passed to the decoder without copying.
+*/
+class CSampleIndex
+{
+public:
+
+    CSampleIndex(CFHD_ALLOCATOR *allocator = NULL);
+
+    ~CSampleIndex();
+
+    //! Map the stream into memory and load or build the index
+    CFHD_Error Open(const char *streamPath, const char *indexPath);
+
+    //! Number of frames in the stream
+    uint32_t FrameCount() const
+    {
+        return (m_index != NULL) ? (uint32_t)m_index->count : 0;
+    }
+
+    //! Return the sample for the specified frame
+    CFHD_Error GetSample(uint32_t frame, void **samplePtrOut, size_t *sampleSizeOut,
+                         CFHD_SampleIndexEntry *entryOut);
+
+    //! Return the frame that must be decoded first to decode the specified frame
+    CFHD_Error Seek(uint32_t frame, uint32_t *keyFrameOut);
+
+private:
+
+    CFHD_Error MapStream(const char *streamPath);
+
+    void UnmapStream();
+
+    CFHD_ALLOCATOR *m_allocator;
+
+    SAMPLE_INDEX *m_index;			//!< Index built by the codec library
+
+    uint8_t *m_stream;				//!< Address of the stream mapped into memory
+    uint64_t m_streamSize;			//!< Size of the stream (in bytes)
+
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#endif
+};
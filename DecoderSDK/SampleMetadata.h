@@ -29,6 +29,7 @@
 
 #include "CFHDError.h"
 #include "../Common/AVIExtendedHeader.h"
+#include "../Codec/metadata.h"
 
 class CSampleMetadata
 {
@@ -60,6 +61,11 @@ public:
         memset(&m_currentClipGUID, 0, sizeof(myGUID));
         memset(m_overrideData, 0, MAX_OVERRIDE_SIZE);
         memset(m_workspaceData, 0, MAX_OVERRIDE_SIZE);
+#if _ALLOCATOR
+        InitMetadataIndex(&m_sampleIndex, NULL);
+#else
+        InitMetadataIndex(&m_sampleIndex);
+#endif
     }
 
 public:
@@ -108,6 +114,9 @@ public:
 
     uint32_t last_write_time;
 
+    // Index of the metadata in the sample (built by the first lookup after the sample is set)
+    METADATA_INDEX m_sampleIndex;
+
     CFHD_Error SetAllocator(CFHD_ALLOCATOR *allocator)
     {
         m_allocator = allocator;
@@ -192,6 +201,24 @@ public:
 
     bool GetClipDatabase();
 
+    // Find the first metadata tuple in the sample with the specified tag
+    void *FindInSample(METADATA_TAG tag, METADATA_SIZE *size, METADATA_TYPE *type)
+    {
+        if (!m_sampleIndex.valid && m_sampleData != NULL && m_sampleSize > 0)
+        {
+#if _ALLOCATOR
+            m_sampleIndex.allocator = (ALLOCATOR *)m_allocator;
+#endif
+            if (BuildMetadataIndex(&m_sampleIndex, m_sampleData, m_sampleSize) != CODEC_ERROR_OKAY)
+            {
+                // Search the sample if the index could not be built
+                return MetaDataFindInSample(m_sampleData, m_sampleSize, tag, size, type);
+            }
+        }
+
+        return MetadataIndexFind(&m_sampleIndex, tag, size, type);
+    }
+
     void FreeDatabase()
     {
         if (m_databaseSize && m_databaseData)
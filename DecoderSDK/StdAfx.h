@@ -49,5 +49,15 @@
 #include <stdbool.h>
 #include "../Common/ver.h"
 
+#ifndef _WIN32
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
+// The decoder pool uses containers from the standard template library
+#include <vector>
+#include <deque>
+#include <queue>
+
 //TODO: reference additional headers your program requires here
 
@@ -28,6 +28,7 @@
 #include "encoder.h"
 #include "thread.h"
 #include "metadata.h"
+#include "stereo.h"
 
 //TODO: Eliminate references to the codec library
 
@@ -234,3 +235,136 @@ CFHD_GetEncodeThumbnail(CFHD_EncoderRef encoderRef,
 
     return errorCode;
 }
+
+CFHDENCODER_API CFHD_Error
+CFHD_TranscodeSample(CFHD_EncoderRef encoderRef,
+                     void *samplePtr,
+                     size_t sampleSize,
+                     CFHD_EncodingQuality encodingQuality,
+                     void *outputBuffer,
+                     size_t outputBufferSize,
+                     size_t *retSize)
+{
+    // Check the input arguments
+    if (encoderRef == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+    if (samplePtr == NULL || sampleSize == 0)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+    if (outputBuffer == NULL || retSize == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Only the quality level can be changed (uncompressed samples cannot be transcoded)
+    if (encodingQuality < CFHD_ENCODING_QUALITY_LOW || encodingQuality > CFHD_ENCODING_QUALITY_FILMSCAN3)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    CSampleEncoder *encoder = (CSampleEncoder *)encoderRef;
+
+    return encoder->TranscodeSample(samplePtr,
+                                    sampleSize,
+                                    encodingQuality,
+                                    outputBuffer,
+                                    outputBufferSize,
+                                    retSize);
+}
+
+CFHDENCODER_API CFHD_Error
+CFHD_EncodeProxySample(CFHD_EncoderRef encoderRef,
+                       void *samplePtr,
+                       size_t sampleSize)
+{
+    CFHD_Error error = CFHD_ERROR_OKAY;
+    CFHD_Error errorFree = CFHD_ERROR_OKAY;
+
+    // Check the input arguments
+    if (encoderRef == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+    if (samplePtr == NULL || sampleSize == 0)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    CSampleEncoder *encoder = (CSampleEncoder *)encoderRef;
+
+    error = encoder->HandleMetadata();
+    error = encoder->EncodeProxySample(samplePtr, sampleSize);
+    errorFree = encoder->FreeLocalMetadata();
+    if (error == CFHD_ERROR_OKAY)
+    {
+        return errorFree;
+    }
+
+    return error;
+}
+
+CFHDENCODER_API CFHD_Error
+CFHD_ExtractStereoEye(void *samplePtr,
+                      size_t sampleSize,
+                      CFHD_VideoSelect eye,
+                      void *outputBuffer,
+                      size_t outputBufferSize,
+                      size_t *retSize)
+{
+    // Check the input arguments
+    if (samplePtr == NULL || sampleSize == 0)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+    if (outputBuffer == NULL || retSize == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+    if (eye != VIDEO_SELECT_LEFT_EYE && eye != VIDEO_SELECT_RIGHT_EYE)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    CODEC_ERROR error = ExtractStereoEye((const uint8_t *)samplePtr, sampleSize,
+                                         (eye == VIDEO_SELECT_RIGHT_EYE) ? 1 : 0,
+                                         (uint8_t *)outputBuffer, outputBufferSize, retSize);
+    if (error != CODEC_ERROR_OKAY)
+    {
+        return CFHD_CODEC_ERROR(error);
+    }
+
+    return CFHD_ERROR_OKAY;
+}
+
+CFHDENCODER_API CFHD_Error
+CFHD_MuxStereoSample(void *leftSamplePtr,
+                     size_t leftSampleSize,
+                     void *rightSamplePtr,
+                     size_t rightSampleSize,
+                     void *outputBuffer,
+                     size_t outputBufferSize,
+                     size_t *retSize)
+{
+    // Check the input arguments
+    if (leftSamplePtr == NULL || leftSampleSize == 0 || rightSamplePtr == NULL || rightSampleSize == 0)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+    if (outputBuffer == NULL || retSize == NULL)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    CODEC_ERROR error = MuxStereoSample((const uint8_t *)leftSamplePtr, leftSampleSize,
+                                        (const uint8_t *)rightSamplePtr, rightSampleSize,
+                                        (uint8_t *)outputBuffer, outputBufferSize, retSize);
+    if (error != CODEC_ERROR_OKAY)
+    {
+        return CFHD_CODEC_ERROR(error);
+    }
+
+    return CFHD_ERROR_OKAY;
+}
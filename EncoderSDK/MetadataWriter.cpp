@@ -20,6 +20,7 @@
 // Include files from the codec library
 #include "encoder.h"
 #include "metadata.h"
+#include "crc.h"
 
 //TODO: Eliminate references to the codec library
 
@@ -37,59 +38,6 @@
 #include "SampleEncoder.h"
 
 
-//! Table of CRCs of all 8-bit messages.
-static unsigned long look_crc_table[256];
-
-//! Flag: has the table been computed? Initially false.
-static int look_crc_table_computed = 0;
-
-//! Make the table for a fast CRC.
-void look_make_crc_table(void)
-{
-    unsigned long c;
-    int n, k;
-
-    for (n = 0; n < 256; n++)
-    {
-        c = (unsigned long) n;
-        for (k = 0; k < 8; k++)
-        {
-            if (c & 1)
-                c = 0xedb88320L ^ (c >> 1);
-            else
-                c = c >> 1;
-        }
-        look_crc_table[n] = c;
-    }
-    look_crc_table_computed = 1;
-}
-
-/*!
- * Update a running CRC with the bytes buf[0..len-1]--the CRC should be
- * initialized to all 1's, and the transmitted value is the 1's complement of
- * the final running CRC (see the crc() routine below)).
- */
-unsigned long look_update_crc(unsigned long crc, unsigned char *buf,
-                              int len)
-{
-    unsigned long c = crc;
-    int n;
-
-    if (!look_crc_table_computed)
-        look_make_crc_table();
-    for (n = 0; n < len; n++)
-    {
-        c = look_crc_table[(c ^ buf[n]) & 0xff] ^ (c >> 8);
-    }
-    return c;
-}
-
-/* Return the CRC of the bytes buf[0..len-1]. */
-unsigned long look_calc_crc(unsigned char *buf, int len)
-{
-    return look_update_crc(0xffffffffL, buf, len) ^ 0xffffffffL;
-}
-
 #define OUTPUT 0
 #define BUFSIZE	1024
 
@@ -284,7 +232,7 @@ uint32_t ValidateLookGenCRCEnc(char *path)
         if (finished && (size * size * size * 3 == entries))
         {
             // valid 3D LUT
-            crc = look_calc_crc((unsigned char *)LUT, entries * 4);
+            crc = CalculateCRC32(LUT, entries * 4);
         }
 
         free(LUT);
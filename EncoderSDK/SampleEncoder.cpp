@@ -25,12 +25,14 @@
 // Include files from the codec library
 #include "encoder.h"
 #include "thumbnail.h"
+#include "transcoder.h"
 
 // Include files for the encoder DLL
 #include "Allocator.h"
 //#include "Includes/CFHDEncoder.h"
 #include "CFHDError.h"
 #include "CFHDTypes.h"
+#include "CFHDDecoder.h"
 //#include "Lock.h"
 #include "SampleMetadata.h"
 #include "VideoBuffers.h"
@@ -40,13 +42,6 @@
 #include "metadata.h"
 
 
-// Embed an error from the codec library in an SDK error code
-static inline CFHD_Error CFHD_CODEC_ERROR(CODEC_ERROR error)
-{
-    return (CFHD_Error)((uint32_t)CFHD_ERROR_CODEC_ERROR | (uint32_t)error);
-}
-
-
 CFHD_Error
 CSampleEncoder::GetInputFormats(CFHD_PixelFormat *inputFormatArray,
                                 int inputFormatArrayLength,
@@ -446,6 +441,37 @@ CSampleEncoder::ReleaseScratchBuffer()
     return CFHD_ERROR_OKAY;
 }
 
+CFHD_Error
+CSampleEncoder::ReleaseTranscoder()
+{
+    if (m_transcoder != NULL)
+    {
+        DeleteTranscoder(m_transcoder);
+        m_transcoder = NULL;
+    }
+
+    return CFHD_ERROR_OKAY;
+}
+
+CFHD_Error
+CSampleEncoder::ReleaseProxyDecoder()
+{
+    if (m_proxyDecoder != NULL)
+    {
+        CFHD_CloseDecoder(m_proxyDecoder);
+        m_proxyDecoder = NULL;
+    }
+
+    if (m_proxyBuffer != NULL)
+    {
+        FreeAligned(m_proxyBuffer);
+        m_proxyBuffer = NULL;
+        m_proxyBufferSize = 0;
+    }
+
+    return CFHD_ERROR_OKAY;
+}
+
 
 CFHD_Error
 CSampleEncoder::EncodeSample(void *frameBuffer,
@@ -696,6 +722,134 @@ CSampleEncoder::GetThumbnail(void *samplePtr,
     }
 }
 
+CFHD_Error
+CSampleEncoder::TranscodeSample(void *samplePtr,
+                                size_t sampleSize,
+                                CFHD_EncodingQuality encodingQuality,
+                                void *outputBuffer,
+                                size_t outputSize,
+                                size_t *retSize)
+{
+    CODEC_ERROR error = CODEC_ERROR_OKAY;
+
+    // Create the transcoder the first time that a sample is transcoded
+    if (m_transcoder == NULL)
+    {
+#if _ALLOCATOR
+        m_transcoder = CreateTranscoder((ALLOCATOR *)m_allocator);
+#else
+        m_transcoder = CreateTranscoder();
+#endif
+        if (m_transcoder == NULL)
+        {
+            return CFHD_ERROR_OUTOFMEMORY;
+        }
+    }
+
+    error = ::TranscodeSample(m_transcoder,
+                              (const uint8_t *)samplePtr,
+                              sampleSize,
+                              (int)encodingQuality,
+                              (uint8_t *)outputBuffer,
+                              outputSize,
+                              retSize);
+    if (error != CODEC_ERROR_OKAY)
+    {
+        return CFHD_CODEC_ERROR(error);
+    }
+
+    return CFHD_ERROR_OKAY;
+}
+
+CFHD_Error
+CSampleEncoder::EncodeProxySample(void *samplePtr,
+                                  size_t sampleSize)
+{
+    CFHD_Error error = CFHD_ERROR_OKAY;
+    int decodedWidth = 0;
+    int decodedHeight = 0;
+    CFHD_PixelFormat decodedFormat = CFHD_PIXEL_FORMAT_UNKNOWN;
+    int32_t decodedPitch = 0;
+    uint32_t decodedSize = 0;
+
+    // The encoder must have been prepared for the dimensions of the proxy
+    if (m_encoder == NULL)
+    {
+        return CFHD_ERROR_UNEXPECTED;
+    }
+
+    // The decoder cannot output a half resolution Bayer frame
+    if (m_inputFormat == CFHD_PIXEL_FORMAT_BYR4 || m_inputFormat == CFHD_PIXEL_FORMAT_BYR5)
+    {
+        return CFHD_ERROR_BADFORMAT;
+    }
+
+    // Create the decoder the first time that a proxy is encoded
+    if (m_proxyDecoder == NULL)
+    {
+        error = CFHD_OpenDecoder(&m_proxyDecoder, m_allocator);
+        if (error != CFHD_ERROR_OKAY)
+        {
+            m_proxyDecoder = NULL;
+            return error;
+        }
+    }
+
+    // The decoder is only rebuilt if the encoded dimensions or format have changed
+    error = CFHD_PrepareToDecode(m_proxyDecoder, 0, 0, m_inputFormat,
+                                 CFHD_DECODED_RESOLUTION_HALF, CFHD_DECODING_FLAGS_NONE,
+                                 samplePtr, sampleSize,
+                                 &decodedWidth, &decodedHeight, &decodedFormat);
+    if (error != CFHD_ERROR_OKAY)
+    {
+        return error;
+    }
+
+    // The half resolution frame must match the dimensions of the encoded proxy
+    if (decodedWidth != m_inputWidth || decodedHeight != m_inputHeight || decodedFormat != m_inputFormat)
+    {
+        return CFHD_ERROR_INVALID_ARGUMENT;
+    }
+
+    error = CFHD_GetImagePitch(decodedWidth, decodedFormat, &decodedPitch);
+    if (error != CFHD_ERROR_OKAY)
+    {
+        return error;
+    }
+
+    error = CFHD_GetImageSize(decodedWidth, decodedHeight, decodedFormat,
+                              VIDEO_SELECT_DEFAULT, STEREO3D_TYPE_DEFAULT, &decodedSize);
+    if (error != CFHD_ERROR_OKAY)
+    {
+        return error;
+    }
+
+    // Allocate the buffer for the half resolution frame
+    if (m_proxyBuffer == NULL || m_proxyBufferSize < decodedSize)
+    {
+        if (m_proxyBuffer != NULL)
+        {
+            FreeAligned(m_proxyBuffer);
+            m_proxyBufferSize = 0;
+        }
+
+        m_proxyBuffer = AllocAligned(decodedSize, 16);
+        if (m_proxyBuffer == NULL)
+        {
+            return CFHD_ERROR_OUTOFMEMORY;
+        }
+        m_proxyBufferSize = decodedSize;
+    }
+
+    error = CFHD_DecodeSample(m_proxyDecoder, samplePtr, sampleSize, m_proxyBuffer, decodedPitch);
+    if (error != CFHD_ERROR_OKAY)
+    {
+        return error;
+    }
+
+    return EncodeSample(m_proxyBuffer, decodedPitch);
+}
+
 
 CFHD_Error
 CSampleEncoder::HandleMetadata()
@@ -23,6 +23,15 @@
 // Forward reference to the encoder in the code library
 typedef struct encoder ENCODER;
 
+// Forward reference to the transcoder in the code library
+typedef struct transcoder TRANSCODER;
+
+// Embed an error from the codec library in an SDK error code
+static inline CFHD_Error CFHD_CODEC_ERROR(CODEC_ERROR error)
+{
+    return (CFHD_Error)((uint32_t)CFHD_ERROR_CODEC_ERROR | (uint32_t)error);
+}
+
 class CSampleEncoder
 {
     //IMemAlloc *m_allocator;
@@ -34,6 +43,13 @@ class CSampleEncoder
     FILE *m_logfile;
     ENCODER *m_encoder;
 
+    //! Transcoder for requantizing encoded samples (created when first used)
+    TRANSCODER *m_transcoder;
+
+    void *m_proxyDecoder;				//!< Decoder used to reduce samples to half resolution
+    void *m_proxyBuffer;				//!< Half resolution frame that is encoded as a proxy
+    size_t m_proxyBufferSize;			//!< Size of the proxy frame buffer (in bytes)
+
     TRANSFORM *m_transformArray[TRANSFORM_MAX_CHANNELS];
 
     int m_inputWidth;					//!< Width of the input frames
@@ -96,6 +112,10 @@ public:
         //m_privateAllocatorFlag(true),
         m_logfile(NULL),
         m_encoder(NULL),
+        m_transcoder(NULL),
+        m_proxyDecoder(NULL),
+        m_proxyBuffer(NULL),
+        m_proxyBufferSize(0),
         m_inputWidth(0),
         m_inputHeight(0),
         m_inputFormat(CFHD_PIXEL_FORMAT_UNKNOWN),
@@ -142,6 +162,10 @@ public:
         //m_privateAllocatorFlag(false),
         m_logfile(NULL),
         m_encoder(NULL),
+        m_transcoder(NULL),
+        m_proxyDecoder(NULL),
+        m_proxyBuffer(NULL),
+        m_proxyBufferSize(0),
         m_inputWidth(0),
         m_inputHeight(0),
         m_inputFormat(CFHD_PIXEL_FORMAT_UNKNOWN),
@@ -190,6 +214,12 @@ public:
             Free(m_encoder);
             m_encoder = NULL;
         }
+
+        // Release the transcoder
+        ReleaseTranscoder();
+
+        ReleaseProxyDecoder();
+
         // Free the global metadata
         for (int i = 0; i < 5; i++)
             FreeMetadata(&global[i]);
@@ -251,6 +281,16 @@ public:
                             size_t *retHeight,
                             size_t *retSize);
 
+    CFHD_Error TranscodeSample(void *samplePtr,
+                               size_t sampleSize,
+                               CFHD_EncodingQuality encodingQuality,
+                               void *outputBuffer,
+                               size_t outputSize,
+                               size_t *retSize);
+
+    CFHD_Error EncodeProxySample(void *samplePtr,
+                                 size_t sampleSize);
+
     CFHD_Error SetAllocator(CFHD_ALLOCATOR *allocator)
     {
 #if _ALLOCATOR
@@ -355,6 +395,12 @@ protected:
     // Release the scratch buffer used for encoding
     CFHD_Error ReleaseScratchBuffer();
 
+    // Release the transcoder used for requantizing samples
+    CFHD_Error ReleaseTranscoder();
+
+    // Release the decoder and frame buffer used for encoding proxies
+    CFHD_Error ReleaseProxyDecoder();
+
     void *Alloc(size_t size)
     {
 #if _ALLOCATOR